@@ -147,7 +147,10 @@ minOpenCascadeVersion(7, 4, 0) {
 }
 
 !minOpenCascadeVersion(7, 5, 0) {
-    SOURCES -= src/base/io_occ_gltf_writer.cpp
+    SOURCES -= \
+        src/base/io_gltf_parallel_writer.cpp \
+        src/base/io_obj_parallel_reader.cpp \
+        src/base/io_occ_gltf_writer.cpp
 }
 
 # -- VRML support
@@ -194,9 +197,6 @@ isEmpty(GMIO_ROOT) {
 
     INCLUDEPATH += $$GMIO_ROOT/include
     LIBS += -L$$GMIO_ROOT/lib -lgmio_static$$GMIO_BIN_SUFFIX
-    SOURCES += \
-        $$GMIO_ROOT/src/gmio_support/stl_occ_brep.cpp \
-        $$GMIO_ROOT/src/gmio_support/stl_occ_polytri.cpp \
-        $$GMIO_ROOT/src/gmio_support/stream_qt.cpp
+    SOURCES += $$GMIO_ROOT/src/gmio_support/stream_qt.cpp
     DEFINES += HAVE_GMIO
 }
@@ -13,10 +13,15 @@
 #include "../base/occt_enums.h"
 #include "../base/settings.h"
 #include "../graphics/graphics_entity_driver.h"
+#include "../graphics/graphics_lod_selector.h"
+#include "../graphics/graphics_object_unloader.h"
 #include "../gui/gui_application.h"
 #include "../gui/gui_document.h"
 
 #include <QtCore/QDir>
+#include <QtCore/QThread>
+#include <QtCore/QTimer>
+#include <QtGui/QGuiApplication>
 #include <iterator>
 
 namespace Mayo {
@@ -49,6 +54,12 @@ AppModule::AppModule(Application* app)
       lastOpenDir(this, textId("lastOpenFolder")),
       lastSelectedFormatFilter(this, textId("lastSelectedFormatFilter")),
       linkWithDocumentSelector(this, textId("linkWithDocumentSelector")),
+      // -- Import cache
+      sectionId_applicationImportCache(
+          app->settings()->addSection(this->groupId_application, textId("importCache"))),
+      importCacheOn(this, textId("importCacheOn")),
+      importCacheMaxSize(this, textId("importCacheMaxSize")),
+      importCacheUsage(this, textId("importCacheUsage")),
       // Graphics
       groupId_graphics(app->settings()->addGroup(textId("graphics"))),
       defaultShowOriginTrihedron(this, textId("defaultShowOriginTrihedron")),
@@ -64,7 +75,21 @@ AppModule::AppModule(Application* app)
       meshDefaultsEdgeColor(this, textId("edgeColor")),
       meshDefaultsMaterial(this, textId("material"), &OcctEnums::Graphic3d_NameOfMaterial()),
       meshDefaultsShowEdges(this, textId("showEgesOn")),
-      meshDefaultsShowNodes(this, textId("showNodesOn"))
+      meshDefaultsShowNodes(this, textId("showNodesOn")),
+      // -- Memory
+      sectionId_graphicsMemory(
+          app->settings()->addSection(this->groupId_graphics, textId("memory"))),
+      unloadHiddenGraphicsOn(this, textId("unloadHiddenGraphicsOn")),
+      hiddenGraphicsMemoryBudget(this, textId("hiddenGraphicsMemoryBudget")),
+      // -- Level of detail
+      sectionId_graphicsLevelOfDetail(
+          app->settings()->addSection(this->groupId_graphics, textId("levelOfDetail"))),
+      levelOfDetailOn(this, textId("levelOfDetailOn")),
+      levelOfDetailCoarsePixelSize(this, textId("coarsePixelSize")),
+      levelOfDetailCullingPixelSize(this, textId("cullingPixelSize")),
+      // Import/Export
+      groupId_import(app->settings()->addGroup(textId("import"))),
+      groupId_export(app->settings()->addGroup(textId("export")))
 {
     auto settings = app->settings();
 
@@ -93,6 +118,21 @@ AppModule::AppModule(Application* app)
     this->recentFiles.setUserVisible(false);
     this->lastOpenDir.setUserVisible(false);
     this->lastSelectedFormatFilter.setUserVisible(false);
+    // -- Import cache
+    this->importCacheOn.setDescription(
+                tr("Keep translated STEP/IGES documents, so importing again an unchanged file with "
+                   "the same import options skips translation"));
+    this->importCacheMaxSize.setDescription(
+                tr("Maximum disk space(in megabytes) used by the import cache. Least recently used "
+                   "documents are removed first"));
+    this->importCacheMaxSize.setRange(0, 1024 * 1024);
+    this->importCacheMaxSize.setSingleStep(256);
+    this->importCacheMaxSize.setConstraintsEnabled(true);
+    this->importCacheUsage.setDescription(tr("Current contents of the import cache"));
+    this->importCacheUsage.setUserReadOnly(true);
+    settings->addSetting(&this->importCacheOn, this->sectionId_applicationImportCache);
+    settings->addSetting(&this->importCacheMaxSize, this->sectionId_applicationImportCache);
+    settings->addSetting(&this->importCacheUsage, this->sectionId_applicationImportCache);
 
     // Graphics
     this->defaultShowOriginTrihedron.setDescription(
@@ -112,39 +152,39 @@ AppModule::AppModule(Application* app)
     settings->addSetting(&this->meshDefaultsMaterial, this->sectionId_graphicsMeshDefaults);
     settings->addSetting(&this->meshDefaultsShowEdges, this->sectionId_graphicsMeshDefaults);
     settings->addSetting(&this->meshDefaultsShowNodes, this->sectionId_graphicsMeshDefaults);
-    // Import
-    auto groupId_Import = settings->addGroup(textId("import"));
-    for (const IO::Format& format : app->ioSystem()->readerFormats()) {
-        auto sectionId_format = settings->addSection(groupId_Import, format.identifier);
-        const IO::FactoryReader* factory = app->ioSystem()->findFactoryReader(format);
-        std::unique_ptr<PropertyGroup> ptrGroup = factory->createProperties(format, settings);
-        if (ptrGroup) {
-            for (Property* property : ptrGroup->properties())
-                settings->addSetting(property, sectionId_format);
-
-            PropertyGroup* rawPtrGroup = ptrGroup.get();
-            settings->addGroupResetFunction(groupId_Import, [=]{ rawPtrGroup->restoreDefaults(); });
-            m_mapFormatReaderParameters.insert({ format.identifier, rawPtrGroup });
-            m_vecPtrPropertyGroup.push_back(std::move(ptrGroup));
-        }
-    }
-
-    // Export
-    auto groupId_Export = settings->addGroup(textId("export"));
-    for (const IO::Format& format : app->ioSystem()->writerFormats()) {
-        auto sectionId_format = settings->addSection(groupId_Export, format.identifier);
-        const IO::FactoryWriter* factory = app->ioSystem()->findFactoryWriter(format);
-        std::unique_ptr<PropertyGroup> ptrGroup = factory->createProperties(format, settings);
-        if (ptrGroup) {
-            for (Property* property : ptrGroup->properties())
-                settings->addSetting(property, sectionId_format);
-
-            PropertyGroup* rawPtrGroup = ptrGroup.get();
-            settings->addGroupResetFunction(groupId_Export, [=]{ rawPtrGroup->restoreDefaults(); });
-            m_mapFormatWriterParameters.insert({ format.identifier, ptrGroup.get() });
-            m_vecPtrPropertyGroup.push_back(std::move(ptrGroup));
-        }
-    }
+    // -- Memory
+    this->unloadHiddenGraphicsOn.setDescription(
+                tr("Release 3D presentations of hidden entities when their memory usage exceeds the "
+                   "budget. Presentations are rebuilt when entities are shown again"));
+    this->hiddenGraphicsMemoryBudget.setDescription(
+                tr("Maximum memory(in megabytes) used by 3D presentations of hidden entities. "
+                   "Entities hidden for the longest time are unloaded first"));
+    this->hiddenGraphicsMemoryBudget.setRange(0, 64 * 1024);
+    this->hiddenGraphicsMemoryBudget.setSingleStep(64);
+    this->hiddenGraphicsMemoryBudget.setConstraintsEnabled(true);
+    settings->addSetting(&this->unloadHiddenGraphicsOn, this->sectionId_graphicsMemory);
+    settings->addSetting(&this->hiddenGraphicsMemoryBudget, this->sectionId_graphicsMemory);
+    // -- Level of detail
+    this->levelOfDetailOn.setDescription(
+                tr("Draw parts with a coarse tessellation when they are small in the 3D view, "
+                   "and don't draw at all the tiniest entities"));
+    this->levelOfDetailCoarsePixelSize.setDescription(
+                tr("Parts whose projected size(in pixels) is below this threshold are drawn "
+                   "with a coarse tessellation"));
+    this->levelOfDetailCullingPixelSize.setDescription(
+                tr("Entities whose projected size(in pixels) is below this threshold aren't drawn"));
+    this->levelOfDetailCoarsePixelSize.setRange(0, 4096);
+    this->levelOfDetailCoarsePixelSize.setSingleStep(8);
+    this->levelOfDetailCoarsePixelSize.setConstraintsEnabled(true);
+    this->levelOfDetailCullingPixelSize.setRange(0, 64);
+    this->levelOfDetailCullingPixelSize.setSingleStep(1);
+    this->levelOfDetailCullingPixelSize.setConstraintsEnabled(true);
+    settings->addSetting(&this->levelOfDetailOn, this->sectionId_graphicsLevelOfDetail);
+    settings->addSetting(&this->levelOfDetailCoarsePixelSize, this->sectionId_graphicsLevelOfDetail);
+    settings->addSetting(&this->levelOfDetailCullingPixelSize, this->sectionId_graphicsLevelOfDetail);
+    // Import/Export
+    settings->setGroupInitFunction(this->groupId_import, [=]{ this->initImportGroup(); });
+    settings->setGroupInitFunction(this->groupId_export, [=]{ this->initExportGroup(); });
 
     // Register reset functions
     settings->addGroupResetFunction(this->groupId_system, [&]{
@@ -157,6 +197,8 @@ AppModule::AppModule(Application* app)
         this->lastOpenDir.setValue(QString());
         this->lastSelectedFormatFilter.setValue(QString());
         this->linkWithDocumentSelector.setValue(true);
+        this->importCacheOn.setValue(false);
+        this->importCacheMaxSize.setValue(2048);
     });
     settings->addGroupResetFunction(this->groupId_graphics, [&]{
         this->defaultShowOriginTrihedron.setValue(true);
@@ -168,6 +210,12 @@ AppModule::AppModule(Application* app)
         this->meshDefaultsMaterial.setValue(meshDefaults.material);
         this->meshDefaultsShowEdges.setValue(meshDefaults.showEdges);
         this->meshDefaultsShowNodes.setValue(meshDefaults.showNodes);
+        this->unloadHiddenGraphicsOn.setValue(true);
+        this->hiddenGraphicsMemoryBudget.setValue(1024);
+        const GraphicsLodSelector::Parameters lodParams;
+        this->levelOfDetailOn.setValue(lodParams.isEnabled);
+        this->levelOfDetailCoarsePixelSize.setValue(lodParams.coarsePixelSize);
+        this->levelOfDetailCullingPixelSize.setValue(lodParams.cullingPixelSize);
     });
 }
 
@@ -187,16 +235,34 @@ QString AppModule::qmFilePath(const QByteArray& languageCode)
 
 const PropertyGroup* AppModule::findReaderParameters(const IO::Format& format) const
 {
+    this->initImportExportParameters();
     auto it = m_mapFormatReaderParameters.find(format.identifier);
     return it != m_mapFormatReaderParameters.cend() ? it->second : nullptr;
 }
 
-const PropertyGroup *AppModule::findWriterParameters(const IO::Format& format) const
+const PropertyGroup* AppModule::findWriterParameters(const IO::Format& format) const
 {
+    this->initImportExportParameters();
     auto it = m_mapFormatWriterParameters.find(format.identifier);
     return it != m_mapFormatWriterParameters.cend() ? it->second : nullptr;
 }
 
+void AppModule::initImportExportParameters() const
+{
+    if (m_isImportExportParametersInitialized)
+        return;
+
+    if (QThread::currentThread() != m_app->thread()) {
+        QMetaObject::invokeMethod(
+                    m_app, [=]{ this->initImportExportParameters(); }, Qt::BlockingQueuedConnection);
+        return;
+    }
+
+    m_app->settings()->initGroup(this->groupId_import);
+    m_app->settings()->initGroup(this->groupId_export);
+    m_isImportExportParametersInitialized = true;
+}
+
 void AppModule::prependRecentFile(const QString& filepath)
 {
     const RecentFile* ptrRecentFile = this->findRecentFile(filepath);
@@ -256,6 +322,29 @@ void AppModule::recordRecentFileThumbnail(GuiDocument* guiDoc)
     this->recentFiles.setValue(newListRecentFile);
 }
 
+void AppModule::recordRecentFileThumbnailWhenIdle(GuiDocument* guiDoc)
+{
+    if (!guiDoc)
+        return;
+
+    // Timer is owned by the GuiDocument, so it can't fire after document destruction
+    auto timerIdle = new QTimer(guiDoc);
+    timerIdle->setSingleShot(true);
+    timerIdle->setInterval(2000);
+    QObject::connect(
+                guiDoc, &GuiDocument::graphicsBoundingBoxChanged,
+                timerIdle, qOverload<>(&QTimer::start));
+    QObject::connect(timerIdle, &QTimer::timeout, this, [=]{
+        if (QGuiApplication::mouseButtons() != Qt::NoButton) {
+            timerIdle->start(); // User is interacting, try later
+            return;
+        }
+
+        this->recordRecentFileThumbnail(guiDoc);
+    });
+    timerIdle->start();
+}
+
 void AppModule::recordRecentFileThumbnails(GuiApplication* guiApp)
 {
     if (!guiApp)
@@ -278,6 +367,44 @@ void AppModule::recordRecentFileThumbnails(GuiApplication* guiApp)
     this->recentFiles.setValue(newListRecentFile);
 }
 
+void AppModule::migrateRecentFileThumbnails()
+{
+    RecentFiles newListRecentFile = this->recentFiles.value();
+    bool hasMigrated = false;
+    for (RecentFile& recentFile : newListRecentFile)
+        hasMigrated = recentFile.migrateLegacyThumbnail() || hasMigrated;
+
+    if (hasMigrated)
+        this->recentFiles.setValue(newListRecentFile);
+}
+
+void AppModule::updateImportCacheUsage()
+{
+    const IO::ImportCache* importCache = m_app->ioSystem()->importCache();
+    if (!importCache) {
+        this->importCacheUsage.setValue(QString());
+        return;
+    }
+
+    const auto entryCount = importCache->entries().size();
+    const double sizeMb = importCache->totalSize() / (1024. * 1024.);
+    //: %1 is the count of cached documents, %2 the disk space used in megabytes, %3 the directory
+    const QString text = tr("%1 document(s), %2 MB in %3")
+            .arg(entryCount)
+            .arg(sizeMb, 0, 'f', 1)
+            .arg(QDir::toNativeSeparators(importCache->directoryPath()));
+    this->importCacheUsage.setValue(text);
+}
+
+void AppModule::clearImportCache()
+{
+    IO::ImportCache* importCache = m_app->ioSystem()->importCache();
+    if (importCache)
+        importCache->clear();
+
+    this->updateImportCacheUsage();
+}
+
 AppModule* AppModule::get(const ApplicationPtr& app)
 {
     if (app)
@@ -286,6 +413,46 @@ AppModule* AppModule::get(const ApplicationPtr& app)
     return nullptr;
 }
 
+void AppModule::initImportGroup()
+{
+    Settings* settings = m_app->settings();
+    const IO::System* ioSystem = m_app->ioSystem();
+    for (const IO::Format& format : ioSystem->readerFormats()) {
+        auto sectionId_format = settings->addSection(this->groupId_import, format.identifier);
+        const IO::FactoryReader* factory = ioSystem->findFactoryReader(format);
+        std::unique_ptr<PropertyGroup> ptrGroup = factory->createProperties(format, settings);
+        if (ptrGroup) {
+            for (Property* property : ptrGroup->properties())
+                settings->addSetting(property, sectionId_format);
+
+            PropertyGroup* rawPtrGroup = ptrGroup.get();
+            settings->addGroupResetFunction(this->groupId_import, [=]{ rawPtrGroup->restoreDefaults(); });
+            m_mapFormatReaderParameters.insert({ format.identifier, rawPtrGroup });
+            m_vecPtrPropertyGroup.push_back(std::move(ptrGroup));
+        }
+    }
+}
+
+void AppModule::initExportGroup()
+{
+    Settings* settings = m_app->settings();
+    const IO::System* ioSystem = m_app->ioSystem();
+    for (const IO::Format& format : ioSystem->writerFormats()) {
+        auto sectionId_format = settings->addSection(this->groupId_export, format.identifier);
+        const IO::FactoryWriter* factory = ioSystem->findFactoryWriter(format);
+        std::unique_ptr<PropertyGroup> ptrGroup = factory->createProperties(format, settings);
+        if (ptrGroup) {
+            for (Property* property : ptrGroup->properties())
+                settings->addSetting(property, sectionId_format);
+
+            PropertyGroup* rawPtrGroup = ptrGroup.get();
+            settings->addGroupResetFunction(this->groupId_export, [=]{ rawPtrGroup->restoreDefaults(); });
+            m_mapFormatWriterParameters.insert({ format.identifier, rawPtrGroup });
+            m_vecPtrPropertyGroup.push_back(std::move(ptrGroup));
+        }
+    }
+}
+
 void AppModule::onPropertyChanged(Property* prop)
 {
     if (prop == &this->meshDefaultsColor
@@ -302,6 +469,31 @@ void AppModule::onPropertyChanged(Property* prop)
         values.showNodes = this->meshDefaultsShowNodes.value();
         GraphicsMeshEntityDriver::setDefaultValues(values);
     }
+    else if (prop == &this->importCacheOn || prop == &this->importCacheMaxSize) {
+        IO::ImportCache* importCache = m_app->ioSystem()->importCache();
+        if (importCache) {
+            importCache->setEnabled(this->importCacheOn.value());
+            importCache->setMaxSize(int64_t(this->importCacheMaxSize.value()) * 1024 * 1024);
+        }
+    }
+    else if (prop == &this->unloadHiddenGraphicsOn) {
+        GraphicsObjectUnloader::globalInstance()->setEnabled(this->unloadHiddenGraphicsOn.value());
+    }
+    else if (prop == &this->hiddenGraphicsMemoryBudget) {
+        const size_t budgetBytes = size_t(this->hiddenGraphicsMemoryBudget.value()) * 1024 * 1024;
+        GraphicsObjectUnloader::globalInstance()->setMemoryBudget(budgetBytes);
+    }
+    else if (prop == &this->levelOfDetailOn
+             || prop == &this->levelOfDetailCoarsePixelSize
+             || prop == &this->levelOfDetailCullingPixelSize)
+    {
+        // Taken into account by GuiDocument objects on next view change
+        auto params = GraphicsLodSelector::defaultParameters();
+        params.isEnabled = this->levelOfDetailOn.value();
+        params.coarsePixelSize = this->levelOfDetailCoarsePixelSize.value();
+        params.cullingPixelSize = this->levelOfDetailCullingPixelSize.value();
+        GraphicsLodSelector::setDefaultParameters(params);
+    }
 
     PropertyGroup::onPropertyChanged(prop);
 }
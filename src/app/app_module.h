@@ -18,6 +18,7 @@
 
 #include <fougtools/qttools/core/qbytearray_hfunc.h>
 #include <QtCore/QObject>
+#include <atomic>
 #include <unordered_map>
 #include <vector>
 
@@ -41,15 +42,26 @@ public:
 
     static QString qmFilePath(const QByteArray& languageCode);
 
+    // Parameters of readers/writers are created on first query(see Settings::setGroupInitFunction())
+    // Can be called from any thread, eg by IO tasks
     const PropertyGroup* findReaderParameters(const IO::Format& format) const override;
     const PropertyGroup* findWriterParameters(const IO::Format& format) const override;
 
     void prependRecentFile(const QString& filepath);
     const RecentFile* findRecentFile(const QString& filepath) const;
     void recordRecentFileThumbnail(GuiDocument* guiDoc);
+    // Records thumbnail of 'guiDoc' once it has been left idle for a while(no graphics changes and
+    // no mouse interaction), so it isn't left to the costly "close document" or "exit" steps
+    void recordRecentFileThumbnailWhenIdle(GuiDocument* guiDoc);
     void recordRecentFileThumbnails(GuiApplication* guiApp);
+    // Moves thumbnails stored along with recent files by previous versions into the disk cache
+    void migrateRecentFileThumbnails();
     QSize recentFileThumbnailSize() const { return { 190, 150 }; }
 
+    // Refreshes property 'importCacheUsage' from current contents of the import cache
+    void updateImportCacheUsage();
+    void clearImportCache();
+
     // System
     const Settings_GroupIndex groupId_system;
     const Settings_SectionIndex sectionId_systemUnits;
@@ -62,6 +74,11 @@ public:
     PropertyQString lastOpenDir;
     PropertyQString lastSelectedFormatFilter;
     PropertyBool linkWithDocumentSelector;
+    // -- Import cache
+    const Settings_SectionIndex sectionId_applicationImportCache;
+    PropertyBool importCacheOn;
+    PropertyInt importCacheMaxSize;
+    PropertyQString importCacheUsage;
     // Graphics
     const Settings_GroupIndex groupId_graphics;
     PropertyBool defaultShowOriginTrihedron;
@@ -76,12 +93,30 @@ public:
     PropertyEnumeration meshDefaultsMaterial;
     PropertyBool meshDefaultsShowEdges;
     PropertyBool meshDefaultsShowNodes;
+    // -- Memory
+    const Settings_SectionIndex sectionId_graphicsMemory;
+    PropertyBool unloadHiddenGraphicsOn;
+    PropertyInt hiddenGraphicsMemoryBudget;
+    // -- Level of detail
+    const Settings_SectionIndex sectionId_graphicsLevelOfDetail;
+    PropertyBool levelOfDetailOn;
+    PropertyInt levelOfDetailCoarsePixelSize;
+    PropertyInt levelOfDetailCullingPixelSize;
+    // Import/Export(settings are created on first access)
+    const Settings_GroupIndex groupId_import;
+    const Settings_GroupIndex groupId_export;
 
 protected:
     void onPropertyChanged(Property* prop) override;
 
 private:
+    void initImportGroup();
+    void initExportGroup();
+    // Settings aren't thread-safe, groups are initialized in the thread of the application
+    void initImportExportParameters() const;
+
     Application* m_app = nullptr;
+    mutable std::atomic<bool> m_isImportExportParametersInitialized = false;
     std::vector<std::unique_ptr<PropertyGroup>> m_vecPtrPropertyGroup;
     std::unordered_map<QByteArray, PropertyGroup*> m_mapFormatReaderParameters;
     std::unordered_map<QByteArray, PropertyGroup*> m_mapFormatWriterParameters;
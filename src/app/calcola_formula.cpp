@@ -3,44 +3,213 @@
 ** All rights reserved.
 ** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
 ****************************************************************************/
-/*
+
 #include "calcola_formula.h"
 
-#include "ui_dialog_about.h"
-#include "version.h"
-#include <Standard_Version.hxx>
-#ifdef HAVE_GMIO
-#  include <gmio_core/version.h>
-#endif
+#include "../base/application.h"
+#include "../base/caf_utils.h"
+#include "../base/document.h"
+#include "../base/string_utils.h"
+#include "app_module.h"
+#include "ui_calcola_formula.h"
+
+#include <QtCore/QTimer>
+#include <algorithm>
 
 namespace Mayo {
 
-calcola_formula::calcola_formula(QWidget *parent)
+namespace Internal {
+
+// Rows displayed in the table, statistics are computed on all the rows
+const int MaxDisplayedRowCount = 1000;
+
+} // namespace Internal
+
+struct calcola_formula::EvaluationData {
+    std::shared_ptr<const DocumentFormulaTable> docTable;
+    Formula formula;
+    std::vector<double> vecResult;
+    bool isComplete = false;
+};
+
+calcola_formula::calcola_formula(QWidget* parent)
     : QDialog(parent),
       m_ui(new Ui_calcola_formula)
 {
     m_ui->setupUi(this);
-    m_ui->label_AppByOrg->setText(
-                tr("%1 By %2").arg(QApplication::applicationName(),
-                                   QApplication::organizationName()));
-
-    m_ui->label_Version->setText(
-                m_ui->label_Version->text().arg(strVersion).arg(QT_POINTER_SIZE * 8));
-    m_ui->label_BuildDateTime->setText(
-                m_ui->label_BuildDateTime->text().arg(__DATE__).arg(__TIME__));
-    m_ui->label_Qt->setText(m_ui->label_Qt->text().arg(QT_VERSION_STR));
-    m_ui->label_Occ->setText(m_ui->label_Occ->text().arg(OCC_VERSION_COMPLETE));
-#ifdef HAVE_GMIO
-    m_ui->label_Gmio->setText(m_ui->label_Gmio->text().arg(GMIO_VERSION_STR));
-#else
-    m_ui->label_Gmio->hide();
-#endif
+    m_ui->edit_Formula->setEnabled(false);
+    // Task manager signals are emitted from worker threads, so 'ended' is a queued connection
+    QObject::connect(&m_taskMgr, &TaskManager::ended, this, &calcola_formula::onTaskEnded);
+    QObject::connect(
+                m_ui->edit_Formula, &QLineEdit::textChanged,
+                this, &calcola_formula::onFormulaEdited);
+    QObject::connect(
+                m_ui->btn_ColorByValue, &QPushButton::clicked,
+                this, &calcola_formula::onColorByValue);
 }
 
-DialogAbout::~DialogAbout()
+calcola_formula::~calcola_formula()
 {
+    for (TaskId taskId : { m_loadTaskId, m_evalTaskId }) {
+        m_taskMgr.requestAbort(taskId);
+        m_taskMgr.waitForDone(taskId);
+    }
+
     delete m_ui;
 }
 
+void calcola_formula::load(const DocumentPtr& doc)
+{
+    m_doc = doc;
+    // Colors don't change node properties, so they don't trigger any reload
+    auto fnConnectReload = [=](auto signal) {
+        QObject::connect(doc.get(), signal, this, &calcola_formula::scheduleReload);
+    };
+    fnConnectReload(&Document::entityAdded);
+    fnConnectReload(&Document::entityAboutToBeDestroyed);
+    fnConnectReload(&Document::entityShapesChanged);
+    QObject::connect(
+                Application::instance().get(), &Application::documentAboutToClose,
+                this, [=](const DocumentPtr& docClosed) {
+        if (docClosed == m_doc)
+            this->close();
+    });
+    this->reload();
+}
+
+void calcola_formula::reload()
+{
+    m_isReloadPending = false;
+    for (TaskId taskId : { m_loadTaskId, m_evalTaskId })
+        m_taskMgr.requestAbort(taskId);
+
+    // Results refer to tree nodes which may not exist anymore
+    m_evalTaskId = 0;
+    m_evalData.reset();
+    m_ui->tableWidget_Results->setRowCount(0);
+    m_ui->btn_ColorByValue->setEnabled(false);
+    m_ui->edit_Formula->setEnabled(false);
+    m_ui->label_Status->setText(tr("Computing properties of document nodes..."));
+    auto docTable = std::make_shared<DocumentFormulaTable>();
+    const DocumentPtr doc = m_doc;
+    m_loadingDocTable = docTable;
+    m_loadTaskId = m_taskMgr.newTask([=](TaskProgress* progress) {
+        *docTable = DocumentFormulaTable::build(doc, progress);
+    });
+    m_taskMgr.run(m_loadTaskId);
+}
+
+void calcola_formula::scheduleReload()
+{
+    // Entity is removed from the model tree after signal entityAboutToBeDestroyed() is emitted, so
+    // the reload is deferred. Many changes in a row(eg import of several files) trigger one reload
+    if (!m_isReloadPending) {
+        m_isReloadPending = true;
+        QTimer::singleShot(0, this, &calcola_formula::reload);
+    }
+}
+
+void calcola_formula::onFormulaEdited()
+{
+    if (m_evalTaskId != 0)
+        m_taskMgr.requestAbort(m_evalTaskId);
+
+    m_evalTaskId = 0;
+    m_evalData.reset();
+    m_ui->btn_ColorByValue->setEnabled(false);
+    const QString expression = m_ui->edit_Formula->text().trimmed();
+    if (expression.isEmpty()) {
+        m_ui->label_Status->clear();
+        m_ui->tableWidget_Results->setRowCount(0);
+        return;
+    }
+
+    if (!m_docTable)
+        return;
+
+    // Compilation is cheap, only evaluation is done in background
+    const Result<Formula> formula = Formula::compile(expression, m_docTable->table);
+    if (!formula) {
+        m_ui->label_Status->setText(formula.errorText());
+        return;
+    }
+
+    auto evalData = std::make_shared<EvaluationData>();
+    evalData->docTable = m_docTable;
+    evalData->formula = formula.get();
+    m_evalData = evalData;
+    m_evalTaskId = m_taskMgr.newTask([=](TaskProgress* progress) {
+        const FormulaTable& table = evalData->docTable->table;
+        evalData->vecResult.resize(table.rowCount());
+        evalData->isComplete = evalData->formula.evaluate(table, evalData->vecResult, progress);
+    });
+    m_taskMgr.run(m_evalTaskId);
+}
+
+void calcola_formula::onTaskEnded(TaskId taskId)
+{
+    if (taskId == m_loadTaskId) {
+        m_loadTaskId = 0;
+        m_docTable = std::move(m_loadingDocTable);
+        const FormulaTable& table = m_docTable->table;
+        QStringList listColumnName;
+        for (int i = 0; i < table.columnCount(); ++i)
+            listColumnName.push_back(table.columnName(i));
+
+        m_ui->label_Variables->setText(tr("Variables: %1").arg(listColumnName.join(", ")));
+        m_ui->label_Status->clear();
+        m_ui->edit_Formula->setEnabled(true);
+        m_ui->edit_Formula->setFocus();
+        this->onFormulaEdited();
+    }
+    else if (taskId == m_evalTaskId) {
+        m_evalTaskId = 0;
+        if (m_evalData && m_evalData->isComplete)
+            this->showResults(*m_evalData);
+    }
+}
+
+void calcola_formula::onColorByValue()
+{
+    if (!m_evalData || !m_evalData->isComplete)
+        return;
+
+    const int bucketCount = m_ui->spin_BucketCount->value();
+    const auto vecNodeColor = m_evalData->docTable->bucketColors(m_evalData->vecResult, bucketCount);
+    m_doc->changeColors(vecNodeColor);
+}
+
+void calcola_formula::showResults(const EvaluationData& data)
+{
+    const std::vector<double>& vecResult = data.vecResult;
+    const StringUtils::TextOptions textOptions =
+            AppModule::get(Application::instance())->defaultTextOptions();
+    if (!vecResult.empty()) {
+        // Sum only of parts, as assemblies and instances would count the same geometry many times
+        const auto itMinMax = std::minmax_element(vecResult.cbegin(), vecResult.cend());
+        const double sum = data.docTable->sumOfParts(vecResult);
+        m_ui->label_Status->setText(
+                    tr("%1 nodes  Min: %2  Max: %3  Sum of parts: %4")
+                    .arg(vecResult.size())
+                    .arg(StringUtils::text(*itMinMax.first, textOptions))
+                    .arg(StringUtils::text(*itMinMax.second, textOptions))
+                    .arg(StringUtils::text(sum, textOptions)));
+    }
+    else {
+        m_ui->label_Status->setText(tr("No nodes"));
+    }
+
+    m_ui->btn_ColorByValue->setEnabled(!vecResult.empty());
+    const Tree<TDF_Label>& modelTree = m_doc->modelTree();
+    const int rowCount = std::min(int(vecResult.size()), Internal::MaxDisplayedRowCount);
+    m_ui->tableWidget_Results->setRowCount(rowCount);
+    for (int row = 0; row < rowCount; ++row) {
+        const TreeNodeId nodeId = data.docTable->vecTreeNodeId.at(row);
+        const QString name = CafUtils::labelAttrStdName(modelTree.nodeData(nodeId));
+        const QString value = StringUtils::text(vecResult.at(row), textOptions);
+        m_ui->tableWidget_Results->setItem(row, 0, new QTableWidgetItem(name));
+        m_ui->tableWidget_Results->setItem(row, 1, new QTableWidgetItem(value));
+    }
+}
+
 } // namespace Mayo
-*/
@@ -6,18 +6,46 @@
 
 #pragma once
 
+#include "../base/document_formula_table.h"
+#include "../base/document_ptr.h"
+#include "../base/task_manager.h"
+
 #include <QtWidgets/QDialog>
+#include <memory>
 
 namespace Mayo {
 
+// Evaluates a formula over the shape nodes of a document, eg 'volume * density'
+// Node properties are computed in background, again each time entities of the document change,
+// then the formula is compiled and evaluated again each time it's edited
+// Parts can be colored from the bucket their result falls in, eg to color them by area
 class calcola_formula : public QDialog {
     Q_OBJECT
 public:
-    calcola_formula(QWidget *parent = nullptr);
+    calcola_formula(QWidget* parent = nullptr);
     ~calcola_formula();
 
+    void load(const DocumentPtr& doc);
+
 private:
-    //class Ui_calcola_formula* m_ui = nullptr;
+    struct EvaluationData;
+
+    void reload();
+    void scheduleReload();
+    void onFormulaEdited();
+    void onTaskEnded(TaskId taskId);
+    void onColorByValue();
+    void showResults(const EvaluationData& data);
+
+    class Ui_calcola_formula* m_ui = nullptr;
+    DocumentPtr m_doc;
+    TaskManager m_taskMgr;
+    TaskId m_loadTaskId = 0;
+    TaskId m_evalTaskId = 0;
+    bool m_isReloadPending = false;
+    std::shared_ptr<DocumentFormulaTable> m_docTable;
+    std::shared_ptr<DocumentFormulaTable> m_loadingDocTable;
+    std::shared_ptr<EvaluationData> m_evalData;
 };
 
 } // namespace Mayo
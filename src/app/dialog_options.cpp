@@ -201,9 +201,23 @@ QWidget* DialogOptions::createEditor(Property* property, QWidget* parentWidget)
     return widget;
 }
 
+void DialogOptions::addActionButton(const QString& text, const std::function<void()>& fn)
+{
+    auto btn = m_ui->buttonBox->addButton(text, QDialogButtonBox::ActionRole);
+    QObject::connect(btn, &QPushButton::clicked, this, [=]{
+        fn();
+        this->syncEditors();
+    });
+}
+
 void DialogOptions::restoreDefaults()
 {
     m_settings->resetAll();
+    this->syncEditors();
+}
+
+void DialogOptions::syncEditors()
+{
     for (int i = 0; i < m_ui->listWidget_Settings->count(); ++i) {
         QListWidgetItem* listItem = m_ui->listWidget_Settings->item(i);
         QWidget* itemWidget = m_ui->listWidget_Settings->itemWidget(listItem);
@@ -8,6 +8,7 @@
 
 #include "property_editor_factory.h"
 #include <QtWidgets/QDialog>
+#include <functional>
 #include <memory>
 
 namespace Mayo {
@@ -23,9 +24,13 @@ public:
     PropertyEditorFactory* editorFactory() const { return m_editorFactory.get(); }
     void setPropertyEditorFactory(std::unique_ptr<PropertyEditorFactory> editorFactory);
 
+    // Adds a button executing 'fn', editors are synchronized with settings afterwards
+    void addActionButton(const QString& text, const std::function<void()>& fn);
+
 private:
     QWidget* createEditor(Property* property, QWidget* parentWidget) const;
     void restoreDefaults();
+    void syncEditors();
 
     class Ui_DialogOptions* m_ui = nullptr;
     std::unique_ptr<PropertyEditorFactory> m_editorFactory;
@@ -6,6 +6,7 @@
 
 #include "../base/application.h"
 #include "../base/document_tree_node_properties_provider.h"
+#include "../base/io_mayo_doc.h"
 #include "../base/io_occ.h"
 #include "../base/io_system.h"
 #include "../base/settings.h"
@@ -22,6 +23,8 @@
 
 #include <QtCore/QtDebug>
 #include <QtCore/QCommandLineParser>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QStandardPaths>
 #include <QtCore/QTimer>
 #include <QtCore/QTranslator>
 #include <QtWidgets/QApplication>
@@ -70,6 +73,41 @@ static CommandLineArguments processCommandLine()
     return args;
 }
 
+// Measures time spent in the steps of application startup
+// Report is printed only if environment variable MAYO_STARTUP_TRACE is defined
+class StartupTrace {
+public:
+    StartupTrace()
+        : m_isEnabled(qEnvironmentVariableIsSet("MAYO_STARTUP_TRACE"))
+    {
+        m_timer.start();
+    }
+
+    void step(const char* title) {
+        const qint64 elapsed = m_timer.elapsed();
+        if (m_isEnabled)
+            qDebug().noquote() << QString("[startup] %1: %2ms").arg(title).arg(elapsed - m_lastElapsed);
+
+        m_lastElapsed = elapsed;
+    }
+
+    void finish() {
+        const qint64 elapsed = m_timer.elapsed();
+        if (m_isEnabled) {
+            qDebug().noquote() << QString("[startup] Total: %1ms").arg(elapsed);
+            if (elapsed > BudgetMs)
+                qWarning().noquote() << QString("[startup] Budget of %1ms exceeded").arg(BudgetMs);
+        }
+    }
+
+    static constexpr qint64 BudgetMs = 1000;
+
+private:
+    QElapsedTimer m_timer;
+    qint64 m_lastElapsed = 0;
+    bool m_isEnabled = false;
+};
+
 static std::unique_ptr<Theme> globalTheme;
 
 // Declared in theme.h
@@ -80,16 +118,22 @@ Theme* mayoTheme()
 
 static int runApp(QApplication* qtApp)
 {
+    StartupTrace startupTrace;
     const CommandLineArguments args = processCommandLine();
     Application::setOpenCascadeEnvironment("opencascade.conf");
+    startupTrace.step("Command line and OpenCascade environment");
 
     auto app = Application::instance().get();
     auto guiApp = new GuiApplication(app);
 
-    // Register IO OpenCascade objects
+    // Register IO objects
     app->ioSystem()->addFactoryReader(std::make_unique<IO::OccFactoryReader>());
     app->ioSystem()->addFactoryWriter(std::make_unique<IO::OccFactoryWriter>());
+    app->ioSystem()->addFactoryReader(std::make_unique<IO::MayoDocFactoryReader>());
+    app->ioSystem()->addFactoryWriter(std::make_unique<IO::MayoDocFactoryWriter>());
     IO::addPredefinedFormatProbes(app->ioSystem());
+    app->ioSystem()->setImportCache(std::make_unique<IO::ImportCache>(
+                QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/imports"));
 
     // Register Graphics/TreeNode mapping drivers
     guiApp->graphicsTreeNodeMappingDriverTable()->addDriver(
@@ -104,6 +148,9 @@ static int runApp(QApplication* qtApp)
     QObject::connect(
                 guiApp, &GuiApplication::guiDocumentErased,
                 appModule, &AppModule::recordRecentFileThumbnail);
+    QObject::connect(
+                guiApp, &GuiApplication::guiDocumentAdded,
+                appModule, &AppModule::recordRecentFileThumbnailWhenIdle);
 
     // Register document tree node providers
     app->documentTreeNodePropertiesProviderTable()->addProvider(
@@ -114,6 +161,7 @@ static int runApp(QApplication* qtApp)
     // Register WidgetModelTreeBuilter prototypes
     WidgetModelTree::addPrototypeBuilder(std::make_unique<WidgetModelTreeBuilder_Mesh>());
     WidgetModelTree::addPrototypeBuilder(std::make_unique<WidgetModelTreeBuilder_Xde>());
+    startupTrace.step("Registration of modules");
 
     // Create theme
     globalTheme.reset(createTheme(args.themeName));
@@ -123,6 +171,7 @@ static int runApp(QApplication* qtApp)
         return -1;
     }
     mayoTheme()->setup();
+    startupTrace.step("Theme setup");
 
     // Load translation files before UI creation
     {
@@ -134,18 +183,24 @@ static int runApp(QApplication* qtApp)
         else
             std::cerr << qUtf8Printable(Main::tr("Failed to load translation for '%1'").arg(qmFilePath)) << std::endl;
     }
+    startupTrace.step("Translation loading");
 
     // Create MainWindow
     app->settings()->loadProperty(app->settings()->findProperty(&appModule->recentFiles));
+    appModule->migrateRecentFileThumbnails();
     MainWindow mainWindow(guiApp);
     mainWindow.setWindowTitle(QApplication::applicationName());
     mainWindow.show();
+    startupTrace.step("MainWindow creation");
+    QTimer::singleShot(0, [&]{ startupTrace.finish(); }); // Event loop started
     if (!args.listFileToOpen.empty()) {
         QTimer::singleShot(0, [&]{ mainWindow.openDocumentsFromList(args.listFileToOpen); });
     }
 
+    // Import/export settings groups are initialized and loaded on first access
     app->settings()->resetAll();
     app->settings()->load();
+    startupTrace.step("Settings loading");
     const int code = qtApp->exec();
     appModule->recordRecentFileThumbnails(guiApp);
     app->settings()->save();
@@ -10,6 +10,7 @@
 #include "../base/application.h"
 #include "../base/application_item_selection_model.h"
 #include "../base/document.h"
+#include "../base/io_file_scan.h"
 #include "../base/io_format.h"
 #include "../base/io_system.h"
 #include "../base/messenger.h"
@@ -21,6 +22,7 @@
 #include "../gui/gui_document.h"
 #include "../gui/gui_document_list_model.h"
 #include "app_module.h"
+#include "calcola_formula.h"
 #include "dialog_about.h"
 #include "dialog_inspect_xde.h"
 #include "dialog_options.h"
@@ -50,6 +52,9 @@
 #include <QtGui/QDesktopServices>
 #include <QtGui/QDragEnterEvent>
 #include <QtGui/QDropEvent>
+#include <QtGui/QGuiApplication>
+#include <QtGui/QScreen>
+#include <QtGui/QWindow>
 #include <QtWidgets/QActionGroup>
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QFileDialog>
@@ -297,6 +302,9 @@ MainWindow::MainWindow(GuiApplication* guiApp, QWidget *parent)
     QObject::connect(
                 m_ui->actionInspectXDE, &QAction::triggered,
                 this, &MainWindow::inspectXde);
+    QObject::connect(
+                m_ui->actionEvaluateFormula, &QAction::triggered,
+                this, &MainWindow::evaluateFormula);
     QObject::connect(
                 m_ui->actionOptions, &QAction::triggered,
                 this, &MainWindow::editOptions);
@@ -701,7 +709,10 @@ void MainWindow::zoomOutCurrentDoc()
 
 void MainWindow::editOptions()
 {
+    auto appModule = AppModule::get(m_guiApp->application());
+    appModule->updateImportCacheUsage();
     auto dlg = new DialogOptions(m_guiApp->application()->settings(), this);
+    dlg->addActionButton(tr("Clear Import Cache"), [=]{ appModule->clearImportCache(); });
     qtgui::QWidgetUtils::asyncDialogExec(dlg);
 }
 
@@ -730,6 +741,24 @@ void MainWindow::inspectXde()
     }
 }
 
+void MainWindow::evaluateFormula()
+{
+    const Span<const ApplicationItem> spanAppItem = m_guiApp->selectionModel()->selectedItems();
+    DocumentPtr xcafDoc;
+    for (const ApplicationItem& appItem : spanAppItem) {
+        if (appItem.document()->isXCafDocument()) {
+            xcafDoc = appItem.document();
+            break;
+        }
+    }
+
+    if (!xcafDoc.IsNull()) {
+        auto dlg = new calcola_formula(this);
+        dlg->load(xcafDoc);
+        qtgui::QWidgetUtils::asyncDialogExec(dlg);
+    }
+}
+
 void MainWindow::toggleFullscreen()
 {
     if (this->isFullScreen()) {
@@ -832,10 +861,41 @@ void MainWindow::onGuiDocumentAdded(GuiDocument* guiDoc)
     }
 
     V3dViewController* ctrl = widget->controller();
+    GraphicsScene* gfxScene = guiDoc->graphicsScene();
+    // Highlighting is paced by the refresh rate of the screen showing the view(ie the one of the
+    // main window), which can change when the window is moved
+    auto fnSetHighlightFrameInterval = [=](const QScreen* screen) {
+        if (screen && screen->refreshRate() > 0)
+            gfxScene->setHighlightFrameInterval(qRound(1000. / screen->refreshRate()));
+    };
+    const QWindow* window = this->windowHandle();
+    fnSetHighlightFrameInterval(window ? window->screen() : QGuiApplication::primaryScreen());
+    if (window)
+        QObject::connect(window, &QWindow::screenChanged, gfxScene, fnSetHighlightFrameInterval);
+
     QObject::connect(ctrl, &V3dViewController::mouseMoved, [=](const QPoint& pos2d) {
-        guiDoc->graphicsScene()->highlightAt(pos2d, widget->guiDocument()->v3dView());
-        auto selector = guiDoc->graphicsScene()->mainSelector();
-        selector->Pick(pos2d.x(), pos2d.y(), guiDoc->v3dView());
+        gfxScene->requestHighlightAt(pos2d, guiDoc->v3dView());
+    });
+    QObject::connect(ctrl, &V3dViewController::dynamicActionStarted, [=]{
+        gfxScene->setHighlightSuspended(true);
+    });
+    QObject::connect(ctrl, &V3dViewController::dynamicActionEnded, [=]{
+        gfxScene->setHighlightSuspended(false);
+    });
+    auto fnSelectArea = [=](const QPolygon& area) {
+        std::vector<ApplicationItem> vecItem;
+        for (const DocumentTreeNode& treeNode : guiDoc->findTreeNodesInsideArea(area))
+            vecItem.emplace_back(treeNode);
+
+        m_guiApp->selectionModel()->setSelectedItems(vecItem);
+    };
+    QObject::connect(ctrl, &V3dViewController::boxSelected, [=](const QRect& rect) {
+        fnSelectArea(QPolygon(rect, true));
+    });
+    QObject::connect(ctrl, &V3dViewController::lassoSelected, fnSelectArea);
+    QObject::connect(gfxScene, &GraphicsScene::highlightedAt, [=](const QPoint& pos2d) {
+        // Picking results of the highlight are still in the selector, no need to pick again
+        auto selector = gfxScene->mainSelector();
         const gp_Pnt pos3d =
                 selector->NbPicked() > 0 ?
                     selector->PickedPoint(1) :
@@ -944,10 +1004,10 @@ void MainWindow::closeCurrentDocument()
 void MainWindow::closeDocument(WidgetGuiDocument* widget)
 {
     if (widget) {
-        const DocumentPtr& doc = widget->guiDocument()->document();
+        const DocumentPtr doc = widget->guiDocument()->document();
         m_ui->stack_GuiDocuments->removeWidget(widget);
         widget->deleteLater();
-        m_guiApp->application()->closeDocument(doc);
+        m_guiApp->application()->closeDocumentInBackground(doc, TaskManager::globalInstance());
         this->updateControlsActivation();
     }
 }
@@ -988,6 +1048,13 @@ void MainWindow::openDocumentsFromList(const QStringList& listFilePath)
         if (docPtr.IsNull()) {
             const QString locAbsoluteFilePath = QDir::toNativeSeparators(loc.absoluteFilePath());
             const TaskId taskId = taskMgr->newTask([=](TaskProgress* progress) {
+                // Summary of the file contents is reported before the possibly long import, scan
+                // is bounded by its time budget
+                const IO::Format format = app->ioSystem()->probeFormat(locAbsoluteFilePath);
+                const IO::FileScan scan = IO::scanFile(locAbsoluteFilePath, format);
+                if (scan.isValid())
+                    Messenger::defaultInstance()->emitInfo(loc.fileName() + "\n" + scan.summaryText());
+
                 QTime chrono;
                 chrono.start();
                 DocumentPtr doc;
@@ -1054,6 +1121,7 @@ void MainWindow::updateControlsActivation()
                 spanSelectedAppItem.size() == 1
                 && firstAppItem.isValid()
                 && firstAppItem.document()->isXCafDocument());
+    m_ui->actionEvaluateFormula->setEnabled(m_ui->actionInspectXDE->isEnabled());
 }
 
 int MainWindow::currentDocumentIndex() const
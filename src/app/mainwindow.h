@@ -50,6 +50,7 @@ private:
     void editOptions();
     void saveImageView();
     void inspectXde();
+    void evaluateFormula();
     void toggleFullscreen();
     void toggleLeftSidebar();
     void aboutMayo();
@@ -320,6 +320,9 @@ QWidget* DefaultPropertyEditorFactory::createEditor(Property* property, QWidget*
     if (propTypeName == BasePropertyQuantity::TypeName)
         editor = new PropertyQuantityEditor(static_cast<BasePropertyQuantity*>(property), parentWidget);
 
+    if (editor && property->isUserReadOnly())
+        editor->setEnabled(false);
+
     this->syncEditorWithProperty(editor);
     return editor;
 }
@@ -6,7 +6,6 @@
 
 #include "recent_files.h"
 
-#include "occt_window.h"
 #include "theme.h"
 #include "../graphics/graphics_utils.h"
 #include "../gui/gui_document.h"
@@ -14,12 +13,49 @@
 #include <fougtools/occtools/qt_utils.h>
 #include <gsl/gsl_util>
 
+#include <Aspect_NeutralWindow.hxx>
+#include <QtCore/QCryptographicHash>
 #include <QtCore/QDateTime>
+#include <QtCore/QDir>
 #include <QtCore/QFileInfo>
-#include <QtWidgets/QWidget>
+#include <QtCore/QStandardPaths>
 
 namespace Mayo {
 
+namespace {
+
+QByteArray thumbnailCacheKey(const QString& filepath)
+{
+    const QByteArray absFilepath = QFileInfo(filepath).absoluteFilePath().toUtf8();
+    return QCryptographicHash::hash(absFilepath, QCryptographicHash::Sha1).toHex();
+}
+
+// Removes from the disk cache the thumbnails of 'filepath' other than 'keepFilePath'
+void removeStaleThumbnails(const QString& filepath, const QString& keepFilePath)
+{
+    const QDir cacheDir(RecentFile::thumbnailCacheDirPath());
+    const QString filter = QString::fromLatin1(thumbnailCacheKey(filepath)) + "_*.png";
+    for (const QFileInfo& fi : cacheDir.entryInfoList({ filter }, QDir::Files)) {
+        if (fi != QFileInfo(keepFilePath))
+            QFile::remove(fi.absoluteFilePath());
+    }
+}
+
+bool saveThumbnail(const RecentFile& recentFile, const QImage& img)
+{
+    if (!QDir().mkpath(RecentFile::thumbnailCacheDirPath()))
+        return false;
+
+    const QString cacheFilePath = recentFile.thumbnailCacheFilePath();
+    if (!img.save(cacheFilePath, "PNG"))
+        return false;
+
+    removeStaleThumbnails(recentFile.filepath, cacheFilePath);
+    return true;
+}
+
+} // namespace
+
 bool RecentFile::recordThumbnail(GuiDocument* guiDoc, QSize size)
 {
     if (!guiDoc)
@@ -29,55 +65,67 @@ bool RecentFile::recordThumbnail(GuiDocument* guiDoc, QSize size)
     if (fileInfo != QFileInfo(guiDoc->document()->filePath()))
         return false;
 
-    const int64_t lastModifiedTimestamp = fileInfo.lastModified().toSecsSinceEpoch();
-    if (this->thumbnailTimestamp != lastModifiedTimestamp) {
-        const GuiDocument::ViewTrihedronMode onEntryTrihedronMode = guiDoc->viewTrihedronMode();
-        const bool onEntryOriginTrihedronVisible = guiDoc->isOriginTrihedronVisible();
-        const QColor backgroundColor = mayoTheme()->color(Theme::Color::Palette_Window);
-        Handle_V3d_View view = guiDoc->graphicsScene()->createV3dView();
-        view->ChangeRenderingParams().IsAntialiasingEnabled = true;
-        view->ChangeRenderingParams().NbMsaaSamples = 4;
-        view->SetBackgroundColor(occ::QtUtils::toOccColor(backgroundColor));
-
-        auto _ = gsl::finally([=]{
-            guiDoc->graphicsScene()->v3dViewer()->SetViewOff(view);
-            guiDoc->setViewTrihedronMode(onEntryTrihedronMode);
-            if (guiDoc->isOriginTrihedronVisible() != onEntryOriginTrihedronVisible)
-                guiDoc->toggleOriginTrihedronVisibility();
+    if (!this->isThumbnailOutOfSync())
+        return true;
+
+    // Render offscreen, the virtual window just borrows the native window of the document view to
+    // get a graphics context. Image is then rendered into a framebuffer object by ToPixMap()
+    const Handle_V3d_View& guiDocView = guiDoc->v3dView();
+    if (guiDocView.IsNull() || guiDocView->Window().IsNull())
+        return false;
+
+    GraphicsScene* gfxScene = guiDoc->graphicsScene();
+    const QColor backgroundColor = mayoTheme()->color(Theme::Color::Palette_Window);
+    Handle_V3d_View view = gfxScene->createV3dView();
+    view->ChangeRenderingParams().IsAntialiasingEnabled = true;
+    view->ChangeRenderingParams().NbMsaaSamples = 4;
+    view->SetBackgroundColor(occ::QtUtils::toOccColor(backgroundColor));
+    auto _ = gsl::finally([=]{
+        // Identifier of the view is reused by next created views, which would inherit the affinity
+        gfxScene->foreachDisplayedObject([=](const GraphicsObjectPtr& object) {
+            gfxScene->setObjectVisibleInView(object, view, true);
         });
+        gfxScene->v3dViewer()->SetViewOff(view);
+        view->Remove();
+    });
+
+    Handle_Aspect_NeutralWindow wnd = new Aspect_NeutralWindow;
+    wnd->SetVirtual(true);
+    wnd->SetNativeHandle(guiDocView->Window()->NativeHandle());
+    wnd->SetSize(size.width(), size.height());
+    view->SetWindow(wnd);
+
+    // Show only document entities(no trihedron, view cube, ...), state of GuiDocument is left as is
+    gfxScene->foreachDisplayedObject([=](const GraphicsObjectPtr& object) {
+        gfxScene->setObjectVisibleInView(object, view, guiDoc->isGraphicsEntityObject(object));
+    });
+
+    view->MustBeResized();
+    GraphicsUtils::V3dView_fitAll(view);
+
+    Image_PixMap pixmap;
+    pixmap.SetTopDown(true);
+    V3d_ImageDumpOptions dumpOptions;
+    dumpOptions.BufferType = Graphic3d_BT_RGB;
+    dumpOptions.Width = size.width();
+    dumpOptions.Height = size.height();
+    const bool ok = view->ToPixMap(pixmap, dumpOptions);
+    if (!ok)
+        return false;
+
+    const QImage img(pixmap.Data(),
+                     int(pixmap.Width()),
+                     int(pixmap.Height()),
+                     int(pixmap.SizeRowBytes()),
+                     QImage::Format_RGB888);
+    if (img.isNull())
+        return false;
 
-        guiDoc->graphicsScene()->clearSelection();
-        guiDoc->setViewTrihedronMode(GuiDocument::ViewTrihedronMode::None);
-        if (guiDoc->isOriginTrihedronVisible())
-            guiDoc->toggleOriginTrihedronVisibility();
-
-        QWidget widgetView; // TODO Use a pure offscreen window instead
-        Handle_Aspect_Window hWnd = new OcctWindow(&widgetView);
-        view->SetWindow(hWnd);
-        view->MustBeResized();
-        GraphicsUtils::V3dView_fitAll(view);
-        view->Redraw();
-
-        Image_PixMap pixmap;
-        pixmap.SetTopDown(true);
-        V3d_ImageDumpOptions dumpOptions;
-        dumpOptions.BufferType = Graphic3d_BT_RGB;
-        dumpOptions.Width = size.width();
-        dumpOptions.Height = size.height();
-        bool ok = view->ToPixMap(pixmap, dumpOptions);
-        if (!ok)
-            return false;
-
-        const QImage img(pixmap.Data(),
-                         int(pixmap.Width()),
-                         int(pixmap.Height()),
-                         int(pixmap.SizeRowBytes()),
-                         QImage::Format_RGB888);
-        if (img.isNull())
-            return false;
-
-        this->thumbnail = QPixmap::fromImage(img);
-        this->thumbnailTimestamp = lastModifiedTimestamp;
+    const int64_t onEntryTimestamp = this->thumbnailTimestamp;
+    this->thumbnailTimestamp = fileInfo.lastModified().toSecsSinceEpoch();
+    if (!saveThumbnail(*this, img)) {
+        this->thumbnailTimestamp = onEntryTimestamp;
+        return false;
     }
 
     return true;
@@ -87,20 +135,49 @@ bool RecentFile::isThumbnailOutOfSync() const
 {
     const QFileInfo fileInfo(this->filepath);
     const int64_t lastModifiedTimestamp = fileInfo.lastModified().toSecsSinceEpoch();
-    return this->thumbnailTimestamp != lastModifiedTimestamp;
+    return this->thumbnailTimestamp != lastModifiedTimestamp
+            || !QFileInfo::exists(this->thumbnailCacheFilePath());
+}
+
+QPixmap RecentFile::loadThumbnail() const
+{
+    return QPixmap(this->thumbnailCacheFilePath(), "PNG");
+}
+
+QString RecentFile::thumbnailCacheFilePath() const
+{
+    return QString("%1/%2_%3.png")
+            .arg(RecentFile::thumbnailCacheDirPath())
+            .arg(QString::fromLatin1(thumbnailCacheKey(this->filepath)))
+            .arg(this->thumbnailTimestamp);
+}
+
+bool RecentFile::migrateLegacyThumbnail()
+{
+    if (this->legacyThumbnail.isNull())
+        return false;
+
+    if (!QFileInfo::exists(this->thumbnailCacheFilePath()))
+        saveThumbnail(*this, this->legacyThumbnail.toImage());
+
+    this->legacyThumbnail = QPixmap();
+    return true;
+}
+
+QString RecentFile::thumbnailCacheDirPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/thumbnails";
 }
 
 bool operator==(const RecentFile& lhs, const RecentFile& rhs)
 {
-    return lhs.filepath == rhs.filepath
-            && lhs.thumbnail.cacheKey() == rhs.thumbnail.cacheKey()
-            && lhs.thumbnailTimestamp == rhs.thumbnailTimestamp;
+    return lhs.filepath == rhs.filepath && lhs.thumbnailTimestamp == rhs.thumbnailTimestamp;
 }
 
 QDataStream& operator<<(QDataStream& stream, const RecentFile& recentFile)
 {
     stream << recentFile.filepath;
-    stream << recentFile.thumbnail;
+    stream << QPixmap(); // Thumbnail used to be stored here, kept for compatibility
     stream << recentFile.thumbnailTimestamp;
     return stream;
 }
@@ -108,7 +185,7 @@ QDataStream& operator<<(QDataStream& stream, const RecentFile& recentFile)
 QDataStream& operator>>(QDataStream& stream, RecentFile& recentFile)
 {
     stream >> recentFile.filepath;
-    stream >> recentFile.thumbnail;
+    stream >> recentFile.legacyThumbnail;
     stream >> recentFile.thumbnailTimestamp;
     return stream;
 }
@@ -18,12 +18,21 @@ namespace Mayo {
 
 class GuiDocument;
 
+// Thumbnails are not stored within RecentFile objects but in a disk cache, where entries are keyed
+// by file path and last modification time(see thumbnailCacheFilePath())
 struct RecentFile {
     QString filepath;
-    QPixmap thumbnail;
     int64_t thumbnailTimestamp = 0;
+    // Thumbnail read from a stream written by previous versions, not written back
+    QPixmap legacyThumbnail;
     bool recordThumbnail(GuiDocument* guiDoc, QSize size);
     bool isThumbnailOutOfSync() const;
+    QPixmap loadThumbnail() const;
+    QString thumbnailCacheFilePath() const;
+    // Moves 'legacyThumbnail' into the disk cache. Returns false if there was nothing to migrate
+    bool migrateLegacyThumbnail();
+
+    static QString thumbnailCacheDirPath();
 };
 
 using RecentFiles = std::vector<RecentFile>;
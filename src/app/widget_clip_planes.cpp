@@ -9,25 +9,45 @@
 #include "../base/application.h"
 #include "../base/bnd_utils.h"
 #include "../base/math_utils.h"
+#include "../base/mesh_utils.h"
 #include "../base/settings.h"
+#include "../base/string_utils.h"
 #include "../base/tkernel_utils.h"
+#include "../base/unit_system.h"
 #include "../graphics/graphics_utils.h"
+#include "../gui/gui_document.h"
 #include "app_module.h"
 #include "ui_widget_clip_planes.h"
 
 #include <algorithm>
+#include <atomic>
 #include <QtCore/QFile>
+#include <AIS_Shape.hxx>
+#include <BRep_Builder.hxx>
 #include <Bnd_Box.hxx>
 #include <Graphic3d_ClipPlane.hxx>
 #include <Graphic3d_Texture2Dmanual.hxx>
 #include <Image_AlienPixMap.hxx>
+#include <OSD_Parallel.hxx>
+#include <Prs3d_Drawer.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS_Compound.hxx>
 
 namespace Mayo {
 
-WidgetClipPlanes::WidgetClipPlanes(const Handle_V3d_View& view3d, QWidget* parent)
+// Input and output of a background computation of clip plane sections
+struct WidgetClipPlanes::SectionTaskData {
+    std::vector<gp_Pln> vecPlane;
+    std::vector<TopoDS_Shape> vecSolid;
+    std::vector<ShapeSection> vecSection; // Index is 'iPlane * vecSolid.size() + iSolid'
+    std::atomic<bool> isComplete = {};
+};
+
+WidgetClipPlanes::WidgetClipPlanes(GuiDocument* guiDoc, QWidget* parent)
     : QWidget(parent),
       m_ui(new Ui_WidgetClipPlanes),
-      m_view(view3d)
+      m_guiDoc(guiDoc),
+      m_view(guiDoc->v3dView())
 {
     m_ui->setupUi(this);
     this->createPlaneCappingTexture();
@@ -99,10 +119,28 @@ WidgetClipPlanes::WidgetClipPlanes(const Handle_V3d_View& view3d, QWidget* paren
         }
     });
     m_ui->widget_CustomDir->setVisible(false);
+
+    // Task manager signals are emitted from worker threads, so 'ended' is a queued connection
+    QObject::connect(
+                &m_sectionTaskMgr, &TaskManager::ended,
+                this, &WidgetClipPlanes::onSectionTaskEnded);
+    QObject::connect(
+                m_ui->check_Section, &QAbstractButton::clicked,
+                this, &WidgetClipPlanes::setSectionOn);
+    QObject::connect(m_guiDoc, &QObject::destroyed, this, [=]{
+        this->abortSectionTasks();
+        m_vecSectionObject.clear();
+        m_guiDoc = nullptr;
+    });
 }
 
 WidgetClipPlanes::~WidgetClipPlanes()
 {
+    this->abortSectionTasks();
+    for (const auto& mapPair : m_mapSectionTask)
+        m_sectionTaskMgr.waitForDone(mapPair.first);
+
+    this->eraseSection();
     delete m_ui;
 }
 
@@ -119,6 +157,10 @@ void WidgetClipPlanes::setRanges(const Bnd_Box& bndBox)
             data.ui.check_On->setChecked(false);
     }
 
+    m_ui->check_Section->setEnabled(!isBndBoxVoid);
+    // Shapes may have changed, cached sections of erased shapes are useless now
+    m_sectionCache.clear();
+    this->requestSectionUpdate();
     m_view->Redraw();
 }
 
@@ -127,9 +169,25 @@ void WidgetClipPlanes::setClippingOn(bool on)
     for (ClipPlaneData& data : m_vecClipPlaneData)
         data.graphics->SetOn(on ? data.ui.check_On->isChecked() : false);
 
+    this->requestSectionUpdate();
     m_view->Redraw();
 }
 
+bool WidgetClipPlanes::isSectionOn() const
+{
+    return m_ui->check_Section->isChecked();
+}
+
+void WidgetClipPlanes::setSectionOn(bool on)
+{
+    {
+        QSignalBlocker sigBlock(m_ui->check_Section); Q_UNUSED(sigBlock);
+        m_ui->check_Section->setChecked(on);
+    }
+
+    this->requestSectionUpdate();
+}
+
 void WidgetClipPlanes::connectUi(ClipPlaneData* data)
 {
     UiClipPlane& ui = data->ui;
@@ -141,6 +199,7 @@ void WidgetClipPlanes::connectUi(ClipPlaneData* data)
     QObject::connect(ui.check_On, &QCheckBox::clicked, [=](bool on) {
         ui.widget_Control->setEnabled(on);
         this->setPlaneOn(gfx, on);
+        this->requestSectionUpdate();
         m_view->Redraw();
     });
 
@@ -165,6 +224,7 @@ void WidgetClipPlanes::connectUi(ClipPlaneData* data)
         const double dPct = ui.spinValueToSliderValue(pos);
         posSlider->setValue(qRound(dPct));
         GraphicsUtils::Gpx3dClipPlane_setPosition(gfx, pos);
+        this->requestSectionUpdate();
         m_view->Redraw();
     });
 
@@ -173,6 +233,7 @@ void WidgetClipPlanes::connectUi(ClipPlaneData* data)
         QSignalBlocker sigBlock(posSpin); Q_UNUSED(sigBlock);
         posSpin->setValue(pos);
         GraphicsUtils::Gpx3dClipPlane_setPosition(gfx, pos);
+        this->requestSectionUpdate();
         m_view->Redraw();
     });
 
@@ -180,6 +241,7 @@ void WidgetClipPlanes::connectUi(ClipPlaneData* data)
         const gp_Dir invNormal = gfx->ToPlane().Axis().Direction().Reversed();
         GraphicsUtils::Gpx3dClipPlane_setNormal(gfx, invNormal);
         GraphicsUtils::Gpx3dClipPlane_setPosition(gfx, data->ui.posSpin()->value());
+        this->requestSectionUpdate();
         m_view->Redraw();
     });
 
@@ -198,6 +260,7 @@ void WidgetClipPlanes::connectUi(ClipPlaneData* data)
                 const auto bbc = BndBoxCoords::get(m_bndBox);
                 this->setPlaneRange(data, MathUtils::planeRange(bbc, normal));
                 GraphicsUtils::Gpx3dClipPlane_setNormal(gfx, normal);
+                this->requestSectionUpdate();
                 m_view->Redraw();
             }
         });
@@ -248,6 +311,141 @@ void WidgetClipPlanes::setPlaneRange(ClipPlaneData* data, const Range& range)
     }
 }
 
+void WidgetClipPlanes::requestSectionUpdate()
+{
+    // Sections being computed are now stale, only the latest request is relevant
+    this->abortSectionTasks();
+    if (!m_guiDoc)
+        return;
+
+    auto taskData = std::make_shared<SectionTaskData>();
+    if (this->isSectionOn()) {
+        for (const ClipPlaneData& data : m_vecClipPlaneData) {
+            if (data.graphics->IsOn())
+                taskData->vecPlane.push_back(data.graphics->ToPlane());
+        }
+
+        m_guiDoc->graphicsScene()->foreachDisplayedObject([&](const GraphicsObjectPtr& object) {
+            auto aisShape = Handle_AIS_Shape::DownCast(object);
+            if (!aisShape.IsNull() && m_guiDoc->isGraphicsEntityObject(object)) {
+                for (TopExp_Explorer expl(aisShape->Shape(), TopAbs_SOLID); expl.More(); expl.Next())
+                    taskData->vecSolid.push_back(expl.Current());
+            }
+        });
+    }
+
+    if (taskData->vecPlane.empty() || taskData->vecSolid.empty()) {
+        this->eraseSection();
+        m_ui->label_SectionInfo->clear();
+        m_view->Redraw();
+        return;
+    }
+
+    const TaskId taskId = m_sectionTaskMgr.newTask([=](TaskProgress* progress) {
+        // Bounding boxes of mesh solids need their triangulations, which loading may have been
+        // deferred by the reader(eg glTF)
+        for (const TopoDS_Shape& solid : taskData->vecSolid)
+            MeshUtils::loadDeferredTriangulations(solid);
+
+        const int solidCount = int(taskData->vecSolid.size());
+        const int sectionCount = int(taskData->vecPlane.size()) * solidCount;
+        taskData->vecSection.resize(sectionCount);
+        OSD_Parallel::For(0, sectionCount, [=](int i) {
+            if (progress->isAbortRequested())
+                return;
+
+            const gp_Pln& plane = taskData->vecPlane.at(i / solidCount);
+            const TopoDS_Shape& solid = taskData->vecSolid.at(i % solidCount);
+            taskData->vecSection.at(i) = m_sectionCache.get(solid, plane);
+        });
+        taskData->isComplete = !progress->isAbortRequested();
+    });
+    m_mapSectionTask.insert({ taskId, taskData });
+    m_sectionTaskMgr.run(taskId);
+}
+
+void WidgetClipPlanes::abortSectionTasks()
+{
+    for (const auto& mapPair : m_mapSectionTask)
+        m_sectionTaskMgr.requestAbort(mapPair.first);
+}
+
+void WidgetClipPlanes::onSectionTaskEnded(TaskId taskId)
+{
+    auto itFound = m_mapSectionTask.find(taskId);
+    if (itFound == m_mapSectionTask.end())
+        return;
+
+    const std::shared_ptr<SectionTaskData> taskData = itFound->second;
+    m_mapSectionTask.erase(itFound);
+    // Tasks may end in any order, never replace a section by an older one
+    if (taskData->isComplete && taskId > m_displayedSectionTaskId && this->isSectionOn()) {
+        m_displayedSectionTaskId = taskId;
+        this->displaySection(*taskData);
+    }
+}
+
+void WidgetClipPlanes::displaySection(const SectionTaskData& taskData)
+{
+    if (!m_guiDoc)
+        return;
+
+    this->eraseSection();
+    GraphicsScene* gfxScene = m_guiDoc->graphicsScene();
+    const size_t solidCount = taskData.vecSolid.size();
+    // Section faces lie exactly on the clip plane, so they are slightly moved towards the kept
+    // half-space(along plane normal) to not be clipped themselves
+    const double offset = m_bndBox.IsVoid() ? 0. : std::sqrt(m_bndBox.SquareExtent()) * 1e-5;
+    double area = 0.;
+    for (size_t iPlane = 0; iPlane < taskData.vecPlane.size(); ++iPlane) {
+        TopoDS_Compound compSection;
+        BRep_Builder builder;
+        builder.MakeCompound(compSection);
+        bool isSectionEmpty = true;
+        for (size_t iSolid = 0; iSolid < solidCount; ++iSolid) {
+            const ShapeSection& section = taskData.vecSection.at(iPlane * solidCount + iSolid);
+            if (!section.faces.IsNull()) {
+                builder.Add(compSection, section.faces);
+                area += section.area;
+                isSectionEmpty = false;
+            }
+        }
+
+        if (isSectionEmpty)
+            continue;
+
+        Handle_AIS_Shape gfxSection = new AIS_Shape(compSection);
+        gp_Trsf trsfOffset;
+        trsfOffset.SetTranslation(offset * gp_Vec(taskData.vecPlane.at(iPlane).Axis().Direction()));
+        gfxSection->SetLocalTransformation(trsfOffset);
+        gfxSection->SetDisplayMode(AIS_Shaded);
+        gfxSection->SetColor(Quantity_NOC_ORANGE);
+        gfxSection->Attributes()->SetFaceBoundaryDraw(true);
+        gfxScene->addObject(gfxSection);
+        gfxScene->deactivateObjectSelection(gfxSection, 0);
+        m_vecSectionObject.push_back(gfxSection);
+    }
+
+    const auto appModule = AppModule::get(Application::instance());
+    const auto unitSchema = appModule->unitSystemSchema.valueAs<UnitSystem::Schema>();
+    const auto trRes = UnitSystem::translate(unitSchema, area * Quantity_SquaredMillimeter);
+    m_ui->label_SectionInfo->setText(
+                tr("Area: %1%2")
+                .arg(StringUtils::text(trRes.value, appModule->defaultTextOptions()))
+                .arg(QString::fromUtf8(trRes.strUnit)));
+    gfxScene->redraw();
+}
+
+void WidgetClipPlanes::eraseSection()
+{
+    if (m_guiDoc) {
+        for (const GraphicsObjectPtr& object : m_vecSectionObject)
+            m_guiDoc->graphicsScene()->eraseObject(object);
+    }
+
+    m_vecSectionObject.clear();
+}
+
 void WidgetClipPlanes::createPlaneCappingTexture()
 {
     if (!m_textureCapping.IsNull())
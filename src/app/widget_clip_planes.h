@@ -6,11 +6,17 @@
 
 #pragma once
 
+#include "../base/shape_section.h"
+#include "../base/task_manager.h"
+#include "../graphics/graphics_object_ptr.h"
+
 #include <QtWidgets/QWidget>
 #include <Bnd_Box.hxx>
 #include <Graphic3d_ClipPlane.hxx>
 #include <Graphic3d_TextureMap.hxx>
 #include <V3d_View.hxx>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 class QCheckBox;
 class QDoubleSpinBox;
@@ -19,15 +25,21 @@ class QAbstractButton;
 
 namespace Mayo {
 
+class GuiDocument;
+
 class WidgetClipPlanes : public QWidget {
     Q_OBJECT
 public:
-    WidgetClipPlanes(const Handle_V3d_View& view3d, QWidget* parent = nullptr);
+    WidgetClipPlanes(GuiDocument* guiDoc, QWidget* parent = nullptr);
     ~WidgetClipPlanes();
 
     void setRanges(const Bnd_Box& box);
     void setClippingOn(bool on);
 
+    // Exact sections of the visible solids by the active clip planes, computed in background
+    bool isSectionOn() const;
+    void setSectionOn(bool on);
+
 private:
     struct UiClipPlane {
         QCheckBox* check_On;
@@ -58,11 +70,25 @@ private:
 
     void createPlaneCappingTexture();
 
+    struct SectionTaskData;
+    void requestSectionUpdate();
+    void abortSectionTasks();
+    void onSectionTaskEnded(TaskId taskId);
+    void displaySection(const SectionTaskData& taskData);
+    void eraseSection();
+
     class Ui_WidgetClipPlanes* m_ui;
+    GuiDocument* m_guiDoc = nullptr;
     Handle_V3d_View m_view;
     std::vector<ClipPlaneData> m_vecClipPlaneData;
     Bnd_Box m_bndBox;
     Handle_Graphic3d_TextureMap m_textureCapping;
+
+    TaskManager m_sectionTaskMgr;
+    ShapeSectionCache m_sectionCache;
+    std::unordered_map<TaskId, std::shared_ptr<SectionTaskData>> m_mapSectionTask;
+    TaskId m_displayedSectionTaskId = 0;
+    std::vector<GraphicsObjectPtr> m_vecSectionObject;
 };
 
 } // namespace Mayo
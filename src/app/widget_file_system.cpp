@@ -6,12 +6,18 @@
 
 #include "widget_file_system.h"
 
+#include "../base/application.h"
+#include "../base/io_file_scan.h"
+#include "../base/io_system.h"
 #include "../base/string_utils.h"
 
 #include <QtCore/QDateTime>
 #include <QtCore/QDir>
 #include <QtCore/QFileInfo>
+#include <QtGui/QCursor>
+#include <QtGui/QHelpEvent>
 #include <QtWidgets/QBoxLayout>
+#include <QtWidgets/QToolTip>
 #include <QtWidgets/QTreeWidget>
 
 namespace Mayo {
@@ -23,6 +29,12 @@ static QString absolutePath(const QFileInfo& fi)
     return fi.isDir() ? fi.absoluteFilePath() : fi.absolutePath();
 }
 
+// Item data role telling whether the file was scanned for tooltip
+const int ItemFileScannedRole = Qt::UserRole + 1;
+
+// Tooltip is completed once the file is scanned, scan of huge files is partial
+const int TooltipFileScanTimeBudgetMs = 250;
+
 } // namespace Internal
 
 WidgetFileSystem::WidgetFileSystem(QWidget* parent)
@@ -41,6 +53,15 @@ WidgetFileSystem::WidgetFileSystem(QWidget* parent)
     QObject::connect(
                 m_treeWidget, &QTreeWidget::itemActivated,
                 this, &WidgetFileSystem::onTreeItemActivated);
+    m_treeWidget->viewport()->installEventFilter(this);
+    // Task manager signals are emitted from worker threads, so 'ended' is a queued connection
+    QObject::connect(&m_taskMgr, &TaskManager::ended, this, &WidgetFileSystem::onTooltipScanEnded);
+}
+
+WidgetFileSystem::~WidgetFileSystem()
+{
+    for (const auto& mapPair : m_mapTooltipScan)
+        m_taskMgr.waitForDone(mapPair.first);
 }
 
 QFileInfo WidgetFileSystem::currentLocation() const
@@ -97,6 +118,66 @@ void WidgetFileSystem::setLocation(const QFileInfo& fiLoc)
     m_location = fiLoc;
 }
 
+bool WidgetFileSystem::eventFilter(QObject* watched, QEvent* event)
+{
+    if (watched == m_treeWidget->viewport() && event->type() == QEvent::ToolTip) {
+        // Complete tooltip of STEP/IGES files with their metadata, before it gets displayed
+        auto helpEvent = static_cast<const QHelpEvent*>(event);
+        QTreeWidgetItem* item = m_treeWidget->itemAt(helpEvent->pos());
+        if (item && !item->data(0, Internal::ItemFileScannedRole).toBool()) {
+            item->setData(0, Internal::ItemFileScannedRole, true);
+            const QFileInfo fi(QDir(Internal::absolutePath(m_location)), item->text(0));
+            if (fi.isFile()) {
+                // Basic tooltip is displayed meanwhile
+                auto tooltipScan = std::make_shared<TooltipScan>();
+                tooltipScan->filepath = fi.absoluteFilePath();
+                const TaskId taskId = m_taskMgr.newTask([=](TaskProgress*) {
+                    const QString& filepath = tooltipScan->filepath;
+                    const IO::Format format = Application::instance()->ioSystem()->probeFormat(filepath);
+                    tooltipScan->scan = IO::scanFile(filepath, format, Internal::TooltipFileScanTimeBudgetMs);
+                });
+                m_mapTooltipScan.insert({ taskId, tooltipScan });
+                m_taskMgr.run(taskId);
+            }
+        }
+    }
+
+    return QWidget::eventFilter(watched, event);
+}
+
+void WidgetFileSystem::onTooltipScanEnded(TaskId taskId)
+{
+    auto itScan = m_mapTooltipScan.find(taskId);
+    if (itScan == m_mapTooltipScan.end())
+        return;
+
+    const std::shared_ptr<TooltipScan> tooltipScan = itScan->second;
+    m_mapTooltipScan.erase(itScan);
+    if (!tooltipScan->scan.isValid())
+        return;
+
+    // Location may have changed meanwhile
+    const QFileInfo fi(tooltipScan->filepath);
+    if (Internal::absolutePath(m_location) != fi.absolutePath())
+        return;
+
+    for (int i = 0; i < m_treeWidget->topLevelItemCount(); ++i) {
+        QTreeWidgetItem* item = m_treeWidget->topLevelItem(i);
+        if (item->text(0) != fi.fileName())
+            continue;
+
+        const QString tooltip = item->toolTip(0) + "\n\n" + tooltipScan->scan.summaryText();
+        item->setToolTip(0, tooltip);
+        // Tooltip of the item might be displayed, then it's replaced
+        QWidget* viewport = m_treeWidget->viewport();
+        const QPoint posCursor = QCursor::pos();
+        if (QToolTip::isVisible() && m_treeWidget->itemAt(viewport->mapFromGlobal(posCursor)) == item)
+            QToolTip::showText(posCursor, tooltip, viewport);
+
+        break;
+    }
+}
+
 void WidgetFileSystem::onTreeItemActivated(QTreeWidgetItem* item, int column)
 {
     if (item != nullptr && column == 0) {
@@ -6,9 +6,14 @@
 
 #pragma once
 
+#include "../base/io_file_scan.h"
+#include "../base/task_manager.h"
+
 #include <QtCore/QFileInfo>
 #include <QtWidgets/QWidget>
 #include <QtWidgets/QFileIconProvider>
+#include <memory>
+#include <unordered_map>
 class QTreeWidget;
 class QTreeWidgetItem;
 
@@ -18,19 +23,31 @@ class WidgetFileSystem : public QWidget {
     Q_OBJECT
 public:
     WidgetFileSystem(QWidget* parent = nullptr);
+    ~WidgetFileSystem();
 
     QFileInfo currentLocation() const;
     void setLocation(const QFileInfo& fiLoc);
 
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
 signals:
     void locationActivated(const QFileInfo& loc);
 
 private:
     void onTreeItemActivated(QTreeWidgetItem* item, int column);
+    void onTooltipScanEnded(TaskId taskId);
 
     QTreeWidget* m_treeWidget = nullptr;
     QFileInfo m_location;
     QFileIconProvider m_fileIconProvider;
+
+    // Files are scanned in background, tooltip is completed once scan is done
+    struct TooltipScan {
+        QString filepath;
+        IO::FileScan scan;
+    };
+    TaskManager m_taskMgr;
+    std::unordered_map<TaskId, std::shared_ptr<TooltipScan>> m_mapTooltipScan;
 };
 
 } // namespace Mayo
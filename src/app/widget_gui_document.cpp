@@ -103,6 +103,20 @@ WidgetGuiDocument::WidgetGuiDocument(GuiDocument* guiDoc, QWidget* parent)
     QObject::connect(
                 m_controller, &V3dViewController::viewScaled,
                 m_guiDoc, &GuiDocument::stopViewCameraAnimation);
+    // Projected size of entities changes mostly on zoom, rotation and panning barely affect it
+    QObject::connect(
+                m_controller, &V3dViewController::viewScaled,
+                m_guiDoc, &GuiDocument::updateLevelsOfDetail);
+    QObject::connect(
+                m_controller, &V3dViewController::dynamicActionEnded,
+                m_guiDoc, &GuiDocument::updateLevelsOfDetail);
+    // Hidden-line drawings depend only on camera orientation, they're updated once camera is still
+    QObject::connect(
+                m_controller, &V3dViewController::dynamicActionStarted,
+                m_guiDoc, &GuiDocument::suspendHiddenLineDrawings);
+    QObject::connect(
+                m_controller, &V3dViewController::dynamicActionEnded,
+                m_guiDoc, &GuiDocument::updateHiddenLineDrawings);
     QObject::connect(
                 m_controller, &V3dViewController::mouseClicked, this, [=](Qt::MouseButton btn) {
         if (btn == Qt::MouseButton::LeftButton)
@@ -129,13 +143,14 @@ void WidgetGuiDocument::resizeEvent(QResizeEvent* event)
     QWidget::resizeEvent(event);
     this->layoutViewControls();
     this->layoutWidgetClipPlanes();
+    m_guiDoc->updateLevelsOfDetail();
 }
 
 void WidgetGuiDocument::toggleWidgetClipPlanes()
 {
     if (!m_widgetClipPlanes) {
         auto panel = new Internal::PanelView3d(this);
-        auto widget = new WidgetClipPlanes(m_guiDoc->v3dView(), panel);
+        auto widget = new WidgetClipPlanes(m_guiDoc, panel);
         qtgui::QWidgetUtils::addContentsWidget(panel, widget);
         panel->show();
         panel->adjustSize();
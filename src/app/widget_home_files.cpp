@@ -82,7 +82,7 @@ public:
         else {
             auto appModule = AppModule::get(Application::instance());
             const RecentFile* recentFile = appModule ? appModule->findRecentFile(url) : nullptr;
-            pixmap = recentFile ? recentFile->thumbnail : QPixmap();
+            pixmap = recentFile ? recentFile->loadThumbnail() : QPixmap();
             if (pixmap.isNull()) {
                 const QIcon icon = m_fileIconProvider.icon(QFileInfo(url));
                 pixmap = fnPixmap(icon, 64, 64);
@@ -107,6 +107,10 @@ private:
         if (m_cacheRecentFiles == listRecentFile)
             return;
 
+        // Thumbnails might have been recorded again, force reload from disk cache
+        for (const RecentFile& recentFile : m_cacheRecentFiles)
+            QPixmapCache::remove(recentFile.filepath);
+
         m_storage->m_items.erase(m_storage->m_items.begin() + 2, m_storage->m_items.end());
         auto fnToString = [=](const QDateTime& dateTime) {
             const QString strTime = dateTime.time().toString("HH:mm");
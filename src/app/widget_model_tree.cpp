@@ -8,9 +8,11 @@
 
 #include "../base/application.h"
 #include "../base/application_item_selection_model.h"
+#include "../base/caf_utils.h"
 #include "../base/document.h"
 #include "../base/settings.h"
 #include "../base/string_utils.h"
+#include "../base/task_manager.h"
 #include "../gui/gui_application.h"
 #include "theme.h"
 #include "widget_model_tree_builder.h"
@@ -224,6 +226,13 @@ void WidgetModelTree::registerGuiApplication(GuiApplication* guiApp)
     QObject::connect(
                 m_ui->treeWidget_Model->selectionModel(), &QItemSelectionModel::selectionChanged,
                 this, &WidgetModelTree::onTreeWidgetDocumentSelectionChanged);
+    QObject::connect(
+                m_ui->treeWidget_Model, &QTreeWidget::itemExpanded,
+                this, &WidgetModelTree::onTreeWidgetItemExpanded);
+    // Task manager signals are emitted from worker threads, so 'ended' is a queued connection
+    QObject::connect(
+                TaskManager::globalInstance(), &TaskManager::ended,
+                this, &WidgetModelTree::onLazyShapesTranslated);
 }
 
 WidgetModelTree_UserActions WidgetModelTree::createUserActions(QObject* parent)
@@ -287,6 +296,10 @@ void WidgetModelTree::onDocumentAdded(const DocumentPtr& doc)
 void WidgetModelTree::onDocumentAboutToClose(const DocumentPtr& doc)
 {
     delete this->findTreeItem(doc);
+    for (auto& mapPair : m_mapLazyShapesTask) {
+        if (mapPair.second.doc == doc)
+            mapPair.second.doc.Nullify(); // Shapes translated won't be assigned
+    }
 }
 
 void WidgetModelTree::onDocumentNameChanged(const DocumentPtr& doc, const QString& /*name*/)
@@ -383,6 +396,8 @@ void WidgetModelTree::onTreeWidgetDocumentSelectionChanged(
     for (const QModelIndex& index : listSelectedIndex) {
         const QTreeWidgetItem* treeItem = m_ui->treeWidget_Model->itemFromIndex(index);
         vecSelected.push_back(std::move(Internal::toApplicationItem(treeItem)));
+        if (WidgetModelTree::holdsDocumentTreeNode(treeItem))
+            this->loadLazyShapes(Internal::treeItemDocumentTreeNode(treeItem));
     }
 
     for (const QModelIndex& index : listDeselectedIndex) {
@@ -394,4 +409,42 @@ void WidgetModelTree::onTreeWidgetDocumentSelectionChanged(
     m_guiApp->selectionModel()->remove(vecDeselected);
 }
 
+void WidgetModelTree::onTreeWidgetItemExpanded(QTreeWidgetItem* treeItem)
+{
+    if (WidgetModelTree::holdsDocumentTreeNode(treeItem))
+        this->loadLazyShapes(Internal::treeItemDocumentTreeNode(treeItem));
+}
+
+void WidgetModelTree::loadLazyShapes(const DocumentTreeNode& node)
+{
+    // Child items may merge a component with its referred product, so parts made visible by the
+    // selection or expansion of an item are up to 3 levels below
+    constexpr int depth = 3;
+    const DocumentPtr doc = node.document();
+    if (!doc->hasPendingLazyShapes(node.id(), depth))
+        return;
+
+    const TreeNodeId nodeId = node.id();
+    auto ptrVecShape = std::make_shared<std::vector<Document::TranslatedLazyShape>>();
+    auto taskMgr = TaskManager::globalInstance();
+    const TaskId taskId = taskMgr->newTask([=](TaskProgress* progress) {
+        *ptrVecShape = doc->translateLazyShapes(nodeId, depth, progress);
+    });
+    m_mapLazyShapesTask.insert({ taskId, LazyShapesTask{ doc, ptrVecShape } });
+    taskMgr->setTitle(taskId, tr("Load geometry of '%1'").arg(CafUtils::labelAttrStdName(node.label())));
+    taskMgr->run(taskId);
+}
+
+void WidgetModelTree::onLazyShapesTranslated(TaskId taskId)
+{
+    auto it = m_mapLazyShapesTask.find(taskId);
+    if (it == m_mapLazyShapesTask.end())
+        return;
+
+    const LazyShapesTask task = it->second;
+    m_mapLazyShapesTask.erase(it);
+    if (!task.doc.IsNull())
+        task.doc->assignLazyShapes(*task.ptrVecShape);
+}
+
 } // namespace Mayo
@@ -7,7 +7,9 @@
 #pragma once
 
 #include "../base/application_item.h"
+#include "../base/document.h"
 #include "../base/property.h"
+#include "../base/task_common.h"
 
 #include <QtWidgets/QWidget>
 #include <functional>
@@ -16,6 +18,8 @@ class QTreeWidget;
 class QTreeWidgetItem;
 
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 namespace Mayo {
 
@@ -64,6 +68,10 @@ private:
 
     void onTreeWidgetDocumentSelectionChanged(
             const QItemSelection& selected, const QItemSelection& deselected);
+    void onTreeWidgetItemExpanded(QTreeWidgetItem* treeItem);
+
+    void loadLazyShapes(const DocumentTreeNode& node);
+    void onLazyShapesTranslated(TaskId taskId);
 
     QTreeWidgetItem* loadDocumentEntity(const DocumentTreeNode& entityNode);
 
@@ -77,6 +85,13 @@ private:
     GuiApplication* m_guiApp = nullptr;
     std::vector<BuilderPtr> m_vecBuilder;
     QString m_refItemTextTemplate;
+
+    // Shapes are translated in tasks, then assigned to the document in the GUI thread
+    struct LazyShapesTask {
+        DocumentPtr doc;
+        std::shared_ptr<std::vector<Document::TranslatedLazyShape>> ptrVecShape;
+    };
+    std::unordered_map<TaskId, LazyShapesTask> m_mapLazyShapesTask;
 };
 
 } // namespace Mayo
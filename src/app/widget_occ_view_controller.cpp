@@ -11,6 +11,7 @@
 #include <QtGui/QBitmap>
 #include <QtGui/QCursor>
 #include <QtGui/QMouseEvent>
+#include <QtGui/QPainter>
 #include <QtGui/QWheelEvent>
 #include <QtWidgets/QRubberBand>
 #include <QtWidgets/QStyleFactory>
@@ -114,6 +115,7 @@ bool WidgetOccViewController::eventFilter(QObject* watched, QEvent* event)
         auto mouseEvent = static_cast<const QMouseEvent*>(event);
         const QPoint currPos = m_widgetView->mapFromGlobal(mouseEvent->globalPos());
         m_prevPos = currPos;
+        m_pressModifiers = mouseEvent->modifiers();
         break;
     }
     case QEvent::MouseMove: {
@@ -121,7 +123,26 @@ bool WidgetOccViewController::eventFilter(QObject* watched, QEvent* event)
         const QPoint currPos = m_widgetView->mapFromGlobal(mouseEvent->globalPos());
         const QPoint prevPos = m_prevPos;
         m_prevPos = currPos;
-        if (mouseEvent->buttons() == Qt::LeftButton) {
+        if (mouseEvent->buttons() == Qt::LeftButton && m_pressModifiers == Qt::ShiftModifier) {
+            if (!this->isBoxSelectionStarted()) {
+                this->setViewCursor(Qt::CrossCursor);
+                this->startDynamicAction(DynamicAction::BoxSelection);
+                m_posRubberBandStart = prevPos;
+            }
+
+            this->drawRubberBand(m_posRubberBandStart, currPos);
+        }
+        else if (mouseEvent->buttons() == Qt::LeftButton && m_pressModifiers == Qt::ControlModifier) {
+            if (!this->isLassoSelectionStarted()) {
+                this->setViewCursor(Qt::CrossCursor);
+                this->startDynamicAction(DynamicAction::LassoSelection);
+                m_lassoPolygon = { prevPos };
+            }
+
+            m_lassoPolygon.append(currPos);
+            this->drawLasso(m_lassoPolygon);
+        }
+        else if (mouseEvent->buttons() == Qt::LeftButton) {
             if (!this->isRotationStarted()) {
                 this->setViewCursor(Internal::rotateCursor());
                 this->startDynamicAction(DynamicAction::Rotation);
@@ -161,6 +182,18 @@ bool WidgetOccViewController::eventFilter(QObject* watched, QEvent* event)
             this->windowFitAll(m_posRubberBandStart, currPos);
             this->hideRubberBand();
         }
+        else if (this->isBoxSelectionStarted()) {
+            const QPoint currPos = m_widgetView->mapFromGlobal(mouseEvent->globalPos());
+            this->hideRubberBand();
+            emit boxSelected(QRect(m_posRubberBandStart, currPos).normalized());
+        }
+        else if (this->isLassoSelectionStarted()) {
+            this->hideLasso();
+            if (m_lassoPolygon.size() > 2)
+                emit lassoSelected(m_lassoPolygon);
+
+            m_lassoPolygon.clear();
+        }
 
         this->setViewCursor(Qt::ArrowCursor);
         this->stopDynamicAction();
@@ -217,4 +250,64 @@ V3dViewController::AbstractRubberBand* WidgetOccViewController::createRubberBand
     return new RubberBand(m_widgetView);
 }
 
+struct WidgetOccViewController::Lasso : public V3dViewController::AbstractLasso {
+    Lasso(QWidget* parent)
+        : m_widget(parent)
+    {
+        m_widget.setAttribute(Qt::WA_TransparentForMouseEvents);
+    }
+
+    void updatePolygon(const QPolygon& polygon) override {
+        m_widget.setPolygon(polygon);
+    }
+
+    void setVisible(bool on) override {
+        m_widget.setVisible(on);
+    }
+
+private:
+    class Widget : public QWidget {
+    public:
+        Widget(QWidget* parent) : QWidget(parent) {}
+
+        void setPolygon(const QPolygon& polygon) {
+            m_polygon = polygon;
+            this->setGeometry(polygon.boundingRect().adjusted(-2, -2, 2, 2));
+            // Like QRubberBand, just the lasso line is drawn so the 3D view remains visible
+            // underneath. Widget is masked because it's on top of a native window
+            QBitmap mask(this->size());
+            mask.fill(Qt::color0);
+            QPainter painter(&mask);
+            painter.setPen(QPen(Qt::color1, 2));
+            this->drawLasso(&painter);
+            this->setMask(mask);
+            this->update();
+        }
+
+    protected:
+        void paintEvent(QPaintEvent*) override {
+            QPainter painter(this);
+            painter.setPen(QPen(this->palette().color(QPalette::Highlight), 2));
+            this->drawLasso(&painter);
+        }
+
+    private:
+        void drawLasso(QPainter* painter) const {
+            const QPolygon polygon = m_polygon.translated(-this->pos());
+            painter->drawPolyline(polygon);
+            if (polygon.size() > 2)
+                painter->drawLine(polygon.last(), polygon.first());
+        }
+
+        QPolygon m_polygon;
+    };
+
+    Widget m_widget;
+};
+
+V3dViewController::AbstractLasso* WidgetOccViewController::createLasso()
+{
+    return new Lasso(m_widgetView);
+}
+
 } // namespace Mayo
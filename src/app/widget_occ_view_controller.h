@@ -29,9 +29,14 @@ private:
     AbstractRubberBand* createRubberBand() override;
     struct RubberBand;
 
+    AbstractLasso* createLasso() override;
+    struct Lasso;
+
     WidgetOccView* m_widgetView = nullptr;
     QPoint m_prevPos;
     QPoint m_posRubberBandStart;
+    Qt::KeyboardModifiers m_pressModifiers = Qt::NoModifier;
+    QPolygon m_lassoPolygon;
     Handle_Graphic3d_Camera m_prevCamera;
 };
 
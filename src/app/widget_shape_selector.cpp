@@ -218,7 +218,7 @@ void GpxShapeSelector::onShapeTypeChanged(TopAbs_ShapeEnum shapeEnum)
 
 void GpxShapeSelector::onView3dMouseMove(const QPoint& pos)
 {
-    this->graphicsScene()->highlightAt(pos, m_guiDocument->v3dView());
+    this->graphicsScene()->requestHighlightAt(pos, m_guiDocument->v3dView());
 }
 
 void GpxShapeSelector::onView3dMouseClicked(Qt::MouseButton btn)
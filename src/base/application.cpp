@@ -7,15 +7,18 @@
 #include "application.h"
 #include "document_tree_node_properties_provider.h"
 #include "io_system.h"
+#include "math_utils.h"
 #include "property_builtins.h"
 #include "qmeta_quantity_color.h"
 #include "settings.h"
+#include "task_manager.h"
 #include "tkernel_utils.h"
 
 #include <fougtools/occtools/qt_utils.h>
 
 #include <BinXCAFDrivers_DocumentRetrievalDriver.hxx>
 #include <BinXCAFDrivers_DocumentStorageDriver.hxx>
+#include <TDF_ChildIterator.hxx>
 #include <XCAFApp_Application.hxx>
 #include <XmlXCAFDrivers_DocumentRetrievalDriver.hxx>
 #include <XmlXCAFDrivers_DocumentStorageDriver.hxx>
@@ -32,8 +35,30 @@
 #include <atomic>
 #include <unordered_map>
 
+#include <gsl/gsl_assert>
+
 namespace Mayo {
 
+namespace {
+
+// Forgets all attributes(and so shapes, triangulations, ...) owned by the labels of 'doc'
+void releaseDocumentData(const DocumentPtr& doc, TaskProgress* progress)
+{
+    const TDF_Label rootLabel = doc->rootLabel();
+    const int childCount = rootLabel.NbChildren();
+    int childIndex = 0;
+    for (TDF_ChildIterator it(rootLabel); it.More() && !progress->isAbortRequested(); it.Next()) {
+        TDF_Label childLabel = it.Value();
+        childLabel.ForgetAllAttributes(true);
+        progress->setValue(MathUtils::mappedValue(++childIndex, 0, childCount, 0, 100));
+    }
+
+    rootLabel.ForgetAllAttributes(false);
+    progress->setValue(100);
+}
+
+} // namespace
+
 class Document::FormatBinaryRetrievalDriver : public BinXCAFDrivers_DocumentRetrievalDriver {
 public:
     opencascade::handle<CDM_Document> CreateDocument() override { return new Document;  }
@@ -147,6 +172,24 @@ void Application::closeDocument(const DocumentPtr& doc)
     TDocStd_Application::Close(doc);
 }
 
+TaskId Application::closeDocumentInBackground(const DocumentPtr& doc, TaskManager* taskMgr)
+{
+    Expects(taskMgr != nullptr);
+
+    // Hold a reference as the caller might own 'doc' indirectly(eg through a GuiDocument object)
+    const DocumentPtr docPtr = doc;
+    const QString docName = docPtr->name();
+    this->closeDocument(docPtr);
+
+    // Document object itself is destroyed later along with the task, in the thread owning 'taskMgr'
+    const TaskId taskId = taskMgr->newTask([=](TaskProgress* progress) {
+        releaseDocumentData(docPtr, progress);
+    });
+    taskMgr->setTitle(taskId, tr("Closing %1").arg(docName));
+    taskMgr->run(taskId);
+    return taskId;
+}
+
 Settings* Application::settings() const
 {
     return &(d->m_settings);
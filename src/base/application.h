@@ -8,6 +8,7 @@
 
 #include "application_ptr.h"
 #include "document.h"
+#include "task_common.h"
 #include <CDF_DirectoryIterator.hxx>
 class QFileInfo;
 
@@ -15,6 +16,7 @@ namespace Mayo {
 
 class Settings;
 class DocumentTreeNodePropertiesProviderTable;
+class TaskManager;
 
 namespace IO { class System; }
 
@@ -45,6 +47,9 @@ public:
     int findIndexOfDocument(const DocumentPtr& doc) const;
 
     void closeDocument(const DocumentPtr& doc);
+    // Detaches 'doc' from the application(signal documentAboutToClose is emitted before returning)
+    // then releases its data(labels, attributes, shapes, ...) within a new task run by 'taskMgr'
+    TaskId closeDocumentInBackground(const DocumentPtr& doc, TaskManager* taskMgr);
 
     Settings* settings() const;
     IO::System* ioSystem() const;
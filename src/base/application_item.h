@@ -32,3 +32,18 @@ private:
 };
 
 } // namespace Mayo
+
+namespace std {
+
+//! Specialization of C++11 std::hash<> functor for ApplicationItem
+template<> struct hash<Mayo::ApplicationItem> {
+    inline size_t operator()(const Mayo::ApplicationItem& item) const {
+        const Mayo::Document* doc = item.isDocument() ?
+                    item.document().get() : item.documentTreeNode().document().get();
+        const size_t hashDoc = std::hash<const Mayo::Document*>()(doc);
+        const size_t hashNode = std::hash<Mayo::TreeNodeId>()(item.documentTreeNode().id());
+        return hashDoc ^ (hashNode + 0x9e3779b9 + (hashDoc << 6) + (hashDoc >> 2));
+    }
+};
+
+} // namespace std
@@ -6,23 +6,10 @@
 
 #include "application_item_selection_model.h"
 
-namespace Mayo {
-
-namespace Internal {
+#include <algorithm>
+#include <unordered_set>
 
-static bool hasApplicationItem(Span<ApplicationItem> vec, const ApplicationItem& item)
-{
-    auto itFound = std::find(vec.cbegin(), vec.cend(), item);
-    return itFound != vec.cend();
-}
-
-static std::vector<ApplicationItem>::iterator findApplicationItem(
-        std::vector<ApplicationItem>& vec, const ApplicationItem& item)
-{
-    return std::find(vec.begin(), vec.end(), item);
-}
-
-} // namespace Internal
+namespace Mayo {
 
 ApplicationItemSelectionModel::ApplicationItemSelectionModel(QObject *parent)
     : QObject(parent)
@@ -34,60 +21,149 @@ Span<const ApplicationItem> ApplicationItemSelectionModel::selectedItems() const
     return m_vecSelectedItem;
 }
 
+bool ApplicationItemSelectionModel::isSelected(const ApplicationItem& item) const
+{
+    return m_mapItemIndex.find(item) != m_mapItemIndex.cend();
+}
+
 void ApplicationItemSelectionModel::add(const ApplicationItem& item)
 {
-    if (!Internal::hasApplicationItem(m_vecSelectedItem, item)) {
-        m_vecSelectedItem.push_back(item);
-        std::vector<ApplicationItem> vecItem = { item };
-        emit changed(vecItem, {});
-    }
+    ApplicationItem vecItem[] = { item };
+    this->add(vecItem);
 }
 
 void ApplicationItemSelectionModel::add(Span<ApplicationItem> vecItem)
 {
-    std::vector<ApplicationItem> signalVecItem;
+    const size_t onEntrySelectedCount = m_vecSelectedItem.size();
     for (const ApplicationItem& item : vecItem) {
-        if (!Internal::hasApplicationItem(m_vecSelectedItem, item)) {
-            m_vecSelectedItem.push_back(item);
-            signalVecItem.push_back(item);
-        }
+        if (!this->isSelected(item))
+            this->appendItem(item);
     }
 
-    if (!signalVecItem.empty())
-        emit changed(signalVecItem, {});
+    // Newly selected items are contiguous at the end of m_vecSelectedItem, no need of a copy
+    const auto selectedCount = m_vecSelectedItem.size() - onEntrySelectedCount;
+    if (selectedCount != 0) {
+        const Span<ApplicationItem> spanAll = m_vecSelectedItem;
+        emit changed(spanAll.last(selectedCount), {});
+    }
 }
 
 void ApplicationItemSelectionModel::remove(const ApplicationItem& item)
 {
-    auto itFound = Internal::findApplicationItem(m_vecSelectedItem, item);
-    if (itFound != m_vecSelectedItem.end()) {
-        m_vecSelectedItem.erase(itFound);
-        std::vector<ApplicationItem> vecItem = { item };
-        emit changed({}, vecItem);
-    }
+    ApplicationItem vecItem[] = { item };
+    this->remove(vecItem);
 }
 
 void ApplicationItemSelectionModel::remove(Span<ApplicationItem> vecItem)
 {
-    std::vector<ApplicationItem> signalVecItem;
+    std::vector<ApplicationItem> vecDeselected;
+    this->eraseItems(vecItem, &vecDeselected);
+    if (!vecDeselected.empty())
+        emit changed({}, vecDeselected);
+}
+
+void ApplicationItemSelectionModel::toggle(const ApplicationItem& item)
+{
+    ApplicationItem vecItem[] = { item };
+    this->toggle(vecItem);
+}
+
+void ApplicationItemSelectionModel::toggle(Span<ApplicationItem> vecItem)
+{
+    std::vector<ApplicationItem> vecToDeselect;
+    const size_t onEntrySelectedCount = m_vecSelectedItem.size();
     for (const ApplicationItem& item : vecItem) {
-        auto itFound = Internal::findApplicationItem(m_vecSelectedItem, item);
-        if (itFound != m_vecSelectedItem.end()) {
-            m_vecSelectedItem.erase(itFound);
-            signalVecItem.push_back(item);
-        }
+        auto itFound = m_mapItemIndex.find(item);
+        if (itFound == m_mapItemIndex.end())
+            this->appendItem(item);
+        else if (itFound->second < onEntrySelectedCount)
+            vecToDeselect.push_back(item);
     }
 
-    if (!signalVecItem.empty())
-        emit changed({}, signalVecItem);
+    // Erase deselected items first so the newly selected ones end up contiguous
+    std::vector<ApplicationItem> vecDeselected;
+    this->eraseItems(vecToDeselect, &vecDeselected);
+    const auto selectedCount = m_vecSelectedItem.size() - (onEntrySelectedCount - vecDeselected.size());
+    if (selectedCount != 0 || !vecDeselected.empty()) {
+        const Span<ApplicationItem> spanAll = m_vecSelectedItem;
+        emit changed(spanAll.last(selectedCount), vecDeselected);
+    }
+}
+
+void ApplicationItemSelectionModel::setSelectedItems(Span<ApplicationItem> vecItem)
+{
+    const std::unordered_set<ApplicationItem> setNewItem(vecItem.begin(), vecItem.end());
+    std::vector<ApplicationItem> vecToDeselect;
+    for (const ApplicationItem& item : m_vecSelectedItem) {
+        if (setNewItem.find(item) == setNewItem.cend())
+            vecToDeselect.push_back(item);
+    }
+
+    std::vector<ApplicationItem> vecDeselected;
+    this->eraseItems(vecToDeselect, &vecDeselected);
+    const size_t keptCount = m_vecSelectedItem.size();
+    for (const ApplicationItem& item : vecItem) {
+        if (!this->isSelected(item))
+            this->appendItem(item);
+    }
+
+    const auto selectedCount = m_vecSelectedItem.size() - keptCount;
+    if (selectedCount != 0 || !vecDeselected.empty()) {
+        const Span<ApplicationItem> spanAll = m_vecSelectedItem;
+        emit changed(spanAll.last(selectedCount), vecDeselected);
+    }
 }
 
 void ApplicationItemSelectionModel::clear()
 {
     if (!m_vecSelectedItem.empty()) {
         m_vecSelectedItem.clear();
+        m_mapItemIndex.clear();
         emit cleared();
     }
 }
 
+void ApplicationItemSelectionModel::appendItem(const ApplicationItem& item)
+{
+    m_mapItemIndex.insert({ item, m_vecSelectedItem.size() });
+    m_vecSelectedItem.push_back(item);
+}
+
+void ApplicationItemSelectionModel::eraseItems(
+        Span<ApplicationItem> vecItem, std::vector<ApplicationItem>* ptrVecErased)
+{
+    // Mark items to be erased, then compact m_vecSelectedItem in a single pass
+    std::vector<bool> vecErased(m_vecSelectedItem.size(), false);
+    size_t erasedCount = 0;
+    for (const ApplicationItem& item : vecItem) {
+        auto itFound = m_mapItemIndex.find(item);
+        if (itFound != m_mapItemIndex.end()) {
+            vecErased.at(itFound->second) = true;
+            m_mapItemIndex.erase(itFound);
+            ++erasedCount;
+        }
+    }
+
+    if (erasedCount == 0)
+        return;
+
+    ptrVecErased->reserve(ptrVecErased->size() + erasedCount);
+    size_t newIndex = 0;
+    for (size_t i = 0; i < m_vecSelectedItem.size(); ++i) {
+        if (vecErased.at(i)) {
+            ptrVecErased->push_back(std::move(m_vecSelectedItem.at(i)));
+        }
+        else {
+            if (newIndex != i) {
+                m_vecSelectedItem.at(newIndex) = std::move(m_vecSelectedItem.at(i));
+                m_mapItemIndex.at(m_vecSelectedItem.at(newIndex)) = newIndex;
+            }
+
+            ++newIndex;
+        }
+    }
+
+    m_vecSelectedItem.resize(newIndex);
+}
+
 } // namespace Mayo
@@ -9,31 +9,44 @@
 #include "application_item.h"
 #include "span.h"
 #include <QtCore/QObject>
+#include <unordered_map>
+#include <vector>
 
 namespace Mayo {
 
+// Selected items are kept in selection order, membership is tested in constant time(hashed index)
+// Bulk operations emit a single changed() signal whatever the count of items involved
 class ApplicationItemSelectionModel : public QObject {
     Q_OBJECT
 public:
     ApplicationItemSelectionModel(QObject* parent = nullptr);
 
     Span<const ApplicationItem> selectedItems() const;
+    size_t selectedItemCount() const { return m_vecSelectedItem.size(); }
+    bool isSelected(const ApplicationItem& item) const;
 
     void add(const ApplicationItem& item);
     void add(Span<ApplicationItem> vecItem);
     void remove(const ApplicationItem& item);
     void remove(Span<ApplicationItem> vecItem);
-//    void toggle(const ApplicationItem& item);
-//    void toggle(Span<ApplicationItem> item);
+    void toggle(const ApplicationItem& item);
+    void toggle(Span<ApplicationItem> vecItem);
+    // Replaces current selection with 'vecItem'
+    void setSelectedItems(Span<ApplicationItem> vecItem);
 
     void clear();
 
 signals:
     void cleared();
+    // Spans are valid only during signal emission
     void changed(Span<ApplicationItem> selected, Span<ApplicationItem> deselected);
 
 private:
+    void appendItem(const ApplicationItem& item);
+    void eraseItems(Span<ApplicationItem> vecItem, std::vector<ApplicationItem>* ptrVecErased);
+
     std::vector<ApplicationItem> m_vecSelectedItem;
+    std::unordered_map<ApplicationItem, size_t> m_mapItemIndex; // Item -> index in m_vecSelectedItem
 };
 
 } // namespace Mayo
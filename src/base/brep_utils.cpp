@@ -5,8 +5,11 @@
 ****************************************************************************/
 
 #include "brep_utils.h"
+#include "tkernel_utils.h"
 
+#include <BinTools.hxx>
 #include <BRep_Builder.hxx>
+#include <BRepBuilderAPI_Copy.hxx>
 #include <BRepTools.hxx>
 #include <climits>
 #include <sstream>
@@ -39,4 +42,32 @@ TopoDS_Shape BRepUtils::shapeFromString(const std::string& str)
     return shape;
 }
 
+std::string BRepUtils::shapeToBinaryString(const TopoDS_Shape& shape, bool withTriangulation)
+{
+    std::ostringstream oss(std::ios_base::out | std::ios_base::binary);
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    constexpr bool withNormals = false;
+    BinTools::Write(shape, oss, withTriangulation, withNormals, BinTools_FormatVersion_CURRENT);
+#else
+    // BinTools always writes triangulations, so they have to be removed from a copy of the shape
+    if (!withTriangulation && !shape.IsNull()) {
+        constexpr bool copyGeom = true;
+        constexpr bool copyMesh = false;
+        BinTools::Write(BRepBuilderAPI_Copy(shape, copyGeom, copyMesh).Shape(), oss);
+    }
+    else {
+        BinTools::Write(shape, oss);
+    }
+#endif
+    return oss.str();
+}
+
+TopoDS_Shape BRepUtils::shapeFromBinaryString(const std::string& str)
+{
+    TopoDS_Shape shape;
+    std::istringstream iss(str, std::ios_base::in | std::ios_base::binary);
+    BinTools::Read(shape, iss);
+    return shape;
+}
+
 } // namespace Mayo
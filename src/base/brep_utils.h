@@ -29,6 +29,11 @@ struct BRepUtils {
 
     static std::string shapeToString(const TopoDS_Shape& shape);
     static TopoDS_Shape shapeFromString(const std::string& str);
+
+    // Binary serialization(see BinTools)
+    // Much faster than shapeToString()/shapeFromString(), to be preferred for internal transfers
+    static std::string shapeToBinaryString(const TopoDS_Shape& shape, bool withTriangulation = true);
+    static TopoDS_Shape shapeFromBinaryString(const std::string& str);
 };
 
 
@@ -7,10 +7,16 @@
 #include "application.h"
 #include "caf_utils.h"
 #include "document.h"
+#include "lazy_shape_loader.h"
+#include "task_progress.h"
 #include <fougtools/occtools/qt_utils.h>
+#include <NCollection_DataMap.hxx>
 #include <TDF_ChildIterator.hxx>
+#include <TDF_LabelMapHasher.hxx>
 #include <TDF_TagSource.hxx>
 #include <XCAFDoc_DocumentTool.hxx>
+#include <algorithm>
+#include <functional>
 #include <set>
 
 namespace Mayo {
@@ -149,10 +155,88 @@ void Document::changeColor(TreeNodeId nodeId, const Quantity_Color& color)
     if (nodeLabel.IsNull())
         return;
 
-    m_xcaf.colorTool()->SetColor(nodeLabel, color, XCAFDoc_ColorSurf);
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_mutexModify);
+        m_xcaf.colorTool()->SetColor(nodeLabel, color, XCAFDoc_ColorSurf);
+    }
+
     emit this->colorChanged(nodeId);
 }
 
+void Document::changeColors(Span<const TreeNodeColor> spanNodeColor)
+{
+    if (!this->isXCafDocument() || spanNodeColor.empty())
+        return;
+
+    const Handle_XCAFDoc_ColorTool colorTool = m_xcaf.colorTool();
+    if (!colorTool)
+        return;
+
+    std::unique_lock<std::recursive_mutex> lock(m_mutexModify);
+    const bool isCommandOwner = !this->HasOpenCommand();
+    if (isCommandOwner)
+        this->OpenCommand();
+
+    // Few distinct colors are expected, each color label is looked up once
+    std::vector<std::pair<Quantity_Color, TDF_Label>> vecColorLabel;
+    auto fnColorLabel = [&](const Quantity_Color& color) {
+        auto itFound = std::find_if(
+                    vecColorLabel.cbegin(), vecColorLabel.cend(),
+                    [&](const auto& pair) { return pair.first == color; });
+        if (itFound != vecColorLabel.cend())
+            return itFound->second;
+
+        vecColorLabel.emplace_back(color, colorTool->AddColor(color));
+        return vecColorLabel.back().second;
+    };
+
+    // Occurrences of a shape share its label, the color is set once per label(the last one given
+    // wins) and a single node per entity is notified as the color applies to all occurrences
+    struct LabelColor {
+        Quantity_Color color;
+        std::vector<TreeNodeId> vecTreeNodeId; // One per entity
+    };
+    using MapLabelColor = NCollection_DataMap<TDF_Label, LabelColor, TDF_LabelMapHasher>;
+    MapLabelColor mapLabelColor;
+    for (const TreeNodeColor& nodeColor : spanNodeColor) {
+        const TDF_Label& nodeLabel = m_modelTree.nodeData(nodeColor.treeNodeId);
+        if (nodeLabel.IsNull())
+            continue;
+
+        LabelColor* labelColor = mapLabelColor.ChangeSeek(nodeLabel);
+        if (!labelColor)
+            labelColor = mapLabelColor.Bound(nodeLabel, LabelColor{});
+
+        labelColor->color = nodeColor.color;
+        const TreeNodeId entityTreeNodeId = m_modelTree.nodeRoot(nodeColor.treeNodeId);
+        auto itNode = std::find_if(
+                    labelColor->vecTreeNodeId.cbegin(), labelColor->vecTreeNodeId.cend(),
+                    [=](TreeNodeId id) { return m_modelTree.nodeRoot(id) == entityTreeNodeId; });
+        if (itNode == labelColor->vecTreeNodeId.cend())
+            labelColor->vecTreeNodeId.push_back(nodeColor.treeNodeId);
+    }
+
+    std::vector<TreeNodeId> vecTreeNodeId;
+    for (MapLabelColor::Iterator it(mapLabelColor); it.More(); it.Next()) {
+        const TDF_Label& label = it.Key();
+        const LabelColor& labelColor = it.Value();
+        Quantity_Color currentColor;
+        if (colorTool->GetColor(label, XCAFDoc_ColorSurf, currentColor) && currentColor == labelColor.color)
+            continue;
+
+        colorTool->SetColor(label, fnColorLabel(labelColor.color), XCAFDoc_ColorSurf);
+        vecTreeNodeId.insert(
+                    vecTreeNodeId.end(), labelColor.vecTreeNodeId.cbegin(), labelColor.vecTreeNodeId.cend());
+    }
+
+    if (isCommandOwner)
+        this->CommitCommand();
+
+    lock.unlock();
+    if (!vecTreeNodeId.empty())
+        emit this->colorsChanged(vecTreeNodeId);
+}
+
 void Document::rebuildModelTree()
 {
     m_modelTree.clear();
@@ -197,11 +281,151 @@ void Document::destroyEntity(TreeNodeId entityTreeNodeId)
         return;
 
     emit this->entityAboutToBeDestroyed(entityTreeNodeId);
+    std::lock_guard<std::recursive_mutex> lock(m_mutexModify);
     entityLabel.ForgetAllAttributes();
     entityLabel.Nullify();
     m_modelTree.removeRoot(entityTreeNodeId);
 }
 
+std::vector<std::shared_ptr<LazyShapeLoader>> Document::lazyShapeLoaders() const
+{
+    std::lock_guard<std::mutex> lock(m_mutexLazyShapeLoader);
+    return m_vecLazyShapeLoader;
+}
+
+void Document::addLazyShapeLoader(const std::shared_ptr<LazyShapeLoader>& loader)
+{
+    if (!loader)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_mutexLazyShapeLoader);
+    m_vecLazyShapeLoader.push_back(loader);
+}
+
+std::vector<TDF_Label> Document::pendingLazyShapes(TreeNodeId nodeId, int depth) const
+{
+    std::vector<TDF_Label> vecLabel;
+    const std::vector<std::shared_ptr<LazyShapeLoader>> vecLoader = this->lazyShapeLoaders();
+    if (vecLoader.empty())
+        return vecLabel;
+
+    auto fnIsPending = [&](const TDF_Label& label) {
+        return std::any_of(vecLoader.cbegin(), vecLoader.cend(), [&](const auto& loader) {
+            return loader->isPending(label);
+        });
+    };
+    std::function<void(TreeNodeId, int)> fnExplore = [&](TreeNodeId id, int level) {
+        const TDF_Label& label = m_modelTree.nodeData(id);
+        if (fnIsPending(label)
+                && std::find(vecLabel.cbegin(), vecLabel.cend(), label) == vecLabel.cend())
+        {
+            vecLabel.push_back(label);
+        }
+
+        if (depth >= 0 && level >= depth)
+            return;
+
+        for (auto it = m_modelTree.nodeChildFirst(id); it != 0; it = m_modelTree.nodeSiblingNext(it))
+            fnExplore(it, level + 1);
+    };
+    fnExplore(nodeId, 0);
+    return vecLabel;
+}
+
+bool Document::hasPendingLazyShapes(TreeNodeId nodeId, int depth) const
+{
+    return !this->pendingLazyShapes(nodeId, depth).empty();
+}
+
+std::vector<Document::TranslatedLazyShape> Document::translateLazyShapes(
+        TreeNodeId nodeId, int depth, TaskProgress* progress)
+{
+    std::vector<TranslatedLazyShape> vecShape;
+    const std::vector<TDF_Label> vecLabel = this->pendingLazyShapes(nodeId, depth);
+    if (vecLabel.empty())
+        return vecShape;
+
+    // Dispatch pending labels to the loaders in charge of them
+    struct LoaderLabels {
+        std::shared_ptr<LazyShapeLoader> loader;
+        std::vector<TDF_Label> vecLabel;
+    };
+    std::vector<LoaderLabels> vecLoaderLabels;
+    for (const std::shared_ptr<LazyShapeLoader>& loader : this->lazyShapeLoaders()) {
+        LoaderLabels loaderLabels{ loader, {} };
+        for (const TDF_Label& label : vecLabel) {
+            if (loader->isPending(label))
+                loaderLabels.vecLabel.push_back(label);
+        }
+
+        if (!loaderLabels.vecLabel.empty())
+            vecLoaderLabels.push_back(std::move(loaderLabels));
+    }
+
+    for (const LoaderLabels& loaderLabels : vecLoaderLabels) {
+        if (TaskProgress::isAbortRequested(progress))
+            break;
+
+        for (LazyShape& lazyShape : loaderLabels.loader->translate(loaderLabels.vecLabel, progress))
+            vecShape.push_back({ loaderLabels.loader, std::move(lazyShape) });
+    }
+
+    return vecShape;
+}
+
+bool Document::assignLazyShapes(Span<const TranslatedLazyShape> spanShape)
+{
+    if (spanShape.empty())
+        return true;
+
+    bool ok = true;
+    std::vector<TreeNodeId> vecEntityId;
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_mutexModify);
+        for (const TranslatedLazyShape& translated : spanShape) {
+            if (!translated.lazyShape.shape.IsNull())
+                translated.loader->assign(translated.lazyShape);
+            else
+                ok = false;
+        }
+
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
+        // Compounds of assemblies still refer to the empty compounds of parts
+        if (m_xcaf.shapeTool())
+            m_xcaf.shapeTool()->UpdateAssemblies();
+#endif
+
+        // Parts can be shared by several entities
+        for (const TreeNodeId entityId : m_modelTree.roots()) {
+            bool isEntityAffected = false;
+            deepForeachTreeNode(entityId, m_modelTree, [&](TreeNodeId id) {
+                const TDF_Label& label = m_modelTree.nodeData(id);
+                if (!isEntityAffected) {
+                    isEntityAffected = std::any_of(
+                                spanShape.begin(), spanShape.end(),
+                                [&](const TranslatedLazyShape& translated) {
+                                    return translated.lazyShape.label == label;
+                                });
+                }
+            });
+            if (isEntityAffected)
+                vecEntityId.push_back(entityId);
+        }
+    }
+
+    for (const TreeNodeId entityId : vecEntityId)
+        emit this->entityShapesChanged(entityId);
+
+    return ok;
+}
+
+bool Document::loadLazyShapes(TreeNodeId nodeId, int depth, TaskProgress* progress)
+{
+    const std::vector<TranslatedLazyShape> vecShape = this->translateLazyShapes(nodeId, depth, progress);
+    const bool ok = this->assignLazyShapes(vecShape);
+    return ok && !TaskProgress::isAbortRequested(progress);
+}
+
 void Document::BeforeClose()
 {
     TDocStd_Document::BeforeClose();
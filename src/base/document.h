@@ -8,14 +8,20 @@
 
 #include "document_ptr.h"
 #include "document_tree_node.h"
+#include "lazy_shape_loader.h"
 #include "libtree.h"
+#include "span.h"
 #include "xcaf.h"
 #include <QtCore/QObject>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace Mayo {
 
 class Application;
 class DocumentTreeNode;
+class TaskProgress;
 
 class Document : public QObject, public TDocStd_Document {
     Q_OBJECT
@@ -55,6 +61,14 @@ public:
 
     void changeColor(TreeNodeId nodeId, const Quantity_Color& color);
 
+    struct TreeNodeColor {
+        TreeNodeId treeNodeId;
+        Quantity_Color color;
+    };
+    // Changes the colors of many tree nodes within a single transaction
+    // Signal colorsChanged() is emitted once, instead of colorChanged() for each node
+    void changeColors(Span<const TreeNodeColor> spanNodeColor);
+
     const Tree<TDF_Label>& modelTree() const { return m_modelTree; }
     void rebuildModelTree();
 
@@ -63,11 +77,44 @@ public:
     TDF_Label newEntityLabel();
     void destroyEntity(TreeNodeId entityTreeNodeId);
 
+    // Geometry of parts can be left empty at import, then loaded on demand by a loader
+    // Each lazy import adds its own loader, parts of previous imports are kept in charge
+    std::vector<std::shared_ptr<LazyShapeLoader>> lazyShapeLoaders() const;
+    void addLazyShapeLoader(const std::shared_ptr<LazyShapeLoader>& loader);
+
+    // Part labels with pending geometry found below tree node 'nodeId'(included)
+    // Exploration is limited to 'depth' levels, all levels if negative
+    std::vector<TDF_Label> pendingLazyShapes(TreeNodeId nodeId, int depth = -1) const;
+    bool hasPendingLazyShapes(TreeNodeId nodeId, int depth = -1) const;
+
+    // Shape translated by a loader, see LazyShapeLoader::translate()
+    struct TranslatedLazyShape {
+        std::shared_ptr<LazyShapeLoader> loader;
+        LazyShape lazyShape;
+    };
+
+    // Translates geometry of the parts returned by pendingLazyShapes()
+    // The document isn't modified, so this can be called from any thread
+    // Parts aren't pending anymore on return, but keep empty until assignLazyShapes() is called
+    std::vector<TranslatedLazyShape> translateLazyShapes(
+            TreeNodeId nodeId, int depth = -1, TaskProgress* progress = nullptr);
+
+    // Assigns translated shapes to their part labels, assemblies are then updated
+    // Document modifications are serialized, but should preferably happen in the GUI thread
+    // Signal entityShapesChanged() is emitted for each entity affected
+    // Returns false if some shape couldn't be translated
+    bool assignLazyShapes(Span<const TranslatedLazyShape> spanShape);
+
+    // Translates then assigns geometry of the parts returned by pendingLazyShapes()
+    bool loadLazyShapes(TreeNodeId nodeId, int depth = -1, TaskProgress* progress = nullptr);
+
 signals:
     void nameChanged(const QString& name);
     void colorChanged(TreeNodeId treeNodeId);
+    void colorsChanged(const std::vector<TreeNodeId>& vecTreeNodeId);
     void entityAdded(TreeNodeId entityTreeNodeId);
     void entityAboutToBeDestroyed(TreeNodeId entityTreeNodeId);
+    void entityShapesChanged(TreeNodeId entityTreeNodeId);
     //void itemPropertyChanged(DocumentItem* docItem, Property* prop);
 
 public: // -- from TDocStd_Document
@@ -95,6 +142,10 @@ private:
     QString m_filePath;
     XCaf m_xcaf;
     Tree<TDF_Label> m_modelTree;
+    std::vector<std::shared_ptr<LazyShapeLoader>> m_vecLazyShapeLoader;
+    mutable std::mutex m_mutexLazyShapeLoader;
+    // Serializes modifications of OCAF data, which may happen in worker threads(eg lazy shapes)
+    std::recursive_mutex m_mutexModify;
 };
 
 } // namespace Mayo
@@ -0,0 +1,236 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "document_coloring.h"
+
+#include "caf_utils.h"
+#include "document.h"
+#include "mesh_utils.h"
+#include "task_progress.h"
+#include "xcaf.h"
+
+#include <BRepGProp.hxx>
+#include <GProp_GProps.hxx>
+#include <NCollection_DataMap.hxx>
+#include <OSD_Parallel.hxx>
+#include <TDF_LabelMapHasher.hxx>
+#include <QtCore/QRegularExpression>
+#include <cmath>
+
+namespace Mayo {
+
+namespace {
+
+QRegularExpression wildcardToRegularExpression(const QString& pattern)
+{
+    QString strRegExp = QRegularExpression::escape(pattern);
+    strRegExp.replace(QLatin1String("\\*"), QLatin1String(".*"));
+    strRegExp.replace(QLatin1String("\\?"), QLatin1String("."));
+    QRegularExpression regExp(
+                QLatin1Char('^') + strRegExp + QLatin1Char('$'),
+                QRegularExpression::CaseInsensitiveOption);
+    // Compile now, the expression is then shared read-only by worker threads
+    regExp.optimize();
+    return regExp;
+}
+
+ColorRule::XdeKind xdeKind(const TDF_Label& label)
+{
+    if (XCaf::isShapeAssembly(label))
+        return ColorRule::XdeKind::Assembly;
+    else if (XCaf::isShapeReference(label))
+        return ColorRule::XdeKind::Instance;
+    else if (XCaf::isShapeSub(label))
+        return ColorRule::XdeKind::SubShape;
+    else
+        return ColorRule::XdeKind::Part;
+}
+
+bool isInRange(double value, double rangeMin, double rangeMax)
+{
+    return rangeMin <= value && value <= rangeMax;
+}
+
+bool hasVolumeCriterion(const ColorRule& rule)
+{
+    return rule.minVolume > 0. || !std::isinf(rule.maxVolume);
+}
+
+bool hasAreaCriterion(const ColorRule& rule)
+{
+    return rule.minArea > 0. || !std::isinf(rule.maxArea);
+}
+
+// Properties of a shape label evaluated lazily, as they are needed by rules
+class LabelProperties {
+public:
+    LabelProperties(const TDF_Label& label)
+        : m_label(label), m_shape(XCaf::shape(label)), m_xdeKind(xdeKind(label))
+    {}
+
+    const TopoDS_Shape& shape() const { return m_shape; }
+    ColorRule::XdeKind xdeKind() const { return m_xdeKind; }
+
+    const QString& name() {
+        if (!m_hasName) {
+            m_name = CafUtils::labelAttrStdName(m_label);
+            m_hasName = true;
+        }
+
+        return m_name;
+    }
+
+    double volume() {
+        if (m_volume < 0.) {
+            const XCaf::ValidationProperties validProps = XCaf::validationProperties(m_label);
+            if (validProps.hasVolume) {
+                m_volume = validProps.volume.value();
+            }
+            else {
+                GProp_GProps props;
+                BRepGProp::VolumeProperties(m_shape, props);
+                m_volume = std::abs(props.Mass());
+            }
+        }
+
+        return m_volume;
+    }
+
+    double area() {
+        if (m_area < 0.) {
+            const XCaf::ValidationProperties validProps = XCaf::validationProperties(m_label);
+            if (validProps.hasArea) {
+                m_area = validProps.area.value();
+            }
+            else {
+                GProp_GProps props;
+                BRepGProp::SurfaceProperties(m_shape, props);
+                m_area = props.Mass();
+            }
+        }
+
+        return m_area;
+    }
+
+private:
+    TDF_Label m_label;
+    TopoDS_Shape m_shape;
+    ColorRule::XdeKind m_xdeKind;
+    QString m_name;
+    bool m_hasName = false;
+    double m_volume = -1.;
+    double m_area = -1.;
+};
+
+} // namespace
+
+std::vector<DocumentColoring::Assignment> DocumentColoring::evaluate(
+        const DocumentPtr& doc, Span<const ColorRule> spanRule, TaskProgress* progress)
+{
+    std::vector<Assignment> vecAssignment;
+    if (doc.IsNull() || spanRule.empty() || !doc->isXCafDocument())
+        return vecAssignment;
+
+    // Volume and area of mesh shapes need their triangulations, which loading may have been
+    // deferred by the reader(eg glTF)
+    for (int i = 0; i < doc->entityCount(); ++i)
+        MeshUtils::loadDeferredTriangulations(XCaf::shape(doc->entityLabel(i)));
+
+    // Tree nodes referring to the same label(eg part referenced by many instances) are
+    // evaluated once
+    const Tree<TDF_Label>& modelTree = doc->modelTree();
+    NCollection_DataMap<TDF_Label, int, TDF_LabelMapHasher> mapLabelIndex;
+    std::vector<TDF_Label> vecLabel;
+    std::vector<std::pair<TreeNodeId, int>> vecNodeLabelIndex;
+    deepForeachTreeNode(modelTree, [&](TreeNodeId nodeId) {
+        const TDF_Label& label = modelTree.nodeData(nodeId);
+        if (!XCaf::isShape(label))
+            return;
+
+        const int* ptrIndex = mapLabelIndex.Seek(label);
+        const int index = ptrIndex ? *ptrIndex : int(vecLabel.size());
+        if (!ptrIndex) {
+            mapLabelIndex.Bind(label, index);
+            vecLabel.push_back(label);
+        }
+
+        vecNodeLabelIndex.emplace_back(nodeId, index);
+    });
+
+    if (progress)
+        progress->setValue(10);
+
+    std::vector<QRegularExpression> vecNameRegExp;
+    for (const ColorRule& rule : spanRule)
+        vecNameRegExp.push_back(wildcardToRegularExpression(rule.namePattern));
+
+    // Criteria are checked from the cheapest to the costliest
+    auto fnMatches = [&](int iRule, LabelProperties* props) {
+        const ColorRule& rule = spanRule[iRule];
+        if (rule.xdeKind != ColorRule::XdeKind::Any && rule.xdeKind != props->xdeKind())
+            return false;
+
+        if (rule.shapeType != TopAbs_SHAPE
+                && (props->shape().IsNull() || props->shape().ShapeType() != rule.shapeType))
+        {
+            return false;
+        }
+
+        if (!rule.namePattern.isEmpty() && !vecNameRegExp.at(iRule).match(props->name()).hasMatch())
+            return false;
+
+        if (hasVolumeCriterion(rule) && !isInRange(props->volume(), rule.minVolume, rule.maxVolume))
+            return false;
+
+        if (hasAreaCriterion(rule) && !isInRange(props->area(), rule.minArea, rule.maxArea))
+            return false;
+
+        return true;
+    };
+
+    std::vector<int> vecLabelRuleIndex(vecLabel.size(), -1);
+    const int ruleCount = int(spanRule.size());
+    OSD_Parallel::For(0, int(vecLabel.size()), [&](int iLabel) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        LabelProperties props(vecLabel.at(iLabel));
+        for (int iRule = 0; iRule < ruleCount; ++iRule) {
+            if (fnMatches(iRule, &props)) {
+                vecLabelRuleIndex.at(iLabel) = iRule;
+                break;
+            }
+        }
+    });
+
+    if (TaskProgress::isAbortRequested(progress))
+        return vecAssignment;
+
+    for (const auto& nodeLabelIndex : vecNodeLabelIndex) {
+        const int ruleIndex = vecLabelRuleIndex.at(nodeLabelIndex.second);
+        if (ruleIndex >= 0)
+            vecAssignment.push_back({ nodeLabelIndex.first, ruleIndex });
+    }
+
+    if (progress)
+        progress->setValue(100);
+
+    return vecAssignment;
+}
+
+int DocumentColoring::apply(const DocumentPtr& doc, Span<const ColorRule> spanRule, TaskProgress* progress)
+{
+    const std::vector<Assignment> vecAssignment = DocumentColoring::evaluate(doc, spanRule, progress);
+    std::vector<Document::TreeNodeColor> vecNodeColor;
+    vecNodeColor.reserve(vecAssignment.size());
+    for (const Assignment& assignment : vecAssignment)
+        vecNodeColor.push_back({ assignment.treeNodeId, spanRule[assignment.ruleIndex].color });
+
+    doc->changeColors(vecNodeColor);
+    return int(vecNodeColor.size());
+}
+
+} // namespace Mayo
@@ -0,0 +1,67 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "document_ptr.h"
+#include "libtree.h"
+#include "span.h"
+
+#include <Quantity_Color.hxx>
+#include <TopAbs_ShapeEnum.hxx>
+#include <QtCore/QString>
+#include <limits>
+#include <vector>
+
+namespace Mayo {
+
+class TaskProgress;
+
+// Criteria selecting the XCAF shapes of a document to be assigned a color
+// A shape matches the rule if it satisfies all the criteria
+struct ColorRule {
+    enum class XdeKind {
+        Any,
+        Assembly,
+        Instance, // Reference to some part or assembly
+        Part, // Simple shape, neither assembly nor instance
+        SubShape
+    };
+
+    Quantity_Color color;
+    QString namePattern; // Wildcards '*' and '?' allowed, case insensitive. Empty matches any name
+    TopAbs_ShapeEnum shapeType = TopAbs_SHAPE; // TopAbs_SHAPE matches any type
+    XdeKind xdeKind = XdeKind::Any;
+    // Closed ranges, in cubic and squared millimeters
+    double minVolume = 0.;
+    double maxVolume = std::numeric_limits<double>::infinity();
+    double minArea = 0.;
+    double maxArea = std::numeric_limits<double>::infinity();
+};
+
+// Assigns colors to the shapes of a document from a set of rules
+class DocumentColoring {
+public:
+    struct Assignment {
+        TreeNodeId treeNodeId;
+        int ruleIndex;
+    };
+
+    // Evaluates 'spanRule' over the nodes of the model tree of 'doc', in parallel. For each node
+    // the first matching rule applies. Document isn't modified, so this can be called from a
+    // worker thread
+    // Volumes and areas are computed only if some rule needs them, stored XCAF validation
+    // properties are used when available
+    static std::vector<Assignment> evaluate(
+            const DocumentPtr& doc, Span<const ColorRule> spanRule, TaskProgress* progress = nullptr);
+
+    // Evaluates 'spanRule' then writes all the colors at once with Document::changeColors()
+    // Must be called from the thread of 'doc'. Returns the count of tree nodes colored
+    static int apply(
+            const DocumentPtr& doc, Span<const ColorRule> spanRule, TaskProgress* progress = nullptr);
+};
+
+} // namespace Mayo
@@ -0,0 +1,283 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "document_formula_table.h"
+
+#include "document.h"
+#include "mesh_utils.h"
+#include "task_progress.h"
+#include "xcaf.h"
+
+#include <Bnd_Box.hxx>
+#include <BRepBndLib.hxx>
+#include <BRepGProp.hxx>
+#include <GProp_GProps.hxx>
+#include <NCollection_DataMap.hxx>
+#include <OSD_Parallel.hxx>
+#include <TDF_LabelMapHasher.hxx>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+namespace Mayo {
+
+namespace {
+
+// Properties of a shape label independent of its location
+// For an assembly, they're the sum of the properties of its components
+struct LabelProperties {
+    double area = 0.;
+    double volume = 0.;
+    Bnd_Box bndBox;
+};
+
+LabelProperties computeLabelProperties(const TDF_Label& label)
+{
+    LabelProperties props;
+    const TopoDS_Shape shape = XCaf::shape(label).Located(TopLoc_Location());
+    const XCaf::ValidationProperties validProps = XCaf::validationProperties(label);
+    if (validProps.hasArea) {
+        props.area = validProps.area.value();
+    }
+    else {
+        GProp_GProps gprops;
+        BRepGProp::SurfaceProperties(shape, gprops);
+        props.area = gprops.Mass();
+    }
+
+    if (validProps.hasVolume) {
+        props.volume = validProps.volume.value();
+    }
+    else {
+        GProp_GProps gprops;
+        BRepGProp::VolumeProperties(shape, gprops);
+        props.volume = std::abs(gprops.Mass());
+    }
+
+    BRepBndLib::Add(shape, props.bndBox);
+    return props;
+}
+
+// Values of column "part", 1 for the rows being part nodes
+Span<const double> partValues(const FormulaTable& table)
+{
+    const int col = table.findColumn("part");
+    return col != -1 ? table.columnValues(col) : Span<const double>();
+}
+
+} // namespace
+
+DocumentFormulaTable DocumentFormulaTable::build(const DocumentPtr& doc, TaskProgress* progress)
+{
+    DocumentFormulaTable docTable;
+    if (doc.IsNull() || !doc->isXCafDocument())
+        return docTable;
+
+    // Properties of mesh shapes need their triangulations, which loading may have been deferred by
+    // the reader(eg glTF)
+    for (int i = 0; i < doc->entityCount(); ++i)
+        MeshUtils::loadDeferredTriangulations(XCaf::shape(doc->entityLabel(i)));
+
+    // Instances share the properties of the shape they refer to
+    const Tree<TDF_Label>& modelTree = doc->modelTree();
+    NCollection_DataMap<TDF_Label, int, TDF_LabelMapHasher> mapLabelIndex;
+    std::vector<TDF_Label> vecLabel;
+    std::vector<int> vecNodeLabelIndex;
+    deepForeachTreeNode(modelTree, [&](TreeNodeId nodeId) {
+        const TDF_Label& nodeLabel = modelTree.nodeData(nodeId);
+        if (!XCaf::isShape(nodeLabel))
+            return;
+
+        const TDF_Label label =
+                XCaf::isShapeReference(nodeLabel) ? XCaf::shapeReferred(nodeLabel) : nodeLabel;
+        const int* ptrIndex = mapLabelIndex.Seek(label);
+        const int index = ptrIndex ? *ptrIndex : int(vecLabel.size());
+        if (!ptrIndex) {
+            mapLabelIndex.Bind(label, index);
+            vecLabel.push_back(label);
+        }
+
+        docTable.vecTreeNodeId.push_back(nodeId);
+        vecNodeLabelIndex.push_back(index);
+    });
+
+    if (progress)
+        progress->setValue(10);
+
+    // Only parts are computed from their geometry, assemblies are aggregated afterwards from their
+    // located components
+    std::vector<LabelProperties> vecLabelProps(vecLabel.size());
+    OSD_Parallel::For(0, int(vecLabel.size()), [&](int i) {
+        if (!TaskProgress::isAbortRequested(progress) && !XCaf::isShapeAssembly(vecLabel.at(i)))
+            vecLabelProps.at(i) = computeLabelProperties(vecLabel.at(i));
+    });
+
+    if (TaskProgress::isAbortRequested(progress))
+        return {};
+
+    // An assembly may be a component of an assembly met before it in the model tree, so they are
+    // aggregated depth first
+    std::vector<bool> vecIsAggregated(vecLabel.size(), false);
+    std::function<const LabelProperties*(const TDF_Label&)> fnAssemblyProperties;
+    auto fnLabelProperties = [&](const TDF_Label& label) -> const LabelProperties* {
+        const int* ptrIndex = mapLabelIndex.Seek(label);
+        if (!ptrIndex)
+            return nullptr;
+
+        return XCaf::isShapeAssembly(label) ? fnAssemblyProperties(label) : &vecLabelProps.at(*ptrIndex);
+    };
+    fnAssemblyProperties = [&](const TDF_Label& label) -> const LabelProperties* {
+        const int index = mapLabelIndex.Find(label);
+        LabelProperties& props = vecLabelProps.at(index);
+        if (vecIsAggregated.at(index))
+            return &props;
+
+        vecIsAggregated.at(index) = true;
+        for (const TDF_Label& component : XCaf::shapeComponents(label)) {
+            const LabelProperties* ptrChildProps = fnLabelProperties(XCaf::shapeReferred(component));
+            if (!ptrChildProps)
+                continue;
+
+            props.area += ptrChildProps->area;
+            props.volume += ptrChildProps->volume;
+            if (!ptrChildProps->bndBox.IsVoid()) {
+                const TopLoc_Location loc = XCaf::shapeReferenceLocation(component);
+                props.bndBox.Add(ptrChildProps->bndBox.Transformed(loc.Transformation()));
+            }
+        }
+
+        return &props;
+    };
+    for (const TDF_Label& label : vecLabel) {
+        if (XCaf::isShapeAssembly(label))
+            fnAssemblyProperties(label);
+    }
+
+    if (progress)
+        progress->setValue(80);
+
+    const size_t rowCount = docTable.vecTreeNodeId.size();
+    std::vector<double> vecArea(rowCount);
+    std::vector<double> vecVolume(rowCount);
+    std::vector<double> vecBndBox[6];
+    for (std::vector<double>& vec : vecBndBox)
+        vec.resize(rowCount);
+
+    std::vector<double> vecDepth(rowCount);
+    std::vector<double> vecAssembly(rowCount);
+    std::vector<double> vecInstance(rowCount);
+    std::vector<double> vecPart(rowCount);
+    for (size_t row = 0; row < rowCount; ++row) {
+        const TreeNodeId nodeId = docTable.vecTreeNodeId.at(row);
+        const TDF_Label& nodeLabel = modelTree.nodeData(nodeId);
+        const LabelProperties& props = vecLabelProps.at(vecNodeLabelIndex.at(row));
+        vecArea.at(row) = props.area;
+        vecVolume.at(row) = props.volume;
+        if (!props.bndBox.IsVoid()) {
+            const TopLoc_Location loc = doc->xcaf().shapeAbsoluteLocation(nodeId);
+            const Bnd_Box bndBox = props.bndBox.Transformed(loc.Transformation());
+            bndBox.Get(vecBndBox[0].at(row), vecBndBox[1].at(row), vecBndBox[2].at(row),
+                       vecBndBox[3].at(row), vecBndBox[4].at(row), vecBndBox[5].at(row));
+        }
+
+        int depth = 0;
+        for (TreeNodeId it = modelTree.nodeParent(nodeId); it != 0; it = modelTree.nodeParent(it))
+            ++depth;
+
+        vecDepth.at(row) = depth;
+        const bool isAssembly = XCaf::isShapeAssembly(nodeLabel);
+        const bool isInstance = XCaf::isShapeReference(nodeLabel);
+        vecAssembly.at(row) = isAssembly ? 1. : 0.;
+        vecInstance.at(row) = isInstance ? 1. : 0.;
+        vecPart.at(row) = !isAssembly && !isInstance && !XCaf::isShapeSub(nodeLabel) ? 1. : 0.;
+    }
+
+    std::vector<double> vecSize[3];
+    for (int i = 0; i < 3; ++i) {
+        vecSize[i].resize(rowCount);
+        for (size_t row = 0; row < rowCount; ++row)
+            vecSize[i].at(row) = vecBndBox[i + 3].at(row) - vecBndBox[i].at(row);
+    }
+
+    FormulaTable& table = docTable.table;
+    table.addColumn("area", std::move(vecArea));
+    table.addColumn("volume", std::move(vecVolume));
+    table.addColumn("xmin", std::move(vecBndBox[0]));
+    table.addColumn("ymin", std::move(vecBndBox[1]));
+    table.addColumn("zmin", std::move(vecBndBox[2]));
+    table.addColumn("xmax", std::move(vecBndBox[3]));
+    table.addColumn("ymax", std::move(vecBndBox[4]));
+    table.addColumn("zmax", std::move(vecBndBox[5]));
+    table.addColumn("dx", std::move(vecSize[0]));
+    table.addColumn("dy", std::move(vecSize[1]));
+    table.addColumn("dz", std::move(vecSize[2]));
+    table.addColumn("depth", std::move(vecDepth));
+    table.addColumn("assembly", std::move(vecAssembly));
+    table.addColumn("instance", std::move(vecInstance));
+    table.addColumn("part", std::move(vecPart));
+    if (progress)
+        progress->setValue(100);
+
+    return docTable;
+}
+
+double DocumentFormulaTable::sumOfParts(Span<const double> spanValue) const
+{
+    const Span<const double> spanPart = partValues(this->table);
+    const int rowCount = int(std::min(spanValue.size(), spanPart.size()));
+    double sum = 0.;
+    for (int row = 0; row < rowCount; ++row) {
+        if (spanPart[row] != 0.)
+            sum += spanValue[row];
+    }
+
+    return sum;
+}
+
+std::vector<Document::TreeNodeColor> DocumentFormulaTable::bucketColors(
+        Span<const double> spanValue, int bucketCount) const
+{
+    std::vector<Document::TreeNodeColor> vecNodeColor;
+    if (bucketCount < 1)
+        return vecNodeColor;
+
+    const Span<const double> spanPart = partValues(this->table);
+    const int rowCount = int(std::min(spanValue.size(), spanPart.size()));
+    double valueMin = std::numeric_limits<double>::max();
+    double valueMax = std::numeric_limits<double>::lowest();
+    for (int row = 0; row < rowCount; ++row) {
+        if (spanPart[row] != 0. && std::isfinite(spanValue[row])) {
+            valueMin = std::min(valueMin, spanValue[row]);
+            valueMax = std::max(valueMax, spanValue[row]);
+        }
+    }
+
+    // Blue to green to red
+    auto fnBucketColor = [=](int bucket) {
+        const double t = bucketCount > 1 ? bucket / double(bucketCount - 1) : 0.;
+        if (t < 0.5)
+            return Quantity_Color(0., 2 * t, 1 - 2 * t, Quantity_TOC_RGB);
+        else
+            return Quantity_Color(2 * t - 1, 2 - 2 * t, 0., Quantity_TOC_RGB);
+    };
+
+    const double range = valueMax - valueMin;
+    for (int row = 0; row < rowCount; ++row) {
+        if (spanPart[row] == 0. || !std::isfinite(spanValue[row]))
+            continue;
+
+        int bucket = 0;
+        if (range > 0.)
+            bucket = std::min(int((spanValue[row] - valueMin) / range * bucketCount), bucketCount - 1);
+
+        vecNodeColor.push_back({ this->vecTreeNodeId.at(row), fnBucketColor(bucket) });
+    }
+
+    return vecNodeColor;
+}
+
+} // namespace Mayo
@@ -0,0 +1,47 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "document.h"
+#include "document_ptr.h"
+#include "formula.h"
+#include "libtree.h"
+#include "span.h"
+
+#include <vector>
+
+namespace Mayo {
+
+class TaskProgress;
+
+// Properties of the shape nodes of a document model tree, stored as columns so they can be input
+// of formulas
+// Columns are:
+//     - area, volume: in squared and cubic millimeters
+//     - xmin, ymin, zmin, xmax, ymax, zmax: axis-aligned bounding box in global coordinates
+//     - dx, dy, dz: size of the bounding box
+//     - depth: depth of the node in the model tree, 0 for the entities
+//     - assembly, instance, part: 1 if node is of that XDE kind, 0 otherwise
+struct DocumentFormulaTable {
+    std::vector<TreeNodeId> vecTreeNodeId; // Tree node of each row
+    FormulaTable table;
+
+    // Properties are computed in parallel, once per part shared by many nodes(eg instances of the
+    // same part). Area, volume and bounding box of assemblies are aggregated from their components
+    static DocumentFormulaTable build(const DocumentPtr& doc, TaskProgress* progress = nullptr);
+
+    // Sum of the values(eg results of a formula) of the part rows, each being a distinct occurrence
+    // of a part. Assemblies and instances stand for the parts below them, so they're left out
+    double sumOfParts(Span<const double> spanValue) const;
+
+    // Colors of the part rows from the bucket their value falls in, 'bucketCount' buckets evenly
+    // spread between min and max values of the part rows, from blue(lowest) to red(highest)
+    // Rows whose value isn't finite are left out
+    std::vector<Document::TreeNodeColor> bucketColors(Span<const double> spanValue, int bucketCount) const;
+};
+
+} // namespace Mayo
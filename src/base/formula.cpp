@@ -0,0 +1,568 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "formula.h"
+
+#include "task_progress.h"
+
+#include <OSD_Parallel.hxx>
+#include <gsl/gsl_assert>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+
+namespace Mayo {
+
+namespace {
+
+struct FormulaError {
+    QString text;
+};
+
+struct Token {
+    enum class Type { Number, Identifier, Operator, End };
+    Type type;
+    QString text;
+    double number;
+    int position;
+};
+
+template<typename FN> void applyUnary(double* r0, int count, FN fn)
+{
+    for (int i = 0; i < count; ++i)
+        r0[i] = fn(r0[i]);
+}
+
+template<typename FN> void applyBinary(double* r0, const double* r1, int count, FN fn)
+{
+    for (int i = 0; i < count; ++i)
+        r0[i] = fn(r0[i], r1[i]);
+}
+
+} // namespace
+
+int FormulaTable::findColumn(const QString& name) const
+{
+    auto itFound = std::find_if(
+                m_vecColumn.cbegin(), m_vecColumn.cend(), [&](const Column& column) {
+        return column.name == name;
+    });
+    return itFound != m_vecColumn.cend() ? int(itFound - m_vecColumn.cbegin()) : -1;
+}
+
+int FormulaTable::addColumn(const QString& name, std::vector<double>&& vecValue)
+{
+    Expects(m_vecColumn.empty() || int(vecValue.size()) == m_rowCount);
+    m_rowCount = int(vecValue.size());
+    m_vecColumn.push_back({ name, std::move(vecValue) });
+    return int(m_vecColumn.size()) - 1;
+}
+
+// Recursive descent parser emitting bytecode, operators with constant operands are folded
+class Formula::Compiler {
+public:
+    Compiler(const QString& expression, const FormulaTable& table, Formula* formula)
+        : m_table(table), m_formula(formula)
+    {
+        this->tokenize(expression);
+    }
+
+    void run()
+    {
+        this->parseExpression();
+        if (this->current().type != Token::Type::End)
+            this->throwError(Formula::tr("Unexpected '%1'"), this->current());
+    }
+
+private:
+    const Token& current() const { return m_vecToken.at(m_pos); }
+
+    bool accept(const char* op)
+    {
+        const Token& token = this->current();
+        if (token.type == Token::Type::Operator && token.text == QLatin1String(op)) {
+            ++m_pos;
+            return true;
+        }
+
+        return false;
+    }
+
+    void expect(const char* op)
+    {
+        if (!this->accept(op))
+            this->throwError(Formula::tr("'%1' expected, '%2' found").arg(QLatin1String(op)), this->current());
+    }
+
+    [[noreturn]] void throwError(const QString& text, const Token& token) const
+    {
+        const QString tokenText = token.type == Token::Type::End ? Formula::tr("end") : token.text;
+        throw FormulaError{ Formula::tr("%1 at position %2").arg(text.arg(tokenText)).arg(token.position + 1) };
+    }
+
+    void tokenize(const QString& expression)
+    {
+        static const char* const multiCharOps[] = { "<=", ">=", "==", "!=", "&&", "||" };
+        int pos = 0;
+        while (pos < expression.size()) {
+            const QChar c = expression.at(pos);
+            if (c.isSpace()) {
+                ++pos;
+            }
+            else if (c.isDigit() || (c == '.' && pos + 1 < expression.size() && expression.at(pos + 1).isDigit())) {
+                // Longest prefix being a valid number, exponent included
+                int end = pos;
+                while (end < expression.size() && (expression.at(end).isDigit() || expression.at(end) == '.'))
+                    ++end;
+
+                if (end < expression.size() && (expression.at(end) == 'e' || expression.at(end) == 'E')) {
+                    int endExp = end + 1;
+                    if (endExp < expression.size() && (expression.at(endExp) == '+' || expression.at(endExp) == '-'))
+                        ++endExp;
+
+                    if (endExp < expression.size() && expression.at(endExp).isDigit()) {
+                        while (endExp < expression.size() && expression.at(endExp).isDigit())
+                            ++endExp;
+
+                        end = endExp;
+                    }
+                }
+
+                const QString text = expression.mid(pos, end - pos);
+                bool ok = false;
+                const double number = text.toDouble(&ok);
+                const Token token = { Token::Type::Number, text, number, pos };
+                if (!ok)
+                    this->throwError(Formula::tr("Invalid number '%1'"), token);
+
+                m_vecToken.push_back(token);
+                pos = end;
+            }
+            else if (c.isLetter() || c == '_') {
+                int end = pos + 1;
+                while (end < expression.size() && (expression.at(end).isLetterOrNumber() || expression.at(end) == '_'))
+                    ++end;
+
+                m_vecToken.push_back({ Token::Type::Identifier, expression.mid(pos, end - pos), 0., pos });
+                pos = end;
+            }
+            else {
+                const QString text2 = expression.mid(pos, 2);
+                auto itOp = std::find_if(std::cbegin(multiCharOps), std::cend(multiCharOps), [&](const char* op) {
+                    return text2 == QLatin1String(op);
+                });
+                if (itOp != std::cend(multiCharOps)) {
+                    m_vecToken.push_back({ Token::Type::Operator, text2, 0., pos });
+                    pos += 2;
+                }
+                else if (c.unicode() < 128 && QByteArray("+-*/^<>!?:(),").contains(c.toLatin1())) {
+                    m_vecToken.push_back({ Token::Type::Operator, QString(c), 0., pos });
+                    ++pos;
+                }
+                else {
+                    this->throwError(Formula::tr("Invalid character '%1'"), { Token::Type::Operator, QString(c), 0., pos });
+                }
+            }
+        }
+
+        m_vecToken.push_back({ Token::Type::End, QString(), 0., int(expression.size()) });
+    }
+
+    void emitConstant(double value)
+    {
+        m_formula->m_vecConstant.push_back(value);
+        m_formula->m_vecInstruction.push_back({ OpCode::PushConstant, int(m_formula->m_vecConstant.size()) - 1 });
+        this->pushStack();
+    }
+
+    void emitColumn(int column)
+    {
+        m_formula->m_vecInstruction.push_back({ OpCode::PushColumn, column });
+        this->pushStack();
+    }
+
+    void emitOperator(OpCode opCode)
+    {
+        const int argCount = Formula::operandCount(opCode);
+        std::vector<Instruction>& vecInstruction = m_formula->m_vecInstruction;
+        const bool hasConstantArgs = std::all_of(
+                    vecInstruction.end() - argCount, vecInstruction.end(), [](const Instruction& instr) {
+            return instr.opCode == OpCode::PushConstant;
+        });
+        m_stackSize -= argCount - 1;
+        if (hasConstantArgs) {
+            double args[3] = {};
+            for (int i = 0; i < argCount; ++i)
+                args[i] = m_formula->m_vecConstant.at((vecInstruction.end() - argCount + i)->operand);
+
+            Formula::executeOperator(opCode, args, 1, 1);
+            vecInstruction.erase(vecInstruction.end() - argCount, vecInstruction.end());
+            m_formula->m_vecConstant.push_back(args[0]);
+            vecInstruction.push_back({ OpCode::PushConstant, int(m_formula->m_vecConstant.size()) - 1 });
+        }
+        else {
+            vecInstruction.push_back({ opCode, -1 });
+        }
+    }
+
+    void pushStack()
+    {
+        ++m_stackSize;
+        m_formula->m_maxStackSize = std::max(m_formula->m_maxStackSize, m_stackSize);
+    }
+
+    void parseExpression()
+    {
+        this->parseOr();
+        if (this->accept("?")) {
+            this->parseExpression();
+            this->expect(":");
+            this->parseExpression();
+            this->emitOperator(OpCode::Select);
+        }
+    }
+
+    void parseOr()
+    {
+        this->parseAnd();
+        while (this->accept("||")) {
+            this->parseAnd();
+            this->emitOperator(OpCode::Or);
+        }
+    }
+
+    void parseAnd()
+    {
+        this->parseEquality();
+        while (this->accept("&&")) {
+            this->parseEquality();
+            this->emitOperator(OpCode::And);
+        }
+    }
+
+    void parseEquality()
+    {
+        this->parseComparison();
+        for (;;) {
+            if (this->accept("==")) {
+                this->parseComparison();
+                this->emitOperator(OpCode::Equal);
+            }
+            else if (this->accept("!=")) {
+                this->parseComparison();
+                this->emitOperator(OpCode::NotEqual);
+            }
+            else {
+                break;
+            }
+        }
+    }
+
+    void parseComparison()
+    {
+        this->parseAdditive();
+        for (;;) {
+            OpCode opCode;
+            if (this->accept("<="))
+                opCode = OpCode::LessEqual;
+            else if (this->accept(">="))
+                opCode = OpCode::GreaterEqual;
+            else if (this->accept("<"))
+                opCode = OpCode::Less;
+            else if (this->accept(">"))
+                opCode = OpCode::Greater;
+            else
+                break;
+
+            this->parseAdditive();
+            this->emitOperator(opCode);
+        }
+    }
+
+    void parseAdditive()
+    {
+        this->parseMultiplicative();
+        for (;;) {
+            if (this->accept("+")) {
+                this->parseMultiplicative();
+                this->emitOperator(OpCode::Add);
+            }
+            else if (this->accept("-")) {
+                this->parseMultiplicative();
+                this->emitOperator(OpCode::Subtract);
+            }
+            else {
+                break;
+            }
+        }
+    }
+
+    void parseMultiplicative()
+    {
+        this->parseUnary();
+        for (;;) {
+            if (this->accept("*")) {
+                this->parseUnary();
+                this->emitOperator(OpCode::Multiply);
+            }
+            else if (this->accept("/")) {
+                this->parseUnary();
+                this->emitOperator(OpCode::Divide);
+            }
+            else {
+                break;
+            }
+        }
+    }
+
+    void parseUnary()
+    {
+        if (this->accept("-")) {
+            this->parseUnary();
+            this->emitOperator(OpCode::Negate);
+        }
+        else if (this->accept("!")) {
+            this->parseUnary();
+            this->emitOperator(OpCode::Not);
+        }
+        else if (this->accept("+")) {
+            this->parseUnary();
+        }
+        else {
+            this->parsePower();
+        }
+    }
+
+    // Power is right associative and has precedence over unary minus: -2^2 == -4
+    void parsePower()
+    {
+        this->parsePrimary();
+        if (this->accept("^")) {
+            this->parseUnary();
+            this->emitOperator(OpCode::Power);
+        }
+    }
+
+    void parsePrimary()
+    {
+        const Token token = this->current();
+        if (token.type == Token::Type::Number) {
+            ++m_pos;
+            this->emitConstant(token.number);
+        }
+        else if (token.type == Token::Type::Identifier) {
+            ++m_pos;
+            if (this->accept("("))
+                this->parseFunctionCall(token);
+            else
+                this->parseVariable(token);
+        }
+        else if (this->accept("(")) {
+            this->parseExpression();
+            this->expect(")");
+        }
+        else {
+            this->throwError(Formula::tr("Unexpected '%1'"), token);
+        }
+    }
+
+    void parseVariable(const Token& token)
+    {
+        if (token.text == QLatin1String("pi")) {
+            this->emitConstant(3.14159265358979323846);
+            return;
+        }
+
+        const int column = m_table.findColumn(token.text);
+        if (column < 0)
+            this->throwError(Formula::tr("Unknown variable '%1'"), token);
+
+        this->emitColumn(column);
+    }
+
+    void parseFunctionCall(const Token& token)
+    {
+        struct Function {
+            const char* name;
+            OpCode opCode;
+        };
+        static const Function functions[] = {
+            { "abs", OpCode::Abs }, { "sqrt", OpCode::Sqrt }, { "exp", OpCode::Exp }, { "log", OpCode::Log },
+            { "floor", OpCode::Floor }, { "ceil", OpCode::Ceil }, { "round", OpCode::Round },
+            { "min", OpCode::Min }, { "max", OpCode::Max }, { "pow", OpCode::Power },
+            { "if", OpCode::Select }
+        };
+        auto itFunc = std::find_if(std::cbegin(functions), std::cend(functions), [&](const Function& func) {
+            return token.text == QLatin1String(func.name);
+        });
+        if (itFunc == std::cend(functions))
+            this->throwError(Formula::tr("Unknown function '%1'"), token);
+
+        const int argCount = Formula::operandCount(itFunc->opCode);
+        for (int i = 0; i < argCount; ++i) {
+            if (i > 0)
+                this->expect(",");
+
+            this->parseExpression();
+        }
+
+        if (!this->accept(")")) {
+            const QString errorText =
+                    Formula::tr("Function '%1' expects %2 argument(s)").arg(token.text).arg(argCount);
+            this->throwError(errorText + QLatin1String(", '%1' found"), this->current());
+        }
+
+        this->emitOperator(itFunc->opCode);
+    }
+
+    const FormulaTable& m_table;
+    Formula* m_formula = nullptr;
+    std::vector<Token> m_vecToken;
+    int m_pos = 0;
+    int m_stackSize = 0;
+};
+
+Result<Formula> Formula::compile(const QString& expression, const FormulaTable& table)
+{
+    Formula formula;
+    formula.m_expression = expression;
+    try {
+        Compiler compiler(expression, table, &formula);
+        compiler.run();
+    } catch (const FormulaError& err) {
+        return Result<Formula>::error(err.text);
+    }
+
+    return Result<Formula>::ok(std::move(formula));
+}
+
+bool Formula::evaluate(const FormulaTable& table, Span<double> results, TaskProgress* progress) const
+{
+    Expects(int(results.size()) == table.rowCount());
+    if (this->isNull())
+        return true;
+
+    // Each parallel job evaluates a chunk of blocks, reusing its registers
+    constexpr int chunkSize = 16 * BlockSize;
+    const int rowCount = table.rowCount();
+    const int chunkCount = (rowCount + chunkSize - 1) / chunkSize;
+    OSD_Parallel::For(0, chunkCount, [&](int iChunk) {
+        std::vector<double> vecRegister(m_maxStackSize * BlockSize);
+        const int chunkEnd = std::min((iChunk + 1) * chunkSize, rowCount);
+        for (int rowStart = iChunk * chunkSize; rowStart < chunkEnd; rowStart += BlockSize) {
+            if (TaskProgress::isAbortRequested(progress))
+                return;
+
+            const int blockRowCount = std::min(BlockSize, chunkEnd - rowStart);
+            this->evaluateBlock(table, rowStart, blockRowCount, vecRegister.data());
+            std::memcpy(results.data() + rowStart, vecRegister.data(), blockRowCount * sizeof(double));
+        }
+    });
+
+    if (TaskProgress::isAbortRequested(progress))
+        return false;
+
+    if (progress)
+        progress->setValue(100);
+
+    return true;
+}
+
+std::vector<double> Formula::evaluate(const FormulaTable& table) const
+{
+    std::vector<double> results(table.rowCount(), 0.);
+    this->evaluate(table, results);
+    return results;
+}
+
+int Formula::operandCount(OpCode opCode)
+{
+    switch (opCode) {
+    case OpCode::PushConstant:
+    case OpCode::PushColumn:
+        return 0;
+    case OpCode::Negate:
+    case OpCode::Not:
+    case OpCode::Abs:
+    case OpCode::Sqrt:
+    case OpCode::Exp:
+    case OpCode::Log:
+    case OpCode::Floor:
+    case OpCode::Ceil:
+    case OpCode::Round:
+        return 1;
+    case OpCode::Select:
+        return 3;
+    default:
+        return 2;
+    }
+}
+
+void Formula::executeOperator(OpCode opCode, double* registers, int stride, int count)
+{
+    double* r0 = registers;
+    const double* r1 = registers + stride;
+    const double* r2 = registers + 2 * stride;
+    switch (opCode) {
+    case OpCode::PushConstant:
+    case OpCode::PushColumn:
+        break;
+    case OpCode::Negate: applyUnary(r0, count, [](double x) { return -x; }); break;
+    case OpCode::Not: applyUnary(r0, count, [](double x) { return x == 0. ? 1. : 0.; }); break;
+    case OpCode::Abs: applyUnary(r0, count, [](double x) { return std::abs(x); }); break;
+    case OpCode::Sqrt: applyUnary(r0, count, [](double x) { return std::sqrt(x); }); break;
+    case OpCode::Exp: applyUnary(r0, count, [](double x) { return std::exp(x); }); break;
+    case OpCode::Log: applyUnary(r0, count, [](double x) { return std::log(x); }); break;
+    case OpCode::Floor: applyUnary(r0, count, [](double x) { return std::floor(x); }); break;
+    case OpCode::Ceil: applyUnary(r0, count, [](double x) { return std::ceil(x); }); break;
+    case OpCode::Round: applyUnary(r0, count, [](double x) { return std::round(x); }); break;
+    case OpCode::Add: applyBinary(r0, r1, count, [](double a, double b) { return a + b; }); break;
+    case OpCode::Subtract: applyBinary(r0, r1, count, [](double a, double b) { return a - b; }); break;
+    case OpCode::Multiply: applyBinary(r0, r1, count, [](double a, double b) { return a * b; }); break;
+    case OpCode::Divide: applyBinary(r0, r1, count, [](double a, double b) { return a / b; }); break;
+    case OpCode::Power: applyBinary(r0, r1, count, [](double a, double b) { return std::pow(a, b); }); break;
+    case OpCode::Less: applyBinary(r0, r1, count, [](double a, double b) { return a < b ? 1. : 0.; }); break;
+    case OpCode::LessEqual: applyBinary(r0, r1, count, [](double a, double b) { return a <= b ? 1. : 0.; }); break;
+    case OpCode::Greater: applyBinary(r0, r1, count, [](double a, double b) { return a > b ? 1. : 0.; }); break;
+    case OpCode::GreaterEqual: applyBinary(r0, r1, count, [](double a, double b) { return a >= b ? 1. : 0.; }); break;
+    case OpCode::Equal: applyBinary(r0, r1, count, [](double a, double b) { return a == b ? 1. : 0.; }); break;
+    case OpCode::NotEqual: applyBinary(r0, r1, count, [](double a, double b) { return a != b ? 1. : 0.; }); break;
+    case OpCode::And: applyBinary(r0, r1, count, [](double a, double b) { return a != 0. && b != 0. ? 1. : 0.; }); break;
+    case OpCode::Or: applyBinary(r0, r1, count, [](double a, double b) { return a != 0. || b != 0. ? 1. : 0.; }); break;
+    case OpCode::Min: applyBinary(r0, r1, count, [](double a, double b) { return std::min(a, b); }); break;
+    case OpCode::Max: applyBinary(r0, r1, count, [](double a, double b) { return std::max(a, b); }); break;
+    case OpCode::Select:
+        for (int i = 0; i < count; ++i)
+            r0[i] = r0[i] != 0. ? r1[i] : r2[i];
+        break;
+    }
+}
+
+void Formula::evaluateBlock(const FormulaTable& table, int rowStart, int rowCount, double* registers) const
+{
+    int stackSize = 0;
+    for (const Instruction& instr : m_vecInstruction) {
+        double* top = registers + stackSize * BlockSize;
+        if (instr.opCode == OpCode::PushConstant) {
+            std::fill(top, top + rowCount, m_vecConstant.at(instr.operand));
+            ++stackSize;
+        }
+        else if (instr.opCode == OpCode::PushColumn) {
+            const double* values = table.columnValues(instr.operand).data() + rowStart;
+            std::memcpy(top, values, rowCount * sizeof(double));
+            ++stackSize;
+        }
+        else {
+            const int argCount = Formula::operandCount(instr.opCode);
+            stackSize -= argCount;
+            Formula::executeOperator(instr.opCode, registers + stackSize * BlockSize, BlockSize, rowCount);
+            ++stackSize;
+        }
+    }
+}
+
+} // namespace Mayo
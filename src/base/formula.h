@@ -0,0 +1,106 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "result.h"
+#include "span.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QString>
+#include <vector>
+
+namespace Mayo {
+
+class TaskProgress;
+
+// Table of numeric values stored per column, input of formulas
+// All columns have the same count of values(rows)
+class FormulaTable {
+public:
+    int rowCount() const { return m_rowCount; }
+    int columnCount() const { return int(m_vecColumn.size()); }
+
+    // Returns the index of column named 'name'(case sensitive), -1 if not found
+    int findColumn(const QString& name) const;
+    const QString& columnName(int index) const { return m_vecColumn.at(index).name; }
+    Span<const double> columnValues(int index) const { return m_vecColumn.at(index).vecValue; }
+
+    // Count of values in 'vecValue' must be the same as the ones of already added columns
+    // Returns the index of the new column
+    int addColumn(const QString& name, std::vector<double>&& vecValue);
+
+private:
+    struct Column {
+        QString name;
+        std::vector<double> vecValue;
+    };
+
+    std::vector<Column> m_vecColumn;
+    int m_rowCount = 0;
+};
+
+// Arithmetic expression compiled to bytecode, evaluated over all the rows of a FormulaTable
+//
+// Syntax is close to C:
+//     - numbers, 'pi' constant, column names as variables
+//     - binary operators + - * / ^(power) < <= > >= == != && ||, unary operators - !
+//     - ternary operator 'cond ? a : b'
+//     - functions abs sqrt exp log floor ceil round min max pow if(cond, a, b)
+// Comparison and logical operators give 1 for true and 0 for false
+//
+// Bytecode is executed by a stack machine whose registers are blocks of consecutive rows, so each
+// instruction is dispatched once per block and not once per row. Blocks are evaluated in parallel
+class Formula {
+    Q_DECLARE_TR_FUNCTIONS(Mayo::Formula)
+public:
+    // Variables of 'expression' are resolved against the columns of 'table'
+    static Result<Formula> compile(const QString& expression, const FormulaTable& table);
+
+    bool isNull() const { return m_vecInstruction.empty(); }
+    const QString& expression() const { return m_expression; }
+
+    // Evaluates the formula for each row of 'table', which must have the same column layout as the
+    // table used to compile the formula. Count of items in 'results' must be table.rowCount()
+    // Returns false if aborted with 'progress'
+    bool evaluate(const FormulaTable& table, Span<double> results, TaskProgress* progress = nullptr) const;
+    std::vector<double> evaluate(const FormulaTable& table) const;
+
+    // Maximum count of rows evaluated by a single instruction
+    static constexpr int BlockSize = 256;
+
+private:
+    enum class OpCode {
+        PushConstant, PushColumn,
+        Negate, Not,
+        Add, Subtract, Multiply, Divide, Power,
+        Less, LessEqual, Greater, GreaterEqual, Equal, NotEqual, And, Or,
+        Abs, Sqrt, Exp, Log, Floor, Ceil, Round,
+        Min, Max,
+        Select // Pops condition, value if true, value if false
+    };
+
+    struct Instruction {
+        OpCode opCode;
+        int operand; // Index of constant or column
+    };
+
+    class Compiler;
+    friend class Compiler;
+
+    static int operandCount(OpCode opCode);
+    // Applies operator on 'count' rows. Operand i is the register at 'registers + i*stride', result
+    // is written in the register of the first operand
+    static void executeOperator(OpCode opCode, double* registers, int stride, int count);
+    void evaluateBlock(const FormulaTable& table, int rowStart, int rowCount, double* registers) const;
+
+    QString m_expression;
+    std::vector<Instruction> m_vecInstruction;
+    std::vector<double> m_vecConstant;
+    int m_maxStackSize = 0;
+};
+
+} // namespace Mayo
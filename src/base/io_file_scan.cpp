@@ -0,0 +1,837 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "io_file_scan.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QLocale>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Mayo {
+namespace IO {
+
+namespace {
+
+// Records are checked against the time budget once every 'timeCheckPeriod' records
+constexpr int64_t timeCheckPeriod = 4096;
+
+using Text = std::string_view;
+
+bool isBlank(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+bool isKeywordChar(char c)
+{
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_' || c == '-';
+}
+
+Text trimmed(Text text)
+{
+    while (!text.empty() && isBlank(text.front()))
+        text.remove_prefix(1);
+
+    while (!text.empty() && isBlank(text.back()))
+        text.remove_suffix(1);
+
+    return text;
+}
+
+std::vector<FileScan::EntityTypeCount> sortedEntityTypeCounts(std::vector<FileScan::EntityTypeCount>&& vec)
+{
+    std::sort(vec.begin(), vec.end(), [](const FileScan::EntityTypeCount& lhs, const FileScan::EntityTypeCount& rhs) {
+        return lhs.count != rhs.count ? lhs.count > rhs.count : lhs.type < rhs.type;
+    });
+    return std::move(vec);
+}
+
+// --
+// -- STEP
+// --
+
+// Returns position after the comment starting at 'it'("/*" expected)
+const char* skipStepComment(const char* it, const char* end)
+{
+    for (it += 2; it + 1 < end; ++it) {
+        if (it[0] == '*' && it[1] == '/')
+            return it + 2;
+    }
+
+    return end;
+}
+
+// Returns position after the string starting at 'it'(quote expected), escaped quote '' is
+// handled as two consecutive strings
+const char* skipStepString(const char* it, const char* end)
+{
+    auto itQuote = static_cast<const char*>(std::memchr(it + 1, '\'', end - it - 1));
+    return itQuote ? itQuote + 1 : end;
+}
+
+const char* skipStepBlanks(const char* it, const char* end)
+{
+    while (it != end) {
+        if (isBlank(*it))
+            ++it;
+        else if (*it == '/' && it + 1 != end && it[1] == '*')
+            it = skipStepComment(it, end);
+        else
+            break;
+    }
+
+    return it;
+}
+
+// Returns position of the ';' terminating the record starting at 'it', 'end' if none
+const char* findStepRecordEnd(const char* it, const char* end)
+{
+    while (it != end) {
+        const char c = *it;
+        if (c == ';')
+            return it;
+        else if (c == '\'')
+            it = skipStepString(it, end);
+        else if (c == '/' && it + 1 != end && it[1] == '*')
+            it = skipStepComment(it, end);
+        else
+            ++it;
+    }
+
+    return end;
+}
+
+// Returns position of the parenthesis closing the one at 'it', 'end' if none
+const char* findStepClosingParenthesis(const char* it, const char* end)
+{
+    int depth = 0;
+    while (it != end) {
+        const char c = *it;
+        if (c == '\'') {
+            it = skipStepString(it, end);
+            continue;
+        }
+
+        if (c == '(')
+            ++depth;
+        else if (c == ')' && --depth == 0)
+            return it;
+
+        ++it;
+    }
+
+    return end;
+}
+
+// Top-level parameters of a record, 'args' being the text between its parentheses
+std::vector<Text> splitStepParams(Text args)
+{
+    std::vector<Text> vecParam;
+    const char* it = args.data();
+    const char* const end = args.data() + args.size();
+    const char* itParam = it;
+    int depth = 0;
+    while (it != end) {
+        const char c = *it;
+        if (c == '\'') {
+            it = skipStepString(it, end);
+            continue;
+        }
+
+        if (c == '(') {
+            ++depth;
+        }
+        else if (c == ')') {
+            --depth;
+        }
+        else if (c == ',' && depth == 0) {
+            vecParam.push_back(trimmed(Text(itParam, it - itParam)));
+            itParam = it + 1;
+        }
+
+        ++it;
+    }
+
+    const Text lastParam = trimmed(Text(itParam, end - itParam));
+    if (!lastParam.empty() || !vecParam.empty())
+        vecParam.push_back(lastParam);
+
+    return vecParam;
+}
+
+Text stepParam(const std::vector<Text>& vecParam, size_t index)
+{
+    return index < vecParam.size() ? vecParam.at(index) : Text();
+}
+
+// Returns entity number of reference "#N", -1 otherwise
+int64_t stepIdent(Text text)
+{
+    if (text.size() < 2 || text.front() != '#')
+        return -1;
+
+    int64_t ident = 0;
+    for (char c : text.substr(1)) {
+        if (c < '0' || c > '9')
+            return -1;
+
+        ident = ident * 10 + (c - '0');
+    }
+
+    return ident;
+}
+
+int hexDigitValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    else if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    else if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+
+    return -1;
+}
+
+// Decodes STEP string literal(with quotes), handles escaped quotes/backslashes and encodings
+// \X\hh(ISO 8859-1) and \X2\hhhh..\X0\(UTF-16)
+QString decodeStepString(Text text)
+{
+    if (text.size() < 2 || text.front() != '\'' || text.back() != '\'')
+        return {};
+
+    text = text.substr(1, text.size() - 2);
+    QString str;
+    str.reserve(int(text.size()));
+    size_t i = 0;
+    auto fnHexValue = [&](size_t pos, int digitCount) {
+        int value = 0;
+        for (int j = 0; j < digitCount; ++j) {
+            const int digit = pos + j < text.size() ? hexDigitValue(text[pos + j]) : -1;
+            if (digit < 0)
+                return -1;
+
+            value = value * 16 + digit;
+        }
+
+        return value;
+    };
+    while (i < text.size()) {
+        const char c = text[i];
+        if (c == '\'' && i + 1 < text.size() && text[i + 1] == '\'') {
+            str += QLatin1Char('\'');
+            i += 2;
+        }
+        else if (c == '\\' && text.substr(i, 2) == "\\\\") {
+            str += QLatin1Char('\\');
+            i += 2;
+        }
+        else if (text.substr(i, 3) == "\\X\\" && fnHexValue(i + 3, 2) >= 0) {
+            str += QChar(fnHexValue(i + 3, 2));
+            i += 5;
+        }
+        else if (text.substr(i, 4) == "\\X2\\") {
+            i += 4;
+            while (i < text.size() && text.substr(i, 4) != "\\X0\\") {
+                const int code = fnHexValue(i, 4);
+                if (code < 0)
+                    break;
+
+                str += QChar(code);
+                i += 4;
+            }
+
+            i += 4;
+        }
+        else {
+            str += QLatin1Char(c);
+            ++i;
+        }
+    }
+
+    return str;
+}
+
+QString stepLengthUnit(Text siPrefix, Text siName)
+{
+    static const std::pair<Text, const char*> arrayPrefix[] = {
+        { ".MILLI.", "m" }, { ".CENTI.", "c" }, { ".DECI.", "d" },
+        { ".KILO.", "k" }, { ".MICRO.", "µ" }, { ".NANO.", "n" }
+    };
+    if (siName != ".METRE.")
+        return {};
+
+    for (const auto& prefix : arrayPrefix) {
+        if (prefix.first == siPrefix)
+            return QString::fromUtf8(prefix.second) + "m";
+    }
+
+    return QStringLiteral("m");
+}
+
+// Data of interest collected while streaming STEP records
+class StepScanner {
+public:
+    StepScanner(FileScan* scan) : m_scan(scan) {}
+
+    void processRecord(const char* it, const char* end) {
+        it = skipStepBlanks(it, end);
+        if (it == end)
+            return;
+
+        if (*it == '#')
+            this->processEntity(it, end);
+        else
+            this->processHeaderRecord(it, end);
+    }
+
+    void finalize() {
+        std::vector<FileScan::EntityTypeCount> vecTypeCount;
+        for (const auto& typeCount : m_mapTypeCount)
+            vecTypeCount.push_back({ QString::fromLatin1(typeCount.first.data(), int(typeCount.first.size())), typeCount.second });
+
+        for (const auto& typeCount : m_mapComplexTypeCount)
+            vecTypeCount.push_back({ QString::fromStdString(typeCount.first), typeCount.second });
+
+        m_scan->vecEntityTypeCount = sortedEntityTypeCounts(std::move(vecTypeCount));
+
+        // Assembly structure: NAUO -> PRODUCT_DEFINITION -> PRODUCT_DEFINITION_FORMATION -> PRODUCT
+        auto fnProductIndex = [=](int64_t productDefinitionId) {
+            auto itFormation = m_mapDefinitionFormation.find(productDefinitionId);
+            if (itFormation == m_mapDefinitionFormation.cend())
+                return -1;
+
+            auto itProduct = m_mapFormationProduct.find(itFormation->second);
+            if (itProduct == m_mapFormationProduct.cend())
+                return -1;
+
+            auto itIndex = m_mapProductIndex.find(itProduct->second);
+            return itIndex != m_mapProductIndex.cend() ? itIndex->second : -1;
+        };
+        for (const auto& link : m_vecAssemblyLink) {
+            const int parentIndex = fnProductIndex(link.first);
+            const int childIndex = fnProductIndex(link.second);
+            if (parentIndex >= 0 && childIndex >= 0)
+                m_scan->vecProduct.at(parentIndex).vecComponent.push_back(childIndex);
+        }
+
+        m_scan->assemblyComponentCount = int(m_vecAssemblyLink.size());
+    }
+
+private:
+    void processHeaderRecord(const char* it, const char* end) {
+        const char* itKeyword = it;
+        while (it != end && isKeywordChar(*it))
+            ++it;
+
+        const Text keyword(itKeyword, it - itKeyword);
+        if (keyword != "FILE_NAME" && keyword != "FILE_SCHEMA")
+            return;
+
+        const std::vector<Text> vecParam = splitStepParams(this->recordArgs(it, end));
+        if (keyword == "FILE_NAME") {
+            // Parameters: name, time_stamp, author, organization, preprocessor_version,
+            //             originating_system, authorization
+            m_scan->originatingSystem = decodeStepString(stepParam(vecParam, 5));
+            if (m_scan->originatingSystem.isEmpty())
+                m_scan->originatingSystem = decodeStepString(stepParam(vecParam, 4));
+        }
+        else {
+            Text schemas = stepParam(vecParam, 0);
+            if (schemas.size() >= 2 && schemas.front() == '(') {
+                QStringList listSchema;
+                for (Text schema : splitStepParams(schemas.substr(1, schemas.size() - 2)))
+                    listSchema.push_back(decodeStepString(schema));
+
+                m_scan->schema = listSchema.join(", ");
+            }
+        }
+    }
+
+    void processEntity(const char* it, const char* end) {
+        ++m_scan->entityCount;
+        const char* itEqual = static_cast<const char*>(std::memchr(it, '=', end - it));
+        const int64_t ident = stepIdent(trimmed(Text(it, itEqual ? itEqual - it : 0)));
+        if (!itEqual)
+            return;
+
+        it = skipStepBlanks(itEqual + 1, end);
+        if (it != end && *it == '(') {
+            this->processComplexEntity(it, end);
+            return;
+        }
+
+        const char* itType = it;
+        while (it != end && isKeywordChar(*it))
+            ++it;
+
+        const Text type(itType, it - itType);
+        ++m_mapTypeCount[type];
+        // Fast rejection, all types of interest start with 'P' or 'N'
+        if (type.empty() || (type.front() != 'P' && type.front() != 'N'))
+            return;
+
+        if (type == "PRODUCT") {
+            // Parameters: id, name, description, frame_of_reference
+            const std::vector<Text> vecParam = splitStepParams(this->recordArgs(it, end));
+            FileScan::Product product;
+            product.name = decodeStepString(stepParam(vecParam, 1));
+            if (product.name.isEmpty())
+                product.name = decodeStepString(stepParam(vecParam, 0));
+
+            m_mapProductIndex.emplace(ident, int(m_scan->vecProduct.size()));
+            m_scan->vecProduct.push_back(std::move(product));
+        }
+        else if (type == "PRODUCT_DEFINITION_FORMATION"
+                 || type == "PRODUCT_DEFINITION_FORMATION_WITH_SPECIFIED_SOURCE")
+        {
+            // Parameters: id, description, of_product, ...
+            const std::vector<Text> vecParam = splitStepParams(this->recordArgs(it, end));
+            m_mapFormationProduct.emplace(ident, stepIdent(stepParam(vecParam, 2)));
+        }
+        else if (type == "PRODUCT_DEFINITION") {
+            // Parameters: id, description, formation, frame_of_reference
+            const std::vector<Text> vecParam = splitStepParams(this->recordArgs(it, end));
+            m_mapDefinitionFormation.emplace(ident, stepIdent(stepParam(vecParam, 2)));
+        }
+        else if (type == "NEXT_ASSEMBLY_USAGE_OCCURRENCE") {
+            // Parameters: id, name, description, relating_product_definition,
+            //             related_product_definition, reference_designator
+            const std::vector<Text> vecParam = splitStepParams(this->recordArgs(it, end));
+            m_vecAssemblyLink.emplace_back(stepIdent(stepParam(vecParam, 3)), stepIdent(stepParam(vecParam, 4)));
+        }
+    }
+
+    // Complex entity "(TYPE1(...) TYPE2(...) ...)"
+    void processComplexEntity(const char* it, const char* end) {
+        std::string complexType = "(";
+        Text siUnitArgs;
+        Text conversionUnitArgs;
+        bool isLengthUnit = false;
+        for (it = skipStepBlanks(it + 1, end); it != end && *it != ')'; it = skipStepBlanks(it, end)) {
+            const char* itType = it;
+            while (it != end && isKeywordChar(*it))
+                ++it;
+
+            const Text type(itType, it - itType);
+            it = skipStepBlanks(it, end);
+            if (type.empty() || it == end || *it != '(')
+                break;
+
+            const char* itClose = findStepClosingParenthesis(it, end);
+            const Text args(it + 1, itClose - it - 1);
+            it = itClose != end ? itClose + 1 : end;
+            if (complexType.size() > 1)
+                complexType += ' ';
+
+            complexType.append(type.data(), type.size());
+            if (type == "LENGTH_UNIT")
+                isLengthUnit = true;
+            else if (type == "SI_UNIT")
+                siUnitArgs = args;
+            else if (type == "CONVERSION_BASED_UNIT")
+                conversionUnitArgs = args;
+        }
+
+        complexType += ')';
+        ++m_mapComplexTypeCount[complexType];
+        if (!isLengthUnit)
+            return;
+
+        QString unit;
+        if (!conversionUnitArgs.empty()) {
+            unit = decodeStepString(stepParam(splitStepParams(conversionUnitArgs), 0)).toLower();
+        }
+        else if (!siUnitArgs.empty()) {
+            const std::vector<Text> vecParam = splitStepParams(siUnitArgs);
+            unit = stepLengthUnit(stepParam(vecParam, 0), stepParam(vecParam, 1));
+        }
+
+        if (!unit.isEmpty() && !m_scan->lengthUnits.contains(unit))
+            m_scan->lengthUnits.push_back(unit);
+    }
+
+    // Text between the parentheses following 'it'
+    Text recordArgs(const char* it, const char* end) const {
+        auto itOpen = static_cast<const char*>(std::memchr(it, '(', end - it));
+        if (!itOpen)
+            return {};
+
+        const char* itClose = findStepClosingParenthesis(itOpen, end);
+        return Text(itOpen + 1, itClose - itOpen - 1);
+    }
+
+    FileScan* m_scan;
+    std::unordered_map<Text, int64_t> m_mapTypeCount; // Keys point to mapped file contents
+    std::unordered_map<std::string, int64_t> m_mapComplexTypeCount;
+    std::unordered_map<int64_t, int> m_mapProductIndex;
+    std::unordered_map<int64_t, int64_t> m_mapFormationProduct;
+    std::unordered_map<int64_t, int64_t> m_mapDefinitionFormation;
+    std::vector<std::pair<int64_t, int64_t>> m_vecAssemblyLink;
+};
+
+// --
+// -- IGES
+// --
+
+// Parses fields of the global section, handling custom delimiters and Hollerith strings("nHxxx")
+std::vector<QString> parseIgesGlobalSection(Text text)
+{
+    std::vector<QString> vecField;
+    char paramDelimiter = ',';
+    char recordDelimiter = ';';
+    size_t pos = 0;
+    auto fnSkipSpaces = [&]{
+        while (pos < text.size() && text[pos] == ' ')
+            ++pos;
+    };
+    auto fnReadField = [&]() -> QString {
+        fnSkipSpaces();
+        size_t posDigitEnd = pos;
+        while (posDigitEnd < text.size() && text[posDigitEnd] >= '0' && text[posDigitEnd] <= '9')
+            ++posDigitEnd;
+
+        // Hollerith length, an overflowing one is handled as a non-Hollerith field
+        bool isLenValid = posDigitEnd > pos;
+        size_t len = 0;
+        for (size_t i = pos; i < posDigitEnd && isLenValid; ++i) {
+            const size_t digit = size_t(text[i] - '0');
+            isLenValid = len <= (std::numeric_limits<size_t>::max() - digit) / 10;
+            len = len * 10 + digit;
+        }
+
+        if (isLenValid && posDigitEnd < text.size() && text[posDigitEnd] == 'H') {
+            const Text str = text.substr(posDigitEnd + 1, len);
+            pos = posDigitEnd + 1 + str.size();
+            fnSkipSpaces();
+            return QString::fromLatin1(str.data(), int(str.size()));
+        }
+
+        const size_t posBegin = pos;
+        while (pos < text.size() && text[pos] != paramDelimiter && text[pos] != recordDelimiter)
+            ++pos;
+
+        const Text str = trimmed(text.substr(posBegin, pos - posBegin));
+        return QString::fromLatin1(str.data(), int(str.size()));
+    };
+
+    while (pos < text.size()) {
+        const QString field = fnReadField();
+        // First two fields may redefine the delimiters, then used to separate them
+        if (vecField.size() == 0 && !field.isEmpty())
+            paramDelimiter = field.at(0).toLatin1();
+        else if (vecField.size() == 1 && !field.isEmpty())
+            recordDelimiter = field.at(0).toLatin1();
+
+        vecField.push_back(field);
+        if (pos >= text.size() || text[pos] == recordDelimiter)
+            break;
+
+        ++pos; // Skip parameter delimiter
+    }
+
+    return vecField;
+}
+
+QString igesField(const std::vector<QString>& vecField, size_t num)
+{
+    return num >= 1 && num <= vecField.size() ? vecField.at(num - 1) : QString();
+}
+
+QString igesVersion(int flag)
+{
+    static const char* const arrayVersion[] = {
+        "1.0", "ANSI Y14.26M-1981", "2.0", "3.0", "ASME/ANSI Y14.26M-1987",
+        "4.0", "ASME Y14.26M-1989", "5.0", "5.1", "5.2", "5.3"
+    };
+    if (flag >= 1 && flag <= int(std::size(arrayVersion)))
+        return QString("IGES %1").arg(arrayVersion[flag - 1]);
+
+    return {};
+}
+
+QString igesLengthUnit(int flag, const QString& name)
+{
+    static const char* const arrayUnit[] = {
+        "inch", "mm", "", "ft", "mi", "m", "km", "mil", "µm", "cm", "µin"
+    };
+    if (!name.isEmpty())
+        return name.toLower() == QLatin1String("in") ? QStringLiteral("inch") : name.toLower();
+
+    if (flag >= 1 && flag <= int(std::size(arrayUnit)))
+        return QString::fromUtf8(arrayUnit[flag - 1]);
+
+    return {};
+}
+
+QString igesEntityTypeName(int type)
+{
+    static const std::pair<int, const char*> arrayTypeName[] = {
+        { 100, "Circular Arc" }, { 102, "Composite Curve" }, { 104, "Conic Arc" },
+        { 106, "Copious Data" }, { 108, "Plane" }, { 110, "Line" },
+        { 112, "Parametric Spline Curve" }, { 114, "Parametric Spline Surface" }, { 116, "Point" },
+        { 118, "Ruled Surface" }, { 120, "Surface of Revolution" }, { 122, "Tabulated Cylinder" },
+        { 124, "Transformation Matrix" }, { 126, "Rational B-Spline Curve" },
+        { 128, "Rational B-Spline Surface" }, { 140, "Offset Surface" },
+        { 142, "Curve on a Parametric Surface" }, { 143, "Bounded Surface" }, { 144, "Trimmed Surface" },
+        { 186, "Manifold Solid B-Rep Object" }, { 190, "Plane Surface" },
+        { 192, "Right Circular Cylindrical Surface" }, { 194, "Right Circular Conical Surface" },
+        { 196, "Spherical Surface" }, { 198, "Toroidal Surface" },
+        { 308, "Subfigure Definition" }, { 314, "Color Definition" }, { 402, "Associativity Instance" },
+        { 406, "Property" }, { 408, "Singular Subfigure Instance" }, { 502, "Vertex" }, { 504, "Edge" },
+        { 508, "Loop" }, { 510, "Face" }, { 514, "Shell" }
+    };
+    for (const auto& typeName : arrayTypeName) {
+        if (typeName.first == type)
+            return QString("%1 %2").arg(type).arg(typeName.second);
+    }
+
+    return QString::number(type);
+}
+
+} // namespace
+
+int64_t FileScan::estimatedEntityCount() const
+{
+    if (this->isComplete() || this->scannedSize <= 0)
+        return this->entityCount;
+
+    return int64_t(double(this->entityCount) * double(this->fileSize) / double(this->scannedSize));
+}
+
+std::vector<int> FileScan::rootProducts() const
+{
+    std::vector<bool> vecIsComponent(this->vecProduct.size(), false);
+    for (const Product& product : this->vecProduct) {
+        for (int index : product.vecComponent)
+            vecIsComponent.at(index) = true;
+    }
+
+    std::vector<int> vecRoot;
+    for (size_t i = 0; i < vecIsComponent.size(); ++i) {
+        if (!vecIsComponent.at(i))
+            vecRoot.push_back(int(i));
+    }
+
+    return vecRoot;
+}
+
+QString FileScan::summaryText(int maxEntityTypeCount, int maxProductCount) const
+{
+    const QLocale locale;
+    QStringList lines;
+    if (!this->schema.isEmpty())
+        lines.push_back(tr("Schema: %1").arg(this->schema));
+
+    if (!this->originatingSystem.isEmpty())
+        lines.push_back(tr("Originating system: %1").arg(this->originatingSystem));
+
+    if (!this->lengthUnits.isEmpty())
+        lines.push_back(tr("Length unit: %1").arg(this->lengthUnits.join(", ")));
+
+    // Counts of a partial scan are lower bounds
+    auto fnCountText = [&](int64_t count) {
+        const QString strCount = locale.toString(qlonglong(count));
+        return this->isComplete() ? strCount : tr("at least %1").arg(strCount);
+    };
+    if (!this->vecProduct.empty()) {
+        lines.push_back(tr("Products: %1").arg(fnCountText(int64_t(this->vecProduct.size()))));
+        if (this->assemblyComponentCount > 0)
+            lines.push_back(tr("Assembly components: %1").arg(fnCountText(this->assemblyComponentCount)));
+
+        // Assembly tree, instances of the same product are grouped
+        int productLineCount = 0;
+        std::function<void(int, int)> fnAddProductLines = [&](int index, int depth) {
+            if (productLineCount++ >= maxProductCount) {
+                if (productLineCount == maxProductCount + 1)
+                    lines.push_back(QString(2 * (depth + 1), QChar(' ')) + "...");
+
+                return;
+            }
+
+            const Product& product = this->vecProduct.at(index);
+            lines.push_back(QString(2 * (depth + 1), QChar(' ')) + product.name);
+            std::vector<int> vecComponent = product.vecComponent;
+            std::sort(vecComponent.begin(), vecComponent.end());
+            for (auto it = vecComponent.cbegin(); it != vecComponent.cend() && depth < 16; ) {
+                const auto itNext = std::upper_bound(it, vecComponent.cend(), *it);
+                const int instanceCount = int(itNext - it);
+                const int lineIndex = lines.size();
+                fnAddProductLines(*it, depth + 1);
+                if (instanceCount > 1 && lineIndex < lines.size())
+                    lines[lineIndex] += QString(" (x%1)").arg(instanceCount);
+
+                it = itNext;
+            }
+        };
+        for (int index : this->rootProducts())
+            fnAddProductLines(index, 0);
+    }
+
+    if (this->isComplete()) {
+        lines.push_back(tr("Entities: %1").arg(locale.toString(qlonglong(this->entityCount))));
+    }
+    else {
+        const int pctScanned = int(100 * this->scannedSize / std::max<int64_t>(1, this->fileSize));
+        lines.push_back(tr("Entities: ~%1 (estimated, %2% of file scanned)")
+                        .arg(locale.toString(qlonglong(this->estimatedEntityCount())))
+                        .arg(pctScanned));
+    }
+
+    const int typeCount = std::min(int(this->vecEntityTypeCount.size()), maxEntityTypeCount);
+    for (int i = 0; i < typeCount; ++i) {
+        const EntityTypeCount& typeCount = this->vecEntityTypeCount.at(i);
+        lines.push_back(QString("  %1: %2").arg(typeCount.type, fnCountText(typeCount.count)));
+    }
+
+    if (int(this->vecEntityTypeCount.size()) > typeCount)
+        lines.push_back("  ...");
+
+    return lines.join('\n');
+}
+
+FileScan scanFile_STEP(const QString& filepath, int timeBudgetMs)
+{
+    FileScan scan;
+    QFile file(filepath);
+    if (!file.open(QIODevice::ReadOnly))
+        return scan;
+
+    scan.fileSize = file.size();
+    auto data = reinterpret_cast<const char*>(scan.fileSize > 0 ? file.map(0, scan.fileSize) : nullptr);
+    if (!data)
+        return scan;
+
+    QElapsedTimer chrono;
+    chrono.start();
+    scan.format = Format_STEP;
+    StepScanner scanner(&scan);
+    const char* const dataEnd = data + scan.fileSize;
+    const char* it = data;
+    int64_t recordCount = 0;
+    while (it != dataEnd) {
+        const char* itRecordEnd = findStepRecordEnd(it, dataEnd);
+        scanner.processRecord(it, itRecordEnd);
+        it = itRecordEnd != dataEnd ? itRecordEnd + 1 : dataEnd;
+        if (++recordCount % timeCheckPeriod == 0 && chrono.elapsed() > timeBudgetMs)
+            break;
+    }
+
+    scan.scannedSize = it - data;
+    scanner.finalize();
+    return scan;
+}
+
+FileScan scanFile_IGES(const QString& filepath, int timeBudgetMs)
+{
+    FileScan scan;
+    QFile file(filepath);
+    if (!file.open(QIODevice::ReadOnly))
+        return scan;
+
+    scan.fileSize = file.size();
+    auto data = reinterpret_cast<const char*>(scan.fileSize > 0 ? file.map(0, scan.fileSize) : nullptr);
+    if (!data)
+        return scan;
+
+    QElapsedTimer chrono;
+    chrono.start();
+    scan.format = Format_IGES;
+    const char* const dataEnd = data + scan.fileSize;
+    // Lines are 80 columns, possibly not separated by line breaks
+    auto itFirstLineEnd = static_cast<const char*>(std::memchr(data, '\n', dataEnd - data));
+    const bool hasLineBreaks = itFirstLineEnd && itFirstLineEnd - data <= 82;
+    std::string globalSection;
+    std::unordered_map<int, int64_t> mapTypeCount;
+    int64_t directoryLineCount = 0;
+    int64_t lineCount = 0;
+    const char* it = data;
+    // Parameter data section isn't needed, so scan stops on first line of it
+    while (it != dataEnd) {
+        const char* itLineEnd = dataEnd;
+        const char* itNext = dataEnd;
+        if (hasLineBreaks) {
+            auto itBreak = static_cast<const char*>(std::memchr(it, '\n', dataEnd - it));
+            itLineEnd = itBreak ? itBreak : dataEnd;
+            itNext = itBreak ? itBreak + 1 : dataEnd;
+        }
+        else {
+            itLineEnd = itNext = std::min(it + 80, dataEnd);
+        }
+
+        const Text line(it, itLineEnd - it);
+        const char section = line.size() > 72 ? line[72] : ' ';
+        if (section == 'G') {
+            globalSection.append(line.data(), 72);
+        }
+        else if (section == 'D') {
+            // Entity uses two lines, entity type number is in columns 1-8 of the first one
+            if (directoryLineCount++ % 2 == 0) {
+                ++mapTypeCount[std::atoi(std::string(line.substr(0, 8)).c_str())];
+                ++scan.entityCount;
+            }
+        }
+        else if (section == 'P' || section == 'T') {
+            it = dataEnd;
+            break;
+        }
+
+        it = itNext;
+        if (++lineCount % timeCheckPeriod == 0 && chrono.elapsed() > timeBudgetMs)
+            break;
+    }
+
+    scan.scannedSize = it - data;
+
+    // Global section fields(numbered from 1): 3 product id from sender, 5 native system id,
+    // 6 preprocessor version, 14 units flag, 15 units name, 23 version flag
+    const std::vector<QString> vecField = parseIgesGlobalSection(globalSection);
+    scan.schema = igesVersion(igesField(vecField, 23).toInt());
+    scan.originatingSystem = igesField(vecField, 5);
+    if (scan.originatingSystem.isEmpty())
+        scan.originatingSystem = igesField(vecField, 6);
+
+    const QString lengthUnit = igesLengthUnit(igesField(vecField, 14).toInt(), igesField(vecField, 15));
+    if (!lengthUnit.isEmpty())
+        scan.lengthUnits.push_back(lengthUnit);
+
+    const QString productName = igesField(vecField, 3);
+    if (!productName.isEmpty())
+        scan.vecProduct.push_back({ productName, {} });
+
+    // IGES has no product structure, subfigure instances are the closest to assembly components
+    auto itSubfigureInstance = mapTypeCount.find(408);
+    if (itSubfigureInstance != mapTypeCount.cend())
+        scan.assemblyComponentCount = int(itSubfigureInstance->second);
+
+    std::vector<FileScan::EntityTypeCount> vecTypeCount;
+    for (const auto& typeCount : mapTypeCount)
+        vecTypeCount.push_back({ igesEntityTypeName(typeCount.first), typeCount.second });
+
+    scan.vecEntityTypeCount = sortedEntityTypeCounts(std::move(vecTypeCount));
+    return scan;
+}
+
+FileScan scanFile(const QString& filepath, const Format& format, int timeBudgetMs)
+{
+    if (format == Format_STEP)
+        return scanFile_STEP(filepath, timeBudgetMs);
+    else if (format == Format_IGES)
+        return scanFile_IGES(filepath, timeBudgetMs);
+
+    return {};
+}
+
+} // namespace IO
+} // namespace Mayo
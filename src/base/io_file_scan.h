@@ -0,0 +1,67 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "io_format.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <cstdint>
+#include <vector>
+
+namespace Mayo {
+namespace IO {
+
+// Metadata of a CAD file, obtained by streaming its records without any translation
+struct FileScan {
+    Q_DECLARE_TR_FUNCTIONS(Mayo::IO::FileScan)
+public:
+    struct Product {
+        QString name;
+        std::vector<int> vecComponent; // Index of the product of each component(instance)
+    };
+
+    struct EntityTypeCount {
+        QString type;
+        int64_t count;
+    };
+
+    Format format = Format_Unknown;
+    QString schema; // STEP application protocol, IGES version
+    QString originatingSystem;
+    QStringList lengthUnits;
+    std::vector<Product> vecProduct;
+    int assemblyComponentCount = 0;
+    std::vector<EntityTypeCount> vecEntityTypeCount; // Sorted by decreasing count
+    int64_t entityCount = 0;
+    int64_t scannedSize = 0; // Less than 'fileSize' when scan was stopped by its time budget
+    int64_t fileSize = 0;
+
+    bool isValid() const { return this->format != Format_Unknown; }
+    bool isComplete() const { return this->scannedSize >= this->fileSize; }
+
+    // Extrapolation of the count of entities when scan isn't complete
+    int64_t estimatedEntityCount() const;
+
+    // Indexes of the products not referenced as component of other products
+    std::vector<int> rootProducts() const;
+
+    // Multi-line text, typically used for tooltips
+    // Counts are reported as lower bounds("at least N") when scan isn't complete
+    QString summaryText(int maxEntityTypeCount = 8, int maxProductCount = 12) const;
+};
+
+// Scan stops when 'timeBudgetMs' is exceeded, then the returned FileScan is partial
+FileScan scanFile_STEP(const QString& filepath, int timeBudgetMs = 1000);
+FileScan scanFile_IGES(const QString& filepath, int timeBudgetMs = 1000);
+
+// Dispatches to the scan function matching 'format', returns an invalid FileScan if not supported
+FileScan scanFile(const QString& filepath, const Format& format, int timeBudgetMs = 1000);
+
+} // namespace IO
+} // namespace Mayo
@@ -28,10 +28,12 @@ const Format Format_Unknown = { "", "Format_Unknown", {} };
 const Format Format_STEP = { "STEP", "STEP(ISO 10303)", { "stp", "step" } };
 const Format Format_IGES = { "IGES", "IGES(ASME Y14.26M))", { "igs", "iges" } };
 const Format Format_OCCBREP = { "OCCBREP", "OpenCascade BREP", { "brep", "rle", "occ" } };
+const Format Format_OCCBREP_BIN = { "OCCBREP_BIN", "OpenCascade binary BREP", { "bbrep" } };
 const Format Format_STL = { "STL", "STL(STereo-Lithography)", { "stl" } };
 const Format Format_OBJ = { "OBJ", "Wavefront OBJ", { "obj" } };
 const Format Format_GLTF = { "GLTF", "glTF(GL Transmission Format)", { "gltf", "glb" } };
 const Format Format_VRML = { "VRML", "VRML(ISO/CEI 14772-2)", { "wrl", "wrz", "vrml" } };
+const Format Format_MAYODOC = { "MAYODOC", "Mayo document", { "mayo" } };
 
 } // namespace IO
 } // namespace Mayo
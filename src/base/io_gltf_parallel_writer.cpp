@@ -0,0 +1,780 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "io_gltf_parallel_writer.h"
+
+#include "caf_utils.h"
+#include "document.h"
+#include "mesh_utils.h"
+#include "task_progress.h"
+#include "xcaf.h"
+
+#include <BRep_Tool.hxx>
+#include <gp.hxx>
+#include <gp_Quaternion.hxx>
+#include <Graphic3d_Vec3.hxx>
+#include <NCollection_DataMap.hxx>
+#include <OSD_Parallel.hxx>
+#include <RWMesh_FaceIterator.hxx>
+#include <TDataXtd_Triangulation.hxx>
+#include <TDF_LabelMapHasher.hxx>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QtEndian>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace Mayo {
+namespace IO {
+
+namespace {
+
+// Values defined by the glTF 2.0 specification
+enum GltfComponentType {
+    GltfComponentType_Byte = 5120,
+    GltfComponentType_UnsignedShort = 5123,
+    GltfComponentType_UnsignedInt = 5125,
+    GltfComponentType_Float = 5126
+};
+
+enum GltfBufferViewTarget {
+    GltfBufferViewTarget_ArrayBuffer = 34962,
+    GltfBufferViewTarget_ElementArrayBuffer = 34963
+};
+
+constexpr quint32 GlbMagic = 0x46546C67; // "glTF"
+constexpr quint32 GlbChunkType_Json = 0x4E4F534A; // "JSON"
+constexpr quint32 GlbChunkType_Bin = 0x004E4942; // "BIN\0"
+
+// Byte offsets and lengths of glTF buffer views must be multiples of 4
+uint64_t alignedSize(uint64_t size)
+{
+    return (size + 3) & ~uint64_t(3);
+}
+
+void writeLittleEndianFloat(char* dst, double value)
+{
+    const float fValue = float(value);
+    quint32 bits;
+    std::memcpy(&bits, &fValue, sizeof(float));
+    qToLittleEndian(bits, dst);
+}
+
+QJsonArray toJsonArray(const gp_XYZ& coords)
+{
+    return { coords.X(), coords.Y(), coords.Z() };
+}
+
+} // namespace
+
+class GltfParallelWriter::Encoder {
+public:
+    Encoder(const GltfParallelWriter::Options& options)
+        : m_options(options)
+    {}
+
+    // Adds the node of 'label' and its descendants, returns the index of the node
+    int addNode(const TDF_Label& label);
+
+    QByteArray toJson(const QString& binFileName) const;
+    uint64_t binSize() const { return m_binSize; }
+    bool writeBin(QFile* file, TaskProgress* progress) const;
+
+private:
+    // Triangulation of a face, part of a primitive
+    struct FaceMesh {
+        Handle_Poly_Triangulation triangulation;
+        gp_Trsf trsf; // Location of the face within the mesh
+        bool isReversed;
+        int primitive; // Index in m_vecPrimitive
+        int nodeOffset; // Index of the first node within the primitive
+        int triangleOffset; // Index of the first triangle within the primitive
+    };
+
+    // Faces of a mesh sharing the same material
+    struct Primitive {
+        int mesh = -1; // Index in m_vecMesh
+        int material = -1; // Index in m_vecMaterialColor, -1 if none
+        std::vector<int> vecFace; // Indexes in m_vecFace
+        int nodeCount = 0;
+        int triangleCount = 0;
+        bool hasUV = false;
+        uint64_t offset = 0; // Offset of the primitive data in the BIN chunk
+        uint64_t positionSize = 0;
+        uint64_t normalSize = 0;
+        uint64_t uvSize = 0;
+        uint64_t indexSize = 0;
+        gp_XYZ minPosition;
+        gp_XYZ maxPosition;
+        bool indexIsUInt32() const { return nodeCount > std::numeric_limits<quint16>::max(); }
+    };
+
+    struct Mesh {
+        QString name;
+        std::vector<int> vecPrimitive; // Indexes in m_vecPrimitive
+        // Dequantization of positions: position = origin + scale * quantizedPosition
+        gp_XYZ quantizationOrigin;
+        double quantizationScale = 1.;
+    };
+
+    int findOrAddMesh(const TDF_Label& label);
+    int findOrAddMaterial(const Quantity_ColorRGBA& color);
+    void addFace(Mesh* mesh, const Handle_Poly_Triangulation& triangulation, const TopLoc_Location& loc, bool isReversed, int material);
+    void finalizeMesh(Mesh* mesh);
+
+    void setNodeTransformation(QJsonObject* node, gp_Trsf trsf) const;
+    gp_XYZ meshPosition(const FaceMesh& face, int iNode) const;
+    std::array<quint16, 3> quantizedPosition(const Mesh& mesh, const gp_XYZ& position) const;
+    void encodeFace(const FaceMesh& face, char* primitiveData) const;
+
+    const GltfParallelWriter::Options& m_options;
+    std::vector<QJsonObject> m_vecNode;
+    std::vector<Mesh> m_vecMesh;
+    std::vector<Primitive> m_vecPrimitive;
+    std::vector<FaceMesh> m_vecFace;
+    std::vector<Quantity_ColorRGBA> m_vecMaterialColor;
+    NCollection_DataMap<TDF_Label, int, TDF_LabelMapHasher> m_mapLabelMesh;
+    uint64_t m_binSize = 0;
+};
+
+int GltfParallelWriter::Encoder::addNode(const TDF_Label& label)
+{
+    const int nodeIndex = int(m_vecNode.size());
+    m_vecNode.emplace_back();
+    QJsonObject node;
+    const TDF_Label referred = XCaf::isShapeReference(label) ? XCaf::shapeReferred(label) : label;
+    QString name = CafUtils::labelAttrStdName(label);
+    if (name.isEmpty())
+        name = CafUtils::labelAttrStdName(referred);
+
+    if (!name.isEmpty())
+        node.insert("name", name);
+
+    if (XCaf::isShape(label))
+        this->setNodeTransformation(&node, XCaf::shape(label).Location().Transformation());
+
+    QJsonArray children;
+    if (XCaf::isShapeAssembly(referred)) {
+        for (const TDF_Label& component : XCaf::shapeComponents(referred))
+            children.append(this->addNode(component));
+    }
+    else {
+        const int meshIndex = this->findOrAddMesh(referred);
+        if (meshIndex >= 0 && m_options.quantize) {
+            // Positions are dequantized by an additional node, so the mesh can be shared by all
+            // instances of the part whatever their transformation
+            const Mesh& mesh = m_vecMesh.at(meshIndex);
+            const double scale = mesh.quantizationScale;
+            QJsonObject meshNode;
+            meshNode.insert("mesh", meshIndex);
+            meshNode.insert("translation", toJsonArray(mesh.quantizationOrigin));
+            meshNode.insert("scale", QJsonArray{ scale, scale, scale });
+            children.append(int(m_vecNode.size()));
+            m_vecNode.push_back(meshNode);
+        }
+        else if (meshIndex >= 0) {
+            node.insert("mesh", meshIndex);
+        }
+    }
+
+    if (!children.isEmpty())
+        node.insert("children", children);
+
+    m_vecNode.at(nodeIndex) = node;
+    return nodeIndex;
+}
+
+int GltfParallelWriter::Encoder::findOrAddMesh(const TDF_Label& label)
+{
+    // Parts referenced by several components are written once
+    const int* ptrMeshIndex = m_mapLabelMesh.Seek(label);
+    if (ptrMeshIndex)
+        return *ptrMeshIndex;
+
+    Mesh mesh;
+    mesh.name = CafUtils::labelAttrStdName(label);
+    if (XCaf::isShape(label)) {
+        MeshUtils::loadDeferredTriangulations(XCaf::shape(label));
+        // Location of the part shape is carried by the glTF node
+        for (RWMesh_FaceIterator itFace(label, TopLoc_Location(), true); itFace.More(); itFace.Next()) {
+            if (itFace.IsEmptyMesh())
+                continue;
+
+            const int material = itFace.HasFaceColor() ? this->findOrAddMaterial(itFace.FaceColor()) : -1;
+            TopLoc_Location loc;
+            const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(itFace.Face(), loc);
+            this->addFace(&mesh, triangulation, loc, itFace.Face().Orientation() == TopAbs_REVERSED, material);
+        }
+    }
+    else {
+        auto attrTriangulation = CafUtils::findAttribute<TDataXtd_Triangulation>(label);
+        if (!attrTriangulation.IsNull() && !attrTriangulation->Get().IsNull())
+            this->addFace(&mesh, attrTriangulation->Get(), TopLoc_Location(), false, -1);
+    }
+
+    int meshIndex = -1;
+    if (!mesh.vecPrimitive.empty()) {
+        this->finalizeMesh(&mesh);
+        meshIndex = int(m_vecMesh.size());
+        m_vecMesh.push_back(std::move(mesh));
+    }
+
+    m_mapLabelMesh.Bind(label, meshIndex);
+    return meshIndex;
+}
+
+int GltfParallelWriter::Encoder::findOrAddMaterial(const Quantity_ColorRGBA& color)
+{
+    auto itColor = std::find_if(
+                m_vecMaterialColor.cbegin(), m_vecMaterialColor.cend(), [&](const Quantity_ColorRGBA& other) {
+        return other.GetRGB().IsEqual(color.GetRGB()) && other.Alpha() == color.Alpha();
+    });
+    if (itColor != m_vecMaterialColor.cend())
+        return int(itColor - m_vecMaterialColor.cbegin());
+
+    m_vecMaterialColor.push_back(color);
+    return int(m_vecMaterialColor.size()) - 1;
+}
+
+void GltfParallelWriter::Encoder::addFace(
+        Mesh* mesh,
+        const Handle_Poly_Triangulation& triangulation,
+        const TopLoc_Location& loc,
+        bool isReversed,
+        int material)
+{
+    if (triangulation.IsNull() || triangulation->NbNodes() == 0 || triangulation->NbTriangles() == 0)
+        return;
+
+    auto itPrimitive = std::find_if(
+                mesh->vecPrimitive.cbegin(), mesh->vecPrimitive.cend(), [=](int iPrimitive) {
+        return m_vecPrimitive.at(iPrimitive).material == material;
+    });
+    int primitiveIndex = -1;
+    if (itPrimitive != mesh->vecPrimitive.cend()) {
+        primitiveIndex = *itPrimitive;
+    }
+    else {
+        primitiveIndex = int(m_vecPrimitive.size());
+        mesh->vecPrimitive.push_back(primitiveIndex);
+        m_vecPrimitive.emplace_back();
+        // Mesh is added once all its faces are known
+        m_vecPrimitive.back().mesh = int(m_vecMesh.size());
+        m_vecPrimitive.back().material = material;
+    }
+
+    Primitive& primitive = m_vecPrimitive.at(primitiveIndex);
+    FaceMesh face;
+    face.triangulation = triangulation;
+    face.trsf = loc.Transformation();
+    face.isReversed = isReversed;
+    face.primitive = primitiveIndex;
+    face.nodeOffset = primitive.nodeCount;
+    face.triangleOffset = primitive.triangleCount;
+    primitive.vecFace.push_back(int(m_vecFace.size()));
+    primitive.nodeCount += triangulation->NbNodes();
+    primitive.triangleCount += triangulation->NbTriangles();
+    primitive.hasUV = primitive.hasUV || (m_options.exportUV && triangulation->HasUVNodes());
+    m_vecFace.push_back(std::move(face));
+}
+
+void GltfParallelWriter::Encoder::finalizeMesh(Mesh* mesh)
+{
+    // Bounding boxes of the faces, computed in parallel
+    std::vector<int> vecFace;
+    for (int iPrimitive : mesh->vecPrimitive) {
+        const Primitive& primitive = m_vecPrimitive.at(iPrimitive);
+        vecFace.insert(vecFace.end(), primitive.vecFace.cbegin(), primitive.vecFace.cend());
+    }
+
+    std::vector<std::pair<gp_XYZ, gp_XYZ>> vecFaceMinMax(vecFace.size());
+    OSD_Parallel::For(0, int(vecFace.size()), [&](int i) {
+        const FaceMesh& face = m_vecFace.at(vecFace.at(i));
+        const double inf = std::numeric_limits<double>::max();
+        gp_XYZ pntMin(inf, inf, inf);
+        gp_XYZ pntMax(-inf, -inf, -inf);
+        for (int iNode = 0; iNode < face.triangulation->NbNodes(); ++iNode) {
+            const gp_XYZ position = this->meshPosition(face, iNode);
+            for (int iCoord = 1; iCoord <= 3; ++iCoord) {
+                pntMin.SetCoord(iCoord, std::min(pntMin.Coord(iCoord), position.Coord(iCoord)));
+                pntMax.SetCoord(iCoord, std::max(pntMax.Coord(iCoord), position.Coord(iCoord)));
+            }
+        }
+
+        vecFaceMinMax.at(i) = { pntMin, pntMax };
+    });
+
+    const double inf = std::numeric_limits<double>::max();
+    gp_XYZ meshMin(inf, inf, inf);
+    gp_XYZ meshMax(-inf, -inf, -inf);
+    int iFaceMinMax = 0;
+    for (int iPrimitive : mesh->vecPrimitive) {
+        Primitive& primitive = m_vecPrimitive.at(iPrimitive);
+        primitive.minPosition.SetCoord(inf, inf, inf);
+        primitive.maxPosition.SetCoord(-inf, -inf, -inf);
+        for (size_t i = 0; i < primitive.vecFace.size(); ++i, ++iFaceMinMax) {
+            const auto& faceMinMax = vecFaceMinMax.at(iFaceMinMax);
+            for (int iCoord = 1; iCoord <= 3; ++iCoord) {
+                const double coordMin = std::min(primitive.minPosition.Coord(iCoord), faceMinMax.first.Coord(iCoord));
+                const double coordMax = std::max(primitive.maxPosition.Coord(iCoord), faceMinMax.second.Coord(iCoord));
+                primitive.minPosition.SetCoord(iCoord, coordMin);
+                primitive.maxPosition.SetCoord(iCoord, coordMax);
+            }
+        }
+
+        for (int iCoord = 1; iCoord <= 3; ++iCoord) {
+            meshMin.SetCoord(iCoord, std::min(meshMin.Coord(iCoord), primitive.minPosition.Coord(iCoord)));
+            meshMax.SetCoord(iCoord, std::max(meshMax.Coord(iCoord), primitive.maxPosition.Coord(iCoord)));
+        }
+
+        // Layout of the primitive data in the BIN chunk
+        const uint64_t nodeCount = primitive.nodeCount;
+        primitive.offset = m_binSize;
+        // Quantized vertex attributes are padded so each vertex is 4-byte aligned
+        primitive.positionSize = nodeCount * (m_options.quantize ? 4 * sizeof(quint16) : 3 * sizeof(float));
+        primitive.normalSize = nodeCount * (m_options.quantize ? 4 * sizeof(qint8) : 3 * sizeof(float));
+        primitive.uvSize = primitive.hasUV ? nodeCount * 2 * sizeof(float) : 0;
+        const uint64_t indexSize = primitive.indexIsUInt32() ? sizeof(quint32) : sizeof(quint16);
+        primitive.indexSize = alignedSize(uint64_t(primitive.triangleCount) * 3 * indexSize);
+        m_binSize += primitive.positionSize + primitive.normalSize + primitive.uvSize + primitive.indexSize;
+    }
+
+    // Uniform scale, so normals aren't distorted by the dequantization transformation
+    const gp_XYZ extent = meshMax - meshMin;
+    const double maxExtent = std::max({ extent.X(), extent.Y(), extent.Z() });
+    mesh->quantizationOrigin = meshMin;
+    mesh->quantizationScale = maxExtent > 0 ? maxExtent / std::numeric_limits<quint16>::max() : 1.;
+}
+
+void GltfParallelWriter::Encoder::setNodeTransformation(QJsonObject* node, gp_Trsf trsf) const
+{
+    m_options.coordinateSystemConverter.TransformTransformation(trsf);
+    if (trsf.Form() == gp_Identity)
+        return;
+
+    const bool useMatrix =
+            m_options.transformationFormat == RWGltf_WriterTrsfFormat_Mat4
+            || (m_options.transformationFormat == RWGltf_WriterTrsfFormat_Compact && trsf.ScaleFactor() < 0);
+    if (useMatrix) {
+        // Column-major order
+        QJsonArray matrix;
+        for (int col = 1; col <= 4; ++col) {
+            for (int row = 1; row <= 3; ++row)
+                matrix.append(trsf.Value(row, col));
+
+            matrix.append(col == 4 ? 1. : 0.);
+        }
+
+        node->insert("matrix", matrix);
+        return;
+    }
+
+    const gp_Quaternion rotation = trsf.GetRotation();
+    if (std::abs(rotation.W()) < 1. - gp::Resolution())
+        node->insert("rotation", QJsonArray{ rotation.X(), rotation.Y(), rotation.Z(), rotation.W() });
+
+    const double scale = std::abs(trsf.ScaleFactor());
+    if (std::abs(scale - 1.) > gp::Resolution())
+        node->insert("scale", QJsonArray{ scale, scale, scale });
+
+    if (trsf.TranslationPart().Modulus() > gp::Resolution())
+        node->insert("translation", toJsonArray(trsf.TranslationPart()));
+}
+
+gp_XYZ GltfParallelWriter::Encoder::meshPosition(const FaceMesh& face, int iNode) const
+{
+    gp_XYZ position = face.triangulation->Nodes().Value(iNode + 1).XYZ();
+    face.trsf.Transforms(position);
+    m_options.coordinateSystemConverter.TransformPosition(position);
+    return position;
+}
+
+std::array<quint16, 3> GltfParallelWriter::Encoder::quantizedPosition(
+        const Mesh& mesh, const gp_XYZ& position) const
+{
+    std::array<quint16, 3> coords;
+    for (int i = 0; i < 3; ++i) {
+        const double value = (position.Coord(i + 1) - mesh.quantizationOrigin.Coord(i + 1)) / mesh.quantizationScale;
+        coords[i] = quint16(std::clamp(std::round(value), 0., double(std::numeric_limits<quint16>::max())));
+    }
+
+    return coords;
+}
+
+void GltfParallelWriter::Encoder::encodeFace(const FaceMesh& face, char* primitiveData) const
+{
+    const Primitive& primitive = m_vecPrimitive.at(face.primitive);
+    const Handle_Poly_Triangulation& triangulation = face.triangulation;
+    const int nodeCount = triangulation->NbNodes();
+    const Poly_Array1OfTriangle& vecTriangle = triangulation->Triangles();
+    auto fnTriangleNodes = [&](int iTriangle) {
+        std::array<int, 3> nodes;
+        vecTriangle.Value(iTriangle + 1).Get(nodes[0], nodes[1], nodes[2]);
+        if (face.isReversed)
+            std::swap(nodes[1], nodes[2]);
+
+        return nodes;
+    };
+
+    // Normals of the nodes, in the coordinate system of the triangulation
+    std::vector<gp_XYZ> vecNormal(nodeCount);
+    if (triangulation->HasNormals()) {
+        const TShort_Array1OfShortReal& normals = triangulation->Normals();
+        for (int i = 0; i < nodeCount; ++i) {
+            vecNormal[i].SetCoord(normals.Value(3*i + 1), normals.Value(3*i + 2), normals.Value(3*i + 3));
+            if (face.isReversed)
+                vecNormal[i].Reverse();
+        }
+    }
+    else {
+        // Area-weighted average of the normals of adjacent triangles, already following the
+        // orientation of the face
+        const TColgp_Array1OfPnt& vecNode = triangulation->Nodes();
+        for (int iTriangle = 0; iTriangle < triangulation->NbTriangles(); ++iTriangle) {
+            const std::array<int, 3> nodes = fnTriangleNodes(iTriangle);
+            const gp_XYZ& p1 = vecNode.Value(nodes[0]).XYZ();
+            const gp_XYZ& p2 = vecNode.Value(nodes[1]).XYZ();
+            const gp_XYZ& p3 = vecNode.Value(nodes[2]).XYZ();
+            const gp_XYZ normal = (p2 - p1).Crossed(p3 - p1);
+            for (int node : nodes)
+                vecNormal[node - 1] += normal;
+        }
+    }
+
+    const Mesh& mesh = m_vecMesh.at(primitive.mesh);
+    const bool hasTrsf = face.trsf.Form() != gp_Identity;
+    char* positionData = primitiveData;
+    char* normalData = positionData + primitive.positionSize;
+    char* uvData = normalData + primitive.normalSize;
+    for (int i = 0; i < nodeCount; ++i) {
+        const int iVertex = face.nodeOffset + i;
+        const gp_XYZ position = this->meshPosition(face, i);
+        if (m_options.quantize) {
+            const std::array<quint16, 3> coords = this->quantizedPosition(mesh, position);
+            for (int c = 0; c < 3; ++c)
+                qToLittleEndian(coords[c], positionData + iVertex*8 + c*2);
+        }
+        else {
+            for (int c = 0; c < 3; ++c)
+                writeLittleEndianFloat(positionData + iVertex*12 + c*4, position.Coord(c + 1));
+        }
+
+        gp_Vec normalVec(vecNormal[i]);
+        if (hasTrsf)
+            normalVec.Transform(face.trsf);
+
+        Graphic3d_Vec3 normal(float(normalVec.X()), float(normalVec.Y()), float(normalVec.Z()));
+        m_options.coordinateSystemConverter.TransformNormal(normal);
+        const float normalModulus = normal.Modulus();
+        if (normalModulus > 0)
+            normal /= normalModulus;
+
+        if (m_options.quantize) {
+            for (int c = 0; c < 3; ++c)
+                normalData[iVertex*4 + c] = char(qint8(std::lround(std::clamp(normal[c], -1.f, 1.f) * 127)));
+        }
+        else {
+            for (int c = 0; c < 3; ++c)
+                writeLittleEndianFloat(normalData + iVertex*12 + c*4, normal[c]);
+        }
+
+        if (primitive.hasUV) {
+            // Origin of glTF texture coordinates is the top-left corner of the image
+            const gp_Pnt2d uv = triangulation->HasUVNodes() ? triangulation->UVNodes().Value(i + 1) : gp_Pnt2d();
+            writeLittleEndianFloat(uvData + iVertex*8, uv.X());
+            writeLittleEndianFloat(uvData + iVertex*8 + 4, 1. - uv.Y());
+        }
+    }
+
+    char* indexData = uvData + primitive.uvSize;
+    const bool indexIsUInt32 = primitive.indexIsUInt32();
+    for (int iTriangle = 0; iTriangle < triangulation->NbTriangles(); ++iTriangle) {
+        const std::array<int, 3> nodes = fnTriangleNodes(iTriangle);
+        const int iIndex = 3 * (face.triangleOffset + iTriangle);
+        for (int c = 0; c < 3; ++c) {
+            const quint32 index = quint32(face.nodeOffset + nodes[c] - 1);
+            if (indexIsUInt32)
+                qToLittleEndian(index, indexData + (iIndex + c)*4);
+            else
+                qToLittleEndian(quint16(index), indexData + (iIndex + c)*2);
+        }
+    }
+}
+
+QByteArray GltfParallelWriter::Encoder::toJson(const QString& binFileName) const
+{
+    QJsonArray jsonMaterials;
+    for (const Quantity_ColorRGBA& color : m_vecMaterialColor) {
+        const Quantity_Color& rgb = color.GetRGB();
+        QJsonObject pbr;
+        pbr.insert("baseColorFactor", QJsonArray{ rgb.Red(), rgb.Green(), rgb.Blue(), color.Alpha() });
+        pbr.insert("metallicFactor", 0.);
+        pbr.insert("roughnessFactor", 1.);
+        QJsonObject material;
+        material.insert("pbrMetallicRoughness", pbr);
+        if (color.Alpha() < 1.f)
+            material.insert("alphaMode", "BLEND");
+
+        jsonMaterials.append(material);
+    }
+
+    QJsonArray jsonBufferViews;
+    QJsonArray jsonAccessors;
+    auto fnAddBufferView = [&](uint64_t offset, uint64_t size, int stride, GltfBufferViewTarget target) {
+        QJsonObject bufferView;
+        bufferView.insert("buffer", 0);
+        bufferView.insert("byteOffset", double(offset));
+        bufferView.insert("byteLength", double(size));
+        if (stride > 0)
+            bufferView.insert("byteStride", stride);
+
+        bufferView.insert("target", target);
+        jsonBufferViews.append(bufferView);
+        return jsonBufferViews.size() - 1;
+    };
+    auto fnAddAccessor = [&](int bufferView, GltfComponentType componentType, int count, const char* type) {
+        QJsonObject accessor;
+        accessor.insert("bufferView", bufferView);
+        accessor.insert("componentType", componentType);
+        accessor.insert("count", count);
+        accessor.insert("type", type);
+        jsonAccessors.append(accessor);
+        return jsonAccessors.size() - 1;
+    };
+
+    QJsonArray jsonMeshes;
+    for (const Mesh& mesh : m_vecMesh) {
+        QJsonArray jsonPrimitives;
+        for (int iPrimitive : mesh.vecPrimitive) {
+            const Primitive& primitive = m_vecPrimitive.at(iPrimitive);
+            uint64_t offset = primitive.offset;
+            QJsonObject attributes;
+            {
+                const int stride = m_options.quantize ? 8 : 12;
+                const int view = fnAddBufferView(offset, primitive.positionSize, stride, GltfBufferViewTarget_ArrayBuffer);
+                const auto componentType = m_options.quantize ? GltfComponentType_UnsignedShort : GltfComponentType_Float;
+                const int accessor = fnAddAccessor(view, componentType, primitive.nodeCount, "VEC3");
+                QJsonObject jsonAccessor = jsonAccessors.at(accessor).toObject();
+                if (m_options.quantize) {
+                    const auto coordsMin = this->quantizedPosition(mesh, primitive.minPosition);
+                    const auto coordsMax = this->quantizedPosition(mesh, primitive.maxPosition);
+                    jsonAccessor.insert("min", QJsonArray{ coordsMin[0], coordsMin[1], coordsMin[2] });
+                    jsonAccessor.insert("max", QJsonArray{ coordsMax[0], coordsMax[1], coordsMax[2] });
+                }
+                else {
+                    // Bounds must match exactly the values stored as single precision floats
+                    auto fnFloatArray = [](const gp_XYZ& coords) {
+                        return QJsonArray{ float(coords.X()), float(coords.Y()), float(coords.Z()) };
+                    };
+                    jsonAccessor.insert("min", fnFloatArray(primitive.minPosition));
+                    jsonAccessor.insert("max", fnFloatArray(primitive.maxPosition));
+                }
+
+                jsonAccessors.replace(accessor, jsonAccessor);
+                attributes.insert("POSITION", accessor);
+                offset += primitive.positionSize;
+            }
+
+            {
+                const int stride = m_options.quantize ? 4 : 12;
+                const int view = fnAddBufferView(offset, primitive.normalSize, stride, GltfBufferViewTarget_ArrayBuffer);
+                const auto componentType = m_options.quantize ? GltfComponentType_Byte : GltfComponentType_Float;
+                const int accessor = fnAddAccessor(view, componentType, primitive.nodeCount, "VEC3");
+                if (m_options.quantize) {
+                    QJsonObject jsonAccessor = jsonAccessors.at(accessor).toObject();
+                    jsonAccessor.insert("normalized", true);
+                    jsonAccessors.replace(accessor, jsonAccessor);
+                }
+
+                attributes.insert("NORMAL", accessor);
+                offset += primitive.normalSize;
+            }
+
+            if (primitive.hasUV) {
+                const int view = fnAddBufferView(offset, primitive.uvSize, 8, GltfBufferViewTarget_ArrayBuffer);
+                attributes.insert("TEXCOORD_0", fnAddAccessor(view, GltfComponentType_Float, primitive.nodeCount, "VEC2"));
+                offset += primitive.uvSize;
+            }
+
+            const int indexView = fnAddBufferView(offset, primitive.indexSize, 0, GltfBufferViewTarget_ElementArrayBuffer);
+            const auto indexComponentType =
+                    primitive.indexIsUInt32() ? GltfComponentType_UnsignedInt : GltfComponentType_UnsignedShort;
+            QJsonObject jsonPrimitive;
+            jsonPrimitive.insert("attributes", attributes);
+            jsonPrimitive.insert("indices", fnAddAccessor(indexView, indexComponentType, 3 * primitive.triangleCount, "SCALAR"));
+            jsonPrimitive.insert("mode", 4); // Triangles
+            if (primitive.material >= 0)
+                jsonPrimitive.insert("material", primitive.material);
+
+            jsonPrimitives.append(jsonPrimitive);
+        }
+
+        QJsonObject jsonMesh;
+        if (!mesh.name.isEmpty())
+            jsonMesh.insert("name", mesh.name);
+
+        jsonMesh.insert("primitives", jsonPrimitives);
+        jsonMeshes.append(jsonMesh);
+    }
+
+    QJsonArray jsonNodes;
+    for (const QJsonObject& node : m_vecNode)
+        jsonNodes.append(node);
+
+    // Root nodes are the ones without parent
+    std::vector<bool> vecIsChild(m_vecNode.size(), false);
+    for (const QJsonObject& node : m_vecNode) {
+        for (const QJsonValue& child : node.value("children").toArray())
+            vecIsChild.at(child.toInt()) = true;
+    }
+
+    QJsonArray jsonSceneNodes;
+    for (size_t i = 0; i < vecIsChild.size(); ++i) {
+        if (!vecIsChild.at(i))
+            jsonSceneNodes.append(int(i));
+    }
+
+    QJsonObject jsonRoot;
+    jsonRoot.insert("asset", QJsonObject{ { "version", "2.0" }, { "generator", "Mayo" } });
+    if (m_options.quantize && !m_vecMesh.empty()) {
+        jsonRoot.insert("extensionsUsed", QJsonArray{ "KHR_mesh_quantization" });
+        jsonRoot.insert("extensionsRequired", QJsonArray{ "KHR_mesh_quantization" });
+    }
+
+    jsonRoot.insert("scene", 0);
+    jsonRoot.insert("scenes", QJsonArray{ QJsonObject{ { "nodes", jsonSceneNodes } } });
+    jsonRoot.insert("nodes", jsonNodes);
+    if (!jsonMeshes.isEmpty()) {
+        jsonRoot.insert("meshes", jsonMeshes);
+        jsonRoot.insert("accessors", jsonAccessors);
+        jsonRoot.insert("bufferViews", jsonBufferViews);
+        QJsonObject jsonBuffer;
+        jsonBuffer.insert("byteLength", double(m_binSize));
+        if (!binFileName.isEmpty())
+            jsonBuffer.insert("uri", binFileName);
+
+        jsonRoot.insert("buffers", QJsonArray{ jsonBuffer });
+    }
+
+    if (!jsonMaterials.isEmpty())
+        jsonRoot.insert("materials", jsonMaterials);
+
+    return QJsonDocument(jsonRoot).toJson(QJsonDocument::Compact);
+}
+
+bool GltfParallelWriter::Encoder::writeBin(QFile* file, TaskProgress* progress) const
+{
+    // Primitives are encoded by batches of this size at least, each batch is written once encoded
+    constexpr uint64_t BatchSize = 16 * 1024 * 1024;
+    std::vector<char> buffer;
+    std::vector<int> vecBatchFace;
+    size_t iPrimitive = 0;
+    while (iPrimitive < m_vecPrimitive.size()) {
+        if (TaskProgress::isAbortRequested(progress))
+            return false;
+
+        const uint64_t batchOffset = m_vecPrimitive.at(iPrimitive).offset;
+        uint64_t batchEnd = batchOffset;
+        vecBatchFace.clear();
+        while (iPrimitive < m_vecPrimitive.size() && batchEnd - batchOffset < BatchSize) {
+            const Primitive& primitive = m_vecPrimitive.at(iPrimitive++);
+            batchEnd = primitive.offset + primitive.positionSize + primitive.normalSize + primitive.uvSize + primitive.indexSize;
+            vecBatchFace.insert(vecBatchFace.end(), primitive.vecFace.cbegin(), primitive.vecFace.cend());
+        }
+
+        // Padding bytes must be zero
+        buffer.assign(batchEnd - batchOffset, 0);
+        OSD_Parallel::For(0, int(vecBatchFace.size()), [&](int i) {
+            const FaceMesh& face = m_vecFace.at(vecBatchFace.at(i));
+            const Primitive& primitive = m_vecPrimitive.at(face.primitive);
+            this->encodeFace(face, buffer.data() + (primitive.offset - batchOffset));
+        });
+
+        if (file->write(buffer.data(), buffer.size()) != qint64(buffer.size()))
+            return false;
+
+        if (progress)
+            progress->setValue(int((batchEnd * 100) / std::max<uint64_t>(m_binSize, 1)));
+    }
+
+    return true;
+}
+
+GltfParallelWriter::GltfParallelWriter(const Options& options)
+    : m_options(options)
+{
+}
+
+bool GltfParallelWriter::perform(
+        const QString& filepath,
+        const DocumentPtr& doc,
+        const TDF_LabelSequence& seqRootLabel,
+        TaskProgress* progress)
+{
+    Encoder encoder(m_options);
+    if (seqRootLabel.IsEmpty()) {
+        for (int i = 0; i < doc->entityCount(); ++i)
+            encoder.addNode(doc->entityLabel(i));
+    }
+    else {
+        for (const TDF_Label& label : seqRootLabel)
+            encoder.addNode(label);
+    }
+
+    if (TaskProgress::isAbortRequested(progress))
+        return false;
+
+    QFile file(filepath);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    if (!m_options.binary) {
+        const QFileInfo fileInfo(filepath);
+        const QString binFileName = fileInfo.completeBaseName() + ".bin";
+        if (file.write(encoder.toJson(encoder.binSize() > 0 ? binFileName : QString())) < 0)
+            return false;
+
+        if (encoder.binSize() == 0)
+            return true;
+
+        QFile binFile(fileInfo.dir().filePath(binFileName));
+        return binFile.open(QIODevice::WriteOnly) && encoder.writeBin(&binFile, progress);
+    }
+
+    // GLB container: header, JSON chunk then BIN chunk
+    QByteArray json = encoder.toJson(QString());
+    json.append(int(alignedSize(json.size()) - json.size()), ' ');
+    const uint64_t binChunkSize = encoder.binSize() > 0 ? 8 + encoder.binSize() : 0;
+    const uint64_t glbSize = 12 + 8 + json.size() + binChunkSize;
+    if (glbSize > std::numeric_limits<quint32>::max())
+        return false;
+
+    auto fnWriteUInt32 = [&](quint32 value) {
+        char bytes[4];
+        qToLittleEndian(value, bytes);
+        return file.write(bytes, sizeof(bytes)) == sizeof(bytes);
+    };
+    bool ok = fnWriteUInt32(GlbMagic) && fnWriteUInt32(2) && fnWriteUInt32(quint32(glbSize));
+    ok = ok && fnWriteUInt32(quint32(json.size())) && fnWriteUInt32(GlbChunkType_Json);
+    ok = ok && file.write(json) == json.size();
+    if (ok && binChunkSize > 0) {
+        ok = fnWriteUInt32(quint32(encoder.binSize())) && fnWriteUInt32(GlbChunkType_Bin);
+        ok = ok && encoder.writeBin(&file, progress);
+    }
+
+    return ok;
+}
+
+} // namespace IO
+} // namespace Mayo
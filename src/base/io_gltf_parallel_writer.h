@@ -0,0 +1,58 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "document_ptr.h"
+
+#include <QtCore/QString>
+#include <RWGltf_WriterTrsfFormat.hxx>
+#include <RWMesh_CoordinateSystemConverter.hxx>
+#include <TDF_LabelSequence.hxx>
+
+namespace Mayo {
+
+class TaskProgress;
+
+namespace IO {
+
+// Multi-threaded writer of XCAF documents to glTF 2.0 files(.gltf or .glb)
+//
+// Compared to OpenCascade RWGltf_CafWriter:
+//     - a part referenced by several assembly components is written once, as a single glTF mesh
+//       shared by all the nodes of its instances
+//     - vertex positions and normals can be quantized to 16-bit and 8-bit integers as allowed by
+//       extension KHR_mesh_quantization, positions of a mesh are dequantized by the transformation
+//       of a child node
+//     - binary buffers are encoded by several threads and streamed to the output file by batches,
+//       so the whole BIN chunk is never held in memory
+// Faces are grouped per surface color into mesh primitives. Textures aren't supported
+class GltfParallelWriter {
+public:
+    struct Options {
+        bool binary = true; // .glb file, otherwise .gltf file with an external .bin file
+        bool quantize = true;
+        bool exportUV = false;
+        RWGltf_WriterTrsfFormat transformationFormat = RWGltf_WriterTrsfFormat_Compact;
+        RWMesh_CoordinateSystemConverter coordinateSystemConverter;
+    };
+
+    GltfParallelWriter(const Options& options);
+
+    // Writes the shapes of 'seqRootLabel' to 'filepath', all the entities of 'doc' if empty
+    bool perform(
+            const QString& filepath,
+            const DocumentPtr& doc,
+            const TDF_LabelSequence& seqRootLabel,
+            TaskProgress* progress);
+
+private:
+    class Encoder;
+    Options m_options;
+};
+
+} // namespace IO
+} // namespace Mayo
@@ -0,0 +1,424 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "io_import_cache.h"
+
+#include "document.h"
+#include "io_mayo_doc.h"
+#include "property.h"
+#include "task_progress.h"
+#include "tkernel_utils.h"
+#include "xcaf.h"
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QTemporaryFile>
+#include <TDataStd_TreeNode.hxx>
+#include <XCAFDoc.hxx>
+#include <XCAFDoc_DimTolTool.hxx>
+#include <XCAFDoc_DocumentTool.hxx>
+#include <XCAFDoc_LayerTool.hxx>
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+#  include <XCAFDoc_VisMaterialTool.hxx>
+#endif
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+
+namespace Mayo {
+namespace IO {
+
+namespace {
+
+// Has to be changed when translation or storage of cached documents changes, so obsolete entries
+// are no longer hit
+const QByteArray importCacheKeyVersion = "Mayo_ImportCache_1";
+
+// Unique path of a temporary file in the directory of 'filepath', the file itself isn't kept
+QString temporaryFilePath(const QString& filepath)
+{
+    QTemporaryFile file(filepath + ".XXXXXX.tmp");
+    return file.open() ? file.fileName() : QString();
+}
+
+// Replaces 'targetFilepath' with 'filepath', atomically on file systems supporting it
+bool replaceFile(const QString& filepath, const QString& targetFilepath)
+{
+    std::error_code ec;
+    std::filesystem::rename(
+                std::filesystem::path(filepath.toStdWString()),
+                std::filesystem::path(targetFilepath.toStdWString()),
+                ec);
+    return !ec;
+}
+
+QJsonObject readJsonObject(const QString& filepath)
+{
+    QFile file(filepath);
+    if (!file.open(QIODevice::ReadOnly))
+        return {};
+
+    return QJsonDocument::fromJson(file.readAll()).object();
+}
+
+bool writeJsonObject(const QString& filepath, const QJsonObject& jsonObject)
+{
+    QFile file(filepath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    const QByteArray bytes = QJsonDocument(jsonObject).toJson();
+    return file.write(bytes) == bytes.size();
+}
+
+// Whether layers or materials are attached to 'label'
+bool hasLayersOrMaterials(const TDF_Label& label)
+{
+    TDF_LabelSequence seqLayer;
+    if (XCAFDoc_DocumentTool::LayerTool(label)->GetLayers(label, seqLayer) && !seqLayer.IsEmpty())
+        return true;
+
+    Handle_TDataStd_TreeNode materialNode;
+    if (label.FindAttribute(XCAFDoc::MaterialRefGUID(), materialNode))
+        return true;
+
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+    if (!XCAFDoc_DocumentTool::VisMaterialTool(label)->GetShapeMaterial(label).IsNull())
+        return true;
+#endif
+
+    return false;
+}
+
+// GD&T items are attached to the document, not to a specific entity
+bool hasGdt(const DocumentPtr& doc)
+{
+    const Handle_XCAFDoc_DimTolTool dimTolTool = XCAFDoc_DocumentTool::DimTolTool(doc->Main());
+    TDF_LabelSequence seqDimTol;
+    TDF_LabelSequence seqDimension;
+    TDF_LabelSequence seqGeomTolerance;
+    TDF_LabelSequence seqDatum;
+    dimTolTool->GetDimTolLabels(seqDimTol);
+    dimTolTool->GetDimensionLabels(seqDimension);
+    dimTolTool->GetGeomToleranceLabels(seqGeomTolerance);
+    dimTolTool->GetDatumLabels(seqDatum);
+    return !seqDimTol.IsEmpty()
+            || !seqDimension.IsEmpty()
+            || !seqGeomTolerance.IsEmpty()
+            || !seqDatum.IsEmpty();
+}
+
+QString currentDateTimeText()
+{
+    return QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs);
+}
+
+} // namespace
+
+ImportCache::ImportCache(const QString& dirPath)
+    : m_dirPath(dirPath)
+{
+}
+
+ImportCache::~ImportCache()
+{
+    this->waitForBackgroundStores();
+}
+
+int64_t ImportCache::maxSize() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_maxSize;
+}
+
+void ImportCache::setMaxSize(int64_t bytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxSize = std::max<int64_t>(bytes, 0);
+    this->prune_nolock();
+}
+
+bool ImportCache::isFormatSupported(const Format& format)
+{
+    return format == Format_STEP || format == Format_IGES;
+}
+
+QString ImportCache::computeKey(const QString& filepath, const PropertyGroup* readerParameters)
+{
+    QFile file(filepath);
+    if (!file.open(QIODevice::ReadOnly))
+        return QString();
+
+    const QFileInfo fileInfo(file);
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(importCacheKeyVersion);
+    hash.addData(fileInfo.absoluteFilePath().toUtf8());
+    hash.addData(QByteArray::number(fileInfo.size()));
+    hash.addData(QByteArray::number(fileInfo.lastModified().toMSecsSinceEpoch()));
+    if (!hash.addData(&file))
+        return QString();
+
+    if (readerParameters) {
+        for (const Property* property : readerParameters->properties()) {
+            QByteArray bytesValue;
+            QDataStream stream(&bytesValue, QIODevice::WriteOnly);
+            stream << property->valueAsVariant();
+            hash.addData(property->name().key);
+            hash.addData(bytesValue);
+        }
+    }
+
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+bool ImportCache::isStorable(Span<const ApplicationItem> appItems)
+{
+    for (const ApplicationItem& appItem : appItems) {
+        const DocumentPtr doc = appItem.document();
+        if (doc.IsNull() || hasGdt(doc))
+            return false;
+
+        std::vector<TreeNodeId> vecNodeId;
+        if (appItem.isDocument()) {
+            for (int i = 0; i < doc->entityCount(); ++i)
+                vecNodeId.push_back(doc->entityTreeNodeId(i));
+        }
+        else if (appItem.isDocumentTreeNode()) {
+            vecNodeId.push_back(appItem.documentTreeNode().id());
+        }
+
+        bool hasAttributes = false;
+        for (const TreeNodeId nodeId : vecNodeId) {
+            deepForeachTreeNode(nodeId, doc->modelTree(), [&](TreeNodeId id) {
+                const TDF_Label& label = doc->modelTree().nodeData(id);
+                if (!hasAttributes)
+                    hasAttributes = hasLayersOrMaterials(label);
+
+                // Attributes of parts are attached to the referred labels
+                if (!hasAttributes && XCaf::isShapeReference(label))
+                    hasAttributes = hasLayersOrMaterials(XCaf::shapeReferred(label));
+            });
+        }
+
+        if (hasAttributes)
+            return false;
+    }
+
+    return true;
+}
+
+QString ImportCache::findDocumentFile(const QString& key)
+{
+    if (key.isEmpty())
+        return QString();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const QString docFilepath = this->documentFilePath(key);
+    const QString infoFilepath = this->entryInfoFilePath(key);
+    if (!QFileInfo::exists(docFilepath) || !QFileInfo::exists(infoFilepath))
+        return QString();
+
+    QJsonObject jsonInfo = readJsonObject(infoFilepath);
+    jsonInfo.insert("lastUsed", currentDateTimeText());
+    writeJsonObject(infoFilepath, jsonInfo);
+    return docFilepath;
+}
+
+// Entities gathered from the document, ready to be written(the document isn't accessed anymore)
+struct ImportCache::PendingEntry {
+    QString key;
+    QString sourceFilepath;
+    QByteArray formatIdentifier;
+    MayoDocWriter writer;
+};
+
+bool ImportCache::store(
+        const QString& key,
+        const QString& sourceFilepath,
+        const Format& sourceFormat,
+        Span<const ApplicationItem> appItems,
+        TaskProgress* progress)
+{
+    const std::shared_ptr<PendingEntry> entry = this->prepareEntry(key, sourceFilepath, sourceFormat, appItems, progress);
+    return entry ? this->writeEntry(*entry, progress) : false;
+}
+
+void ImportCache::storeInBackground(
+        const QString& key,
+        const QString& sourceFilepath,
+        const Format& sourceFormat,
+        Span<const ApplicationItem> appItems)
+{
+    TaskProgress progressPrepare;
+    const std::shared_ptr<PendingEntry> entry = this->prepareEntry(key, sourceFilepath, sourceFormat, appItems, &progressPrepare);
+    if (!entry)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_mutexStoreTask);
+    const TaskId taskId = m_storeTaskMgr.newTask([=](TaskProgress* progress) {
+        this->writeEntry(*entry, progress);
+    });
+    m_storeTaskMgr.run(taskId, TaskAutoDestroy::Off);
+    m_vecStoreTaskId.push_back(taskId);
+}
+
+void ImportCache::waitForBackgroundStores()
+{
+    std::lock_guard<std::mutex> lock(m_mutexStoreTask);
+    for (const TaskId taskId : m_vecStoreTaskId)
+        m_storeTaskMgr.waitForDone(taskId);
+
+    m_vecStoreTaskId.clear();
+}
+
+std::shared_ptr<ImportCache::PendingEntry> ImportCache::prepareEntry(
+        const QString& key,
+        const QString& sourceFilepath,
+        const Format& sourceFormat,
+        Span<const ApplicationItem> appItems,
+        TaskProgress* progress)
+{
+    if (key.isEmpty() || appItems.empty() || !ImportCache::isStorable(appItems))
+        return {};
+
+    auto entry = std::make_shared<PendingEntry>();
+    entry->key = key;
+    entry->sourceFilepath = QFileInfo(sourceFilepath).absoluteFilePath();
+    entry->formatIdentifier = sourceFormat.identifier;
+    if (!entry->writer.transfer(appItems, progress))
+        return {};
+
+    return entry;
+}
+
+bool ImportCache::writeEntry(PendingEntry& entry, TaskProgress* progress)
+{
+    if (!QDir().mkpath(m_dirPath))
+        return false;
+
+    // Files are written out of the lock to temporary paths, this can be long for big documents
+    // They are then renamed, so a partially written entry is never visible
+    const QString docFilepath = this->documentFilePath(entry.key);
+    const QString infoFilepath = this->entryInfoFilePath(entry.key);
+    const QString docTempFilepath = temporaryFilePath(docFilepath);
+    const QString infoTempFilepath = temporaryFilePath(infoFilepath);
+    bool ok = !docTempFilepath.isEmpty() && !infoTempFilepath.isEmpty();
+    ok = ok && entry.writer.writeFile(docTempFilepath, progress);
+    if (ok) {
+        QJsonObject jsonInfo;
+        jsonInfo.insert("sourceFilepath", entry.sourceFilepath);
+        jsonInfo.insert("format", QString::fromLatin1(entry.formatIdentifier));
+        jsonInfo.insert("lastUsed", currentDateTimeText());
+        ok = writeJsonObject(infoTempFilepath, jsonInfo);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Entry is complete once its info file exists(see findDocumentFile()), so it's renamed last
+    ok = ok && replaceFile(docTempFilepath, docFilepath) && replaceFile(infoTempFilepath, infoFilepath);
+    if (!ok) {
+        QFile::remove(docTempFilepath);
+        QFile::remove(infoTempFilepath);
+        return false;
+    }
+
+    this->prune_nolock();
+    return QFileInfo::exists(docFilepath);
+}
+
+std::vector<ImportCache::Entry> ImportCache::entries() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return this->entries_nolock();
+}
+
+int64_t ImportCache::totalSize() const
+{
+    int64_t size = 0;
+    for (const Entry& entry : this->entries())
+        size += entry.size;
+
+    return size;
+}
+
+void ImportCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const QDir dir(m_dirPath);
+    for (const QFileInfo& fileInfo : dir.entryInfoList({ "*.mayo", "*.json", "*.tmp" }, QDir::Files))
+        QFile::remove(fileInfo.absoluteFilePath());
+}
+
+void ImportCache::prune()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    this->prune_nolock();
+}
+
+QString ImportCache::documentFilePath(const QString& key) const
+{
+    return m_dirPath + "/" + key + ".mayo";
+}
+
+QString ImportCache::entryInfoFilePath(const QString& key) const
+{
+    return m_dirPath + "/" + key + ".json";
+}
+
+std::vector<ImportCache::Entry> ImportCache::entries_nolock() const
+{
+    std::vector<Entry> vecEntry;
+    const QDir dir(m_dirPath);
+    for (const QFileInfo& infoFileInfo : dir.entryInfoList({ "*.json" }, QDir::Files)) {
+        const QFileInfo docFileInfo(this->documentFilePath(infoFileInfo.completeBaseName()));
+        if (!docFileInfo.exists())
+            continue;
+
+        const QJsonObject jsonInfo = readJsonObject(infoFileInfo.absoluteFilePath());
+        Entry entry;
+        entry.key = infoFileInfo.completeBaseName();
+        entry.sourceFilepath = jsonInfo.value("sourceFilepath").toString();
+        entry.formatIdentifier = jsonInfo.value("format").toString().toLatin1();
+        entry.lastUsed = QDateTime::fromString(jsonInfo.value("lastUsed").toString(), Qt::ISODateWithMs);
+        if (!entry.lastUsed.isValid())
+            entry.lastUsed = infoFileInfo.lastModified();
+
+        entry.size = docFileInfo.size() + infoFileInfo.size();
+        vecEntry.push_back(std::move(entry));
+    }
+
+    return vecEntry;
+}
+
+void ImportCache::prune_nolock()
+{
+    std::vector<Entry> vecEntry = this->entries_nolock();
+    int64_t size = 0;
+    for (const Entry& entry : vecEntry)
+        size += entry.size;
+
+    if (size <= m_maxSize)
+        return;
+
+    std::sort(vecEntry.begin(), vecEntry.end(), [](const Entry& lhs, const Entry& rhs) {
+        return lhs.lastUsed < rhs.lastUsed;
+    });
+    for (const Entry& entry : vecEntry) {
+        if (size <= m_maxSize)
+            break;
+
+        QFile::remove(this->documentFilePath(entry.key));
+        QFile::remove(this->entryInfoFilePath(entry.key));
+        size -= entry.size;
+    }
+}
+
+} // namespace IO
+} // namespace Mayo
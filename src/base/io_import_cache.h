@@ -0,0 +1,125 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "application_item.h"
+#include "io_format.h"
+#include "span.h"
+#include "task_manager.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QString>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Mayo {
+
+class PropertyGroup;
+class TaskProgress;
+
+namespace IO {
+
+// Directory of translated documents, so importing again an unchanged file skips translation
+//
+// An entry is identified by a key computed from the path, size, modification time and contents of
+// the source file, along with the reader parameters. Translated entities are stored with the
+// Mayo document format(see MayoDocWriter) and restored with MayoDocReader
+// Least recently used entries are removed when the size of the cache exceeds its limit
+class ImportCache {
+public:
+    struct Entry {
+        QString key;
+        QString sourceFilepath;
+        QByteArray formatIdentifier;
+        QDateTime lastUsed;
+        int64_t size = 0; // In bytes
+    };
+
+    ImportCache(const QString& dirPath);
+    ~ImportCache(); // Waits for background stores
+
+    const QString& directoryPath() const { return m_dirPath; }
+
+    // Can be queried from any thread, eg by IO tasks
+    bool isEnabled() const { return m_isEnabled; }
+    void setEnabled(bool on) { m_isEnabled = on; }
+
+    int64_t maxSize() const;
+    void setMaxSize(int64_t bytes);
+
+    // Only formats translated to exact geometry(BRep) can be cached
+    static bool isFormatSupported(const Format& format);
+
+    // Returns empty string if 'filepath' can't be read
+    static QString computeKey(const QString& filepath, const PropertyGroup* readerParameters);
+
+    // Whether 'appItems' can be stored without loss, the Mayo document format doesn't support
+    // layers, materials and GD&T
+    static bool isStorable(Span<const ApplicationItem> appItems);
+
+    // Returns path of the cached document matching 'key', empty string if none
+    // Last use time of the entry is updated
+    QString findDocumentFile(const QString& key);
+
+    // Stores entities 'appItems' translated from 'sourceFilepath', then prunes the cache
+    // Nothing is stored if 'appItems' isn't storable(see isStorable())
+    bool store(
+            const QString& key,
+            const QString& sourceFilepath,
+            const Format& sourceFormat,
+            Span<const ApplicationItem> appItems,
+            TaskProgress* progress);
+
+    // Same as store(), but only entities are gathered in the calling thread, which is fast and
+    // must happen while the document is consistent(eg at the end of an import task)
+    // Writing of the entry is done in a background task
+    void storeInBackground(
+            const QString& key,
+            const QString& sourceFilepath,
+            const Format& sourceFormat,
+            Span<const ApplicationItem> appItems);
+
+    // Blocks until the entries stored in background are written
+    void waitForBackgroundStores();
+
+    std::vector<Entry> entries() const;
+    int64_t totalSize() const;
+
+    void clear();
+    void prune();
+
+private:
+    struct PendingEntry;
+    std::shared_ptr<PendingEntry> prepareEntry(
+            const QString& key,
+            const QString& sourceFilepath,
+            const Format& sourceFormat,
+            Span<const ApplicationItem> appItems,
+            TaskProgress* progress);
+    bool writeEntry(PendingEntry& entry, TaskProgress* progress);
+
+    QString documentFilePath(const QString& key) const;
+    QString entryInfoFilePath(const QString& key) const;
+    std::vector<Entry> entries_nolock() const;
+    void prune_nolock();
+
+    QString m_dirPath;
+    std::atomic<bool> m_isEnabled = { false };
+    int64_t m_maxSize = 2048 * 1024 * 1024LL;
+    mutable std::mutex m_mutex;
+
+    // TaskManager isn't thread-safe, stores can be requested from several import tasks
+    TaskManager m_storeTaskMgr;
+    std::vector<TaskId> m_vecStoreTaskId;
+    std::mutex m_mutexStoreTask;
+};
+
+} // namespace IO
+} // namespace Mayo
@@ -0,0 +1,1212 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "io_mayo_doc.h"
+
+#include "application_item.h"
+#include "brep_utils.h"
+#include "caf_utils.h"
+#include "document.h"
+#include "io_format.h"
+#include "lazy_shape_loader.h"
+#include "property_builtins.h"
+#include "scope_import.h"
+#include "task_progress.h"
+#include "tkernel_utils.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <BRep_Builder.hxx>
+#include <BRep_Tool.hxx>
+#include <BinTools.hxx>
+#include <NCollection_DataMap.hxx>
+#include <OSD_Parallel.hxx>
+#include <Poly_Triangulation.hxx>
+#include <Quantity_ColorRGBA.hxx>
+#include <Standard_Failure.hxx>
+#include <TDF_LabelMapHasher.hxx>
+#include <TopExp.hxx>
+#include <TopTools_IndexedMapOfShape.hxx>
+#include <TopoDS.hxx>
+#include <XCAFDoc_ColorTool.hxx>
+#include <XCAFDoc_ShapeTool.hxx>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <istream>
+#include <iterator>
+#include <mutex>
+#include <streambuf>
+#include <string>
+
+namespace Mayo {
+namespace IO {
+
+namespace {
+
+// -- File layout
+// -- Numbers are stored with the native byte order of the writer, which is checked at reading
+
+constexpr char MayoDoc_Magic[8] = { 'M', 'A', 'Y', 'O', 'D', 'O', 'C', '\0' };
+constexpr uint32_t MayoDoc_Version = 1;
+constexpr uint32_t MayoDoc_ByteOrderMark = 0x01020304;
+constexpr uint32_t MayoDoc_NullIndex = UINT32_MAX;
+constexpr uint64_t MayoDoc_Alignment = 8;
+
+enum class SectionType : uint32_t {
+    Roots = 1,  // uint32_t[], indexes of root ShapeRecord items
+    Shapes,     // ShapeRecord[]
+    Components, // ComponentRecord[]
+    SubShapes,  // SubShapeRecord[]
+    Styles,     // StyleRecord[]
+    Strings,    // BlobRef[], UTF-8 strings
+    BRepBlobs,  // BlobRef[], binary BRep(BinTools)
+    Data,       // Bytes referenced by BlobRef items
+    Triangulations // BlobRef[], same indexes as BRepBlobs, TriangulationRecord items(empty if none)
+};
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrderMark;
+    uint32_t sectionCount; // SectionEntry items following the header
+    uint32_t reserved;
+};
+
+struct SectionEntry {
+    uint32_t type;
+    uint32_t itemCount;
+    uint64_t offset; // From start of file
+    uint64_t size;
+};
+
+struct BlobRef {
+    uint64_t offset; // From start of file
+    uint64_t size;
+};
+
+enum ShapeFlag : uint32_t {
+    ShapeFlag_Assembly = 0x01
+};
+
+struct ShapeRecord {
+    uint32_t flags;
+    uint32_t nameIndex;
+    uint32_t styleIndex;
+    uint32_t blobIndex; // Null for assemblies
+    uint32_t firstChild; // Index of first ComponentRecord(assembly) or SubShapeRecord(part)
+    uint32_t childCount;
+};
+
+struct ComponentRecord {
+    uint32_t shapeIndex; // Referred ShapeRecord
+    uint32_t nameIndex;
+    uint32_t styleIndex;
+    uint32_t reserved;
+    double trsf[12]; // Rows of the 3x4 transformation matrix
+};
+
+struct SubShapeRecord {
+    uint32_t subShapeIndex; // Index in TopExp::MapShapes() of the part shape(starting at 1)
+    uint32_t nameIndex;
+    uint32_t styleIndex;
+    uint32_t reserved;
+};
+
+enum TriangulationFlag : uint32_t {
+    TriangulationFlag_UV = 0x01
+};
+
+// Followed by arrays of nodes(double[3]), UV nodes if any(double[2]) and triangles(int32_t[3],
+// node indexes starting at 1), then padded up to the alignment
+struct TriangulationRecord {
+    uint32_t faceIndex; // Index in TopExp::MapShapes(TopAbs_FACE) of the part shape(starting at 1)
+    uint32_t flags;
+    uint32_t nodeCount;
+    uint32_t triangleCount;
+    double deflection;
+};
+
+enum StyleFlag : uint32_t {
+    StyleFlag_ColorGen = 0x01,
+    StyleFlag_ColorSurf = 0x02,
+    StyleFlag_ColorCurv = 0x04
+};
+
+struct StyleRecord {
+    uint32_t flags;
+    uint32_t reserved;
+    float colorGen[4]; // RGBA
+    float colorSurf[4];
+    float colorCurv[4];
+};
+
+static_assert(sizeof(FileHeader) == 24);
+static_assert(sizeof(SectionEntry) == 24);
+static_assert(sizeof(BlobRef) == 16);
+static_assert(sizeof(ShapeRecord) == 24);
+static_assert(sizeof(ComponentRecord) == 112);
+static_assert(sizeof(SubShapeRecord) == 16);
+static_assert(sizeof(TriangulationRecord) == 24);
+static_assert(sizeof(StyleRecord) == 56);
+
+uint64_t alignedOffset(uint64_t offset)
+{
+    return (offset + MayoDoc_Alignment - 1) & ~(MayoDoc_Alignment - 1);
+}
+
+// Size of the arrays following a TriangulationRecord, padding included
+uint64_t triangulationArraysSize(const TriangulationRecord& record)
+{
+    const uint64_t nodeCount = record.nodeCount;
+    const uint64_t uvSize = (record.flags & TriangulationFlag_UV) ? nodeCount * 2 * sizeof(double) : 0;
+    return alignedOffset(
+                nodeCount * 3 * sizeof(double) + uvSize + uint64_t(record.triangleCount) * 3 * sizeof(int32_t));
+}
+
+// Triangulations of the faces of 'shape', as a sequence of TriangulationRecord items and arrays
+std::string encodeTriangulations(const TopoDS_Shape& shape)
+{
+    std::string blob;
+    auto fnAppend = [&](const void* data, size_t size) {
+        blob.append(reinterpret_cast<const char*>(data), size);
+    };
+
+    TopTools_IndexedMapOfShape mapFace;
+    TopExp::MapShapes(shape, TopAbs_FACE, mapFace);
+    for (int i = 1; i <= mapFace.Extent(); ++i) {
+        TopLoc_Location loc;
+        const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(TopoDS::Face(mapFace(i)), loc);
+        if (triangulation.IsNull() || triangulation->NbNodes() == 0 || triangulation->NbTriangles() == 0)
+            continue;
+
+        TriangulationRecord record = {};
+        record.faceIndex = uint32_t(i);
+        record.flags = triangulation->HasUVNodes() ? TriangulationFlag_UV : 0;
+        record.nodeCount = uint32_t(triangulation->NbNodes());
+        record.triangleCount = uint32_t(triangulation->NbTriangles());
+        record.deflection = triangulation->Deflection();
+        fnAppend(&record, sizeof(TriangulationRecord));
+        const size_t sizeBefore = blob.size();
+        for (int j = 1; j <= triangulation->NbNodes(); ++j) {
+            const gp_Pnt& node = triangulation->Node(j);
+            const double coords[] = { node.X(), node.Y(), node.Z() };
+            fnAppend(coords, sizeof(coords));
+        }
+
+        if (record.flags & TriangulationFlag_UV) {
+            for (int j = 1; j <= triangulation->NbNodes(); ++j) {
+                const gp_Pnt2d& uv = triangulation->UVNode(j);
+                const double coords[] = { uv.X(), uv.Y() };
+                fnAppend(coords, sizeof(coords));
+            }
+        }
+
+        for (int j = 1; j <= triangulation->NbTriangles(); ++j) {
+            int n1, n2, n3;
+            triangulation->Triangle(j).Get(n1, n2, n3);
+            const int32_t nodes[] = { n1, n2, n3 };
+            fnAppend(nodes, sizeof(nodes));
+        }
+
+        blob.resize(sizeBefore + triangulationArraysSize(record), '\0');
+    }
+
+    return blob;
+}
+
+struct StyleColor {
+    XCAFDoc_ColorType type;
+    StyleFlag flag;
+};
+
+const StyleColor styleColors[] = {
+    { XCAFDoc_ColorGen, StyleFlag_ColorGen },
+    { XCAFDoc_ColorSurf, StyleFlag_ColorSurf },
+    { XCAFDoc_ColorCurv, StyleFlag_ColorCurv }
+};
+
+float* styleRecordColor(StyleRecord& style, StyleFlag flag)
+{
+    switch (flag) {
+    case StyleFlag_ColorGen: return style.colorGen;
+    case StyleFlag_ColorSurf: return style.colorSurf;
+    case StyleFlag_ColorCurv: return style.colorCurv;
+    }
+
+    return nullptr;
+}
+
+const float* styleRecordColor(const StyleRecord& style, StyleFlag flag)
+{
+    return styleRecordColor(const_cast<StyleRecord&>(style), flag);
+}
+
+// Read-only stream buffer over a memory block, as required by BinTools::Read()
+class MemoryStreamBuffer : public std::streambuf {
+public:
+    MemoryStreamBuffer(const char* data, size_t size) {
+        char* begin = const_cast<char*>(data);
+        this->setg(begin, begin, begin + size);
+    }
+
+protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override
+    {
+        if (!(which & std::ios_base::in))
+            return pos_type(off_type(-1));
+
+        char* ptrBase = this->eback();
+        if (dir == std::ios_base::cur)
+            ptrBase = this->gptr();
+        else if (dir == std::ios_base::end)
+            ptrBase = this->egptr();
+
+        char* ptrPos = ptrBase + off;
+        if (ptrPos < this->eback() || ptrPos > this->egptr())
+            return pos_type(off_type(-1));
+
+        this->setg(this->eback(), ptrPos, this->egptr());
+        return pos_type(ptrPos - this->eback());
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override
+    {
+        return this->seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+};
+
+} // namespace
+
+// Memory-mapped file, records are accessed in place
+struct MayoDocReader::FileData {
+    ~FileData();
+
+    bool open(const QString& filepath);
+
+    QString stringAt(uint32_t index) const;
+    TopoDS_Shape decodeBlob(uint32_t index) const;
+    void decodeTriangulations(uint32_t index, const TopoDS_Shape& shape) const;
+
+    void applyAttributes(
+            const TDF_Label& label,
+            uint32_t nameIndex,
+            uint32_t styleIndex,
+            const Handle_XCAFDoc_ColorTool& colorTool) const;
+    void applyPartShape(
+            const ShapeRecord& record,
+            const TDF_Label& label,
+            const TopoDS_Shape& shape,
+            const Handle_XCAFDoc_ShapeTool& shapeTool,
+            const Handle_XCAFDoc_ColorTool& colorTool) const;
+
+    template<typename T> struct Array {
+        const T* items = nullptr;
+        uint32_t count = 0;
+        const T& at(uint32_t i) const { return this->items[i]; }
+    };
+
+    QFile file;
+    uchar* data = nullptr;
+    uint64_t size = 0;
+    Array<uint32_t> roots;
+    Array<ShapeRecord> shapes;
+    Array<ComponentRecord> components;
+    Array<SubShapeRecord> subShapes;
+    Array<StyleRecord> styles;
+    Array<BlobRef> strings;
+    Array<BlobRef> blobs;
+    Array<BlobRef> triangulations;
+
+private:
+    bool isValid() const;
+};
+
+MayoDocReader::FileData::~FileData()
+{
+    if (this->data)
+        this->file.unmap(this->data);
+}
+
+bool MayoDocReader::FileData::open(const QString& filepath)
+{
+    this->file.setFileName(filepath);
+    if (!this->file.open(QIODevice::ReadOnly))
+        return false;
+
+    this->size = this->file.size();
+    if (this->size < sizeof(FileHeader))
+        return false;
+
+    this->data = this->file.map(0, this->size);
+    if (!this->data)
+        return false;
+
+    FileHeader header;
+    std::memcpy(&header, this->data, sizeof(FileHeader));
+    if (std::memcmp(header.magic, MayoDoc_Magic, sizeof(MayoDoc_Magic)) != 0
+            || header.version != MayoDoc_Version
+            || header.byteOrderMark != MayoDoc_ByteOrderMark
+            || header.sectionCount > (this->size - sizeof(FileHeader)) / sizeof(SectionEntry))
+    {
+        return false;
+    }
+
+    auto fnMapSection = [=](const SectionEntry& entry, auto* ptrArray, size_t itemSize) {
+        if (entry.offset % MayoDoc_Alignment != 0
+                || entry.offset > this->size
+                || entry.size > this->size - entry.offset
+                || entry.size != uint64_t(entry.itemCount) * itemSize)
+        {
+            return false;
+        }
+
+        ptrArray->items = reinterpret_cast<decltype(ptrArray->items)>(this->data + entry.offset);
+        ptrArray->count = entry.itemCount;
+        return true;
+    };
+
+    const uchar* ptrEntries = this->data + sizeof(FileHeader);
+    for (uint32_t i = 0; i < header.sectionCount; ++i) {
+        SectionEntry entry;
+        std::memcpy(&entry, ptrEntries + i * sizeof(SectionEntry), sizeof(SectionEntry));
+        bool ok = true;
+        switch (SectionType(entry.type)) {
+        case SectionType::Roots: ok = fnMapSection(entry, &this->roots, sizeof(uint32_t)); break;
+        case SectionType::Shapes: ok = fnMapSection(entry, &this->shapes, sizeof(ShapeRecord)); break;
+        case SectionType::Components: ok = fnMapSection(entry, &this->components, sizeof(ComponentRecord)); break;
+        case SectionType::SubShapes: ok = fnMapSection(entry, &this->subShapes, sizeof(SubShapeRecord)); break;
+        case SectionType::Styles: ok = fnMapSection(entry, &this->styles, sizeof(StyleRecord)); break;
+        case SectionType::Strings: ok = fnMapSection(entry, &this->strings, sizeof(BlobRef)); break;
+        case SectionType::BRepBlobs: ok = fnMapSection(entry, &this->blobs, sizeof(BlobRef)); break;
+        case SectionType::Triangulations: ok = fnMapSection(entry, &this->triangulations, sizeof(BlobRef)); break;
+        case SectionType::Data: break; // Accessed through BlobRef items
+        default: break; // Unknown sections are skipped, for forward compatibility
+        }
+
+        if (!ok)
+            return false;
+    }
+
+    return this->isValid();
+}
+
+bool MayoDocReader::FileData::isValid() const
+{
+    auto fnIsBlobRefValid = [=](const BlobRef& ref) {
+        return ref.offset <= this->size && ref.size <= this->size - ref.offset;
+    };
+    auto fnIsIndexValid = [](uint32_t index, uint32_t count) {
+        return index == MayoDoc_NullIndex || index < count;
+    };
+    auto fnIsRangeValid = [](uint32_t first, uint32_t count, uint32_t arrayCount) {
+        return uint64_t(first) + count <= arrayCount;
+    };
+
+    for (uint32_t i = 0; i < this->strings.count; ++i) {
+        if (!fnIsBlobRefValid(this->strings.at(i)))
+            return false;
+    }
+
+    for (uint32_t i = 0; i < this->blobs.count; ++i) {
+        if (!fnIsBlobRefValid(this->blobs.at(i)))
+            return false;
+    }
+
+    if (this->triangulations.count != 0 && this->triangulations.count != this->blobs.count)
+        return false;
+
+    for (uint32_t i = 0; i < this->triangulations.count; ++i) {
+        if (!fnIsBlobRefValid(this->triangulations.at(i)))
+            return false;
+    }
+
+    for (uint32_t i = 0; i < this->roots.count; ++i) {
+        if (this->roots.at(i) >= this->shapes.count)
+            return false;
+    }
+
+    for (uint32_t i = 0; i < this->shapes.count; ++i) {
+        const ShapeRecord& record = this->shapes.at(i);
+        if (!fnIsIndexValid(record.nameIndex, this->strings.count)
+                || !fnIsIndexValid(record.styleIndex, this->styles.count))
+        {
+            return false;
+        }
+
+        if (record.flags & ShapeFlag_Assembly) {
+            if (!fnIsRangeValid(record.firstChild, record.childCount, this->components.count))
+                return false;
+        }
+        else {
+            if (record.blobIndex >= this->blobs.count
+                    || !fnIsRangeValid(record.firstChild, record.childCount, this->subShapes.count))
+            {
+                return false;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < this->components.count; ++i) {
+        const ComponentRecord& record = this->components.at(i);
+        if (record.shapeIndex >= this->shapes.count
+                || !fnIsIndexValid(record.nameIndex, this->strings.count)
+                || !fnIsIndexValid(record.styleIndex, this->styles.count))
+        {
+            return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < this->subShapes.count; ++i) {
+        const SubShapeRecord& record = this->subShapes.at(i);
+        if (!fnIsIndexValid(record.nameIndex, this->strings.count)
+                || !fnIsIndexValid(record.styleIndex, this->styles.count))
+        {
+            return false;
+        }
+    }
+
+    // Assemblies must not contain themselves, directly or not
+    enum class VisitState : uint8_t { None, InProgress, Done };
+    std::vector<VisitState> vecVisitState(this->shapes.count, VisitState::None);
+    std::function<bool(uint32_t)> fnIsAcyclic = [&](uint32_t shapeIndex) {
+        if (vecVisitState.at(shapeIndex) != VisitState::None)
+            return vecVisitState.at(shapeIndex) == VisitState::Done;
+
+        vecVisitState.at(shapeIndex) = VisitState::InProgress;
+        const ShapeRecord& record = this->shapes.at(shapeIndex);
+        if (record.flags & ShapeFlag_Assembly) {
+            for (uint32_t i = 0; i < record.childCount; ++i) {
+                if (!fnIsAcyclic(this->components.at(record.firstChild + i).shapeIndex))
+                    return false;
+            }
+        }
+
+        vecVisitState.at(shapeIndex) = VisitState::Done;
+        return true;
+    };
+    for (uint32_t i = 0; i < this->shapes.count; ++i) {
+        if (!fnIsAcyclic(i))
+            return false;
+    }
+
+    return true;
+}
+
+QString MayoDocReader::FileData::stringAt(uint32_t index) const
+{
+    if (index == MayoDoc_NullIndex)
+        return QString();
+
+    const BlobRef& ref = this->strings.at(index);
+    return QString::fromUtf8(reinterpret_cast<const char*>(this->data + ref.offset), int(ref.size));
+}
+
+TopoDS_Shape MayoDocReader::FileData::decodeBlob(uint32_t index) const
+{
+    const BlobRef& ref = this->blobs.at(index);
+    MemoryStreamBuffer buffer(reinterpret_cast<const char*>(this->data + ref.offset), ref.size);
+    std::istream istr(&buffer);
+    TopoDS_Shape shape;
+    try {
+        BinTools::Read(shape, istr);
+    } catch (const Standard_Failure&) {
+        shape.Nullify();
+    }
+
+    if (!shape.IsNull())
+        this->decodeTriangulations(index, shape);
+
+    return shape;
+}
+
+void MayoDocReader::FileData::decodeTriangulations(uint32_t index, const TopoDS_Shape& shape) const
+{
+    if (index >= this->triangulations.count || this->triangulations.at(index).size == 0)
+        return;
+
+    TopTools_IndexedMapOfShape mapFace;
+    TopExp::MapShapes(shape, TopAbs_FACE, mapFace);
+    BRep_Builder builder;
+    const BlobRef& ref = this->triangulations.at(index);
+    const uchar* ptr = this->data + ref.offset;
+    const uchar* ptrEnd = ptr + ref.size;
+    while (uint64_t(ptrEnd - ptr) >= sizeof(TriangulationRecord)) {
+        TriangulationRecord record;
+        std::memcpy(&record, ptr, sizeof(TriangulationRecord));
+        ptr += sizeof(TriangulationRecord);
+        const uint64_t arraysSize = triangulationArraysSize(record);
+        if (arraysSize > uint64_t(ptrEnd - ptr))
+            return;
+
+        const uchar* ptrArray = ptr;
+        ptr += arraysSize;
+        if (record.faceIndex == 0 || int(record.faceIndex) > mapFace.Extent()
+                || record.nodeCount == 0 || record.triangleCount == 0)
+        {
+            continue;
+        }
+
+        const int nodeCount = int(record.nodeCount);
+        const bool hasUV = record.flags & TriangulationFlag_UV;
+        Handle_Poly_Triangulation triangulation = new Poly_Triangulation(nodeCount, int(record.triangleCount), hasUV);
+        triangulation->Deflection(record.deflection);
+        for (int i = 1; i <= nodeCount; ++i) {
+            double coords[3];
+            std::memcpy(coords, ptrArray, sizeof(coords));
+            ptrArray += sizeof(coords);
+            triangulation->ChangeNode(i).SetCoord(coords[0], coords[1], coords[2]);
+        }
+
+        if (hasUV) {
+            for (int i = 1; i <= nodeCount; ++i) {
+                double coords[2];
+                std::memcpy(coords, ptrArray, sizeof(coords));
+                ptrArray += sizeof(coords);
+                triangulation->ChangeUVNode(i).SetCoord(coords[0], coords[1]);
+            }
+        }
+
+        bool areTrianglesValid = true;
+        for (int i = 1; i <= int(record.triangleCount); ++i) {
+            int32_t nodes[3];
+            std::memcpy(nodes, ptrArray, sizeof(nodes));
+            ptrArray += sizeof(nodes);
+            for (int32_t node : nodes)
+                areTrianglesValid = areTrianglesValid && node >= 1 && node <= nodeCount;
+
+            triangulation->ChangeTriangle(i).Set(nodes[0], nodes[1], nodes[2]);
+        }
+
+        if (areTrianglesValid)
+            builder.UpdateFace(TopoDS::Face(mapFace(int(record.faceIndex))), triangulation);
+    }
+}
+
+void MayoDocReader::FileData::applyAttributes(
+        const TDF_Label& label,
+        uint32_t nameIndex,
+        uint32_t styleIndex,
+        const Handle_XCAFDoc_ColorTool& colorTool) const
+{
+    if (nameIndex != MayoDoc_NullIndex)
+        CafUtils::setLabelAttrStdName(label, this->stringAt(nameIndex));
+
+    if (styleIndex == MayoDoc_NullIndex || colorTool.IsNull())
+        return;
+
+    const StyleRecord& style = this->styles.at(styleIndex);
+    for (const StyleColor& styleColor : styleColors) {
+        if (style.flags & styleColor.flag) {
+            const float* rgba = styleRecordColor(style, styleColor.flag);
+            const Quantity_Color color(rgba[0], rgba[1], rgba[2], Quantity_TOC_RGB);
+            colorTool->SetColor(label, Quantity_ColorRGBA(color, rgba[3]), styleColor.type);
+        }
+    }
+}
+
+void MayoDocReader::FileData::applyPartShape(
+        const ShapeRecord& record,
+        const TDF_Label& label,
+        const TopoDS_Shape& shape,
+        const Handle_XCAFDoc_ShapeTool& shapeTool,
+        const Handle_XCAFDoc_ColorTool& colorTool) const
+{
+    if (shape.IsNull())
+        return;
+
+    shapeTool->SetShape(label, shape);
+    if (record.childCount == 0)
+        return;
+
+    TopTools_IndexedMapOfShape mapSubShape;
+    TopExp::MapShapes(shape, mapSubShape);
+    for (uint32_t i = 0; i < record.childCount; ++i) {
+        const SubShapeRecord& subRecord = this->subShapes.at(record.firstChild + i);
+        if (subRecord.subShapeIndex == 0 || int(subRecord.subShapeIndex) > mapSubShape.Extent())
+            continue;
+
+        const TDF_Label subLabel = shapeTool->AddSubShape(label, mapSubShape.FindKey(subRecord.subShapeIndex));
+        if (!subLabel.IsNull())
+            this->applyAttributes(subLabel, subRecord.nameIndex, subRecord.styleIndex, colorTool);
+    }
+}
+
+namespace {
+
+// Decodes on demand the geometry of parts left empty at import
+// Blobs are decoded in parallel, assignment to the document is left to Document::assignLazyShapes()
+class MayoDocLazyShapeLoader : public LazyShapeLoader {
+public:
+    using FileData = MayoDocReader::FileData;
+
+    MayoDocLazyShapeLoader(
+            const std::shared_ptr<const FileData>& fileData,
+            const DocumentPtr& doc,
+            const NCollection_DataMap<TDF_Label, uint32_t, TDF_LabelMapHasher>& mapPendingPart)
+        : m_fileData(fileData),
+          m_shapeTool(doc->xcaf().shapeTool()),
+          m_colorTool(doc->xcaf().colorTool()),
+          m_mapPendingPart(mapPendingPart)
+    {}
+
+    bool isPending(const TDF_Label& partLabel) const override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_mapPendingPart.IsBound(partLabel);
+    }
+
+    std::vector<LazyShape> translate(Span<const TDF_Label> spanPartLabel, TaskProgress* progress) override
+    {
+        std::vector<std::pair<TDF_Label, uint32_t>> vecPart;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (const TDF_Label& label : spanPartLabel) {
+                uint32_t shapeIndex;
+                if (m_mapPendingPart.Find(label, shapeIndex)) {
+                    vecPart.emplace_back(label, shapeIndex);
+                    m_mapPendingPart.UnBind(label);
+                    m_mapTranslatedPart.Bind(label, shapeIndex); // Needed by assign()
+                }
+            }
+        }
+
+        std::vector<LazyShape> vecShape(vecPart.size());
+        OSD_Parallel::For(0, int(vecPart.size()), [&](int i) {
+            const ShapeRecord& record = m_fileData->shapes.at(vecPart.at(i).second);
+            vecShape.at(i) = { vecPart.at(i).first, m_fileData->decodeBlob(record.blobIndex) };
+        });
+        if (progress)
+            progress->setValue(100);
+
+        return vecShape;
+    }
+
+    void assign(const LazyShape& lazyShape) override
+    {
+        uint32_t shapeIndex;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_mapTranslatedPart.Find(lazyShape.label, shapeIndex))
+                return;
+
+            m_mapTranslatedPart.UnBind(lazyShape.label);
+        }
+
+        const ShapeRecord& record = m_fileData->shapes.at(shapeIndex);
+        m_fileData->applyPartShape(record, lazyShape.label, lazyShape.shape, m_shapeTool, m_colorTool);
+    }
+
+private:
+    std::shared_ptr<const FileData> m_fileData;
+    Handle_XCAFDoc_ShapeTool m_shapeTool;
+    Handle_XCAFDoc_ColorTool m_colorTool;
+    NCollection_DataMap<TDF_Label, uint32_t, TDF_LabelMapHasher> m_mapPendingPart;
+    NCollection_DataMap<TDF_Label, uint32_t, TDF_LabelMapHasher> m_mapTranslatedPart;
+    mutable std::mutex m_mutex;
+};
+
+} // namespace
+
+class MayoDocReader::Properties : public PropertyGroup {
+    MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::IO::MayoDocReader_Properties)
+public:
+    Properties(PropertyGroup* parentGroup)
+        : PropertyGroup(parentGroup),
+          loadPartsOnDemand(this, textId("loadPartsOnDemand"))
+    {
+        this->loadPartsOnDemand.setDescription(
+                    textIdTr("Create only the assembly structure, names and colors at import, "
+                             "geometry of parts is decoded later when they are expanded, "
+                             "selected or exported"));
+    }
+
+    void restoreDefaults() override {
+        const MayoDocReader::Parameters params;
+        this->loadPartsOnDemand.setValue(params.loadPartsOnDemand);
+    }
+
+    PropertyBool loadPartsOnDemand;
+};
+
+MayoDocReader::MayoDocReader()
+{
+}
+
+MayoDocReader::~MayoDocReader()
+{
+}
+
+bool MayoDocReader::readFile(const QString& filepath, TaskProgress* progress)
+{
+    m_fileData = std::make_shared<FileData>();
+    m_baseFilename = QFileInfo(filepath).baseName();
+    if (!m_fileData->open(filepath)) {
+        m_fileData.reset();
+        return false;
+    }
+
+    progress->setValue(100);
+    return true;
+}
+
+bool MayoDocReader::transfer(DocumentPtr doc, TaskProgress* progress)
+{
+    if (!m_fileData)
+        return false;
+
+    const FileData& fileData = *m_fileData;
+    XCafScopeImport import(doc);
+    const Handle_XCAFDoc_ShapeTool shapeTool = doc->xcaf().shapeTool();
+    const Handle_XCAFDoc_ColorTool colorTool = doc->xcaf().colorTool();
+
+    // Decode geometry of all parts in parallel
+    std::vector<TopoDS_Shape> vecPartShape;
+    if (!m_params.loadPartsOnDemand) {
+        vecPartShape.resize(fileData.blobs.count);
+        OSD_Parallel::For(0, int(fileData.blobs.count), [&](int i) {
+            vecPartShape.at(i) = fileData.decodeBlob(i);
+        });
+    }
+
+    progress->setValue(70);
+    if (TaskProgress::isAbortRequested(progress)) {
+        import.setConfirmation(false);
+        return false;
+    }
+
+    // Shapes reachable from roots, in depth-first order so free shapes(ie entities of the document)
+    // are created in the order of roots
+    // Every shape is a root for files without Roots section
+    std::vector<uint32_t> vecShapeIndex;
+    std::vector<bool> vecShapeVisited(fileData.shapes.count, false);
+    std::function<void(uint32_t)> fnVisitShape = [&](uint32_t shapeIndex) {
+        if (vecShapeVisited.at(shapeIndex))
+            return;
+
+        vecShapeVisited.at(shapeIndex) = true;
+        vecShapeIndex.push_back(shapeIndex);
+        const ShapeRecord& record = fileData.shapes.at(shapeIndex);
+        if (record.flags & ShapeFlag_Assembly) {
+            for (uint32_t i = 0; i < record.childCount; ++i)
+                fnVisitShape(fileData.components.at(record.firstChild + i).shapeIndex);
+        }
+    };
+    for (uint32_t i = 0; i < fileData.roots.count; ++i)
+        fnVisitShape(fileData.roots.at(i));
+
+    if (fileData.roots.count == 0) {
+        for (uint32_t i = 0; i < fileData.shapes.count; ++i)
+            fnVisitShape(i);
+    }
+
+    // Create labels of all shapes first, so components can refer to them
+    NCollection_DataMap<TDF_Label, uint32_t, TDF_LabelMapHasher> mapPendingPart;
+    std::vector<TDF_Label> vecShapeLabel(fileData.shapes.count);
+    for (const uint32_t i : vecShapeIndex) {
+        const ShapeRecord& record = fileData.shapes.at(i);
+        const TDF_Label label = shapeTool->NewShape();
+        vecShapeLabel.at(i) = label;
+        fileData.applyAttributes(label, record.nameIndex, record.styleIndex, colorTool);
+        if (!(record.flags & ShapeFlag_Assembly)) {
+            if (m_params.loadPartsOnDemand)
+                mapPendingPart.Bind(label, i);
+            else
+                fileData.applyPartShape(record, label, vecPartShape.at(record.blobIndex), shapeTool, colorTool);
+        }
+    }
+
+    vecPartShape.clear();
+    progress->setValue(85);
+
+    for (const uint32_t i : vecShapeIndex) {
+        const ShapeRecord& record = fileData.shapes.at(i);
+        if (!(record.flags & ShapeFlag_Assembly))
+            continue;
+
+        for (uint32_t j = 0; j < record.childCount; ++j) {
+            const ComponentRecord& compRecord = fileData.components.at(record.firstChild + j);
+            const double* m = compRecord.trsf;
+            gp_Trsf trsf;
+            trsf.SetValues(m[0], m[1], m[2], m[3], m[4], m[5], m[6], m[7], m[8], m[9], m[10], m[11]);
+            const TDF_Label compLabel = shapeTool->AddComponent(
+                        vecShapeLabel.at(i), vecShapeLabel.at(compRecord.shapeIndex), TopLoc_Location(trsf));
+            if (!compLabel.IsNull())
+                fileData.applyAttributes(compLabel, compRecord.nameIndex, compRecord.styleIndex, colorTool);
+        }
+    }
+
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
+    shapeTool->UpdateAssemblies();
+#endif
+
+    if (m_params.nameSingleRootAfterFile && fileData.roots.count == 1) {
+        const TDF_Label rootLabel = vecShapeLabel.at(fileData.roots.at(0));
+        if (CafUtils::labelAttrStdName(rootLabel).isEmpty())
+            CafUtils::setLabelAttrStdName(rootLabel, m_baseFilename);
+    }
+
+    if (!mapPendingPart.IsEmpty())
+        doc->addLazyShapeLoader(std::make_shared<MayoDocLazyShapeLoader>(m_fileData, doc, mapPendingPart));
+
+    progress->setValue(100);
+    return true;
+}
+
+std::unique_ptr<PropertyGroup> MayoDocReader::createProperties(PropertyGroup* parentGroup)
+{
+    return std::make_unique<Properties>(parentGroup);
+}
+
+void MayoDocReader::applyProperties(const PropertyGroup* params)
+{
+    auto ptr = dynamic_cast<const Properties*>(params);
+    if (ptr)
+        m_params.loadPartsOnDemand = ptr->loadPartsOnDemand.value();
+}
+
+// Records gathered from the application items, ready to be written
+struct MayoDocWriter::Content {
+    std::vector<uint32_t> vecRoot;
+    std::vector<ShapeRecord> vecShape;
+    std::vector<ComponentRecord> vecComponent;
+    std::vector<SubShapeRecord> vecSubShape;
+    std::vector<StyleRecord> vecStyle;
+    std::vector<QByteArray> vecString;
+    std::vector<TopoDS_Shape> vecBlobShape;
+};
+
+class MayoDocWriter::Properties : public PropertyGroup {
+    MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::IO::MayoDocWriter_Properties)
+public:
+    Properties(PropertyGroup* parentGroup)
+        : PropertyGroup(parentGroup),
+          writeTriangulation(this, textId("writeTriangulation"))
+    {
+        this->writeTriangulation.setDescription(
+                    textIdTr("Store the triangulations of faces along with the exact geometry, "
+                             "so meshing isn't needed again when the document is reopened"));
+    }
+
+    void restoreDefaults() override {
+        const MayoDocWriter::Parameters params;
+        this->writeTriangulation.setValue(params.writeTriangulation);
+    }
+
+    PropertyBool writeTriangulation;
+};
+
+bool MayoDocWriter::transfer(Span<const ApplicationItem> appItems, TaskProgress* progress)
+{
+    m_content = std::make_shared<Content>();
+    Content& content = *m_content;
+    Handle_XCAFDoc_ColorTool colorTool;
+
+    auto fnAddString = [&](const QString& str) {
+        if (str.isEmpty())
+            return MayoDoc_NullIndex;
+
+        content.vecString.push_back(str.toUtf8());
+        return uint32_t(content.vecString.size() - 1);
+    };
+
+    auto fnAddStyle = [&](const TDF_Label& label) {
+        StyleRecord style = {};
+        for (const StyleColor& styleColor : styleColors) {
+            Quantity_ColorRGBA color;
+            if (!colorTool.IsNull() && colorTool->GetColor(label, styleColor.type, color)) {
+                float* rgba = styleRecordColor(style, styleColor.flag);
+                rgba[0] = float(color.GetRGB().Red());
+                rgba[1] = float(color.GetRGB().Green());
+                rgba[2] = float(color.GetRGB().Blue());
+                rgba[3] = color.Alpha();
+                style.flags |= styleColor.flag;
+            }
+        }
+
+        if (style.flags == 0)
+            return MayoDoc_NullIndex;
+
+        content.vecStyle.push_back(style);
+        return uint32_t(content.vecStyle.size() - 1);
+    };
+
+    NCollection_DataMap<TDF_Label, uint32_t, TDF_LabelMapHasher> mapShapeIndex;
+    std::function<uint32_t(const TDF_Label&)> fnAddShape = [&](const TDF_Label& label) {
+        uint32_t index;
+        if (mapShapeIndex.Find(label, index))
+            return index;
+
+        index = uint32_t(content.vecShape.size());
+        mapShapeIndex.Bind(label, index);
+        content.vecShape.emplace_back();
+        ShapeRecord record = {};
+        record.nameIndex = fnAddString(CafUtils::labelAttrStdName(label));
+        record.styleIndex = fnAddStyle(label);
+        record.blobIndex = MayoDoc_NullIndex;
+        if (XCaf::isShapeAssembly(label)) {
+            const TDF_LabelSequence seqComponent = XCaf::shapeComponents(label);
+            record.flags = ShapeFlag_Assembly;
+            record.firstChild = uint32_t(content.vecComponent.size());
+            record.childCount = uint32_t(seqComponent.Length());
+            content.vecComponent.resize(record.firstChild + record.childCount);
+            uint32_t compId = record.firstChild;
+            for (const TDF_Label& compLabel : seqComponent) {
+                ComponentRecord compRecord = {};
+                compRecord.nameIndex = fnAddString(CafUtils::labelAttrStdName(compLabel));
+                compRecord.styleIndex = fnAddStyle(compLabel);
+                const gp_Trsf trsf = XCaf::shapeReferenceLocation(compLabel).Transformation();
+                for (int row = 1; row <= 3; ++row) {
+                    for (int col = 1; col <= 4; ++col)
+                        compRecord.trsf[(row - 1) * 4 + (col - 1)] = trsf.Value(row, col);
+                }
+
+                compRecord.shapeIndex = fnAddShape(XCaf::shapeReferred(compLabel));
+                content.vecComponent.at(compId++) = compRecord;
+            }
+        }
+        else {
+            const TopoDS_Shape shape = XCaf::shape(label);
+            record.blobIndex = uint32_t(content.vecBlobShape.size());
+            content.vecBlobShape.push_back(shape);
+            record.firstChild = uint32_t(content.vecSubShape.size());
+            const TDF_LabelSequence seqSubShape = XCaf::shapeSubs(label);
+            if (!seqSubShape.IsEmpty()) {
+                TopTools_IndexedMapOfShape mapSubShape;
+                TopExp::MapShapes(shape, mapSubShape);
+                for (const TDF_Label& subLabel : seqSubShape) {
+                    const int subShapeIndex = mapSubShape.FindIndex(XCaf::shape(subLabel));
+                    if (subShapeIndex <= 0)
+                        continue;
+
+                    SubShapeRecord subRecord = {};
+                    subRecord.subShapeIndex = uint32_t(subShapeIndex);
+                    subRecord.nameIndex = fnAddString(CafUtils::labelAttrStdName(subLabel));
+                    subRecord.styleIndex = fnAddStyle(subLabel);
+                    content.vecSubShape.push_back(subRecord);
+                }
+            }
+
+            record.childCount = uint32_t(content.vecSubShape.size()) - record.firstChild;
+        }
+
+        content.vecShape.at(index) = record;
+        return index;
+    };
+
+    auto fnAddRoot = [&](const TDF_Label& label) {
+        const TDF_Label shapeLabel = XCaf::isShapeReference(label) ? XCaf::shapeReferred(label) : label;
+        const uint32_t index = fnAddShape(shapeLabel);
+        if (std::find(content.vecRoot.cbegin(), content.vecRoot.cend(), index) == content.vecRoot.cend())
+            content.vecRoot.push_back(index);
+    };
+
+    for (const ApplicationItem& item : appItems) {
+        const DocumentPtr doc = item.document();
+        colorTool = doc->xcaf().colorTool();
+        if (item.isDocument()) {
+            for (const TDF_Label& label : doc->xcaf().topLevelFreeShapes())
+                fnAddRoot(label);
+        }
+        else if (item.isDocumentTreeNode()) {
+            fnAddRoot(item.documentTreeNode().label());
+        }
+    }
+
+    progress->setValue(100);
+    return true;
+}
+
+bool MayoDocWriter::writeFile(const QString& filepath, TaskProgress* progress)
+{
+    if (!m_content)
+        return false;
+
+    const Content& content = *m_content;
+    const bool withTriangulation = m_params.writeTriangulation;
+    const size_t blobCount = content.vecBlobShape.size();
+
+    // Layout: header, section table, record sections then data(strings and blobs)
+    // Offsets of blobs are known only once serialized, so the sections are written a first time
+    // to reserve their space, then a second time when data has been written
+    std::vector<BlobRef> vecStringRef(content.vecString.size());
+    std::vector<BlobRef> vecBlobRef(blobCount);
+    std::vector<BlobRef> vecTriangulationRef(withTriangulation ? blobCount : 0);
+    struct SectionData {
+        SectionType type;
+        uint32_t itemCount;
+        const void* data;
+        uint64_t size;
+    };
+    auto fnSectionData = [](SectionType type, const auto& vec) {
+        using ItemType = typename std::decay_t<decltype(vec)>::value_type;
+        return SectionData{ type, uint32_t(vec.size()), vec.data(), vec.size() * sizeof(ItemType) };
+    };
+    const SectionData arraySectionData[] = {
+        fnSectionData(SectionType::Roots, content.vecRoot),
+        fnSectionData(SectionType::Shapes, content.vecShape),
+        fnSectionData(SectionType::Components, content.vecComponent),
+        fnSectionData(SectionType::SubShapes, content.vecSubShape),
+        fnSectionData(SectionType::Styles, content.vecStyle),
+        fnSectionData(SectionType::Strings, vecStringRef),
+        fnSectionData(SectionType::BRepBlobs, vecBlobRef),
+        fnSectionData(SectionType::Triangulations, vecTriangulationRef)
+    };
+    const uint32_t sectionCount = uint32_t(std::size(arraySectionData)) + 1; // Data section
+
+    std::vector<SectionEntry> vecEntry;
+    uint64_t offset = alignedOffset(sizeof(FileHeader) + sectionCount * sizeof(SectionEntry));
+    for (const SectionData& section : arraySectionData) {
+        vecEntry.push_back({ uint32_t(section.type), section.itemCount, offset, section.size });
+        offset = alignedOffset(offset + section.size);
+    }
+
+    const uint64_t offsetData = offset;
+    vecEntry.push_back({ uint32_t(SectionType::Data), 0, offsetData, 0 });
+
+    // Write
+    QFile file(filepath);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    bool ok = true;
+    auto fnWrite = [&](const void* data, uint64_t size) {
+        if (ok && size > 0)
+            ok = file.write(reinterpret_cast<const char*>(data), size) == qint64(size);
+    };
+    auto fnWritePadding = [&]{
+        const char zeros[MayoDoc_Alignment] = {};
+        const uint64_t pos = file.pos();
+        fnWrite(zeros, alignedOffset(pos) - pos);
+    };
+    auto fnWriteData = [&](const void* data, uint64_t size) {
+        const BlobRef ref = { uint64_t(file.pos()), size };
+        fnWrite(data, size);
+        fnWritePadding();
+        return ref;
+    };
+    auto fnWriteSections = [&]{
+        FileHeader header = {};
+        std::memcpy(header.magic, MayoDoc_Magic, sizeof(MayoDoc_Magic));
+        header.version = MayoDoc_Version;
+        header.byteOrderMark = MayoDoc_ByteOrderMark;
+        header.sectionCount = sectionCount;
+        fnWrite(&header, sizeof(FileHeader));
+        fnWrite(vecEntry.data(), vecEntry.size() * sizeof(SectionEntry));
+        fnWritePadding();
+        for (const SectionData& section : arraySectionData) {
+            fnWrite(section.data, section.size);
+            fnWritePadding();
+        }
+    };
+
+    fnWriteSections();
+    for (size_t i = 0; i < content.vecString.size(); ++i)
+        vecStringRef.at(i) = fnWriteData(content.vecString.at(i).constData(), content.vecString.at(i).size());
+
+    // Geometry of parts is serialized in parallel by batches, then written in order, so only the
+    // blobs of a single batch are held in memory
+    struct Blobs {
+        std::string brep;
+        std::string triangulations;
+    };
+    const size_t batchSize = std::max(1, 2 * OSD_Parallel::NbLogicalProcessors());
+    std::vector<Blobs> vecBatchBlobs;
+    for (size_t iBatch = 0; iBatch < blobCount && ok; iBatch += batchSize) {
+        if (TaskProgress::isAbortRequested(progress)) {
+            ok = false;
+            break;
+        }
+
+        vecBatchBlobs.clear();
+        vecBatchBlobs.resize(std::min(batchSize, blobCount - iBatch));
+        OSD_Parallel::For(0, int(vecBatchBlobs.size()), [&](int i) {
+            const TopoDS_Shape& shape = content.vecBlobShape.at(iBatch + i);
+            Blobs& blobs = vecBatchBlobs.at(i);
+            blobs.brep = BRepUtils::shapeToBinaryString(shape, false/*withTriangulation*/);
+            if (withTriangulation)
+                blobs.triangulations = encodeTriangulations(shape);
+        });
+        for (size_t i = 0; i < vecBatchBlobs.size(); ++i) {
+            const Blobs& blobs = vecBatchBlobs.at(i);
+            vecBlobRef.at(iBatch + i) = fnWriteData(blobs.brep.data(), blobs.brep.size());
+            if (withTriangulation) {
+                vecTriangulationRef.at(iBatch + i) =
+                        fnWriteData(blobs.triangulations.data(), blobs.triangulations.size());
+            }
+        }
+
+        progress->setValue(int((iBatch + vecBatchBlobs.size()) * 100 / blobCount));
+    }
+
+    // Now offsets are known, rewrite the sections
+    vecEntry.back().size = uint64_t(file.pos()) - offsetData;
+    ok = ok && file.seek(0);
+    fnWriteSections();
+    progress->setValue(100);
+    return ok;
+}
+
+std::unique_ptr<PropertyGroup> MayoDocWriter::createProperties(PropertyGroup* parentGroup)
+{
+    return std::make_unique<Properties>(parentGroup);
+}
+
+void MayoDocWriter::applyProperties(const PropertyGroup* params)
+{
+    auto ptr = dynamic_cast<const Properties*>(params);
+    if (ptr)
+        m_params.writeTriangulation = ptr->writeTriangulation.value();
+}
+
+Span<const Format> MayoDocFactoryReader::formats() const
+{
+    static const Format array[] = { Format_MAYODOC };
+    return array;
+}
+
+std::unique_ptr<Reader> MayoDocFactoryReader::create(const Format& format) const
+{
+    if (format == Format_MAYODOC)
+        return std::make_unique<MayoDocReader>();
+
+    return {};
+}
+
+std::unique_ptr<PropertyGroup> MayoDocFactoryReader::createProperties(
+        const Format& format, PropertyGroup* parentGroup) const
+{
+    if (format == Format_MAYODOC)
+        return MayoDocReader::createProperties(parentGroup);
+
+    return {};
+}
+
+Span<const Format> MayoDocFactoryWriter::formats() const
+{
+    static const Format array[] = { Format_MAYODOC };
+    return array;
+}
+
+std::unique_ptr<Writer> MayoDocFactoryWriter::create(const Format& format) const
+{
+    if (format == Format_MAYODOC)
+        return std::make_unique<MayoDocWriter>();
+
+    return {};
+}
+
+std::unique_ptr<PropertyGroup> MayoDocFactoryWriter::createProperties(
+        const Format& format, PropertyGroup* parentGroup) const
+{
+    if (format == Format_MAYODOC)
+        return MayoDocWriter::createProperties(parentGroup);
+
+    return {};
+}
+
+} // namespace IO
+} // namespace Mayo
@@ -0,0 +1,106 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "io_reader.h"
+#include "io_writer.h"
+#include "property.h"
+#include <memory>
+
+namespace Mayo {
+namespace IO {
+
+// Mayo native document file format
+//
+// The file is a fixed header followed by a table of sections. Each section is an array of
+// fixed-size records, or raw data referenced by offset/size:
+//     - the XCAF label graph: root shapes, shapes(parts and assemblies), components with their
+//       locations, sub-shapes
+//     - names and colors
+//     - geometry of parts as binary BRep blobs(see BinTools), without triangulations
+//     - triangulations of part faces as raw Poly_Triangulation arrays, one blob per part
+// All sections and blobs start at 8-byte aligned offsets, so the file can be memory-mapped and
+// the blobs decoded in parallel, or lazily(see MayoDocReader::Parameters::loadPartsOnDemand)
+//
+// Layers, materials and GD&T data aren't stored
+class MayoDocReader : public Reader {
+public:
+    MayoDocReader();
+    ~MayoDocReader();
+
+    bool readFile(const QString& filepath, TaskProgress* progress) override;
+    bool transfer(DocumentPtr doc, TaskProgress* progress) override;
+
+    static std::unique_ptr<PropertyGroup> createProperties(PropertyGroup* parentGroup);
+    void applyProperties(const PropertyGroup* params) override;
+
+    // Parameters
+    struct Parameters {
+        // Geometry of parts is decoded only when needed(see Document::loadLazyShapes())
+        bool loadPartsOnDemand = false;
+        // Single unnamed root is named after the file, as other readers do
+        // Should be disabled when the document structure has to be restored as is(eg import cache)
+        bool nameSingleRootAfterFile = true;
+    };
+    Parameters& parameters() { return m_params; }
+    const Parameters& constParameters() const { return m_params; }
+
+    // Memory-mapped contents of the file, shared with the loader of part geometries
+    struct FileData;
+
+private:
+    class Properties;
+    std::shared_ptr<FileData> m_fileData;
+    QString m_baseFilename;
+    Parameters m_params;
+};
+
+// Writer for Mayo native document file format(see MayoDocReader)
+class MayoDocWriter : public Writer {
+public:
+    bool transfer(Span<const ApplicationItem> appItems, TaskProgress* progress) override;
+    bool writeFile(const QString& filepath, TaskProgress* progress) override;
+
+    static std::unique_ptr<PropertyGroup> createProperties(PropertyGroup* parentGroup);
+    void applyProperties(const PropertyGroup* params) override;
+
+    // Parameters
+    struct Parameters {
+        bool writeTriangulation = true;
+    };
+    Parameters& parameters() { return m_params; }
+    const Parameters& constParameters() const { return m_params; }
+
+private:
+    class Properties;
+    struct Content;
+    std::shared_ptr<Content> m_content;
+    Parameters m_params;
+};
+
+// Provides factory for MayoDocReader objects
+class MayoDocFactoryReader : public FactoryReader {
+public:
+    Span<const Format> formats() const override;
+    std::unique_ptr<Reader> create(const Format& format) const override;
+    std::unique_ptr<PropertyGroup> createProperties(
+            const Format& format,
+            PropertyGroup* parentGroup) const override;
+};
+
+// Provides factory for MayoDocWriter objects
+class MayoDocFactoryWriter : public FactoryWriter {
+public:
+    Span<const Format> formats() const override;
+    std::unique_ptr<Writer> create(const Format& format) const override;
+    std::unique_ptr<PropertyGroup> createProperties(
+            const Format& format,
+            PropertyGroup* parentGroup) const override;
+};
+
+} // namespace IO
+} // namespace Mayo
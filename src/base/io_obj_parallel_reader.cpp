@@ -0,0 +1,567 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "io_obj_parallel_reader.h"
+
+#include <BRep_Builder.hxx>
+#include <Graphic3d_Vec3.hxx>
+#include <Message_ProgressScope.hxx>
+#include <OSD_Parallel.hxx>
+#include <Poly_Triangulation.hxx>
+#include <TShort_HArray1OfShortReal.hxx>
+#include <TopoDS_Compound.hxx>
+#include <TopoDS_Face.hxx>
+#include <QtCore/QFile>
+#include <QtCore/QString>
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace Mayo {
+namespace IO {
+
+namespace {
+
+// Index of a position, texture coordinates and normal, zero-based. -1 if absent
+struct FaceVertex {
+    int position;
+    int uv;
+    int normal;
+};
+
+struct Triangle {
+    FaceVertex vertices[3];
+};
+
+struct UV {
+    float u;
+    float v;
+};
+
+struct Normal {
+    float x;
+    float y;
+    float z;
+};
+
+// Range of contiguous lines of the file
+struct Chunk {
+    struct Group {
+        size_t triangleOffset; // Relative to the first triangle of the chunk
+        std::string name;
+    };
+
+    const char* begin;
+    const char* end;
+    // Counts of records, computed by the first pass
+    size_t positionCount = 0;
+    size_t uvCount = 0;
+    size_t normalCount = 0;
+    size_t triangleCount = 0;
+    std::vector<Group> vecGroup;
+    // Index of the first record of the chunk in the global arrays
+    size_t positionBase = 0;
+    size_t uvBase = 0;
+    size_t normalBase = 0;
+    size_t triangleBase = 0;
+};
+
+enum class RecordType {
+    Other, Position, UV, Normal, Face, Group
+};
+
+bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+const char* skipBlanks(const char* it, const char* end)
+{
+    while (it != end && isBlank(*it))
+        ++it;
+
+    return it;
+}
+
+const char* skipToken(const char* it, const char* end)
+{
+    while (it != end && !isBlank(*it))
+        ++it;
+
+    return it;
+}
+
+// Finds type of the record starting at 'it', which is advanced after the record keyword
+RecordType recordType(const char*& it, const char* end)
+{
+    it = skipBlanks(it, end);
+    const char* itKeywordEnd = skipToken(it, end);
+    const size_t keywordLen = itKeywordEnd - it;
+    RecordType type = RecordType::Other;
+    if (keywordLen == 1) {
+        switch (*it) {
+        case 'v': type = RecordType::Position; break;
+        case 'f': type = RecordType::Face; break;
+        case 'g':
+        case 'o': type = RecordType::Group; break;
+        }
+    }
+    else if (keywordLen == 2 && it[0] == 'v') {
+        if (it[1] == 't')
+            type = RecordType::UV;
+        else if (it[1] == 'n')
+            type = RecordType::Normal;
+    }
+
+    it = itKeywordEnd;
+    return type;
+}
+
+const char* findLineEnd(const char* it, const char* end)
+{
+    auto itFound = static_cast<const char*>(std::memchr(it, '\n', end - it));
+    return itFound ? itFound : end;
+}
+
+bool parseReal(const char*& it, const char* end, double* value)
+{
+    it = skipBlanks(it, end);
+    if (it != end && *it == '+')
+        ++it;
+
+#if __cpp_lib_to_chars >= 201611L
+    const std::from_chars_result res = std::from_chars(it, end, *value);
+    if (res.ec != std::errc())
+        return false;
+
+    it = res.ptr;
+    return true;
+#else
+    // Locale independent fallback
+    const char* itStart = it;
+    const bool isNegative = it != end && *it == '-';
+    if (isNegative)
+        ++it;
+
+    double mantissa = 0.;
+    int exponent = 0;
+    for (; it != end && *it >= '0' && *it <= '9'; ++it)
+        mantissa = mantissa * 10. + (*it - '0');
+
+    if (it != end && *it == '.') {
+        for (++it; it != end && *it >= '0' && *it <= '9'; ++it) {
+            mantissa = mantissa * 10. + (*it - '0');
+            --exponent;
+        }
+    }
+
+    if (it == itStart || (isNegative && it == itStart + 1))
+        return false;
+
+    if (it != end && (*it == 'e' || *it == 'E')) {
+        ++it;
+        const bool isExpNegative = it != end && *it == '-';
+        if (it != end && (*it == '-' || *it == '+'))
+            ++it;
+
+        int expValue = 0;
+        for (; it != end && *it >= '0' && *it <= '9'; ++it)
+            expValue = expValue * 10 + (*it - '0');
+
+        exponent += isExpNegative ? -expValue : expValue;
+    }
+
+    *value = (isNegative ? -mantissa : mantissa) * std::pow(10., exponent);
+    return true;
+#endif
+}
+
+// Parses OBJ index(1-based, or negative relative to 'currentCount') into zero-based index
+bool parseIndex(const char*& it, const char* end, size_t currentCount, int* index)
+{
+    int value = 0;
+    const std::from_chars_result res = std::from_chars(it, end, value);
+    if (res.ec != std::errc() || value == 0)
+        return false;
+
+    it = res.ptr;
+    *index = value > 0 ? value - 1 : int(currentCount) + value;
+    return *index >= 0;
+}
+
+// Parses face vertex "p", "p/t", "p//n" or "p/t/n"
+bool parseFaceVertex(const char*& it, const char* end, const size_t (&counts)[3], FaceVertex* vertex)
+{
+    *vertex = { -1, -1, -1 };
+    if (!parseIndex(it, end, counts[0], &vertex->position))
+        return false;
+
+    if (it != end && *it == '/') {
+        ++it;
+        if (it != end && *it != '/' && !parseIndex(it, end, counts[1], &vertex->uv))
+            return false;
+
+        if (it != end && *it == '/') {
+            ++it;
+            if (!parseIndex(it, end, counts[2], &vertex->normal))
+                return false;
+        }
+    }
+
+    return it == end || isBlank(*it);
+}
+
+void scanChunk(Chunk* chunk)
+{
+    const char* it = chunk->begin;
+    while (it != chunk->end) {
+        const char* itLineEnd = findLineEnd(it, chunk->end);
+        switch (recordType(it, itLineEnd)) {
+        case RecordType::Position: ++chunk->positionCount; break;
+        case RecordType::UV: ++chunk->uvCount; break;
+        case RecordType::Normal: ++chunk->normalCount; break;
+        case RecordType::Face: {
+            int vertexCount = 0;
+            for (it = skipBlanks(it, itLineEnd); it != itLineEnd; it = skipBlanks(skipToken(it, itLineEnd), itLineEnd))
+                ++vertexCount;
+
+            chunk->triangleCount += std::max(vertexCount - 2, 0);
+            break;
+        }
+        case RecordType::Group: {
+            const char* itNameBegin = skipBlanks(it, itLineEnd);
+            const char* itNameEnd = itLineEnd;
+            while (itNameEnd != itNameBegin && isBlank(*(itNameEnd - 1)))
+                --itNameEnd;
+
+            chunk->vecGroup.push_back({ chunk->triangleCount, std::string(itNameBegin, itNameEnd) });
+            break;
+        }
+        case RecordType::Other:
+            break;
+        }
+
+        it = itLineEnd != chunk->end ? itLineEnd + 1 : itLineEnd;
+    }
+}
+
+struct ParseOutput {
+    std::vector<gp_XYZ> vecPosition;
+    std::vector<UV> vecUV;
+    std::vector<Normal> vecNormal;
+    std::vector<Triangle> vecTriangle;
+};
+
+// Parses records of 'chunk' into 'output' arrays, at the chunk base indices
+// Count of records written must be the same as the ones found by scanChunk()
+bool parseChunk(const Chunk& chunk, ParseOutput* output)
+{
+    size_t counts[3] = { chunk.positionBase, chunk.uvBase, chunk.normalBase };
+    size_t triangleIndex = chunk.triangleBase;
+    bool ok = true;
+    const char* it = chunk.begin;
+    while (it != chunk.end) {
+        const char* itLineEnd = findLineEnd(it, chunk.end);
+        switch (recordType(it, itLineEnd)) {
+        case RecordType::Position: {
+            double coords[3] = {};
+            for (double& coord : coords)
+                ok = parseReal(it, itLineEnd, &coord) && ok;
+
+            output->vecPosition[counts[0]++].SetCoord(coords[0], coords[1], coords[2]);
+            break;
+        }
+        case RecordType::UV: {
+            double coords[2] = {};
+            for (double& coord : coords)
+                ok = parseReal(it, itLineEnd, &coord) && ok;
+
+            output->vecUV[counts[1]++] = { float(coords[0]), float(coords[1]) };
+            break;
+        }
+        case RecordType::Normal: {
+            double coords[3] = {};
+            for (double& coord : coords)
+                ok = parseReal(it, itLineEnd, &coord) && ok;
+
+            output->vecNormal[counts[2]++] = { float(coords[0]), float(coords[1]), float(coords[2]) };
+            break;
+        }
+        case RecordType::Face: {
+            // Polygons are triangulated as fans
+            FaceVertex vertexFirst = {};
+            FaceVertex vertexPrev = {};
+            int vertexCount = 0;
+            for (it = skipBlanks(it, itLineEnd); it != itLineEnd; it = skipBlanks(it, itLineEnd)) {
+                FaceVertex vertex;
+                if (!parseFaceVertex(it, itLineEnd, counts, &vertex)) {
+                    ok = false;
+                    it = skipToken(it, itLineEnd);
+                }
+
+                if (vertexCount == 0)
+                    vertexFirst = vertex;
+                else if (vertexCount >= 2)
+                    output->vecTriangle[triangleIndex++] = { { vertexFirst, vertexPrev, vertex } };
+
+                vertexPrev = vertex;
+                ++vertexCount;
+            }
+
+            break;
+        }
+        case RecordType::Group:
+        case RecordType::Other:
+            break;
+        }
+
+        it = itLineEnd != chunk.end ? itLineEnd + 1 : itLineEnd;
+    }
+
+    return ok;
+}
+
+bool isValid(const FaceVertex& vertex, const ParseOutput& output)
+{
+    return size_t(vertex.position) < output.vecPosition.size()
+            && (vertex.uv < 0 || size_t(vertex.uv) < output.vecUV.size())
+            && (vertex.normal < 0 || size_t(vertex.normal) < output.vecNormal.size());
+}
+
+} // namespace
+
+Standard_Boolean ObjParallelCafReader::performMesh(
+        const TCollection_AsciiString& filepath,
+        const Message_ProgressRange& progress,
+        const Standard_Boolean onlyHeader)
+{
+    Message_ProgressScope progressScope(progress, "Reading OBJ file", 4);
+    QFile file(QString::fromUtf8(filepath.ToCString()));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    const qint64 fileSize = file.size();
+    const uchar* fileData = fileSize > 0 ? file.map(0, fileSize) : nullptr;
+    if (!fileData)
+        return false;
+
+    // Split file in chunks ending at line boundaries
+    const char* const dataBegin = reinterpret_cast<const char*>(fileData);
+    const char* const dataEnd = dataBegin + fileSize;
+    constexpr qint64 minChunkSize = 1024 * 1024;
+    const int chunkCount = int(std::clamp<qint64>(
+                fileSize / minChunkSize, 1, 4 * OSD_Parallel::NbLogicalProcessors()));
+    std::vector<Chunk> vecChunk;
+    const char* itChunkBegin = dataBegin;
+    for (int i = 1; i <= chunkCount && itChunkBegin != dataEnd; ++i) {
+        const char* itChunkEnd = i < chunkCount ? dataBegin + (fileSize * i) / chunkCount : dataEnd;
+        if (itChunkEnd < itChunkBegin)
+            itChunkEnd = itChunkBegin;
+
+        itChunkEnd = findLineEnd(itChunkEnd, dataEnd);
+        if (itChunkEnd != dataEnd)
+            ++itChunkEnd;
+
+        Chunk chunk;
+        chunk.begin = itChunkBegin;
+        chunk.end = itChunkEnd;
+        vecChunk.push_back(std::move(chunk));
+        itChunkBegin = itChunkEnd;
+    }
+
+    // First pass: count records
+    OSD_Parallel::For(0, int(vecChunk.size()), [&](int i) {
+        if (!progressScope.UserBreak())
+            scanChunk(&vecChunk.at(i));
+    });
+    if (!progressScope.More())
+        return false;
+
+    progressScope.Next();
+    ParseOutput output;
+    size_t positionCount = 0;
+    size_t uvCount = 0;
+    size_t normalCount = 0;
+    size_t triangleCount = 0;
+    for (Chunk& chunk : vecChunk) {
+        chunk.positionBase = positionCount;
+        chunk.uvBase = uvCount;
+        chunk.normalBase = normalCount;
+        chunk.triangleBase = triangleCount;
+        positionCount += chunk.positionCount;
+        uvCount += chunk.uvCount;
+        normalCount += chunk.normalCount;
+        triangleCount += chunk.triangleCount;
+    }
+
+    if (onlyHeader)
+        return true;
+
+    // Second pass: parse records into arrays allocated with exact counts
+    output.vecPosition.resize(positionCount);
+    output.vecUV.resize(uvCount);
+    output.vecNormal.resize(normalCount);
+    output.vecTriangle.resize(triangleCount);
+    std::atomic<bool> okParse = true;
+    OSD_Parallel::For(0, int(vecChunk.size()), [&](int i) {
+        if (!progressScope.UserBreak() && !parseChunk(vecChunk.at(i), &output))
+            okParse = false;
+    });
+    if (!okParse || !progressScope.More())
+        return false;
+
+    const bool okIndices = std::all_of(
+                output.vecTriangle.cbegin(), output.vecTriangle.cend(), [&](const Triangle& tri) {
+        return isValid(tri.vertices[0], output)
+                && isValid(tri.vertices[1], output)
+                && isValid(tri.vertices[2], output);
+    });
+    if (!okIndices)
+        return false;
+
+    progressScope.Next();
+
+    // Triangle ranges of the groups
+    struct Group {
+        size_t triangleBegin;
+        size_t triangleEnd;
+        std::string name;
+    };
+    std::vector<Group> vecGroup;
+    vecGroup.push_back({ 0, 0, {} });
+    for (const Chunk& chunk : vecChunk) {
+        for (const Chunk::Group& chunkGroup : chunk.vecGroup) {
+            const size_t triangleOffset = chunk.triangleBase + chunkGroup.triangleOffset;
+            vecGroup.back().triangleEnd = triangleOffset;
+            vecGroup.push_back({ triangleOffset, 0, chunkGroup.name });
+        }
+    }
+
+    vecGroup.back().triangleEnd = triangleCount;
+    vecGroup.erase(std::remove_if(vecGroup.begin(), vecGroup.end(), [](const Group& group) {
+        return group.triangleBegin == group.triangleEnd;
+    }), vecGroup.end());
+
+    // Stitch the triangles of each group into a triangulation with local node indices
+    // A node is a distinct (position, uv, normal) tuple of the face records, so a position shared by
+    // faces with different normals(eg hard edge) or UVs(eg texture seam) gives many nodes
+    // Nodes of the same position are chained from the last one created, chains are short in practice
+    std::vector<int> vecPositionNode(positionCount, -1);
+    std::vector<int> vecNodePosition;
+    std::vector<int> vecNodeUV;
+    std::vector<int> vecNodeNormal;
+    std::vector<int> vecNodeNext; // Next node with the same position, -1 if none
+    std::vector<int> vecTriangleNode; // 3 nodes per triangle
+    const bool hasUVs = uvCount > 0;
+    const bool hasNormals = normalCount > 0;
+    std::vector<TopoDS_Face> vecFace;
+    BRep_Builder builder;
+    Message_ProgressScope groupProgressScope(progressScope.Next(), "Building triangulations", double(vecGroup.size()));
+    for (const Group& group : vecGroup) {
+        vecNodePosition.clear();
+        vecNodeUV.clear();
+        vecNodeNormal.clear();
+        vecNodeNext.clear();
+        vecTriangleNode.clear();
+        for (size_t i = group.triangleBegin; i < group.triangleEnd; ++i) {
+            for (const FaceVertex& vertex : output.vecTriangle.at(i).vertices) {
+                int node = vecPositionNode[vertex.position];
+                while (node >= 0 && (vecNodeUV[node] != vertex.uv || vecNodeNormal[node] != vertex.normal))
+                    node = vecNodeNext[node];
+
+                if (node < 0) {
+                    node = int(vecNodePosition.size());
+                    vecNodeNext.push_back(vecPositionNode[vertex.position]);
+                    vecPositionNode[vertex.position] = node;
+                    vecNodePosition.push_back(vertex.position);
+                    vecNodeUV.push_back(vertex.uv);
+                    vecNodeNormal.push_back(vertex.normal);
+                }
+
+                vecTriangleNode.push_back(node);
+            }
+        }
+
+        const int nodeCount = int(vecNodePosition.size());
+        const int groupTriangleCount = int(group.triangleEnd - group.triangleBegin);
+        Handle_Poly_Triangulation triangulation = new Poly_Triangulation(nodeCount, groupTriangleCount, hasUVs);
+        Handle_TShort_HArray1OfShortReal normals;
+        if (hasNormals)
+            normals = new TShort_HArray1OfShortReal(1, 3 * nodeCount);
+
+        OSD_Parallel::For(0, nodeCount, [&](int iNode) {
+            gp_XYZ coords = output.vecPosition[vecNodePosition[iNode]];
+            myCoordSysConverter.TransformPosition(coords);
+            triangulation->ChangeNode(iNode + 1).SetXYZ(coords);
+            if (hasUVs) {
+                const int iUV = vecNodeUV[iNode];
+                const UV uv = iUV >= 0 ? output.vecUV[iUV] : UV{};
+                triangulation->ChangeUVNode(iNode + 1).SetCoord(uv.u, uv.v);
+            }
+
+            if (hasNormals) {
+                const int iNormal = vecNodeNormal[iNode];
+                Graphic3d_Vec3 normal;
+                if (iNormal >= 0) {
+                    const Normal& n = output.vecNormal[iNormal];
+                    normal.SetValues(n.x, n.y, n.z);
+                    myCoordSysConverter.TransformNormal(normal);
+                }
+
+                normals->SetValue(3 * iNode + 1, normal.x());
+                normals->SetValue(3 * iNode + 2, normal.y());
+                normals->SetValue(3 * iNode + 3, normal.z());
+            }
+        });
+        OSD_Parallel::For(0, groupTriangleCount, [&](int iTri) {
+            triangulation->ChangeTriangle(iTri + 1).Set(
+                        vecTriangleNode[3 * iTri] + 1,
+                        vecTriangleNode[3 * iTri + 1] + 1,
+                        vecTriangleNode[3 * iTri + 2] + 1);
+        });
+        if (!normals.IsNull())
+            triangulation->SetNormals(normals);
+
+        // Reset for next group
+        for (int position : vecNodePosition)
+            vecPositionNode[position] = -1;
+
+        TopoDS_Face face;
+        builder.MakeFace(face, triangulation);
+        if (!group.name.empty()) {
+            RWMesh_NodeAttributes attribs;
+            attribs.Name = group.name.c_str();
+            myAttribMap.Bind(face, attribs);
+        }
+
+        vecFace.push_back(face);
+        groupProgressScope.Next();
+        if (groupProgressScope.UserBreak())
+            return false;
+    }
+
+    if (vecFace.size() == 1) {
+        myRootShapes.Append(vecFace.front());
+    }
+    else if (vecFace.size() > 1) {
+        TopoDS_Compound comp;
+        builder.MakeCompound(comp);
+        for (const TopoDS_Face& face : vecFace)
+            builder.Add(comp, face);
+
+        myRootShapes.Append(comp);
+    }
+
+    return true;
+}
+
+} // namespace IO
+} // namespace Mayo
@@ -0,0 +1,31 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include <RWMesh_CafReader.hxx>
+
+namespace Mayo {
+namespace IO {
+
+// Multi-threaded reader for Wavefront OBJ format, alternative to OpenCascade RWObj_CafReader
+//
+// File is memory-mapped and split into chunks at line boundaries. Chunks are first scanned in
+// parallel to count the records, then parsed in parallel into arrays allocated once with the
+// exact counts. Each group('g' or 'o' record) gives a face holding a Poly_Triangulation
+// A node is created per position referenced by a group, texture coordinates and normals are the
+// ones of the first face vertex referencing this position. Materials are ignored
+class ObjParallelCafReader : public RWMesh_CafReader {
+    DEFINE_STANDARD_RTTI_INLINE(ObjParallelCafReader, RWMesh_CafReader)
+protected:
+    Standard_Boolean performMesh(
+            const TCollection_AsciiString& filepath,
+            const Message_ProgressRange& progress,
+            const Standard_Boolean onlyHeader) override;
+};
+
+} // namespace IO
+} // namespace Mayo
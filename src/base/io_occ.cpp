@@ -127,6 +127,7 @@ inline static const auto occFactoryReaderData = FactoryData<Reader>()
         .addExchanger<OccStepReader>(Format_STEP)
         .addExchanger<OccIgesReader>(Format_IGES)
         .addExchanger<OccBRepReader>(Format_OCCBREP)
+        .addExchanger<OccBinaryBRepReader>(Format_OCCBREP_BIN)
         #if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
         .addExchanger<OccGltfReader>(Format_GLTF)
         .addExchanger<OccObjReader>(Format_OBJ)
@@ -137,6 +138,7 @@ inline static const auto occFactoryWriterData = FactoryData<Writer>()
         .addExchanger<OccStepWriter>(Format_STEP)
         .addExchanger<OccIgesWriter>(Format_IGES)
         .addExchanger<OccBRepWriter>(Format_OCCBREP)
+        .addExchanger<OccBinaryBRepWriter>(Format_OCCBREP_BIN)
         #if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
         .addExchanger<OccGltfWriter>(Format_GLTF)
         #endif
@@ -145,6 +147,13 @@ inline static const auto occFactoryWriterData = FactoryData<Writer>()
 
 } // namespace
 
+OccFactoryReader::OccFactoryReader()
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
+    OccGltfReader::registerMappedFileSystem();
+#endif
+}
+
 Span<const Format> OccFactoryReader::formats() const
 {
     return occFactoryReaderData.formats();
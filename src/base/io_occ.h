@@ -14,8 +14,12 @@ namespace Mayo {
 namespace IO {
 
 // Provides factory for OpenCascade-based Reader objects
+// Construction registers global OpenCascade objects needed by readers(eg file systems), so the
+// factory has to be created at startup, before any IO task
 class OccFactoryReader : public FactoryReader {
 public:
+    OccFactoryReader();
+
     Span<const Format> formats() const override;
     std::unique_ptr<Reader> create(const Format& format) const override;
     std::unique_ptr<PropertyGroup> createProperties(
@@ -78,10 +78,10 @@ bool OccBaseMeshReader::readFile(const QString& filepath, TaskProgress* progress
 bool OccBaseMeshReader::transfer(DocumentPtr doc, TaskProgress* progress)
 {
     this->applyParameters();
-    m_reader.SetDocument(doc);
+    m_reader->SetDocument(doc);
     Handle_Message_ProgressIndicator indicator = new OccProgressIndicator(progress);
     XCafScopeImport import(doc);
-    const bool okPerform = m_reader.Perform(
+    const bool okPerform = m_reader->Perform(
                 occ::QtUtils::toOccUtf8String(m_filepath), TKernelUtils::start(indicator));
     import.setConfirmation(okPerform && !TaskProgress::isAbortRequested(progress));
     return okPerform;
@@ -99,15 +99,15 @@ void OccBaseMeshReader::applyProperties(const PropertyGroup* params)
 }
 
 OccBaseMeshReader::OccBaseMeshReader(RWMesh_CafReader& reader)
-    : m_reader(reader)
+    : m_reader(&reader)
 {
 }
 
 void OccBaseMeshReader::applyParameters()
 {
-    m_reader.SetRootPrefix(occ::QtUtils::toOccUtf8String(this->constParameters().rootPrefix));
-    m_reader.SetSystemLengthUnit(OccBaseMeshReaderProperties::lengthUnitFactor(this->constParameters().systemLengthUnit));
-    m_reader.SetSystemCoordinateSystem(this->constParameters().systemCoordinatesConverter);
+    m_reader->SetRootPrefix(occ::QtUtils::toOccUtf8String(this->constParameters().rootPrefix));
+    m_reader->SetSystemLengthUnit(OccBaseMeshReaderProperties::lengthUnitFactor(this->constParameters().systemLengthUnit));
+    m_reader->SetSystemCoordinateSystem(this->constParameters().systemCoordinatesConverter);
 }
 
 } // namespace IO
@@ -40,9 +40,14 @@ protected:
     OccBaseMeshReader(RWMesh_CafReader& reader);
     virtual void applyParameters();
 
+    const QString& filepath() const { return m_filepath; }
+
+    // Replaces the reader used to perform transfer, eg from applyParameters()
+    void setReader(RWMesh_CafReader& reader) { m_reader = &reader; }
+
 private:
     QString m_filepath;
-    RWMesh_CafReader& m_reader;
+    RWMesh_CafReader* m_reader = nullptr;
 };
 
 // Common properties for OccBaseMeshReader
@@ -10,17 +10,40 @@
 #include "caf_utils.h"
 #include "document.h"
 #include "occ_progress_indicator.h"
+#include "property_builtins.h"
 #include "scope_import.h"
 #include "task_progress.h"
 #include "tkernel_utils.h"
 
 #include <QtCore/QFileInfo>
+#include <BinTools.hxx>
 #include <BRep_Builder.hxx>
+#include <BRepBuilderAPI_Copy.hxx>
 #include <BRepTools.hxx>
 
 namespace Mayo {
 namespace IO {
 
+class OccBinaryBRepWriter::Properties : public PropertyGroup {
+    MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::IO::OccBinaryBRepWriter_Properties)
+public:
+    Properties(PropertyGroup* parentGroup)
+        : PropertyGroup(parentGroup),
+          writeTriangulation(this, textId("writeTriangulation"))
+    {
+        this->writeTriangulation.setDescription(
+                    textIdTr("Store the triangulations of faces along with the exact geometry, "
+                             "so meshing isn't needed again when the file is read back"));
+    }
+
+    void restoreDefaults() override {
+        const OccBinaryBRepWriter::Parameters params;
+        this->writeTriangulation.setValue(params.writeTriangulation);
+    }
+
+    PropertyBool writeTriangulation;
+};
+
 bool OccBRepReader::readFile(const QString& filepath, TaskProgress* progress)
 {
     m_shape.Nullify();
@@ -34,6 +57,20 @@ bool OccBRepReader::readFile(const QString& filepath, TaskProgress* progress)
                 TKernelUtils::start(indicator));
 }
 
+bool OccBinaryBRepReader::readFile(const QString& filepath, TaskProgress* progress)
+{
+    m_shape.Nullify();
+    m_baseFilename = QFileInfo(filepath).baseName();
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+    Handle_Message_ProgressIndicator indicator = new OccProgressIndicator(progress);
+    return BinTools::Read(m_shape, filepath.toUtf8().constData(), TKernelUtils::start(indicator));
+#else
+    const bool ok = BinTools::Read(m_shape, filepath.toUtf8().constData());
+    progress->setValue(100);
+    return ok;
+#endif
+}
+
 bool OccBRepReader::transfer(DocumentPtr doc, TaskProgress* progress)
 {
     if (m_shape.IsNull())
@@ -88,5 +125,50 @@ bool OccBRepWriter::writeFile(const QString& filepath, TaskProgress* progress)
     return BRepTools::Write(m_shape, filepath.toUtf8().constData(), TKernelUtils::start(indicator));
 }
 
+bool OccBinaryBRepWriter::writeFile(const QString& filepath, TaskProgress* progress)
+{
+    const QByteArray strFilepath = filepath.toUtf8();
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    Handle_Message_ProgressIndicator indicator = new OccProgressIndicator(progress);
+    constexpr bool withNormals = false;
+    return BinTools::Write(
+                m_shape,
+                strFilepath.constData(),
+                m_params.writeTriangulation,
+                withNormals,
+                BinTools_FormatVersion_CURRENT,
+                TKernelUtils::start(indicator));
+#else
+    // BinTools always writes triangulations, so they have to be removed from a copy of the shape
+    TopoDS_Shape shape = m_shape;
+    if (!m_params.writeTriangulation && !shape.IsNull()) {
+        constexpr bool copyGeom = true;
+        constexpr bool copyMesh = false;
+        shape = BRepBuilderAPI_Copy(m_shape, copyGeom, copyMesh).Shape();
+    }
+
+#  if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+    Handle_Message_ProgressIndicator indicator = new OccProgressIndicator(progress);
+    return BinTools::Write(shape, strFilepath.constData(), TKernelUtils::start(indicator));
+#  else
+    const bool ok = BinTools::Write(shape, strFilepath.constData());
+    progress->setValue(100);
+    return ok;
+#  endif
+#endif
+}
+
+std::unique_ptr<PropertyGroup> OccBinaryBRepWriter::createProperties(PropertyGroup* parentGroup)
+{
+    return std::make_unique<Properties>(parentGroup);
+}
+
+void OccBinaryBRepWriter::applyProperties(const PropertyGroup* params)
+{
+    auto ptr = dynamic_cast<const Properties*>(params);
+    if (ptr)
+        m_params.writeTriangulation = ptr->writeTriangulation.value();
+}
+
 } // namespace IO
 } // namespace Mayo
@@ -20,20 +20,47 @@ public:
     bool readFile(const QString& filepath, TaskProgress* progress) override;
     bool transfer(DocumentPtr doc, TaskProgress* progress) override;
 
-private:
+protected:
     TopoDS_Shape m_shape;
     QString m_baseFilename;
 };
 
+// Reader for OpenCascade binary BRep file format(see BinTools)
+class OccBinaryBRepReader : public OccBRepReader {
+public:
+    bool readFile(const QString& filepath, TaskProgress* progress) override;
+};
+
 // Writer for OpenCascade BRep file format
 class OccBRepWriter : public Writer {
 public:
     bool transfer(Span<const ApplicationItem> appItems, TaskProgress* progress) override;
     bool writeFile(const QString& filepath, TaskProgress* progress) override;
 
-private:
+protected:
     TopoDS_Shape m_shape;
 };
 
+// Writer for OpenCascade binary BRep file format(see BinTools)
+// Much faster to write and read back than ASCII BRep, and files are smaller
+class OccBinaryBRepWriter : public OccBRepWriter {
+public:
+    bool writeFile(const QString& filepath, TaskProgress* progress) override;
+
+    static std::unique_ptr<PropertyGroup> createProperties(PropertyGroup* parentGroup);
+    void applyProperties(const PropertyGroup* params) override;
+
+    // Parameters
+    struct Parameters {
+        bool writeTriangulation = true;
+    };
+    Parameters& parameters() { return m_params; }
+    const Parameters& constParameters() const { return m_params; }
+
+private:
+    class Properties;
+    Parameters m_params;
+};
+
 } // namespace IO
 } // namespace Mayo
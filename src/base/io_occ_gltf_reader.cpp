@@ -5,33 +5,69 @@
 ****************************************************************************/
 
 #include "io_occ_gltf_reader.h"
+#include "occ_mapped_file_system.h"
 #include "property_builtins.h"
+#include <gsl/gsl_util>
 
 namespace Mayo {
 namespace IO {
 
+namespace {
+
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+Handle_OccMappedFileSystem& globalMappedFileSystem()
+{
+    static Handle_OccMappedFileSystem fileSystem;
+    return fileSystem;
+}
+#endif
+
+} // namespace
+
 class OccGltfReader::Properties : public OccBaseMeshReaderProperties {
     MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::IO::OccGltfReader_Properties)
 public:
     Properties(PropertyGroup* parentGroup)
         : OccBaseMeshReaderProperties(parentGroup),
           skipEmptyNodes(this, textId("skipEmptyNodes")),
-          useMeshNameAsFallback(this, textId("useMeshNameAsFallback"))
+          useMeshNameAsFallback(this, textId("useMeshNameAsFallback")),
+          parallelDecoding(this, textId("parallelDecoding")),
+          useMemoryMapping(this, textId("useMemoryMapping")),
+          deferTriangulationLoading(this, textId("deferTriangulationLoading"))
     {
        this->skipEmptyNodes.setDescription(
                     textIdTr("Ignore nodes without geometry(`Yes` by default)"));
         this->useMeshNameAsFallback.setDescription(
                     textIdTr("Use mesh name in case if node name is empty(`Yes` by default)"));
+        this->parallelDecoding.setDescription(
+                    textIdTr("Decode mesh primitives with multiple threads(`Yes` by default)"));
+        this->useMemoryMapping.setDescription(
+                    textIdTr("Read binary buffers through a memory mapping of the file instead of "
+                             "copying them(`Yes` by default)"));
+        this->deferTriangulationLoading.setDescription(
+                    textIdTr("Load triangulation data of an entity only when it's displayed for "
+                             "the first time(`No` by default)"));
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 6, 0)
+        this->useMemoryMapping.setUserVisible(false);
+        this->deferTriangulationLoading.setUserVisible(false);
+#endif
     }
 
     void restoreDefaults() override {
         OccBaseMeshReaderProperties::restoreDefaults();
-        this->skipEmptyNodes.setValue(true);
-        this->useMeshNameAsFallback.setValue(true);
+        const OccGltfReader::Parameters defaults;
+        this->skipEmptyNodes.setValue(defaults.skipEmptyNodes);
+        this->useMeshNameAsFallback.setValue(defaults.useMeshNameAsFallback);
+        this->parallelDecoding.setValue(defaults.parallelDecoding);
+        this->useMemoryMapping.setValue(defaults.useMemoryMapping);
+        this->deferTriangulationLoading.setValue(defaults.deferTriangulationLoading);
     }
 
     PropertyBool skipEmptyNodes;
     PropertyBool useMeshNameAsFallback;
+    PropertyBool parallelDecoding;
+    PropertyBool useMemoryMapping;
+    PropertyBool deferTriangulationLoading;
 };
 
 OccGltfReader::OccGltfReader()
@@ -39,6 +75,39 @@ OccGltfReader::OccGltfReader()
 {
 }
 
+bool OccGltfReader::transfer(DocumentPtr doc, TaskProgress* progress)
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    // RWGltf_CafReader opens buffers with the default file system, the mapped one supports the
+    // file being read only for the time of the transfer
+    const QString filepath = this->filepath();
+    Handle_OccMappedFileSystem fileSystem;
+    if (m_params.useMemoryMapping) {
+        fileSystem = globalMappedFileSystem();
+        if (!fileSystem.IsNull())
+            fileSystem->addFile(filepath);
+    }
+
+    auto _ = gsl::finally([=]{
+        if (!fileSystem.IsNull())
+            fileSystem->removeFile(filepath);
+    });
+#endif
+
+    return OccBaseMeshReader::transfer(doc, progress);
+}
+
+void OccGltfReader::registerMappedFileSystem()
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    Handle_OccMappedFileSystem& fileSystem = globalMappedFileSystem();
+    if (fileSystem.IsNull()) {
+        fileSystem = new OccMappedFileSystem(OccMappedFileSystem::FileScope::AddedFiles);
+        OSD_FileSystem::AddDefaultProtocol(fileSystem, true/*preferred*/);
+    }
+#endif
+}
+
 std::unique_ptr<PropertyGroup> OccGltfReader::createProperties(PropertyGroup* parentGroup)
 {
     return std::make_unique<Properties>(parentGroup);
@@ -51,6 +120,9 @@ void OccGltfReader::applyProperties(const PropertyGroup* params)
     if (ptr) {
         m_params.useMeshNameAsFallback = ptr->useMeshNameAsFallback.value();
         m_params.skipEmptyNodes = ptr->skipEmptyNodes.value();
+        m_params.parallelDecoding = ptr->parallelDecoding.value();
+        m_params.useMemoryMapping = ptr->useMemoryMapping.value();
+        m_params.deferTriangulationLoading = ptr->deferTriangulationLoading.value();
     }
 }
 
@@ -59,6 +131,12 @@ void OccGltfReader::applyParameters()
     OccBaseMeshReader::applyParameters();
     m_reader.SetSkipEmptyNodes(m_params.skipEmptyNodes);
     m_reader.SetMeshNameAsFallback(m_params.useMeshNameAsFallback);
+    m_reader.SetParallel(m_params.parallelDecoding);
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    // Deferred triangulations keep a reference to their data in the file, which is loaded with
+    // Poly_Triangulation::LoadDeferredData()
+    m_reader.SetToSkipLateDataLoading(m_params.deferTriangulationLoading);
+#endif
 }
 
 } // namespace IO
@@ -18,14 +18,32 @@ class OccGltfReader : public OccBaseMeshReader {
 public:
     OccGltfReader();
 
+    bool transfer(DocumentPtr doc, TaskProgress* progress) override;
+
     static std::unique_ptr<PropertyGroup> createProperties(PropertyGroup* parentGroup);
     void applyProperties(const PropertyGroup* params) override;
 
+    // Registers the file system used to read buffers through a memory mapping(see
+    // Parameters::useMemoryMapping) as a preferred OpenCascade default protocol
+    // This isn't thread-safe, so it has to be done once at startup(see OccFactoryReader), before
+    // any IO task. Memory mapping isn't used when not registered
+    // Requires OpenCascade >= v7.6.0, does nothing otherwise
+    static void registerMappedFileSystem();
+
     // Parameters
 
     struct Parameters : public OccBaseMeshReader::Parameters {
         bool skipEmptyNodes = true;
         bool useMeshNameAsFallback = true;
+        // Mesh primitives are decoded by several threads
+        bool parallelDecoding = true;
+        // Buffers(eg binary chunk of .glb files) are read through a memory mapping of the file
+        // Requires OpenCascade >= v7.6.0
+        bool useMemoryMapping = true;
+        // Triangulation data isn't loaded while reading, but when the owning entity is displayed
+        // for the first time(see GuiDocument)
+        // Requires OpenCascade >= v7.6.0
+        bool deferTriangulationLoading = false;
     };
     OccGltfReader::Parameters& parameters() override { return m_params; }
     const OccGltfReader::Parameters& constParameters() const override { return m_params; }
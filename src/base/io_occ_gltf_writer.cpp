@@ -7,6 +7,7 @@
 #include "io_occ_gltf_writer.h"
 
 #include "application_item.h"
+#include "io_gltf_parallel_writer.h"
 #include "io_occ_common.h"
 #include "occ_progress_indicator.h"
 #include "property_builtins.h"
@@ -28,7 +29,9 @@ public:
           coordinatesConverter(this, textId("coordinatesConverter"), &OccCommon::enumMeshCoordinateSystem()),
           transformationFormat(this, textId("transformationFormat"), &enumTrsfFormat),
           format(this, textId("format"), &enumFormat),
-          forceExportUV(this, textId("forceExportUV"))
+          forceExportUV(this, textId("forceExportUV")),
+          engine(this, textId("engine"), &enumEngine),
+          quantizeVertexAttributes(this, textId("quantizeVertexAttributes"))
     {
         this->coordinatesConverter.setDescription(
                     textIdTr("Coordinate system transformation from OpenCascade to glTF"));
@@ -36,6 +39,13 @@ public:
                     textIdTr("Preferred transformation format for writing into glTF file"));
         this->forceExportUV.setDescription(
                     textIdTr("Export UV coordinates even if there is no mapped texture"));
+        this->engine.setDescription(
+                    textIdTr("Writer of the glTF file. `Parallel` shares meshes of parts between "
+                             "their instances, encodes buffers with multiple threads and ignores "
+                             "textures"));
+        this->quantizeVertexAttributes.setDescription(
+                    textIdTr("Store vertex positions and normals as 16-bit and 8-bit integers "
+                             "(KHR_mesh_quantization extension), `Parallel` engine only"));
     }
 
     void restoreDefaults() override {
@@ -44,6 +54,8 @@ public:
         this->transformationFormat.setValue(defaults.transformationFormat);
         this->format.setValue(defaults.format);
         this->forceExportUV.setValue(defaults.forceExportUV);
+        this->engine.setValue(int(defaults.engine));
+        this->quantizeVertexAttributes.setValue(defaults.quantizeVertexAttributes);
     }
 
     static inline const Enumeration enumTrsfFormat = {
@@ -57,10 +69,17 @@ public:
 
     static inline const Enumeration enumFormat = Enumeration::fromEnum<OccGltfWriter::Format>(textIdContext());
 
+    static inline const Enumeration enumEngine = {
+        { int(OccGltfWriter::Engine::OpenCascade), textId("OpenCascade"), {} },
+        { int(OccGltfWriter::Engine::Parallel), textId("Parallel"), {} }
+    };
+
     PropertyEnumeration coordinatesConverter;
     PropertyEnumeration transformationFormat;
     PropertyEnumeration format;
     PropertyBool forceExportUV;
+    PropertyEnumeration engine;
+    PropertyBool quantizeVertexAttributes;
 };
 
 bool OccGltfWriter::transfer(Span<const ApplicationItem> spanAppItem, TaskProgress*)
@@ -91,9 +110,23 @@ bool OccGltfWriter::writeFile(const QString& filepath, TaskProgress* progress)
     if (!m_document)
         return false;
 
-    Handle_Message_ProgressIndicator occProgress = new OccProgressIndicator(progress);
     const bool isBinary = m_params.format == Format::Binary;
+    if (m_params.engine == Engine::Parallel) {
+        GltfParallelWriter::Options options;
+        options.binary = isBinary;
+        options.quantize = m_params.quantizeVertexAttributes;
+        options.exportUV = m_params.forceExportUV;
+        options.transformationFormat = m_params.transformationFormat;
+        options.coordinateSystemConverter.SetInputCoordinateSystem(m_params.coordinatesConverter);
+        options.coordinateSystemConverter.SetOutputCoordinateSystem(RWMesh_CoordinateSystem_glTF);
+        return GltfParallelWriter(options).perform(filepath, m_document, m_seqRootLabel, progress);
+    }
+
+    Handle_Message_ProgressIndicator occProgress = new OccProgressIndicator(progress);
     RWGltf_CafWriter writer(occ::QtUtils::toOccUtf8String(filepath), isBinary);
+    writer.ChangeCoordinateSystemConverter().SetInputCoordinateSystem(m_params.coordinatesConverter);
+    writer.SetTransformationFormat(m_params.transformationFormat);
+    writer.SetForcedUVExport(m_params.forceExportUV);
     const TColStd_IndexedDataMapOfStringString fileInfo;
     if (m_seqRootLabel.IsEmpty())
         return writer.Perform(m_document, fileInfo, occProgress->Start());
@@ -114,6 +147,8 @@ void OccGltfWriter::applyProperties(const PropertyGroup* params)
         m_params.forceExportUV = ptr->forceExportUV.value();
         m_params.format = ptr->format.valueAs<Format>();
         m_params.transformationFormat = ptr->transformationFormat.valueAs<RWGltf_WriterTrsfFormat>();
+        m_params.engine = ptr->engine.valueAs<Engine>();
+        m_params.quantizeVertexAttributes = ptr->quantizeVertexAttributes.value();
     }
 }
 
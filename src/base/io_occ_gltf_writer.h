@@ -16,7 +16,8 @@
 namespace Mayo {
 namespace IO {
 
-// OpenCascade-based writer for glTF format
+// Writer for glTF format, either OpenCascade-based(RWGltf_CafWriter) or multi-threaded
+// GltfParallelWriter
 // Requires OpenCascade >= v7.5.0
 class OccGltfWriter : public Writer {
 public:
@@ -30,11 +31,20 @@ public:
 
     enum class Format { Json, Binary };
 
+    enum class Engine {
+        OpenCascade, // RWGltf_CafWriter
+        Parallel // GltfParallelWriter
+    };
+
     struct Parameters {
         RWMesh_CoordinateSystem coordinatesConverter = RWMesh_CoordinateSystem_glTF;
         RWGltf_WriterTrsfFormat transformationFormat = RWGltf_WriterTrsfFormat_Compact;
         Format format = Format::Binary;
         bool forceExportUV = false;
+        Engine engine = Engine::OpenCascade;
+        // Vertex positions and normals stored as integers(KHR_mesh_quantization), `Parallel`
+        // engine only
+        bool quantizeVertexAttributes = true;
     };
     Parameters& parameters() { return m_params; }
     const Parameters& constParameters() const { return m_params; }
@@ -6,6 +6,7 @@
 
 #include "io_occ_obj.h"
 #include "property_builtins.h"
+#include "property_enumeration.h"
 
 namespace Mayo {
 namespace IO {
@@ -16,17 +17,37 @@ public:
     Properties(PropertyGroup* parentGroup)
         : OccBaseMeshReaderProperties(parentGroup),
           singlePrecisionVertexCoords(this, textId("singlePrecisionVertexCoords"))
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+          , engine(this, textId("engine"), &enumEngine)
+#endif
     {
         this->singlePrecisionVertexCoords.setDescription(
                     textId("Single precision flag for reading vertex data(coordinates)").tr());
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+        this->engine.setDescription(
+                    textId("Parser of the OBJ file. `Parallel` is much faster with big files, "
+                           "it ignores materials and 'singlePrecisionVertexCoords' option").tr());
+#endif
     }
 
     void restoreDefaults() override {
+        const OccObjReader::Parameters defaults;
         OccBaseMeshReaderProperties::restoreDefaults();
-        this->singlePrecisionVertexCoords.setValue(false);
+        this->singlePrecisionVertexCoords.setValue(defaults.singlePrecisionVertexCoords);
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+        this->engine.setValue(int(defaults.engine));
+#endif
     }
 
     PropertyBool singlePrecisionVertexCoords;
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+    static inline const Enumeration enumEngine = {
+        { int(OccObjReader::Engine::OpenCascade), textId("OpenCascade"), {} },
+        { int(OccObjReader::Engine::Parallel), textId("Parallel"), {} }
+    };
+
+    PropertyEnumeration engine;
+#endif
 };
 
 OccObjReader::OccObjReader()
@@ -45,11 +66,21 @@ void OccObjReader::applyProperties(const PropertyGroup* params)
     auto ptr = dynamic_cast<const Properties*>(params);
     if (ptr) {
         m_params.singlePrecisionVertexCoords = ptr->singlePrecisionVertexCoords.value();
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+        m_params.engine = ptr->engine.valueAs<Engine>();
+#endif
     }
 }
 
 void OccObjReader::applyParameters()
 {
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+    if (m_params.engine == Engine::Parallel)
+        this->setReader(m_parallelReader);
+    else
+        this->setReader(m_reader);
+#endif
+
     OccBaseMeshReader::applyParameters();
     m_reader.SetSinglePrecision(m_params.singlePrecisionVertexCoords);
 }
@@ -7,13 +7,19 @@
 #pragma once
 
 #include "io_occ_base_mesh.h"
+#include "tkernel_utils.h"
 #include <RWObj_CafReader.hxx>
 
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+#  include "io_obj_parallel_reader.h"
+#endif
+
 namespace Mayo {
 namespace IO {
 
 // OpenCascade-based reader for Wavefront OBJ format
-// Requires OpenCascade >= v7.4.0
+// Parsing is done either by OpenCascade RWObj_CafReader or by the multi-threaded ObjParallelCafReader
+// Requires OpenCascade >= v7.4.0, ObjParallelCafReader requires OpenCascade >= v7.5.0
 class OccObjReader : public OccBaseMeshReader {
 public:
     OccObjReader();
@@ -23,8 +29,18 @@ public:
 
     // Parameters
 
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+    enum class Engine {
+        OpenCascade, // Single-threaded RWObj_CafReader
+        Parallel // ObjParallelCafReader
+    };
+#endif
+
     struct Parameters : public OccBaseMeshReader::Parameters {
         bool singlePrecisionVertexCoords = false;
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+        Engine engine = Engine::OpenCascade;
+#endif
     };
     OccObjReader::Parameters& parameters() override { return m_params; }
     const OccObjReader::Parameters& constParameters() const override { return m_params; }
@@ -36,6 +52,9 @@ private:
     class Properties;
     Parameters m_params;
     RWObj_CafReader m_reader;
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+    ObjParallelCafReader m_parallelReader;
+#endif
 };
 
 } // namespace IO
@@ -6,6 +6,9 @@
 
 #include "io_occ_step.h"
 #include "io_occ_caf.h"
+#include "io_step_parallel_reader.h"
+#include "document.h"
+#include "lazy_shape_loader.h"
 #include "occ_static_variables_rollback.h"
 #include "property_builtins.h"
 #include "property_enumeration.h"
@@ -14,23 +17,146 @@
 #include "enumeration_fromenum.h"
 
 #include <Interface_Static.hxx>
+#include <NCollection_DataMap.hxx>
 #include <STEPCAFControl_Controller.hxx>
+#include <STEPControl_Reader.hxx>
+#include <StepBasic_ProductDefinition.hxx>
+#include <TDF_LabelMapHasher.hxx>
+#include <TopoDS_Iterator.hxx>
+#include <TransferBRep.hxx>
+#include <Transfer_TransientProcess.hxx>
+#include <XSControl_TransferReader.hxx>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 namespace Mayo {
 namespace IO {
 
+namespace {
+
+// Translates on demand the parts imported as empty compounds with "read.step.assembly.level"
+// set to Structure
+// The STEP model is shared with the import session, but transfers are done in a separate session
+// so the results of the structure transfer(empty compounds) don't shadow the part geometries
+class OccStepLazyShapeLoader : public LazyShapeLoader {
+public:
+    OccStepLazyShapeLoader(const DocumentPtr& doc, const Handle_XSControl_WorkSession& importSession)
+        : m_shapeTool(doc->xcaf().shapeTool())
+    {
+        const Handle_Interface_InterfaceModel model = importSession->Model();
+        const Handle_XSControl_WorkSession ws = m_reader.WS();
+        ws->SetModel(model);
+        ws->InitTransferReader(4);
+
+        const Handle_Transfer_TransientProcess tproc = importSession->TransferReader()->TransientProcess();
+        for (int i = 1; i <= model->NbEntities(); ++i) {
+            auto pd = Handle_StepBasic_ProductDefinition::DownCast(model->Value(i));
+            if (pd.IsNull())
+                continue;
+
+            // Parts are empty compounds, assemblies are compounds of located components
+            const TopoDS_Shape shape = TransferBRep::ShapeResult(tproc, pd);
+            if (shape.IsNull() || TopoDS_Iterator(shape).More())
+                continue;
+
+            TDF_Label label;
+            if (m_shapeTool->FindShape(shape, label) && XCaf::isShapeSimple(label))
+                m_mapPendingPart.Bind(label, pd);
+        }
+    }
+
+    bool isPending(const TDF_Label& partLabel) const override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_mapPendingPart.IsBound(partLabel);
+    }
+
+    std::vector<LazyShape> translate(Span<const TDF_Label> spanPartLabel, TaskProgress* progress) override
+    {
+        // Pending parts are taken out of the map, so isPending() isn't blocked by the translation
+        std::vector<std::pair<TDF_Label, Handle_StepBasic_ProductDefinition>> vecPart;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (const TDF_Label& label : spanPartLabel) {
+                Handle_StepBasic_ProductDefinition pd;
+                if (m_mapPendingPart.Find(label, pd)) {
+                    vecPart.emplace_back(label, pd);
+                    m_mapPendingPart.UnBind(label);
+                }
+            }
+        }
+
+        std::vector<LazyShape> vecShape;
+        if (vecPart.empty())
+            return vecShape;
+
+        // OpenCascade STEP translator relies on global state(static variables, unit factors),
+        // so translations can't run concurrently
+        {
+            MayoIO_CafGlobalScopedLock(cafLock);
+            OccStaticVariablesRollback rollback;
+            rollback.change("read.step.assembly.level", int(OccStepReader::AssemblyLevel::Shape));
+            for (const auto& part : vecPart) {
+                if (TaskProgress::isAbortRequested(progress))
+                    break;
+
+                LazyShape lazyShape{ part.first, {} };
+                m_reader.ClearShapes();
+                const bool okTransfer = m_reader.TransferEntity(part.second);
+                if (okTransfer && m_reader.NbShapes() > 0)
+                    lazyShape.shape = m_reader.Shape(m_reader.NbShapes());
+
+                vecShape.push_back(std::move(lazyShape));
+                if (progress)
+                    progress->setValue(int((vecShape.size() * 100) / vecPart.size()));
+            }
+
+            m_reader.ClearShapes();
+        }
+
+        // Aborted, remaining parts are still pending
+        if (vecShape.size() < vecPart.size()) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (size_t i = vecShape.size(); i < vecPart.size(); ++i)
+                m_mapPendingPart.Bind(vecPart.at(i).first, vecPart.at(i).second);
+        }
+
+        return vecShape;
+    }
+
+    void assign(const LazyShape& lazyShape) override
+    {
+        m_shapeTool->SetShape(lazyShape.label, lazyShape.shape);
+    }
+
+private:
+    Handle_XCAFDoc_ShapeTool m_shapeTool;
+    STEPControl_Reader m_reader;
+    NCollection_DataMap<TDF_Label, Handle_StepBasic_ProductDefinition, TDF_LabelMapHasher> m_mapPendingPart;
+    mutable std::mutex m_mutex;
+};
+
+} // namespace
+
 class OccStepReader::Properties : public PropertyGroup {
     MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::IO::OccStepReader_Properties)
 public:
     Properties(PropertyGroup* parentGroup)
         : PropertyGroup(parentGroup),
+          parser(this, textId("parser"), &enumParser),
           productContext(this, textId("productContext"), &enumProductContext),
           assemblyLevel(this, textId("assemblyLevel"), &enumAssemblyLevel),
           preferredShapeRepresentation(this, textId("preferredShapeRepresentation"), &enumShapeRepresentation()),
           readShapeAspect(this, textId("readShapeAspect")),
           readSubShapesNames(this, textId("readSubShapesNames")),
-          encoding(this, textId("encoding"), &enumEncoding())
+          encoding(this, textId("encoding"), &enumEncoding()),
+          loadPartsOnDemand(this, textId("loadPartsOnDemand"))
     {
+        this->parser.setDescription(
+                    textIdTr("Parser of the STEP file. `Parallel` splits the DATA section in chunks "
+                             "tokenized by several threads, which is much faster with big files. "
+                             "OpenCascade parser is used as fallback for files not supported"));
         this->productContext.setDescription(
                     textIdTr("When reading AP 209 STEP files, allows selecting either only `design` "
                              "or `analysis`, or both types of products for translation\n"
@@ -54,17 +180,30 @@ public:
         this->readSubShapesNames.setDescription(
                     textIdTr("Indicates whether to read sub-shape names from 'Name' attributes of "
                              "STEP Representation Items"));
+        this->loadPartsOnDemand.setDescription(
+                    textIdTr("Translate only the assembly structure and names at import, geometry "
+                             "of parts is translated later when they are expanded, selected or "
+                             "exported.\n"
+                             "This speeds up opening of big assemblies and saves memory for the "
+                             "parts never looked at. Colors of parts are not imported"));
     }
 
     void restoreDefaults() override {
         const OccStepReader::Parameters params;
+        this->parser.setValue(params.parser);
         this->productContext.setValue(params.productContext);
         this->assemblyLevel.setValue(params.assemblyLevel);
         this->readShapeAspect.setValue(params.readShapeAspect);
         this->readSubShapesNames.setValue(params.readSubShapesNames);
         this->encoding.setValue(params.encoding);
+        this->loadPartsOnDemand.setValue(params.loadPartsOnDemand);
     }
 
+    inline static const Enumeration enumParser = {
+        { int(Parser::OpenCascade), textId("OpenCascade"), {} },
+        { int(Parser::Parallel), textId("Parallel"), {} }
+    };
+
     inline static const Enumeration enumProductContext = {
         { int(ProductContext::Design), textId("Design"),
           textIdTr("Translate only products that have `PRODUCT_DEFINITION_CONTEXT` with field "
@@ -112,12 +251,14 @@ public:
         return enumObject;
     }
 
+    PropertyEnumeration parser;
     PropertyEnumeration productContext;
     PropertyEnumeration assemblyLevel;
     PropertyEnumeration preferredShapeRepresentation;
     PropertyBool readShapeAspect;
     PropertyBool readSubShapesNames;
     PropertyEnumeration encoding;
+    PropertyBool loadPartsOnDemand;
 };
 
 OccStepReader::OccStepReader()
@@ -137,6 +278,16 @@ bool OccStepReader::readFile(const QString& filepath, TaskProgress* progress)
     MayoIO_CafGlobalScopedLock(cafLock);
     OccStaticVariablesRollback rollback;
     this->changeStaticVariables(&rollback);
+    if (m_params.parser == Parser::Parallel) {
+        const Handle_XSControl_WorkSession ws = Private::cafWorkSession(m_reader);
+        if (StepParallelReader::readFile(filepath, ws, progress))
+            return true;
+
+        // Fallback on OpenCascade parser only for a real parse failure, not when aborted
+        if (TaskProgress::isAbortRequested(progress))
+            return false;
+    }
+
     return Private::cafReadFile(m_reader, filepath, progress);
 }
 
@@ -145,7 +296,13 @@ bool OccStepReader::transfer(DocumentPtr doc, TaskProgress* progress)
     MayoIO_CafGlobalScopedLock(cafLock);
     OccStaticVariablesRollback rollback;
     this->changeStaticVariables(&rollback);
-    return Private::cafTransfer(m_reader, doc, progress);
+    const bool ok = Private::cafTransfer(m_reader, doc, progress);
+    if (ok && this->isLoadPartsOnDemandEnabled()) {
+        const Handle_XSControl_WorkSession ws = Private::cafWorkSession(m_reader);
+        doc->addLazyShapeLoader(std::make_shared<OccStepLazyShapeLoader>(doc, ws));
+    }
+
+    return ok;
 }
 
 std::unique_ptr<PropertyGroup> OccStepReader::createProperties(PropertyGroup* parentGroup)
@@ -157,15 +314,24 @@ void OccStepReader::applyProperties(const PropertyGroup* group)
 {
     auto ptr = dynamic_cast<const Properties*>(group);
     if (ptr) {
+        m_params.parser = ptr->parser.valueAs<Parser>();
         m_params.productContext = ptr->productContext.valueAs<ProductContext>();
         m_params.assemblyLevel = ptr->assemblyLevel.valueAs<AssemblyLevel>();
         m_params.preferredShapeRepresentation = ptr->preferredShapeRepresentation.valueAs<ShapeRepresentation>();
         m_params.readShapeAspect = ptr->readShapeAspect.value();
         m_params.readSubShapesNames = ptr->readSubShapesNames.value();
         m_params.encoding = ptr->encoding.valueAs<Encoding>();
+        m_params.loadPartsOnDemand = ptr->loadPartsOnDemand.value();
     }
 }
 
+bool OccStepReader::isLoadPartsOnDemandEnabled() const
+{
+    return m_params.loadPartsOnDemand
+            && (m_params.assemblyLevel == AssemblyLevel::All
+                || m_params.assemblyLevel == AssemblyLevel::Assembly);
+}
+
 void OccStepReader::changeStaticVariables(OccStaticVariablesRollback* rollback) const
 {
     auto fnOccEncoding = [](Encoding code) {
@@ -209,7 +375,9 @@ void OccStepReader::changeStaticVariables(OccStaticVariablesRollback* rollback)
 #endif
 
     rollback->change("read.step.product.context", int(m_params.productContext));
-    rollback->change("read.step.assembly.level", int(m_params.assemblyLevel));
+    const AssemblyLevel assemblyLevel =
+            this->isLoadPartsOnDemandEnabled() ? AssemblyLevel::Structure : m_params.assemblyLevel;
+    rollback->change("read.step.assembly.level", int(assemblyLevel));
     rollback->change("read.step.shape.repr", int(m_params.preferredShapeRepresentation));
     rollback->change("read.step.shape.aspect", int(m_params.readShapeAspect ? 1 : 0));
     rollback->change("read.stepcaf.subshapes.name", int(m_params.readSubShapesNames ? 1 : 0));
@@ -78,13 +78,23 @@ public:
 #endif
     };
 
+    enum class Parser {
+        OpenCascade, // Single-threaded StepFile_Read()
+        Parallel // StepParallelReader
+    };
+
     struct Parameters {
+        Parser parser = Parser::OpenCascade;
         ProductContext productContext = ProductContext::Both;
         AssemblyLevel assemblyLevel = AssemblyLevel::All;
         ShapeRepresentation preferredShapeRepresentation = ShapeRepresentation::All;
         bool readShapeAspect = true;
         bool readSubShapesNames = false;
         Encoding encoding = Encoding::UTF8;
+        // Only the assembly structure is translated at import, geometry of parts is translated
+        // later when needed(see Document::loadLazyShapes())
+        // Ignored if 'assemblyLevel' is AssemblyLevel::Shape or AssemblyLevel::Structure
+        bool loadPartsOnDemand = false;
     };
     Parameters& parameters() { return m_params; }
     const Parameters& constParameters() const { return m_params; }
@@ -94,6 +104,7 @@ public:
 
 private:
     void changeStaticVariables(OccStaticVariablesRollback* rollback) const;
+    bool isLoadPartsOnDemandEnabled() const;
 
     class Properties;
     STEPCAFControl_Reader m_reader;
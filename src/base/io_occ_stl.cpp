@@ -9,6 +9,7 @@
 #include "application_item.h"
 #include "document.h"
 #include "caf_utils.h"
+#include "mesh_utils.h"
 #include "occ_progress_indicator.h"
 #include "property_enumeration.h"
 #include "scope_import.h"
@@ -16,38 +17,162 @@
 #include "tkernel_utils.h"
 #include <fougtools/occtools/qt_utils.h>
 
+#include <QtCore/QByteArray>
+#include <QtCore/QFile>
 #include <QtCore/QFileInfo>
-#include <BRep_Builder.hxx>
+#include <QtCore/QtEndian>
+#include <BRep_Tool.hxx>
+#include <gp.hxx>
 #include <RWStl.hxx>
-#include <StlAPI_Writer.hxx>
 #include <TDataXtd_Triangulation.hxx>
-#include <TopoDS_Compound.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <memory>
 
 namespace Mayo {
 namespace IO {
 
 namespace {
 
-static TopoDS_Shape asShape(const DocumentPtr& doc)
+// Output buffered in memory and written to file by large chunks
+class BufferedFileOutput {
+public:
+    BufferedFileOutput(QFile* file)
+        : m_file(file), m_buffer(new char[Capacity])
+    {}
+
+    // Returns pointer to at least 'size' writable bytes, must be followed by a call to commit()
+    char* acquire(size_t size) {
+        if (m_size + size > Capacity)
+            this->flush();
+
+        return m_buffer.get() + m_size;
+    }
+
+    void commit(char* end) { m_size = end - m_buffer.get(); }
+
+    void write(const void* data, size_t size) {
+        char* begin = this->acquire(size);
+        std::memcpy(begin, data, size);
+        this->commit(begin + size);
+    }
+
+    // Returns false if some write to the file failed
+    bool flush() {
+        if (m_size > 0 && m_file->write(m_buffer.get(), m_size) != qint64(m_size))
+            m_hasError = true;
+
+        m_size = 0;
+        return !m_hasError;
+    }
+
+private:
+    static constexpr size_t Capacity = 4 * 1024 * 1024;
+    QFile* m_file = nullptr;
+    std::unique_ptr<char[]> m_buffer;
+    size_t m_size = 0;
+    bool m_hasError = false;
+};
+
+struct Facet {
+    gp_XYZ normal;
+    gp_XYZ nodes[3];
+};
+
+// Calls 'fn' for each triangle of 'triangulation' with nodes transformed by 'trsf'
+template<typename FUNCTION>
+void forEachFacet(const Handle_Poly_Triangulation& triangulation, const gp_Trsf& trsf, bool isReversed, FUNCTION fn)
 {
-    TopoDS_Shape shape;
-    const TDF_LabelSequence seqFreeShape = doc->xcaf().topLevelFreeShapes();
-    if (seqFreeShape.Size() > 1) {
-        TopoDS_Compound cmpd;
-        BRep_Builder builder;
-        builder.MakeCompound(cmpd);
-        for (const TDF_Label& label : seqFreeShape)
-            builder.Add(cmpd, XCaf::shape(label));
-
-        shape = cmpd;
+    const bool hasTrsf = trsf.Form() != gp_Identity;
+    const TColgp_Array1OfPnt& vecNode = triangulation->Nodes();
+    Facet facet;
+    for (const Poly_Triangle& tri : triangulation->Triangles()) {
+        int n1, n2, n3;
+        tri.Get(n1, n2, n3);
+        if (isReversed)
+            std::swap(n2, n3);
+
+        facet.nodes[0] = vecNode.Value(n1).XYZ();
+        facet.nodes[1] = vecNode.Value(n2).XYZ();
+        facet.nodes[2] = vecNode.Value(n3).XYZ();
+        if (hasTrsf) {
+            for (gp_XYZ& node : facet.nodes)
+                trsf.Transforms(node);
+        }
+
+        facet.normal = (facet.nodes[1] - facet.nodes[0]).Crossed(facet.nodes[2] - facet.nodes[0]);
+        const double normalModulus = facet.normal.Modulus();
+        if (normalModulus > gp::Resolution())
+            facet.normal /= normalModulus;
+        else
+            facet.normal.SetCoord(0, 0, 0);
+
+        fn(facet);
     }
-    else if (seqFreeShape.Size() == 1) {
-        shape = XCaf::shape(seqFreeShape.First());
+}
+
+char* formatFloat(char* begin, char* end, float value)
+{
+#if __cpp_lib_to_chars >= 201611L
+    // Shortest representation allowing exact round trip
+    return std::to_chars(begin, end, value).ptr;
+#else
+    // Not std::snprintf(), decimal separator would depend on the current C locale
+    const QByteArray bytes = QByteArray::number(value, 'g', 9);
+    const int len = std::min(bytes.size(), int(end - begin));
+    std::memcpy(begin, bytes.constData(), len);
+    return begin + len;
+#endif
+}
+
+char* formatXYZ(char* begin, char* end, const char* prefix, const gp_XYZ& coords)
+{
+    const size_t prefixLen = std::strlen(prefix);
+    std::memcpy(begin, prefix, prefixLen);
+    char* it = begin + prefixLen;
+    for (int i = 1; i <= 3; ++i) {
+        *it++ = ' ';
+        it = formatFloat(it, end, float(coords.Coord(i)));
     }
 
-    return shape;
+    *it++ = '\n';
+    return it;
 }
 
+void writeLittleEndianFloat(char* dst, double value)
+{
+    const float fValue = float(value);
+    quint32 bits;
+    std::memcpy(&bits, &fValue, sizeof(float));
+    qToLittleEndian(bits, dst);
+}
+
+// Reports progress of writing all the triangles, only when the percentage changes
+class FacetProgress {
+public:
+    FacetProgress(TaskProgress* progress, size_t totalCount)
+        : m_progress(progress), m_totalCount(std::max<size_t>(totalCount, 1))
+    {}
+
+    void add(size_t count) {
+        m_count += count;
+        const int pct = int((m_count * 100) / m_totalCount);
+        if (m_progress && pct != m_pct) {
+            m_progress->setValue(pct);
+            m_pct = pct;
+        }
+    }
+
+private:
+    TaskProgress* m_progress = nullptr;
+    size_t m_totalCount = 0;
+    size_t m_count = 0;
+    int m_pct = -1;
+};
+
 } // namespace
 
 class OccStlWriter::Properties : public PropertyGroup {
@@ -93,50 +218,149 @@ bool OccStlReader::transfer(DocumentPtr doc, TaskProgress* progress)
 
 bool OccStlWriter::transfer(Span<const ApplicationItem> appItems, TaskProgress* /*progress*/)
 {
-//    if (appItems.size() > 1)
-//        return Result::error(tr("OpenCascade RWStl does not support multi-solids"));
-
-    m_shape = {};
-    m_mesh = {};
-    if (!appItems.empty()) {
-        const ApplicationItem& item = appItems.at(0);
+    m_vecTriangulationItem.clear();
+    for (const ApplicationItem& item : appItems) {
         if (item.isDocument()) {
-            m_shape = asShape(item.document());
+            const DocumentPtr doc = item.document();
+            for (int i = 0; i < doc->entityCount(); ++i)
+                this->addTreeNode(doc, doc->entityTreeNodeId(i));
         }
         else if (item.isDocumentTreeNode()) {
-            const TDF_Label label = item.documentTreeNode().label();
-            if (XCaf::isShape(label)) {
-                m_shape = XCaf::shape(label);
-            }
-            else {
-                auto attrPolyTri = CafUtils::findAttribute<TDataXtd_Triangulation>(label);
-                if (!attrPolyTri.IsNull())
-                    m_mesh = attrPolyTri->Get();
-            }
+            const DocumentTreeNode& treeNode = item.documentTreeNode();
+            this->addTreeNode(treeNode.document(), treeNode.id());
         }
     }
 
-    return !m_shape.IsNull() || !m_mesh.IsNull();
+    return !m_vecTriangulationItem.empty();
 }
 
 bool OccStlWriter::writeFile(const QString& filepath, TaskProgress* progress)
 {
-    if (!m_shape.IsNull()) {
-        StlAPI_Writer writer;
-        writer.ASCIIMode() = m_params.format == Format::Ascii;
-        return writer.Write(m_shape, filepath.toUtf8().constData());
+    QFile file(filepath);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    if (m_params.format == Format::Ascii)
+        return this->writeAscii(&file, progress);
+    else
+        return this->writeBinary(&file, progress);
+}
+
+void OccStlWriter::addTreeNode(const DocumentPtr& doc, TreeNodeId nodeId)
+{
+    const Tree<TDF_Label>& modelTree = doc->modelTree();
+    // Entity might not have been displayed yet, so triangulations deferred by the reader(eg glTF)
+    // can still be empty
+    MeshUtils::loadDeferredTriangulations(XCaf::shape(modelTree.nodeData(nodeId)));
+    deepForeachTreeNode(nodeId, modelTree, [&](TreeNodeId id) {
+        const TDF_Label& label = modelTree.nodeData(id);
+        if (XCaf::isShape(label)) {
+            // Assemblies and instances are traversed down to the parts they refer to
+            if (XCaf::isShapeSimple(label)) {
+                // Own location of the part comes after the locations of the referring components
+                const TopoDS_Shape partShape = XCaf::shape(label);
+                const TopLoc_Location loc = doc->xcaf().shapeAbsoluteLocation(id) * partShape.Location();
+                this->addShape(partShape.Located(TopLoc_Location()), loc);
+            }
+        }
+        else {
+            auto attrPolyTri = CafUtils::findAttribute<TDataXtd_Triangulation>(label);
+            if (!attrPolyTri.IsNull() && !attrPolyTri->Get().IsNull())
+                m_vecTriangulationItem.push_back({ attrPolyTri->Get(), gp_Trsf(), false });
+        }
+    });
+}
+
+void OccStlWriter::addShape(const TopoDS_Shape& shape, const TopLoc_Location& loc)
+{
+    for (TopExp_Explorer expFace(shape, TopAbs_FACE); expFace.More(); expFace.Next()) {
+        const TopoDS_Face& face = TopoDS::Face(expFace.Current());
+        TopLoc_Location faceLoc;
+        const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(face, faceLoc);
+        if (triangulation.IsNull() || triangulation->NbTriangles() == 0)
+            continue;
+
+        const TopLoc_Location absoluteLoc = loc * faceLoc;
+        m_vecTriangulationItem.push_back({
+                    triangulation, absoluteLoc.Transformation(), face.Orientation() == TopAbs_REVERSED });
+    }
+}
+
+bool OccStlWriter::writeAscii(QFile* file, TaskProgress* progress) const
+{
+    size_t totalFacetCount = 0;
+    for (const TriangulationItem& item : m_vecTriangulationItem)
+        totalFacetCount += item.triangulation->NbTriangles();
+
+    BufferedFileOutput output(file);
+    FacetProgress facetProgress(progress, totalFacetCount);
+    output.write("solid\n", 6);
+    for (const TriangulationItem& item : m_vecTriangulationItem) {
+        if (TaskProgress::isAbortRequested(progress))
+            return false;
+
+        forEachFacet(item.triangulation, item.trsf, item.isReversed, [&](const Facet& facet) {
+            // Upper bound of the text size of a facet
+            constexpr size_t maxFacetSize = 512;
+            char* const begin = output.acquire(maxFacetSize);
+            char* const end = begin + maxFacetSize;
+            char* it = formatXYZ(begin, end, "facet normal", facet.normal);
+            static const char strOuterLoop[] = " outer loop\n";
+            it = std::copy(strOuterLoop, strOuterLoop + sizeof(strOuterLoop) - 1, it);
+            for (const gp_XYZ& node : facet.nodes)
+                it = formatXYZ(it, end, "  vertex", node);
+
+            static const char strEndFacet[] = " endloop\nendfacet\n";
+            it = std::copy(strEndFacet, strEndFacet + sizeof(strEndFacet) - 1, it);
+            output.commit(it);
+        });
+        facetProgress.add(item.triangulation->NbTriangles());
     }
-    else if (!m_mesh.IsNull()) {
-        Handle_Message_ProgressIndicator indicator = new OccProgressIndicator(progress);
-        const QByteArray filepathUtf8 = filepath.toUtf8();
-        const OSD_Path osdFilepath(filepathUtf8.constData());
-        if (m_params.format == Format::Ascii)
-            return RWStl::WriteAscii(m_mesh, osdFilepath, TKernelUtils::start(indicator));
-        else
-            return RWStl::WriteBinary(m_mesh, osdFilepath, TKernelUtils::start(indicator));
+
+    output.write("endsolid\n", 9);
+    return output.flush();
+}
+
+bool OccStlWriter::writeBinary(QFile* file, TaskProgress* progress) const
+{
+    size_t totalFacetCount = 0;
+    for (const TriangulationItem& item : m_vecTriangulationItem)
+        totalFacetCount += item.triangulation->NbTriangles();
+
+    BufferedFileOutput output(file);
+    FacetProgress facetProgress(progress, totalFacetCount);
+    // Header must not start with "solid", otherwise file could be probed as ASCII STL
+    char header[80] = {};
+    const char strHeader[] = "Binary STL written by Mayo";
+    std::memcpy(header, strHeader, sizeof(strHeader) - 1);
+    output.write(header, sizeof(header));
+    char facetCount[4];
+    qToLittleEndian(quint32(totalFacetCount), facetCount);
+    output.write(facetCount, sizeof(facetCount));
+    for (const TriangulationItem& item : m_vecTriangulationItem) {
+        if (TaskProgress::isAbortRequested(progress))
+            return false;
+
+        forEachFacet(item.triangulation, item.trsf, item.isReversed, [&](const Facet& facet) {
+            // 12 floats followed by 2 bytes of attributes
+            constexpr size_t facetSize = 50;
+            char* const begin = output.acquire(facetSize);
+            char* it = begin;
+            for (int i = 1; i <= 3; ++i, it += 4)
+                writeLittleEndianFloat(it, facet.normal.Coord(i));
+
+            for (const gp_XYZ& node : facet.nodes) {
+                for (int i = 1; i <= 3; ++i, it += 4)
+                    writeLittleEndianFloat(it, node.Coord(i));
+            }
+
+            it[0] = it[1] = 0;
+            output.commit(begin + facetSize);
+        });
+        facetProgress.add(item.triangulation->NbTriangles());
     }
 
-    return false;
+    return output.flush();
 }
 
 std::unique_ptr<PropertyGroup> OccStlWriter::createProperties(PropertyGroup* parentGroup)
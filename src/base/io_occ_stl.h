@@ -6,11 +6,16 @@
 
 #pragma once
 
+#include "document_ptr.h"
 #include "io_reader.h"
 #include "io_writer.h"
+#include "libtree.h"
+#include <gp_Trsf.hxx>
 #include <Poly_Triangulation.hxx>
 #include <TopoDS_Shape.hxx>
 #include <QtCore/QString>
+#include <vector>
+class QFile;
 
 namespace Mayo {
 namespace IO {
@@ -26,7 +31,9 @@ private:
     QString m_baseFilename;
 };
 
-// Opencascade-based writer for STL file format
+// Writer for STL file format
+// Facets are streamed from the triangulations of the shapes, absolute locations being applied on
+// the fly. Neither a merged shape nor a merged mesh is built
 class OccStlWriter : public Writer {
 public:
     bool transfer(Span<const ApplicationItem> appItems, TaskProgress* progress) override;
@@ -46,9 +53,21 @@ public:
 
 private:
     class Properties;
+
+    // Triangulation to be written, referenced and not copied
+    struct TriangulationItem {
+        Handle_Poly_Triangulation triangulation;
+        gp_Trsf trsf; // Transformation of the nodes
+        bool isReversed; // Nodes of triangles must be written in reverse order(eg reversed face)
+    };
+
+    void addTreeNode(const DocumentPtr& doc, TreeNodeId nodeId);
+    void addShape(const TopoDS_Shape& shape, const TopLoc_Location& loc);
+    bool writeAscii(QFile* file, TaskProgress* progress) const;
+    bool writeBinary(QFile* file, TaskProgress* progress) const;
+
     Parameters m_params;
-    TopoDS_Shape m_shape;
-    Handle_Poly_Triangulation m_mesh;
+    std::vector<TriangulationItem> m_vecTriangulationItem;
 };
 
 } // namespace IO
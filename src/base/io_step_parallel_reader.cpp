@@ -0,0 +1,613 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "io_step_parallel_reader.h"
+
+#include "task_progress.h"
+#include "tkernel_utils.h"
+
+#include <Interface_ParamType.hxx>
+#include <Interface_Static.hxx>
+#include <OSD_Parallel.hxx>
+#include <StepData_FileRecognizer.hxx>
+#include <StepData_Protocol.hxx>
+#include <StepData_StepModel.hxx>
+#include <StepData_StepReaderData.hxx>
+#include <StepData_StepReaderTool.hxx>
+#include <QtCore/QFile>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace Mayo {
+namespace IO {
+
+namespace {
+
+enum class LexState { Code, String, Comment };
+
+// Parameter types, as of OpenCascade lexer
+enum class ParamType { Sub, Integer, Real, Ident, Void, Text, Enum, Hexa, Misc };
+
+struct StepParam {
+    ParamType type;
+    uint32_t textLength;
+    int64_t textPos; // Offset of the text in file, index of the sub-list within chunk if type is Sub
+};
+
+struct StepRecord {
+    enum class Kind { Entity, ComplexPart, SubList };
+    Kind kind;
+    int64_t ident; // Entity number, valid for kind Entity
+    int64_t typePos; // Offset of the type name in file
+    uint32_t typeLength; // Zero for sub-lists which aren't typed parameters
+    uint32_t firstParam; // Index in StepChunk::vecParam
+    uint32_t paramCount;
+};
+
+// Records of all the entities terminated within a range of the file
+struct StepChunk {
+    int64_t begin = 0; // Start of the range, aligned on a line start
+    int64_t end = 0;
+    int64_t parseBegin = -1; // Start of the first entity terminated in the range
+    int64_t lastTerminator = -1; // Position of the last ';' ending an entity in the range
+    std::vector<StepRecord> vecRecord;
+    std::vector<StepParam> vecParam;
+    int subListCount = 0;
+    int entityCount = 0;
+    bool hasError = false;
+};
+
+struct ScanResult {
+    LexState endState;
+    int64_t lastTerminator; // -1 if none
+};
+
+// Lexical scan of [begin, end) starting in 'state', finds the position of the last ';' found
+// outside strings and comments
+// Boundaries of chunks are at line starts, so two-character tokens("/*" and "*/") aren't split
+ScanResult scanChunk(const char* data, int64_t begin, int64_t end, LexState state)
+{
+    ScanResult result = { state, -1 };
+    for (int64_t i = begin; i < end; ++i) {
+        const char c = data[i];
+        if (state == LexState::Code) {
+            if (c == '\'')
+                state = LexState::String;
+            else if (c == ';')
+                result.lastTerminator = i;
+            else if (c == '/' && i + 1 < end && data[i + 1] == '*')
+                state = LexState::Comment, ++i;
+        }
+        else if (state == LexState::String) {
+            // Escaped quote '' toggles the state twice
+            if (c == '\'')
+                state = LexState::Code;
+        }
+        else if (c == '*' && i + 1 < end && data[i + 1] == '/') {
+            state = LexState::Code, ++i;
+        }
+    }
+
+    result.endState = state;
+    return result;
+}
+
+bool isKeywordChar(char c)
+{
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_' || c == '-';
+}
+
+bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// Tokenizer of STEP records(clear text encoding, ISO 10303-21) within a range of text
+class StepTokenizer {
+public:
+    StepTokenizer(const char* data, int64_t pos, int64_t end, StepChunk* chunk)
+        : m_data(data), m_pos(pos), m_end(end), m_chunk(chunk)
+    {}
+
+    int64_t pos() const { return m_pos; }
+
+    void skipBlanks() {
+        while (m_pos < m_end) {
+            const char c = m_data[m_pos];
+            if (c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+                ++m_pos;
+            }
+            else if (c == '/' && m_pos + 1 < m_end && m_data[m_pos + 1] == '*') {
+                const char* commentEnd = this->find("*/", m_pos + 2);
+                m_pos = commentEnd ? (commentEnd - m_data) + 2 : m_end;
+            }
+            else {
+                break;
+            }
+        }
+    }
+
+    bool atEnd() { this->skipBlanks(); return m_pos >= m_end; }
+
+    // Parses "#N=TYPE(...);" or complex entity "#N=(TYPE1(...)TYPE2(...));"
+    bool parseEntity() {
+        this->skipBlanks();
+        if (!this->accept('#'))
+            return false;
+
+        int64_t ident = 0;
+        if (!this->parseUnsigned(&ident) || !this->acceptAfterBlanks('='))
+            return false;
+
+        this->skipBlanks();
+        if (this->accept('(')) {
+            // Complex entity: first component gets the entity number, others are chained to it
+            bool isFirst = true;
+            while (!this->acceptAfterBlanks(')')) {
+                const auto kind = isFirst ? StepRecord::Kind::Entity : StepRecord::Kind::ComplexPart;
+                if (!this->parseTypedRecord(kind, ident))
+                    return false;
+
+                isFirst = false;
+            }
+
+            if (isFirst)
+                return false;
+        }
+        else if (!this->parseTypedRecord(StepRecord::Kind::Entity, ident)) {
+            return false;
+        }
+
+        ++m_chunk->entityCount;
+        return this->acceptAfterBlanks(';');
+    }
+
+    // Parses "TYPE(...);" as found in header section
+    bool parseHeaderEntity() {
+        this->skipBlanks();
+        ++m_chunk->entityCount;
+        return this->parseTypedRecord(StepRecord::Kind::Entity, 0) && this->acceptAfterBlanks(';');
+    }
+
+private:
+    bool accept(char c) {
+        if (m_pos < m_end && m_data[m_pos] == c) {
+            ++m_pos;
+            return true;
+        }
+
+        return false;
+    }
+
+    bool acceptAfterBlanks(char c) {
+        this->skipBlanks();
+        return this->accept(c);
+    }
+
+    const char* find(const char* str, int64_t from) const {
+        const size_t len = std::strlen(str);
+        for (int64_t i = from; i + int64_t(len) <= m_end; ++i) {
+            if (std::memcmp(m_data + i, str, len) == 0)
+                return m_data + i;
+        }
+
+        return nullptr;
+    }
+
+    bool parseUnsigned(int64_t* value) {
+        const int64_t start = m_pos;
+        *value = 0;
+        while (m_pos < m_end && isDigit(m_data[m_pos]))
+            *value = *value * 10 + (m_data[m_pos++] - '0');
+
+        return m_pos > start;
+    }
+
+    // Returns length of keyword at current position, user-defined keywords start with '!'
+    uint32_t parseKeyword() {
+        const int64_t start = m_pos;
+        this->accept('!');
+        while (m_pos < m_end && isKeywordChar(m_data[m_pos]))
+            ++m_pos;
+
+        return uint32_t(m_pos - start);
+    }
+
+    bool parseTypedRecord(StepRecord::Kind kind, int64_t ident) {
+        this->skipBlanks();
+        const int64_t typePos = m_pos;
+        const uint32_t typeLength = this->parseKeyword();
+        return typeLength > 0
+                && this->acceptAfterBlanks('(')
+                && this->parseRecordParams(kind, ident, typePos, typeLength);
+    }
+
+    // Parses parameters after the opening parenthesis up to the closing one, then adds the record
+    bool parseRecordParams(StepRecord::Kind kind, int64_t ident, int64_t typePos, uint32_t typeLength) {
+        // Parameters of the records being parsed are stacked, a record is added to the chunk once
+        // complete(so after its sub-lists)
+        const size_t depth = m_depth++;
+        if (depth >= m_stackParams.size())
+            m_stackParams.emplace_back();
+
+        m_stackParams.at(depth).clear();
+        if (!this->acceptAfterBlanks(')')) {
+            do {
+                if (!this->parseParam())
+                    return false;
+            } while (this->acceptAfterBlanks(','));
+
+            if (!this->accept(')'))
+                return false;
+        }
+
+        --m_depth;
+        // Stack may have grown while parsing nested sub-lists
+        const std::vector<StepParam>& vecParam = m_stackParams.at(depth);
+        StepRecord record;
+        record.kind = kind;
+        record.ident = ident;
+        record.typePos = typePos;
+        record.typeLength = typeLength;
+        record.firstParam = uint32_t(m_chunk->vecParam.size());
+        record.paramCount = uint32_t(vecParam.size());
+        m_chunk->vecParam.insert(m_chunk->vecParam.end(), vecParam.cbegin(), vecParam.cend());
+        m_chunk->vecRecord.push_back(record);
+        if (kind == StepRecord::Kind::SubList)
+            ++m_chunk->subListCount;
+
+        return true;
+    }
+
+    bool parseParam() {
+        this->skipBlanks();
+        if (m_pos >= m_end)
+            return false;
+
+        const int64_t start = m_pos;
+        auto fnAddParam = [&](ParamType type) {
+            m_stackParams.at(m_depth - 1).push_back({ type, uint32_t(m_pos - start), start });
+            return true;
+        };
+        auto fnAddSubList = [&](int64_t typePos, uint32_t typeLength) {
+            if (!this->parseRecordParams(StepRecord::Kind::SubList, 0, typePos, typeLength))
+                return false;
+
+            // Nested sub-lists were added before, index of this one is the last
+            const int64_t subIndex = m_chunk->subListCount - 1;
+            m_stackParams.at(m_depth - 1).push_back({ ParamType::Sub, 0, subIndex });
+            return true;
+        };
+
+        const char c = m_data[m_pos];
+        if (c == '#') {
+            ++m_pos;
+            int64_t ident;
+            return this->parseUnsigned(&ident) && fnAddParam(ParamType::Ident);
+        }
+        else if (c == '\'') {
+            for (++m_pos; m_pos < m_end; ++m_pos) {
+                if (m_data[m_pos] == '\'') {
+                    if (m_pos + 1 < m_end && m_data[m_pos + 1] == '\'')
+                        ++m_pos;
+                    else
+                        break;
+                }
+            }
+
+            return this->accept('\'') && fnAddParam(ParamType::Text);
+        }
+        else if (c == '"') {
+            ++m_pos;
+            while (m_pos < m_end && m_data[m_pos] != '"')
+                ++m_pos;
+
+            return this->accept('"') && fnAddParam(ParamType::Hexa);
+        }
+        else if (c == '.') {
+            ++m_pos;
+            while (m_pos < m_end && isKeywordChar(m_data[m_pos]))
+                ++m_pos;
+
+            return this->accept('.') && fnAddParam(ParamType::Enum);
+        }
+        else if (c == '$') {
+            ++m_pos;
+            return fnAddParam(ParamType::Void);
+        }
+        else if (c == '*') {
+            ++m_pos;
+            return fnAddParam(ParamType::Misc);
+        }
+        else if (c == '(') {
+            ++m_pos;
+            return fnAddSubList(0, 0);
+        }
+        else if (isDigit(c) || c == '+' || c == '-') {
+            ++m_pos;
+            bool isReal = false;
+            while (m_pos < m_end) {
+                const char cc = m_data[m_pos];
+                if (cc == '.' || cc == 'E' || cc == 'e')
+                    isReal = true;
+                else if (!isDigit(cc) && !((cc == '+' || cc == '-') && isReal))
+                    break;
+
+                ++m_pos;
+            }
+
+            return fnAddParam(isReal ? ParamType::Real : ParamType::Integer);
+        }
+        else if (isKeywordChar(c) || c == '!') {
+            // Typed parameter, eg LENGTH_MEASURE(2.5)
+            const uint32_t typeLength = this->parseKeyword();
+            return this->acceptAfterBlanks('(') && fnAddSubList(start, typeLength);
+        }
+
+        return false;
+    }
+
+    const char* m_data;
+    int64_t m_pos;
+    int64_t m_end;
+    StepChunk* m_chunk;
+    std::vector<std::vector<StepParam>> m_stackParams;
+    size_t m_depth = 0;
+};
+
+// Returns position of 'keyword' starting at 'from' once blanks and comments are skipped, -1 otherwise
+int64_t findKeyword(const char* data, int64_t from, int64_t end, const char* keyword)
+{
+    StepChunk dummy;
+    StepTokenizer tokenizer(data, from, end, &dummy);
+    tokenizer.skipBlanks();
+    const int64_t pos = tokenizer.pos();
+    const size_t len = std::strlen(keyword);
+    if (pos + int64_t(len) <= end && std::memcmp(data + pos, keyword, len) == 0)
+        return pos;
+
+    return -1;
+}
+
+Interface_ParamType toOccParamType(ParamType type)
+{
+    switch (type) {
+    case ParamType::Sub: return Interface_ParamSub;
+    case ParamType::Integer: return Interface_ParamInteger;
+    case ParamType::Real: return Interface_ParamReal;
+    case ParamType::Ident: return Interface_ParamIdent;
+    case ParamType::Void: return Interface_ParamVoid;
+    case ParamType::Text: return Interface_ParamText;
+    case ParamType::Enum: return Interface_ParamEnum;
+    case ParamType::Hexa: return Interface_ParamHexa;
+    case ParamType::Misc: return Interface_ParamMisc;
+    }
+
+    return Interface_ParamMisc;
+}
+
+// Feeds the records of 'chunk' to 'readerData', 'ptrRecordNum' is the number of the last
+// record already fed and 'subListOffset' the count of sub-lists in previous chunks
+void feedRecords(
+        const char* data,
+        const StepChunk& chunk,
+        int subListOffset,
+        int* ptrRecordNum,
+        const Handle_StepData_StepReaderData& readerData)
+{
+    // Type of sub-list records, starts with '(' so they aren't taken as typed parameters
+    static const char strSubListType[] = "(SUB)";
+    std::string ident;
+    std::string type;
+    std::string value;
+    int subListIndex = subListOffset;
+    for (const StepRecord& record : chunk.vecRecord) {
+        const int num = ++(*ptrRecordNum);
+        if (record.kind == StepRecord::Kind::Entity)
+            ident = "#" + std::to_string(record.ident);
+        else if (record.kind == StepRecord::Kind::ComplexPart)
+            ident = "#0";
+        else
+            ident = "$" + std::to_string(++subListIndex);
+
+        if (record.typeLength > 0)
+            type.assign(data + record.typePos, record.typeLength);
+        else
+            type.assign(strSubListType);
+
+        readerData->SetRecord(num, ident.c_str(), type.c_str(), int(record.paramCount));
+        for (uint32_t i = 0; i < record.paramCount; ++i) {
+            const StepParam& param = chunk.vecParam.at(record.firstParam + i);
+            if (param.type == ParamType::Sub)
+                value = "$" + std::to_string(subListOffset + param.textPos + 1);
+            else
+                value.assign(data + param.textPos, param.textLength);
+
+            readerData->AddStepParam(num, value.c_str(), toOccParamType(param.type));
+        }
+    }
+}
+
+} // namespace
+
+bool StepParallelReader::readFile(
+        const QString& filepath, const Handle_XSControl_WorkSession& ws, TaskProgress* progress)
+{
+    auto fnSetProgress = [=](int pct) {
+        if (progress)
+            progress->setValue(pct);
+    };
+
+    auto protocol = Handle_StepData_Protocol::DownCast(ws->Protocol());
+    QFile file(filepath);
+    if (protocol.IsNull() || !file.open(QIODevice::ReadOnly))
+        return false;
+
+    const int64_t fileSize = file.size();
+    const char* data = fileSize > 0 ? reinterpret_cast<const char*>(file.map(0, fileSize)) : nullptr;
+    if (!data)
+        return false;
+
+    // Header section
+    StepChunk headerChunk;
+    int64_t pos = findKeyword(data, 0, fileSize, "ISO-10303-21;");
+    pos = pos >= 0 ? findKeyword(data, pos + 13, fileSize, "HEADER;") : -1;
+    if (pos < 0)
+        return false;
+
+    StepTokenizer headerTokenizer(data, pos + 7, fileSize, &headerChunk);
+    while (findKeyword(data, headerTokenizer.pos(), fileSize, "ENDSEC;") < 0) {
+        if (!headerTokenizer.parseHeaderEntity())
+            return false;
+    }
+
+    // DATA section, up to the last ENDSEC
+    pos = findKeyword(data, headerTokenizer.pos(), fileSize, "ENDSEC;");
+    pos = pos >= 0 ? findKeyword(data, pos + 7, fileSize, "DATA;") : -1;
+    if (pos < 0)
+        return false;
+
+    const int64_t dataBegin = pos + 5;
+    int64_t dataEnd = -1;
+    for (int64_t i = fileSize - 6; i >= dataBegin && dataEnd < 0; --i) {
+        if (std::memcmp(data + i, "ENDSEC", 6) == 0)
+            dataEnd = i;
+    }
+
+    if (dataEnd < 0)
+        return false;
+
+    // Split in chunks starting at line starts
+    const int64_t dataSize = dataEnd - dataBegin;
+    constexpr int64_t minChunkSize = 1024 * 1024;
+    const int64_t chunkCount = std::clamp<int64_t>(
+                dataSize / minChunkSize, 1, 8 * OSD_Parallel::NbLogicalProcessors());
+    std::vector<StepChunk> vecChunk;
+    int64_t chunkBegin = dataBegin;
+    for (int64_t i = 1; i <= chunkCount && chunkBegin < dataEnd; ++i) {
+        int64_t chunkEnd = dataEnd;
+        if (i < chunkCount) {
+            const int64_t nominalEnd = dataBegin + (dataSize * i) / chunkCount;
+            auto itNewLine = static_cast<const char*>(
+                        std::memchr(data + nominalEnd, '\n', size_t(dataEnd - nominalEnd)));
+            chunkEnd = itNewLine ? (itNewLine - data) + 1 : dataEnd;
+        }
+
+        if (chunkEnd > chunkBegin) {
+            vecChunk.emplace_back();
+            vecChunk.back().begin = chunkBegin;
+            vecChunk.back().end = chunkEnd;
+        }
+
+        chunkBegin = chunkEnd;
+    }
+
+    // Locate entity terminators: chunks are first scanned assuming they start in code, which is
+    // the case unless some string or comment spans over a chunk boundary
+    std::vector<ScanResult> vecScan(vecChunk.size());
+    OSD_Parallel::For(0, int(vecChunk.size()), [&](int i) {
+        vecScan.at(i) = scanChunk(data, vecChunk.at(i).begin, vecChunk.at(i).end, LexState::Code);
+    });
+
+    LexState state = LexState::Code;
+    int64_t lastTerminator = dataBegin - 1;
+    for (size_t i = 0; i < vecChunk.size(); ++i) {
+        StepChunk& chunk = vecChunk.at(i);
+        if (state != LexState::Code)
+            vecScan.at(i) = scanChunk(data, chunk.begin, chunk.end, state);
+
+        state = vecScan.at(i).endState;
+        chunk.parseBegin = lastTerminator + 1;
+        chunk.lastTerminator = vecScan.at(i).lastTerminator;
+        if (chunk.lastTerminator >= 0)
+            lastTerminator = chunk.lastTerminator;
+    }
+
+    fnSetProgress(10);
+    if (TaskProgress::isAbortRequested(progress))
+        return false;
+
+    // Tokenize the entities terminated in each chunk
+    OSD_Parallel::For(0, int(vecChunk.size()), [&](int i) {
+        StepChunk& chunk = vecChunk.at(i);
+        if (chunk.lastTerminator < 0)
+            return;
+
+        StepTokenizer tokenizer(data, chunk.parseBegin, chunk.lastTerminator + 1, &chunk);
+        while (!chunk.hasError && !tokenizer.atEnd())
+            chunk.hasError = !tokenizer.parseEntity();
+    });
+
+    StepChunk trailingChunk;
+    StepTokenizer trailingTokenizer(data, lastTerminator + 1, dataEnd, &trailingChunk);
+    if (state != LexState::Code || !trailingTokenizer.atEnd())
+        return false;
+
+    int recordCount = int(headerChunk.vecRecord.size());
+    int paramCount = int(headerChunk.vecParam.size());
+    int entityCount = 0;
+    for (const StepChunk& chunk : vecChunk) {
+        if (chunk.hasError)
+            return false;
+
+        recordCount += int(chunk.vecRecord.size());
+        paramCount += int(chunk.vecParam.size());
+        entityCount += chunk.entityCount;
+    }
+
+    fnSetProgress(40);
+    if (TaskProgress::isAbortRequested(progress))
+        return false;
+
+    // Feed records in file order, as done by StepFile_Read()
+    Handle_StepData_StepModel model = new StepData_StepModel;
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+    model->SetSourceCodePage(static_cast<Resource_FormatType>(Interface_Static::IVal("read.step.codepage")));
+    Handle_StepData_StepReaderData readerData = new StepData_StepReaderData(
+                int(headerChunk.vecRecord.size()), recordCount, paramCount, model->SourceCodePage());
+#else
+    Handle_StepData_StepReaderData readerData = new StepData_StepReaderData(
+                int(headerChunk.vecRecord.size()), recordCount, paramCount);
+#endif
+    int recordNum = 0;
+    int subListOffset = 0;
+    feedRecords(data, headerChunk, subListOffset, &recordNum, readerData);
+    subListOffset += headerChunk.subListCount;
+    for (StepChunk& chunk : vecChunk) {
+        feedRecords(data, chunk, subListOffset, &recordNum, readerData);
+        subListOffset += chunk.subListCount;
+        // Release memory as soon as possible
+        chunk.vecRecord = {};
+        chunk.vecParam = {};
+    }
+
+    readerData->SetEntityNumbers(Standard_True);
+    fnSetProgress(60);
+    if (TaskProgress::isAbortRequested(progress))
+        return false;
+
+    StepData_StepReaderTool readerTool(readerData, protocol);
+    readerTool.SetErrorHandle(Standard_True);
+    readerTool.PrepareHeader(Handle_StepData_FileRecognizer());
+    readerTool.Prepare(Handle_StepData_FileRecognizer());
+    readerTool.LoadModel(model);
+    if (model->Protocol().IsNull())
+        model->SetProtocol(protocol);
+
+    if (model->NbEntities() != entityCount)
+        return false;
+
+    ws->SetModel(model);
+    ws->SetLoadedFile(filepath.toUtf8().constData());
+    ws->InitTransferReader(4);
+    fnSetProgress(100);
+    return true;
+}
+
+} // namespace IO
+} // namespace Mayo
@@ -0,0 +1,36 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QString>
+#include <XSControl_WorkSession.hxx>
+
+namespace Mayo {
+
+class TaskProgress;
+
+namespace IO {
+
+// Multi-threaded replacement of the lexer/parser of OpenCascade STEP reader(StepFile_Read())
+//
+// The file is memory-mapped and its DATA section split into chunks processed in parallel: first
+// the lexical state(code, string, comment) at each chunk boundary is resolved to locate the
+// entity terminators, then each chunk tokenizes the entities ending in it. Records are finally
+// fed in file order to StepData_StepReaderData, the model is loaded by OpenCascade the usual way
+//
+// Records are encoded as done by OpenCascade lexer: lists and typed parameters are sub-records
+// preceding the record referencing them, components of complex entities are chained records
+class StepParallelReader {
+public:
+    // Parses STEP file 'filepath' into a new model set in 'ws', as STEPControl_Reader::ReadFile()
+    // would do. Returns false if the file can't be handled(eg syntax error, SCOPE sections,
+    // multiple DATA sections), then nothing was changed and the regular reader should be used
+    static bool readFile(const QString& filepath, const Handle_XSControl_WorkSession& ws, TaskProgress* progress);
+};
+
+} // namespace IO
+} // namespace Mayo
@@ -7,6 +7,7 @@
 #include "io_system.h"
 
 #include "document.h"
+#include "io_mayo_doc.h"
 #include "io_parameters_provider.h"
 #include "io_reader.h"
 #include "io_writer.h"
@@ -20,137 +21,20 @@
 
 #include <algorithm>
 #include <array>
+#include <cstring>
 #include <future>
 #include <locale>
 #include <mutex>
 #include <regex>
 
 #ifdef HAVE_GMIO
-#  include <gmio_core/error.h>
-#  include <gmio_stl/stl_error.h>
 #  include <gmio_stl/stl_format.h>
-#  include <gmio_stl/stl_infos.h>
-#  include <gmio_stl/stl_io.h>
 #  include <gmio_support/stream_qt.h>
-#  include <gmio_support/stl_occ_brep.h>
-#  include <gmio_support/stl_occ_polytri.h>
 #endif
 
 namespace Mayo {
 namespace IO {
 
-#ifdef HAVE_GMIO
-static bool gmio_qttask_is_stop_requested(void* cookie)
-{
-    auto progress = static_cast<const TaskProgress*>(cookie);
-    return progress ? progress->isAbortRequested() : false;
-}
-
-static void gmio_qttask_handle_progress(
-        void* cookie, intmax_t value, intmax_t maxValue)
-{
-    auto progress = static_cast<TaskProgress*>(cookie);
-    if (progress && maxValue > 0) {
-        const auto pctNorm = value / static_cast<double>(maxValue);
-        const auto pct = qRound(pctNorm * 100);
-        if (pct >= (progress->value() + 5))
-            progress->setValue(pct);
-    }
-}
-
-static gmio_task_iface gmio_qttask_create_task_iface(TaskProgress* progress)
-{
-    gmio_task_iface task = {};
-    task.cookie = progress;
-    task.func_is_stop_requested = gmio_qttask_is_stop_requested;
-    task.func_handle_progress = gmio_qttask_handle_progress;
-    return task;
-}
-
-static QString gmioErrorToQString(int error)
-{
-    switch (error) {
-    // Core
-    case GMIO_ERROR_OK:
-        return QString();
-    case GMIO_ERROR_UNKNOWN:
-        return IO::tr("GMIO_ERROR_UNKNOWN");
-    case GMIO_ERROR_NULL_MEMBLOCK:
-        return IO::tr("GMIO_ERROR_NULL_MEMBLOCK");
-    case GMIO_ERROR_INVALID_MEMBLOCK_SIZE:
-        return IO::tr("GMIO_ERROR_INVALID_MEMBLOCK_SIZE");
-    case GMIO_ERROR_STREAM:
-        return IO::tr("GMIO_ERROR_STREAM");
-    case GMIO_ERROR_TASK_STOPPED:
-        return IO::tr("GMIO_ERROR_TASK_STOPPED");
-    case GMIO_ERROR_STDIO:
-        return IO::tr("GMIO_ERROR_STDIO");
-    case GMIO_ERROR_BAD_LC_NUMERIC:
-        return IO::tr("GMIO_ERROR_BAD_LC_NUMERIC");
-    // TODO: complete other core enum values
-    // STL
-    case GMIO_STL_ERROR_UNKNOWN_FORMAT:
-        return IO::tr("GMIO_STL_ERROR_UNKNOWN_FORMAT");
-    case GMIO_STL_ERROR_NULL_FUNC_GET_TRIANGLE:
-        return IO::tr("GMIO_STL_ERROR_NULL_FUNC_GET_TRIANGLE");
-    case GMIO_STL_ERROR_PARSING:
-        return IO::tr("GMIO_STL_ERROR_PARSING");
-    case GMIO_STL_ERROR_INVALID_FLOAT32_PREC:
-        return IO::tr("GMIO_STL_ERROR_INVALID_FLOAT32_PREC");
-    case GMIO_STL_ERROR_UNSUPPORTED_BYTE_ORDER:
-        return IO::tr("GMIO_STL_ERROR_UNSUPPORTED_BYTE_ORDER");
-    case GMIO_STL_ERROR_HEADER_WRONG_SIZE:
-        return IO::tr("GMIO_STL_ERROR_HEADER_WRONG_SIZE");
-    case GMIO_STL_ERROR_FACET_COUNT:
-        return IO::tr("GMIO_STL_ERROR_FACET_COUNT");
-    }
-
-    return IO::tr("GMIO_ERROR_UNKNOWN");
-}
-
-IO::Result IO::exportStl_gmio(ExportData data)
-{
-    QFile file(data.filepath);
-    if (file.open(QIODevice::WriteOnly)) {
-        gmio_stream stream = gmio_stream_qiodevice(&file);
-        gmio_stl_write_options gmioOptions = {};
-        gmioOptions.stla_float32_format = options.stlaFloat32Format;
-        gmioOptions.stla_float32_prec = options.stlaFloat32Precision;
-        gmioOptions.stla_solid_name = options.stlaSolidName.c_str();
-        gmioOptions.task_iface = Internal::gmio_qttask_create_task_iface(progress);
-        for (const DocumentItem* item : docItems) {
-            if (progress) {
-                progress->setStep(
-                            tr("Writing item %1")
-                            .arg(item->propertyLabel.value()));
-            }
-
-            int error = GMIO_ERROR_OK;
-            if (sameType<XdeDocumentItem>(item)) {
-                auto xdeDocItem = static_cast<const XdeDocumentItem*>(item);
-                const TopoDS_Shape shape = Internal::xdeDocumentWholeShape(xdeDocItem);
-                const gmio_stl_mesh_occshape gmioMesh(shape);
-                error = gmio_stl_write(
-                            options.stlFormat, &stream, &gmioMesh, &gmioOptions);
-            }
-            else if (sameType<MeshItem>(item)) {
-                auto meshItem = static_cast<const MeshItem*>(item);
-                const gmio_stl_mesh_occpolytri gmioMesh(meshItem->triangulation());
-                error = gmio_stl_write(
-                            options.stlFormat, &stream, &gmioMesh, &gmioOptions);
-            }
-
-            if (error != GMIO_ERROR_OK)
-                return IoResult::error(Internal::gmioErrorToQString(error));
-        }
-
-        return IoResult::ok();
-    }
-
-    return Result::error(file.errorString());
-}
-#endif // HAVE_GMIO
-
 namespace {
 
 TaskProgress* nullTaskProgress()
@@ -325,6 +209,12 @@ bool System::importInDocument(const Args_ImportInDocument& args)
     bool ok = true;
 
     using ReaderPtr = std::unique_ptr<Reader>;
+    // Cache entry to be created once the file is transferred, key is empty on cache hit
+    struct CacheStore {
+        QString key;
+        Format format = Format_Unknown;
+    };
+    ImportCache* importCache = m_importCache && m_importCache->isEnabled() ? m_importCache.get() : nullptr;
     auto fnAddError = [&](QString filepath, QString errorMsg) {
         ok = false;
         messenger->emitError(tr("Error during import of '%1'\n%2").arg(filepath, errorMsg));
@@ -333,7 +223,7 @@ bool System::importInDocument(const Args_ImportInDocument& args)
         fnAddError(filepath, errorMsg);
         return {};
     };
-    auto fnReadFile = [&](QString filepath, TaskProgress* subProgress) -> ReaderPtr {
+    auto fnReadFile = [&](QString filepath, TaskProgress* subProgress, CacheStore* cacheStore) -> ReaderPtr {
         subProgress->beginScope(40, tr("Reading file"));
         auto _ = gsl::finally([=]{ subProgress->endScope(); });
         const Format fileFormat = this->probeFormat(filepath);
@@ -344,31 +234,69 @@ bool System::importInDocument(const Args_ImportInDocument& args)
         if (!reader)
             return fnReadFileError(filepath, tr("No supporting reader"));
 
+        const PropertyGroup* readerParams =
+                args.parametersProvider ? args.parametersProvider->findReaderParameters(fileFormat) : nullptr;
         if (args.parametersProvider)
-            reader->applyProperties(args.parametersProvider->findReaderParameters(fileFormat));
+            reader->applyProperties(readerParams);
+
+        if (importCache && ImportCache::isFormatSupported(fileFormat)) {
+            const QString cacheKey = ImportCache::computeKey(filepath, readerParams);
+            const QString cacheFilepath = importCache->findDocumentFile(cacheKey);
+            if (!cacheFilepath.isEmpty()) {
+                auto cacheReader = std::make_unique<MayoDocReader>();
+                cacheReader->parameters().nameSingleRootAfterFile = false;
+                if (cacheReader->readFile(cacheFilepath, subProgress))
+                    return cacheReader;
+            }
+
+            cacheStore->key = cacheKey;
+            cacheStore->format = fileFormat;
+        }
 
         if (!reader->readFile(filepath, subProgress))
             return fnReadFileError(filepath, tr("File read problem"));
 
         return reader;
     };
-    auto fnTransfer = [&](QString filepath, const ReaderPtr& reader, TaskProgress* subProgress) {
+    auto fnStoreInCache = [&](QString filepath, const CacheStore& cacheStore, int firstEntityIndex) {
+        std::vector<ApplicationItem> vecNewEntity;
+        for (int i = firstEntityIndex; i < doc->entityCount(); ++i) {
+            const TreeNodeId entityId = doc->entityTreeNodeId(i);
+            if (doc->hasPendingLazyShapes(entityId))
+                return; // Structure-only import, nothing worth caching
+
+            vecNewEntity.push_back(DocumentTreeNode(doc, entityId));
+        }
+
+        importCache->storeInBackground(cacheStore.key, filepath, cacheStore.format, vecNewEntity);
+    };
+    auto fnTransfer = [&](
+            QString filepath, const ReaderPtr& reader, const CacheStore& cacheStore, TaskProgress* subProgress)
+    {
         subProgress->beginScope(60, tr("Transferring file"));
         if (reader) {
-            if (!reader->transfer(doc, subProgress) && !TaskProgress::isAbortRequested(subProgress))
+            const int entityCountBefore = doc->entityCount();
+            if (reader->transfer(doc, subProgress)) {
+                if (!cacheStore.key.isEmpty())
+                    fnStoreInCache(filepath, cacheStore, entityCountBefore);
+            }
+            else if (!TaskProgress::isAbortRequested(subProgress)) {
                 fnAddError(filepath, tr("File transfer problem"));
+            }
         }
 
         subProgress->endScope();
     };
 
     if (listFilepath.size() == 1) { // Single file case
-        const ReaderPtr reader = fnReadFile(listFilepath.front(), progress);
-        fnTransfer(listFilepath.front(), reader, progress);
+        CacheStore cacheStore;
+        const ReaderPtr reader = fnReadFile(listFilepath.front(), progress, &cacheStore);
+        fnTransfer(listFilepath.front(), reader, cacheStore, progress);
     }
     else { // Many files case
         struct TaskData {
             std::unique_ptr<Reader> reader;
+            CacheStore cacheStore;
             QString filepath;
             TaskProgress* progress = nullptr;
             TaskId taskId = 0;
@@ -387,7 +315,7 @@ bool System::importInDocument(const Args_ImportInDocument& args)
             taskData.filepath = listFilepath.at(i);
             const TaskId childTaskId = childTaskManager.newTask([&](TaskProgress* progressChild) {
                 taskData.progress = progressChild;
-                taskData.reader = fnReadFile(taskData.filepath, progressChild);
+                taskData.reader = fnReadFile(taskData.filepath, progressChild, &taskData.cacheStore);
             });
             taskData.taskId = childTaskId;
             childTaskManager.run(childTaskId, TaskAutoDestroy::Off);
@@ -411,7 +339,7 @@ bool System::importInDocument(const Args_ImportInDocument& args)
             }
 
             if (itTaskData != vecTaskData.end()) {
-                fnTransfer(itTaskData->filepath, itTaskData->reader, itTaskData->progress);
+                fnTransfer(itTaskData->filepath, itTaskData->reader, itTaskData->cacheStore, itTaskData->progress);
                 itTaskData->transferred = true;
                 --taskDataCount;
             }
@@ -421,6 +349,11 @@ bool System::importInDocument(const Args_ImportInDocument& args)
     return ok;
 }
 
+void System::setImportCache(std::unique_ptr<ImportCache> cache)
+{
+    m_importCache = std::move(cache);
+}
+
 System::Operation_ImportInDocument System::importInDocument() {
     return Operation_ImportInDocument(*this);
 }
@@ -439,6 +372,22 @@ bool System::exportApplicationItems(const Args_ExportApplicationItems& args)
         return fnError(tr("No supporting writer"));
 
     writer->applyProperties(args.parameters);
+
+    // Geometry of parts not loaded yet(see Document::lazyShapeLoaders()) has to be exported too
+    for (const ApplicationItem& appItem : args.applicationItems) {
+        const DocumentPtr doc = appItem.document();
+        if (!doc || doc->lazyShapeLoaders().empty())
+            continue;
+
+        if (appItem.isDocument()) {
+            for (int i = 0; i < doc->entityCount(); ++i)
+                doc->loadLazyShapes(doc->entityTreeNodeId(i));
+        }
+        else if (appItem.isDocumentTreeNode()) {
+            doc->loadLazyShapes(appItem.documentTreeNode().id());
+        }
+    }
+
     auto _ = gsl::finally([=]{ progress->endScope(); });
     progress->beginScope(40, tr("Transfer"));
     const bool okTransfer = writer->transfer(args.applicationItems, progress);
@@ -617,6 +566,24 @@ Format probeFormat_OCCBREP(const System::FormatProbeInput& input)
     return Format_Unknown;
 }
 
+Format probeFormat_OCCBREP_BIN(const System::FormatProbeInput& input)
+{
+    // regex : ^\s*Open CASCADE Topology V[0-9]+ \(c\)
+    const QByteArray& sample = input.contentsBegin;
+    auto itContentsBegin = findFirstNonSpace(sample);
+    constexpr std::string_view occBinBRepToken = "Open CASCADE Topology V";
+    if (matchToken(itContentsBegin, occBinBRepToken)) {
+        auto itChar = itContentsBegin + occBinBRepToken.size();
+        auto itVersionEnd = std::find_if_not(itChar, sample.cend(), [](char c) {
+            return std::isdigit(static_cast<unsigned char>(c));
+        });
+        if (itVersionEnd != itChar && matchToken(itVersionEnd, " (c)"))
+            return Format_OCCBREP_BIN;
+    }
+
+    return Format_Unknown;
+}
+
 Format probeFormat_STL(const System::FormatProbeInput& input)
 {
     const QByteArray& sample = input.contentsBegin;
@@ -659,6 +626,20 @@ Format probeFormat_OBJ(const System::FormatProbeInput& input)
     return Format_Unknown;
 }
 
+Format probeFormat_MAYODOC(const System::FormatProbeInput& input)
+{
+    // Magic number at start of file, see io_mayo_doc.cpp
+    constexpr std::string_view mayoDocMagic("MAYODOC\0", 8);
+    const QByteArray& sample = input.contentsBegin;
+    if (sample.size() >= int(mayoDocMagic.size())
+            && std::memcmp(sample.constData(), mayoDocMagic.data(), mayoDocMagic.size()) == 0)
+    {
+        return Format_MAYODOC;
+    }
+
+    return Format_Unknown;
+}
+
 void addPredefinedFormatProbes(System* system)
 {
     if (!system)
@@ -667,6 +648,8 @@ void addPredefinedFormatProbes(System* system)
     system->addFormatProbe(probeFormat_STEP);
     system->addFormatProbe(probeFormat_IGES);
     system->addFormatProbe(probeFormat_OCCBREP);
+    system->addFormatProbe(probeFormat_OCCBREP_BIN);
+    system->addFormatProbe(probeFormat_MAYODOC);
     system->addFormatProbe(probeFormat_STL);
     system->addFormatProbe(probeFormat_OBJ);
 }
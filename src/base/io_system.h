@@ -8,6 +8,7 @@
 
 #include "application_item.h"
 #include "io_format.h"
+#include "io_import_cache.h"
 #include "io_reader.h"
 #include "io_writer.h"
 #include "property.h"
@@ -67,6 +68,10 @@ public:
     };
     bool importInDocument(const Args_ImportInDocument& args);
 
+    // Cache of translated documents used by importInDocument(), null by default
+    ImportCache* importCache() const { return m_importCache.get(); }
+    void setImportCache(std::unique_ptr<ImportCache> cache);
+
     // Export service
 
     struct Args_ExportApplicationItems {
@@ -126,14 +131,17 @@ private:
     std::vector<Format> m_vecWriterFormat;
     std::vector<std::unique_ptr<FactoryReader>> m_vecFactoryReader;
     std::vector<std::unique_ptr<FactoryWriter>> m_vecFactoryWriter;
+    std::unique_ptr<ImportCache> m_importCache;
 };
 
 // Predefined
 Format probeFormat_STEP(const System::FormatProbeInput& input);
 Format probeFormat_IGES(const System::FormatProbeInput& input);
 Format probeFormat_OCCBREP(const System::FormatProbeInput& input);
+Format probeFormat_OCCBREP_BIN(const System::FormatProbeInput& input);
 Format probeFormat_STL(const System::FormatProbeInput& input);
 Format probeFormat_OBJ(const System::FormatProbeInput& input);
+Format probeFormat_MAYODOC(const System::FormatProbeInput& input);
 void addPredefinedFormatProbes(System* system);
 
 } // namespace IO
@@ -0,0 +1,45 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "span.h"
+#include <TDF_Label.hxx>
+#include <TopoDS_Shape.hxx>
+#include <vector>
+
+namespace Mayo {
+
+class TaskProgress;
+
+// Geometry translated for a part label, not yet assigned to the document
+struct LazyShape {
+    TDF_Label label;
+    TopoDS_Shape shape; // Null if translation failed
+};
+
+// Provides the geometry of XCAF part labels left empty at import, so it can be translated later
+// and only for the parts actually needed(see Document::loadLazyShapes())
+// Loading is split in two steps:
+//     - translate() doesn't modify the document, it may be called concurrently from several tasks
+//     - assign() modifies the document, it's called by Document::assignLazyShapes() only
+class LazyShapeLoader {
+public:
+    virtual ~LazyShapeLoader() = default;
+
+    // Whether geometry of 'partLabel' still has to be loaded
+    virtual bool isPending(const TDF_Label& partLabel) const = 0;
+
+    // Translates the shapes of the pending labels in 'spanPartLabel', these labels are no longer
+    // pending on return(unless translation is aborted)
+    // Labels not pending are ignored
+    virtual std::vector<LazyShape> translate(Span<const TDF_Label> spanPartLabel, TaskProgress* progress) = 0;
+
+    // Assigns to its label a shape previously returned by translate()
+    virtual void assign(const LazyShape& lazyShape) = 0;
+};
+
+} // namespace Mayo
@@ -5,8 +5,17 @@
 ****************************************************************************/
 
 #include "mesh_utils.h"
+#include "occ_mapped_file_system.h"
+
+#include <BRep_Tool.hxx>
+#include <OSD_Parallel.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <TopTools_MapOfShape.hxx>
 #include <QtCore/QtGlobal>
+#include <atomic>
 #include <cmath>
+#include <vector>
 
 namespace Mayo {
 
@@ -63,6 +72,61 @@ double MeshUtils::triangulationArea(const Handle_Poly_Triangulation& triangulati
     return area;
 }
 
+int MeshUtils::loadDeferredTriangulations(const TopoDS_Shape& shape)
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    std::vector<Handle_Poly_Triangulation> vecTriangulation;
+    TopTools_MapOfShape mapFace;
+    for (TopExp_Explorer expl(shape, TopAbs_FACE); expl.More(); expl.Next()) {
+        // Faces shared by several instances are visited once
+        if (!mapFace.Add(expl.Current().Located(TopLoc_Location())))
+            continue;
+
+        TopLoc_Location loc;
+        const Handle_Poly_Triangulation& triangulation =
+                BRep_Tool::Triangulation(TopoDS::Face(expl.Current()), loc);
+        if (!triangulation.IsNull() && triangulation->HasDeferredData() && !triangulation->HasGeometry())
+            vecTriangulation.push_back(triangulation);
+    }
+
+    if (vecTriangulation.empty())
+        return 0;
+
+    // Deferred data of the triangulations usually lies in the same file, which is mapped once
+    Handle_OSD_FileSystem fileSystem = new OccMappedFileSystem;
+    std::atomic<int> loadedCount(0);
+    OSD_Parallel::For(0, int(vecTriangulation.size()), [&](int i) {
+        const Handle_Poly_Triangulation& triangulation = vecTriangulation.at(i);
+        // Fallback on the default file system, eg when the file can't be mapped
+        if (triangulation->LoadDeferredData(fileSystem) || triangulation->LoadDeferredData())
+            ++loadedCount;
+    });
+
+    return loadedCount;
+#else
+    Q_UNUSED(shape);
+    return 0;
+#endif
+}
+
+bool MeshUtils::hasDeferredTriangulations(const TopoDS_Shape& shape)
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    for (TopExp_Explorer expl(shape, TopAbs_FACE); expl.More(); expl.Next()) {
+        TopLoc_Location loc;
+        const Handle_Poly_Triangulation& triangulation =
+                BRep_Tool::Triangulation(TopoDS::Face(expl.Current()), loc);
+        if (!triangulation.IsNull() && triangulation->HasDeferredData() && !triangulation->HasGeometry())
+            return true;
+    }
+
+    return false;
+#else
+    Q_UNUSED(shape);
+    return false;
+#endif
+}
+
 // Adapted from http://cs.smith.edu/~jorourke/Code/polyorient.C
 MeshUtils::Orientation MeshUtils::orientation(const AdaptorPolyline2d& polyline)
 {
@@ -8,6 +8,7 @@
 
 #include <Poly_Triangulation.hxx>
 class gp_XYZ;
+class TopoDS_Shape;
 
 namespace Mayo {
 
@@ -18,6 +19,15 @@ struct MeshUtils {
     static double triangulationVolume(const Handle_Poly_Triangulation& triangulation);
     static double triangulationArea(const Handle_Poly_Triangulation& triangulation);
 
+    // Loads in parallel the face triangulations of 'shape' whose data loading was deferred by the
+    // reader(see Poly_Triangulation::HasDeferredData()), returns the count of loaded triangulations
+    // Does nothing with OpenCascade < v7.6.0
+    static int loadDeferredTriangulations(const TopoDS_Shape& shape);
+
+    // Whether some face triangulation of 'shape' has its data loading still deferred(cheap, no
+    // data is loaded). Always false with OpenCascade < v7.6.0
+    static bool hasDeferredTriangulations(const TopoDS_Shape& shape);
+
     enum class Orientation {
         Unknown,
         Clockwise,
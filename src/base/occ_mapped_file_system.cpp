@@ -0,0 +1,178 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "occ_mapped_file_system.h"
+
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+#include <OSD_StreamBuffer.hxx>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <streambuf>
+
+namespace Mayo {
+
+namespace {
+
+QString toFilePath(const TCollection_AsciiString& url)
+{
+    return QFileInfo(QString::fromUtf8(url.ToCString())).absoluteFilePath();
+}
+
+} // namespace
+
+struct OccMappedFileSystem::MappedFile {
+    QFile file;
+    char* data = nullptr;
+    int64_t size = 0;
+};
+
+// Read-only stream buffer whose get area is the whole mapped file, so reads and seeks never call
+// underflow()
+class OccMappedFileSystem::StreamBuffer : public std::streambuf {
+public:
+    StreamBuffer(std::shared_ptr<MappedFile> mappedFile, int64_t offset)
+        : m_mappedFile(std::move(mappedFile))
+    {
+        char* begin = m_mappedFile->data;
+        this->setg(begin, begin + offset, begin + m_mappedFile->size);
+    }
+
+protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override
+    {
+        if (!(which & std::ios_base::in))
+            return pos_type(off_type(-1));
+
+        char* base = this->eback();
+        if (dir == std::ios_base::cur)
+            base = this->gptr();
+        else if (dir == std::ios_base::end)
+            base = this->egptr();
+
+        char* ptr = base + off;
+        if (ptr < this->eback() || ptr > this->egptr())
+            return pos_type(off_type(-1));
+
+        this->setg(this->eback(), ptr, this->egptr());
+        return pos_type(off_type(ptr - this->eback()));
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override
+    {
+        return this->seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+
+private:
+    std::shared_ptr<MappedFile> m_mappedFile;
+};
+
+OccMappedFileSystem::OccMappedFileSystem(FileScope scope)
+    : m_fileScope(scope)
+{
+}
+
+OccMappedFileSystem::OccMappedFileSystem(const QStringList& filepaths)
+    : m_fileScope(FileScope::AddedFiles)
+{
+    for (const QString& filepath : filepaths)
+        this->addFile(filepath);
+}
+
+OccMappedFileSystem::~OccMappedFileSystem()
+{
+}
+
+void OccMappedFileSystem::addFile(const QString& filepath)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_mapAddedFileCount[QFileInfo(filepath).absoluteFilePath().toStdString()];
+}
+
+void OccMappedFileSystem::removeFile(const QString& filepath)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const std::string key = QFileInfo(filepath).absoluteFilePath().toStdString();
+    auto it = m_mapAddedFileCount.find(key);
+    if (it == m_mapAddedFileCount.end())
+        return;
+
+    if (--(it->second) <= 0) {
+        m_mapAddedFileCount.erase(it);
+        m_mapFile.erase(key);
+    }
+}
+
+bool OccMappedFileSystem::IsSupportedPath(const TCollection_AsciiString& url) const
+{
+    const QString filepath = toFilePath(url);
+    if (m_fileScope == FileScope::AddedFiles) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_mapAddedFileCount.find(filepath.toStdString()) != m_mapAddedFileCount.cend();
+    }
+
+    return QFileInfo(filepath).isFile();
+}
+
+bool OccMappedFileSystem::IsOpenIStream(const std::shared_ptr<std::istream>& stream) const
+{
+    auto streamHolder = std::dynamic_pointer_cast<OSD_IStreamBuffer>(stream);
+    return streamHolder && dynamic_cast<const StreamBuffer*>(streamHolder->rdbuf()) != nullptr;
+}
+
+bool OccMappedFileSystem::IsOpenOStream(const std::shared_ptr<std::ostream>&) const
+{
+    return false;
+}
+
+std::shared_ptr<std::streambuf> OccMappedFileSystem::OpenStreamBuffer(
+        const TCollection_AsciiString& url,
+        const std::ios_base::openmode mode,
+        const int64_t offset,
+        int64_t* ptrOutBufferSize)
+{
+    if ((mode & std::ios_base::out) || !(mode & std::ios_base::in))
+        return {};
+
+    std::shared_ptr<MappedFile> mappedFile = this->mappedFile(toFilePath(url));
+    if (!mappedFile || offset < 0 || offset > mappedFile->size)
+        return {};
+
+    if (ptrOutBufferSize)
+        *ptrOutBufferSize = mappedFile->size - offset;
+
+    return std::make_shared<StreamBuffer>(std::move(mappedFile), offset);
+}
+
+std::shared_ptr<OccMappedFileSystem::MappedFile> OccMappedFileSystem::mappedFile(const QString& filepath)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const std::string key = filepath.toStdString();
+    auto it = m_mapFile.find(key);
+    if (it != m_mapFile.end())
+        return it->second;
+
+    auto mappedFile = std::make_shared<MappedFile>();
+    mappedFile->file.setFileName(filepath);
+    if (!mappedFile->file.open(QIODevice::ReadOnly))
+        return {};
+
+    mappedFile->size = mappedFile->file.size();
+    if (mappedFile->size > 0) {
+        uchar* data = mappedFile->file.map(0, mappedFile->size);
+        if (!data)
+            return {};
+
+        mappedFile->data = reinterpret_cast<char*>(data);
+    }
+
+    // File is kept open, mapping stays valid until the QFile is destroyed
+    m_mapFile.emplace(key, mappedFile);
+    return mappedFile;
+}
+
+} // namespace Mayo
+
+#endif
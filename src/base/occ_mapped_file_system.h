@@ -0,0 +1,78 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "tkernel_utils.h"
+
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+#include <OSD_FileSystem.hxx>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace Mayo {
+
+// OpenCascade file system providing read-only streams over memory-mapped files
+//
+// Each file is mapped once and shared by all the streams opened on it, whatever their offset. Data
+// read from streams is copied straight from the mapped pages, so there is no intermediate buffer
+// and the file contents are never duplicated in process memory. Mappings are released when the
+// file system is destroyed
+//
+// Opening streams and adding/removing files is thread-safe, but each stream must be used by a
+// single thread at a time
+class OccMappedFileSystem : public OSD_FileSystem {
+public:
+    enum class FileScope {
+        AnyFile,
+        // Only files added with addFile() are supported, this allows to register the file system
+        // as a preferred default protocol without affecting other files
+        AddedFiles
+    };
+
+    OccMappedFileSystem(FileScope scope = FileScope::AnyFile);
+    // Supports only 'filepaths'(scope is FileScope::AddedFiles)
+    OccMappedFileSystem(const QStringList& filepaths);
+    ~OccMappedFileSystem();
+
+    // A file can be added several times(eg concurrent reads), it's no longer supported and its
+    // mapping is released once removed as many times. Streams already opened remain valid
+    void addFile(const QString& filepath);
+    void removeFile(const QString& filepath);
+
+    bool IsSupportedPath(const TCollection_AsciiString& url) const override;
+    bool IsOpenIStream(const std::shared_ptr<std::istream>& stream) const override;
+    bool IsOpenOStream(const std::shared_ptr<std::ostream>& stream) const override;
+
+    // Only input modes are supported, null is returned otherwise
+    std::shared_ptr<std::streambuf> OpenStreamBuffer(
+            const TCollection_AsciiString& url,
+            const std::ios_base::openmode mode,
+            const int64_t offset = 0,
+            int64_t* ptrOutBufferSize = nullptr) override;
+
+    DEFINE_STANDARD_RTTI_INLINE(OccMappedFileSystem, OSD_FileSystem)
+
+private:
+    struct MappedFile;
+    class StreamBuffer;
+
+    std::shared_ptr<MappedFile> mappedFile(const QString& filepath);
+
+    FileScope m_fileScope = FileScope::AnyFile;
+    std::unordered_map<std::string, int> m_mapAddedFileCount;
+    std::unordered_map<std::string, std::shared_ptr<MappedFile>> m_mapFile;
+    mutable std::mutex m_mutex;
+};
+
+DEFINE_STANDARD_HANDLE(OccMappedFileSystem, OSD_FileSystem)
+
+} // namespace Mayo
+
+#endif
@@ -32,6 +32,7 @@ struct Settings_Group {
     QString overridenTitle;
     std::vector<Settings_Section> vecSection;
     std::vector<Settings::GroupResetFunction> vecFnReset;
+    Settings::GroupInitFunction fnInit; // Null once the group is initialized
 };
 
 static bool isValidIdentifier(const QByteArray& identifier)
@@ -63,6 +64,35 @@ public:
         return this->sectionPath(this->group(index.group()), this->section(index));
     }
 
+    void loadGroup(const Settings_Group& group) {
+        for (const Settings_Section& section : group.vecSection) {
+            const QString sectionPath = this->sectionPath(group, section);
+            for (const Settings_Setting& setting : section.vecSetting)
+                this->loadProperty(sectionPath, setting.property);
+        }
+    }
+
+    void resetGroup(const Settings_Group& group) {
+        for (const Settings::GroupResetFunction& fnReset : group.vecFnReset)
+            fnReset();
+    }
+
+    // Note: group initialization isn't thread-safe, it has to happen in the thread of the Settings
+    // object(ie GUI thread) before any other thread may access the group
+    void initGroup(Settings::GroupIndex index) {
+        Settings_Group& group = this->group(index);
+        if (!group.fnInit)
+            return;
+
+        const Settings::GroupInitFunction fnInit = std::move(group.fnInit);
+        group.fnInit = nullptr;
+        fnInit();
+        // 'group' reference might be invalidated if fnInit() created new groups
+        this->resetGroup(this->group(index));
+        if (m_isLoaded)
+            this->loadGroup(this->group(index));
+    }
+
     void loadProperty(const QString& sectionPath, Property* property) {
         if (!property)
             return;
@@ -78,6 +108,7 @@ public:
     QSettings m_settings;
     QLocale m_locale;
     std::vector<Settings_Group> m_vecGroup;
+    bool m_isLoaded = false;
 };
 
 Settings::Settings(QObject* parent)
@@ -93,13 +124,13 @@ Settings::~Settings()
 
 void Settings::load()
 {
+    // Uninitialized groups are loaded later, in Private::initGroup()
     for (const Settings_Group& group : d->m_vecGroup) {
-        for (const Settings_Section& section : group.vecSection) {
-            const QString sectionPath = d->sectionPath(group, section);
-            for (const Settings_Setting& setting : section.vecSetting)
-                d->loadProperty(sectionPath, setting.property);
-        }
+        if (!group.fnInit)
+            d->loadGroup(group);
     }
+
+    d->m_isLoaded = true;
 }
 
 void Settings::loadProperty(Settings::SettingIndex index)
@@ -114,6 +145,9 @@ void Settings::loadProperty(Settings::SettingIndex index)
 void Settings::save()
 {
     for (const Settings_Group& group : d->m_vecGroup) {
+        if (group.fnInit)
+            continue; // Group never accessed, keep stored values as is
+
         for (const Settings_Section& section : group.vecSection) {
             const QString sectionPath = d->sectionPath(group, section);
             for (const Settings_Setting& setting : section.vecSetting) {
@@ -182,8 +216,24 @@ void Settings::addGroupResetFunction(GroupIndex index, GroupResetFunction fn)
         d->group(index).vecFnReset.push_back(std::move(fn));
 }
 
+void Settings::setGroupInitFunction(GroupIndex index, GroupInitFunction fn)
+{
+    d->group(index).fnInit = std::move(fn);
+}
+
+bool Settings::isGroupInitialized(GroupIndex index) const
+{
+    return !d->group(index).fnInit;
+}
+
+void Settings::initGroup(GroupIndex index)
+{
+    d->initGroup(index);
+}
+
 int Settings::sectionCount(GroupIndex index) const
 {
+    d->initGroup(index);
     return int(d->group(index).vecSection.size());
 }
 
@@ -292,15 +342,16 @@ Settings::SettingIndex Settings::addSetting(Property* property, SectionIndex ind
 
 void Settings::resetGroup(GroupIndex index)
 {
-    Settings_Group& group = d->group(index);
-    for (const GroupResetFunction& fnReset : group.vecFnReset)
-        fnReset();
+    d->initGroup(index);
+    d->resetGroup(d->group(index));
 }
 
 void Settings::resetAll()
 {
-    for (Settings_Group& group : d->m_vecGroup)
-        this->resetGroup(GroupIndex(&group - &d->m_vecGroup.front()));
+    for (const Settings_Group& group : d->m_vecGroup) {
+        if (!group.fnInit)
+            d->resetGroup(group);
+    }
 }
 
 QByteArray Settings::defautLocaleLanguageCode()
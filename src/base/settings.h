@@ -24,6 +24,7 @@ public:
     using SectionIndex = Settings_SectionIndex;
     using SettingIndex = Settings_SettingIndex;
     using GroupResetFunction = std::function<void()>;
+    using GroupInitFunction = std::function<void()>;
 
     Settings(QObject* parent = nullptr);
     ~Settings();
@@ -40,6 +41,12 @@ public:
     void setGroupTitle(GroupIndex index, const QString& title);
     void addGroupResetFunction(GroupIndex index, GroupResetFunction fn);
 
+    // Defers creation of the sections/settings of a group until first access(eg sectionCount())
+    // Once 'fn' is called, the group is reset and then loaded if load() was called before
+    void setGroupInitFunction(GroupIndex index, GroupInitFunction fn);
+    bool isGroupInitialized(GroupIndex index) const;
+    void initGroup(GroupIndex index);
+
     int sectionCount(GroupIndex index) const;
     QByteArray sectionIdentifier(SectionIndex index) const;
     QString sectionTitle(SectionIndex index) const;
@@ -55,6 +62,7 @@ public:
     SettingIndex addSetting(Property* property, SectionIndex index);
 
     void resetGroup(GroupIndex index);
+    // Resets initialized groups only, other ones are reset on initialization anyway
     void resetAll();
 
     // Helpers
@@ -0,0 +1,68 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "shape_hlr.h"
+
+#include <BRep_Builder.hxx>
+#include <HLRAlgo_Projector.hxx>
+#include <HLRBRep_PolyAlgo.hxx>
+#include <HLRBRep_PolyHLRToShape.hxx>
+#include <TopoDS_Compound.hxx>
+#include <initializer_list>
+
+namespace Mayo {
+
+namespace {
+
+TopoDS_Shape makeCompound(std::initializer_list<TopoDS_Shape> listShape, const TopLoc_Location& loc)
+{
+    TopoDS_Compound comp;
+    BRep_Builder builder;
+    bool isEmpty = true;
+    for (const TopoDS_Shape& shape : listShape) {
+        if (shape.IsNull())
+            continue;
+
+        if (isEmpty)
+            builder.MakeCompound(comp);
+
+        builder.Add(comp, shape);
+        isEmpty = false;
+    }
+
+    return isEmpty ? TopoDS_Shape() : comp.Moved(loc);
+}
+
+} // namespace
+
+ShapeHlr ShapeHlr::compute(const TopoDS_Shape& shape, const gp_Ax2& viewAxes, double focus)
+{
+    ShapeHlr hlr;
+    if (shape.IsNull())
+        return hlr;
+
+    const HLRAlgo_Projector projector =
+            focus > 0. ? HLRAlgo_Projector(viewAxes, focus) : HLRAlgo_Projector(viewAxes);
+    Handle_HLRBRep_PolyAlgo algo = new HLRBRep_PolyAlgo;
+    algo->Load(shape);
+    algo->Projector(projector);
+    algo->Update();
+
+    HLRBRep_PolyHLRToShape toShape;
+    toShape.Update(algo);
+
+    // Edges are built in the projection plane, expressed in the coordinate system of the projector
+    const TopLoc_Location locToGlobal(projector.Transformation().Inverted());
+    hlr.visibleEdges = makeCompound(
+                { toShape.VCompound(), toShape.Rg1LineVCompound(), toShape.OutLineVCompound() },
+                locToGlobal);
+    hlr.hiddenEdges = makeCompound(
+                { toShape.HCompound(), toShape.OutLineHCompound() },
+                locToGlobal);
+    return hlr;
+}
+
+} // namespace Mayo
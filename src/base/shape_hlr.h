@@ -0,0 +1,29 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include <gp_Ax2.hxx>
+#include <TopoDS_Shape.hxx>
+
+namespace Mayo {
+
+// Hidden-line removal of a shape, for an orthographic or perspective projection
+// Computation is based on the triangulation of the shape(polygonal algorithm), faces without
+// triangulation are ignored
+struct ShapeHlr {
+    // Compounds of edges lying in the projection plane, null if empty
+    // Edges are expressed in the global coordinate system, so they can be displayed as is
+    TopoDS_Shape visibleEdges; // Sharp, smooth and outline edges
+    TopoDS_Shape hiddenEdges; // Sharp and outline edges
+
+    // Projection plane is defined by 'viewAxes': main direction points towards the viewer
+    // Projection is perspective if 'focus' > 0, the eye being then located on the main direction at
+    // distance 'focus' from the projection plane. Shape must be entirely in front of the eye
+    static ShapeHlr compute(const TopoDS_Shape& shape, const gp_Ax2& viewAxes, double focus = 0.);
+};
+
+} // namespace Mayo
@@ -0,0 +1,124 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "shape_section.h"
+
+#include "brep_utils.h"
+
+#include <BRepAlgoAPI_Common.hxx>
+#include <BRepBndLib.hxx>
+#include <BRepBuilderAPI_MakeFace.hxx>
+#include <BRepGProp.hxx>
+#include <Bnd_Box.hxx>
+#include <ElSLib.hxx>
+#include <GProp_GProps.hxx>
+#include <TopExp_Explorer.hxx>
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+namespace Mayo {
+
+ShapeSection ShapeSection::compute(const TopoDS_Shape& solid, const gp_Pln& plane)
+{
+    ShapeSection section;
+    Bnd_Box bndBox;
+    BRepBndLib::Add(solid, bndBox);
+    if (bndBox.IsVoid() || bndBox.IsOut(plane))
+        return section;
+
+    // Planar face large enough to cross the whole shape, then keep the parts inside the solid
+    const double halfSize = std::sqrt(bndBox.SquareExtent());
+    const gp_Pnt bndCenter((bndBox.CornerMin().XYZ() + bndBox.CornerMax().XYZ()) / 2.);
+    double u, v;
+    ElSLib::Parameters(plane, bndCenter, u, v);
+    const TopoDS_Face face = BRepBuilderAPI_MakeFace(
+                plane, u - halfSize, u + halfSize, v - halfSize, v + halfSize);
+    BRepAlgoAPI_Common common(solid, face);
+    if (!common.IsDone())
+        return section;
+
+    const TopoDS_Shape& shapeCommon = common.Shape();
+    if (!TopExp_Explorer(shapeCommon, TopAbs_FACE).More())
+        return section;
+
+    GProp_GProps props;
+    BRepGProp::SurfaceProperties(shapeCommon, props);
+    section.faces = shapeCommon;
+    section.area = props.Mass();
+    return section;
+}
+
+ShapeSectionCache::ShapeSectionCache(size_t maxEntryCount)
+    : m_maxEntryCount(maxEntryCount)
+{
+}
+
+ShapeSection ShapeSectionCache::get(const TopoDS_Shape& solid, const gp_Pln& plane)
+{
+    const Key key = ShapeSectionCache::makeKey(solid, plane);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto itFound = m_mapEntry.find(key);
+        if (itFound != m_mapEntry.end()) {
+            m_listEntry.splice(m_listEntry.begin(), m_listEntry, itFound->second);
+            return itFound->second->section;
+        }
+    }
+
+    // Computed without holding the lock, concurrent requests for the same key might compute the
+    // section twice but that's harmless
+    const ShapeSection section = ShapeSection::compute(solid, plane);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_mapEntry.find(key) == m_mapEntry.end()) {
+        m_listEntry.push_front({ key, section });
+        m_mapEntry.insert({ key, m_listEntry.begin() });
+        while (m_listEntry.size() > m_maxEntryCount) {
+            m_mapEntry.erase(m_listEntry.back().key);
+            m_listEntry.pop_back();
+        }
+    }
+
+    return section;
+}
+
+size_t ShapeSectionCache::entryCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_listEntry.size();
+}
+
+void ShapeSectionCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_mapEntry.clear();
+    m_listEntry.clear();
+}
+
+bool ShapeSectionCache::Key::operator==(const Key& other) const
+{
+    return this->shape.IsSame(other.shape)
+            && std::memcmp(this->planeCoeffs, other.planeCoeffs, sizeof(this->planeCoeffs)) == 0;
+}
+
+size_t ShapeSectionCache::KeyHasher::operator()(const Key& key) const
+{
+    size_t hash = std::hash<int>()(BRepUtils::hashCode(key.shape));
+    for (double coeff : key.planeCoeffs)
+        hash ^= std::hash<double>()(coeff) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+
+    return hash;
+}
+
+ShapeSectionCache::Key ShapeSectionCache::makeKey(const TopoDS_Shape& solid, const gp_Pln& plane)
+{
+    Key key;
+    key.shape = solid;
+    plane.Coefficients(key.planeCoeffs[0], key.planeCoeffs[1], key.planeCoeffs[2], key.planeCoeffs[3]);
+    return key;
+}
+
+} // namespace Mayo
@@ -0,0 +1,62 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include <gp_Pln.hxx>
+#include <TopoDS_Shape.hxx>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace Mayo {
+
+// Exact planar section of a solid shape
+struct ShapeSection {
+    TopoDS_Shape faces; // Compound of section faces, null if plane doesn't cross the shape
+    double area = 0.; // Total area of section faces, in squared millimeters
+
+    static ShapeSection compute(const TopoDS_Shape& solid, const gp_Pln& plane);
+};
+
+// Provides cached ShapeSection objects, keyed by shape and plane
+// Least recently used entries are discarded once maximum entry count is reached
+// Thread-safe: get() can be called concurrently, sections are computed out of the lock
+class ShapeSectionCache {
+public:
+    ShapeSectionCache(size_t maxEntryCount = 4096);
+
+    ShapeSection get(const TopoDS_Shape& solid, const gp_Pln& plane);
+
+    size_t entryCount() const;
+    void clear();
+
+private:
+    struct Key {
+        TopoDS_Shape shape;
+        double planeCoeffs[4];
+        bool operator==(const Key& other) const;
+    };
+
+    struct KeyHasher {
+        size_t operator()(const Key& key) const;
+    };
+
+    struct Entry {
+        Key key;
+        ShapeSection section;
+    };
+    using ListEntry = std::list<Entry>;
+
+    static Key makeKey(const TopoDS_Shape& solid, const gp_Pln& plane);
+
+    mutable std::mutex m_mutex;
+    size_t m_maxEntryCount = 0;
+    ListEntry m_listEntry; // Front is the most recently used entry
+    std::unordered_map<Key, ListEntry::iterator, KeyHasher> m_mapEntry;
+};
+
+} // namespace Mayo
@@ -7,13 +7,12 @@
 #include "graphics_entity_driver.h"
 
 #include "../base/document.h"
-#include "../base/brep_utils.h"
 #include "../base/caf_utils.h"
 #include "graphics_entity_base_property_group.h"
 #include "graphics_mesh_data_source.h"
 #include "graphics_scene.h"
+#include "graphics_shape_object.h"
 
-#include <AIS_ColoredShape.hxx>
 #include <AIS_DisplayMode.hxx>
 #include <BRep_TFace.hxx>
 #include <MeshVS_DisplayModeFlags.hxx>
@@ -25,6 +24,8 @@
 #include <V3d_View.hxx>
 #include <V3d_Viewer.hxx>
 #include <TDataXtd_Triangulation.hxx>
+#include <TDF_LabelMap.hxx>
+#include <XCAFDoc_ColorTool.hxx>
 #include <XCAFPrs_AISObject.hxx>
 #include <XSDRAWSTLVRML_DataSource.hxx>
 #include <stdexcept>
@@ -33,6 +34,18 @@ namespace Mayo {
 
 namespace { struct GraphicsEntityDriverI18N { MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::GraphicsEntityDriver) }; }
 
+void GraphicsEntityDriver::handleShapesChanged(const GraphicsEntity& entity) const
+{
+    this->throwIf_differentDriver(entity);
+    const Handle_AIS_InteractiveObject& gfx = entity.aisObject();
+    if (gfx.IsNull() || !entity.graphicsScene())
+        return;
+
+    gfx->SetToUpdate(); // Presentations of all display modes
+    entity.graphicsScene()->recomputeObjectPresentation(gfx);
+    entity.graphicsScene()->redraw();
+}
+
 void GraphicsEntityDriver::throwIf_invalidDisplayMode(Enumeration::Value mode) const
 {
     if (this->displayModes().findIndex(mode) == -1)
@@ -89,7 +102,7 @@ GraphicsEntity GraphicsShapeEntityDriver::createEntity(const TDF_Label& label) c
     GraphicsEntity entity;
     this->initEntity(&entity, label);
     if (XCaf::isShape(label)) {
-        Handle_XCAFPrs_AISObject gpx = new XCAFPrs_AISObject(label);
+        Handle_XCAFPrs_AISObject gpx = new GraphicsShapeObject(label);
         gpx->SetDisplayMode(AIS_Shaded);
         gpx->Attributes()->SetFaceBoundaryDraw(true);
         gpx->Attributes()->SetFaceBoundaryAspect(
@@ -107,33 +120,29 @@ void GraphicsShapeEntityDriver::applyDisplayMode(GraphicsEntity* entity, Enumera
 {
     this->throwIf_differentDriver(*entity);
     this->throwIf_invalidDisplayMode(mode);
-    const GraphicsScene* gfxScene = entity->graphicsScene();
-    auto fnSetViewComputedMode = [=](bool on) {
-        V3d_ListOfViewIterator viewIter = gfxScene->v3dViewer()->DefinedViewIterator();
-        while (viewIter.More()) {
-            viewIter.Value()->SetComputedMode(on);
-            viewIter.Next();
-        }
-    };
-    if (mode == DisplayMode_HiddenLineRemoval) {
-        gfxScene->defaultPrs3dDrawer()->SetTypeOfHLR(Prs3d_TOH_PolyAlgo);
-        gfxScene->defaultPrs3dDrawer()->EnableDrawHiddenLine();
-        fnSetViewComputedMode(true);
+    GraphicsScene* gfxScene = entity->graphicsScene();
+    // Hidden-line drawings are computed in background(see GraphicsHlrPresenter), synchronous
+    // hidden-line removal of OpenCascade must stay off
+    V3d_ListOfViewIterator viewIter = gfxScene->v3dViewer()->DefinedViewIterator();
+    while (viewIter.More()) {
+        viewIter.Value()->SetComputedMode(false);
+        viewIter.Next();
     }
-    else {
-        gfxScene->defaultPrs3dDrawer()->SetTypeOfHLR(Prs3d_TOH_NotSet);
-        gfxScene->defaultPrs3dDrawer()->DisableDrawHiddenLine();
-        fnSetViewComputedMode(false);
-        const AIS_DisplayMode aisDispMode = mode == DisplayMode_Wireframe ? AIS_WireFrame : AIS_Shaded;
-        const bool showFaceBounds = mode == DisplayMode_ShadedWithFaceBoundary;
-        const Handle_AIS_InteractiveObject& aisObject = entity->aisObject();
-        if (aisObject->DisplayMode() != aisDispMode)
-            entity->setDisplayMode(aisDispMode);
-
-        if (aisObject->Attributes()->FaceBoundaryDraw() != showFaceBounds) {
-            aisObject->Attributes()->SetFaceBoundaryDraw(showFaceBounds);
-            aisObject->Redisplay(true);
-        }
+
+    gfxScene->setHiddenLineDrawingOn(mode == DisplayMode_HiddenLineRemoval);
+    // Objects are displayed shaded until their hidden-line drawing is ready
+    const AIS_DisplayMode aisDispMode = mode == DisplayMode_Wireframe ? AIS_WireFrame : AIS_Shaded;
+    const bool showFaceBounds = mode == DisplayMode_ShadedWithFaceBoundary;
+    const Handle_AIS_InteractiveObject& aisObject = entity->aisObject();
+    // Coarse shaded mode is a level of detail of shaded mode(see GraphicsLodSelector)
+    const bool isCoarseShaded =
+            aisObject->DisplayMode() == GraphicsShapeObject::DisplayMode_CoarseShaded;
+    if (aisObject->DisplayMode() != aisDispMode && !(isCoarseShaded && aisDispMode == AIS_Shaded))
+        entity->setDisplayMode(aisDispMode);
+
+    if (aisObject->Attributes()->FaceBoundaryDraw() != showFaceBounds) {
+        aisObject->Attributes()->SetFaceBoundaryDraw(showFaceBounds);
+        aisObject->Redisplay(true);
     }
 
     //entity->aisContext()->UpdateCurrentViewer();
@@ -149,7 +158,7 @@ Enumeration::Value GraphicsShapeEntityDriver::currentDisplayMode(const GraphicsE
     if (displayMode == AIS_WireFrame)
         return DisplayMode_Wireframe;
 
-    if (displayMode == AIS_Shaded) {
+    if (displayMode == AIS_Shaded || displayMode == GraphicsShapeObject::DisplayMode_CoarseShaded) {
         return entity.aisObject()->Attributes()->FaceBoundaryDraw() ?
                     DisplayMode_ShadedWithFaceBoundary :
                     DisplayMode_Shaded;
@@ -164,55 +173,83 @@ std::unique_ptr<PropertyGroupSignals> GraphicsShapeEntityDriver::properties(cons
     return std::make_unique<GraphicsEntityBasePropertyGroup>(entity);
 }
 
-void GraphicsShapeEntityDriver::handleColorChanged(
-        const GraphicsEntity& entity, const DocumentTreeNode& docTreeNode) const
+void GraphicsShapeEntityDriver::handleColorsChanged(
+        const GraphicsEntity& entity, Span<const DocumentTreeNode> spanDocTreeNode) const
 {
     this->throwIf_differentDriver(entity);
-    if (!docTreeNode.isValid())
+    auto gfx = Handle_GraphicsShapeObject::DownCast(entity.aisObject());
+    if (gfx.IsNull())
         return;
 
-    // AIS_ColoredShape is the base class of XCAFPrs_AISObject
-    auto gfx = Handle_AIS_ColoredShape::DownCast(entity.aisObject());
-    if (!gfx)
-        return;
+    DocumentPtr doc;
+    TreeNodeId entityTreeNodeId = 0;
+    TDF_LabelMap mapChangedLabel;
+    for (const DocumentTreeNode& docTreeNode : spanDocTreeNode) {
+        if (docTreeNode.isValid()) {
+            doc = docTreeNode.document();
+            entityTreeNodeId = doc->modelTree().nodeRoot(docTreeNode.id());
+            mapChangedLabel.Add(docTreeNode.label());
+        }
+    }
 
-    // Retrieve color
-    const DocumentPtr& doc = docTreeNode.document();
-    Quantity_Color color;
-    if (!doc->xcaf().colorTool()->GetColor(docTreeNode.label(), XCAFDoc_ColorSurf, color))
+    if (doc.IsNull()) {
+        entity.graphicsScene()->redraw();
         return;
+    }
 
-    // Helper function
-    auto fnChangeColor = [=](const TopoDS_Shape& shape){
-        gfx->SetCustomColor(shape, color);
-        gfx->SynchronizeAspects();
-        entity.graphicsScene()->redraw();
+    // New color of a label applies to all its occurrences in the entity, except the ones whose
+    // component has its own color as it replaces the color of the referred shape(see
+    // XCAFPrs::CollectStyleSettings())
+    GraphicsShapeObject::MapShapeColor mapShapeColor;
+    bool isRecomputeNeeded = false;
+    const Tree<TDF_Label>& modelTree = doc->modelTree();
+    const Handle_XCAFDoc_ColorTool colorTool = doc->xcaf().colorTool();
+    auto fnHasOwnColor = [&](const TDF_Label& label) {
+        return colorTool->IsSet(label, XCAFDoc_ColorSurf) || colorTool->IsSet(label, XCAFDoc_ColorGen);
     };
+    deepForeachTreeNode(entityTreeNodeId, modelTree, [&](TreeNodeId nodeId) {
+        const TDF_Label& label = modelTree.nodeData(nodeId);
+        if (isRecomputeNeeded || !mapChangedLabel.Contains(label))
+            return;
 
-    // Retrieve shape
-    const TopLoc_Location shapeLoc = doc->xcaf().shapeAbsoluteLocation(docTreeNode.id());
-    const TopoDS_Shape shape = XCaf::shape(docTreeNode.label()).Located(shapeLoc);
+        const TreeNodeId parentNodeId = modelTree.nodeParent(nodeId);
+        const TDF_Label parentLabel = parentNodeId != 0 ? modelTree.nodeData(parentNodeId) : TDF_Label();
+        if (!XCaf::isShapeReference(label) && XCaf::isShapeReference(parentLabel) && fnHasOwnColor(parentLabel))
+            return;
 
-    // Maybe the shape has "direct" custom aspects
-    if (gfx->CustomAspectsMap().IsBound(shape)) {
-        fnChangeColor(shape);
-        return;
-    }
+        // Color removed, the occurrence gets the style of some other shape
+        Quantity_Color color;
+        if (!colorTool->GetColor(label, XCAFDoc_ColorSurf, color)) {
+            isRecomputeNeeded = true;
+            return;
+        }
 
-    // If not then it has "shared" custom aspects with others in a TopoDS_Compound
-    for (AIS_DataMapOfShapeDrawer::Iterator it(gfx->CustomAspectsMap()); it.More(); it.Next()) {
-        const TopoDS_Shape& baseShape = it.Key();
-        bool exitRequested = false;
-        BRepUtils::forEachSubShape(baseShape, TopAbs_SOLID, [&](const TopoDS_Shape& subShape) {
-            if (!exitRequested && subShape.IsSame(shape)) {
-                fnChangeColor(baseShape);
-                exitRequested = true;
-            }
-        });
+        const TopLoc_Location locParent =
+                parentNodeId != 0 ? doc->xcaf().shapeAbsoluteLocation(parentNodeId) : TopLoc_Location();
+        const TopoDS_Shape shape = XCaf::shape(label).Moved(locParent);
+        if (!mapShapeColor.Bind(shape, color))
+            mapShapeColor.ChangeFind(shape) = color;
+    });
 
-        if (exitRequested)
-            return;
+    // Aspects of existing primitive groups are updated if possible, otherwise styles are dispatched
+    // again and the whole object is recomputed
+    if (isRecomputeNeeded || !gfx->updateColorsInPlace(mapShapeColor)) {
+        gfx->invalidateStyles();
+        gfx->SetToUpdate(); // Presentations of all display modes(eg coarse shaded)
+        entity.graphicsScene()->recomputeObjectPresentation(gfx);
     }
+
+    entity.graphicsScene()->redraw();
+}
+
+void GraphicsShapeEntityDriver::handleShapesChanged(const GraphicsEntity& entity) const
+{
+    this->throwIf_differentDriver(entity);
+    auto gfx = Handle_GraphicsShapeObject::DownCast(entity.aisObject());
+    if (!gfx.IsNull())
+        gfx->invalidateShape();
+
+    GraphicsEntityDriver::handleShapesChanged(entity);
 }
 
 GraphicsMeshEntityDriver::GraphicsMeshEntityDriver()
@@ -8,6 +8,7 @@
 
 #include "graphics_entity.h"
 #include "../base/property_enumeration.h"
+#include "../base/span.h"
 #include <QtCore/QCoreApplication>
 #include <memory>
 
@@ -34,7 +35,13 @@ public:
 
     virtual std::unique_ptr<PropertyGroupSignals> properties(const GraphicsEntity& entity) const = 0;
 
-    virtual void handleColorChanged(const GraphicsEntity& entity, const DocumentTreeNode& docTreeNode) const {}
+    // Colors of tree nodes belonging to 'entity' changed, all changes of a batch are handled at once
+    virtual void handleColorsChanged(
+            const GraphicsEntity& entity, Span<const DocumentTreeNode> spanDocTreeNode) const {}
+
+    // Shapes of 'entity' changed(eg geometry loaded on demand), graphics object is kept but its
+    // presentations have to be recomputed
+    virtual void handleShapesChanged(const GraphicsEntity& entity) const;
 
 protected:
     void setDisplayModes(const Enumeration& enumeration) { m_enumDisplayModes = enumeration; }
@@ -58,7 +65,9 @@ public:
     void applyDisplayMode(GraphicsEntity* entity, Enumeration::Value mode) const override;
     Enumeration::Value currentDisplayMode(const GraphicsEntity& entity) const override;
     std::unique_ptr<PropertyGroupSignals> properties(const GraphicsEntity& entity) const override;
-    void handleColorChanged(const GraphicsEntity& entity, const DocumentTreeNode& docTreeNode) const override;
+    void handleColorsChanged(
+            const GraphicsEntity& entity, Span<const DocumentTreeNode> spanDocTreeNode) const override;
+    void handleShapesChanged(const GraphicsEntity& entity) const override;
 
 protected:
     enum DisplayMode {
@@ -0,0 +1,416 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "graphics_hlr_presenter.h"
+
+#include "../base/mesh_utils.h"
+#include "graphics_scene.h"
+#include "graphics_utils.h"
+
+#include <AIS_Shape.hxx>
+#include <Bnd_Box.hxx>
+#include <BRep_Builder.hxx>
+#include <BRepBuilderAPI_Copy.hxx>
+#include <BRepMesh_IncrementalMesh.hxx>
+#include <gp.hxx>
+#include <OSD_Parallel.hxx>
+#include <Precision.hxx>
+#include <Prs3d_LineAspect.hxx>
+#include <StdPrs_ToolTriangulatedShape.hxx>
+#include <TopoDS_Compound.hxx>
+#include <algorithm>
+
+namespace Mayo {
+
+// Input and output of a background computation of a hidden-line drawing
+struct GraphicsHlrPresenter::TaskData {
+    struct ShapeInput {
+        TopoDS_Shape shape;
+        // Triangulations whose loading was deferred by the reader(eg glTF) are loaded in the task
+        bool hasDeferredTriangulations = false;
+        // Shape not triangulated yet is meshed in the task with these parameters
+        bool isTessellated = false;
+        double deflection = 0.;
+        double angularDeflection = 0.;
+    };
+
+    ViewPoint viewPoint;
+    std::vector<GraphicsObjectPtr> vecObject;
+    std::vector<ShapeInput> vecShapeInput;
+    gp_Ax2 viewAxes;
+    double focus = 0.;
+    ShapeHlr hlr;
+    bool isComplete = false;
+};
+
+GraphicsHlrPresenter::GraphicsHlrPresenter(
+        GraphicsScene* scene, const Handle_V3d_View& view, QObject* parent)
+    : QObject(parent),
+      m_scene(scene),
+      m_view(view)
+{
+    // Task manager signals are emitted from worker threads, so 'ended' is a queued connection
+    QObject::connect(&m_taskMgr, &TaskManager::ended, this, &GraphicsHlrPresenter::onTaskEnded);
+}
+
+GraphicsHlrPresenter::~GraphicsHlrPresenter()
+{
+    this->abortTasks();
+    for (const auto& mapPair : m_mapTask)
+        m_taskMgr.waitForDone(mapPair.first);
+}
+
+void GraphicsHlrPresenter::addObject(const GraphicsObjectPtr& object)
+{
+    if (Handle_AIS_Shape::DownCast(object).IsNull())
+        return;
+
+    m_vecObject.push_back(object);
+    m_isDirty = true;
+}
+
+void GraphicsHlrPresenter::removeObject(const GraphicsObjectPtr& object)
+{
+    auto itFound = std::find(m_vecObject.begin(), m_vecObject.end(), object);
+    if (itFound == m_vecObject.end())
+        return;
+
+    m_vecObject.erase(itFound);
+    m_listCacheEntry.remove_if([&](const CacheEntry& entry) {
+        return std::find(entry.vecObject.cbegin(), entry.vecObject.cend(), object) != entry.vecObject.cend();
+    });
+
+    // Drawing involving the object is obsolete, other objects are displayed as usual until next
+    // call to update()
+    const bool isObjectDrawn =
+            std::find(m_vecObjectHiddenInView.cbegin(), m_vecObjectHiddenInView.cend(), object)
+            != m_vecObjectHiddenInView.cend();
+    if (isObjectDrawn)
+        this->eraseDrawings();
+
+    m_isDirty = true;
+}
+
+void GraphicsHlrPresenter::setEnabled(bool on)
+{
+    if (on == m_isEnabled)
+        return;
+
+    m_isEnabled = on;
+    if (on) {
+        // Drawings replace the synchronous hidden-line removal done by OpenCascade
+        m_view->SetComputedMode(false);
+        m_isDirty = true;
+        m_isSuspended = false;
+        this->update();
+    }
+    else {
+        this->abortTasks();
+        this->eraseDrawings();
+        m_scene->redraw();
+    }
+}
+
+void GraphicsHlrPresenter::update()
+{
+    if (!m_isEnabled)
+        return;
+
+    m_isSuspended = false;
+    const ViewPoint viewPoint = this->currentViewPoint();
+    const std::vector<GraphicsObjectPtr> vecObject = this->drawableObjects(viewPoint);
+    if (!m_isDirty
+            && m_isDrawingDisplayed
+            && viewPoint.isEqual(m_displayedViewPoint)
+            && vecObject == m_vecObjectHiddenInView)
+    {
+        return;
+    }
+
+    // Computation matching current camera and objects is on the way
+    auto itLastTask = m_mapTask.find(m_lastTaskId);
+    if (!m_isDirty
+            && itLastTask != m_mapTask.end()
+            && viewPoint.isEqual(itLastTask->second->viewPoint)
+            && vecObject == itLastTask->second->vecObject)
+    {
+        return;
+    }
+
+    m_isDirty = false;
+    this->abortTasks();
+    this->eraseDrawings();
+    if (vecObject.empty()) {
+        m_scene->redraw();
+        return;
+    }
+
+    const CacheEntry* cacheEntry = this->findCacheEntry(viewPoint, vecObject);
+    if (cacheEntry) {
+        this->displayDrawing(*cacheEntry);
+        return;
+    }
+
+    auto taskData = std::make_shared<TaskData>();
+    taskData->viewPoint = viewPoint;
+    taskData->vecObject = vecObject;
+    Bnd_Box bndBox;
+    for (const GraphicsObjectPtr& object : vecObject) {
+        // Polygonal algorithm needs triangulation. Deflection is evaluated here as it might update
+        // the attributes of the object, meshing is left to the task
+        TaskData::ShapeInput input;
+        input.shape = Handle_AIS_Shape::DownCast(object)->Shape();
+        input.hasDeferredTriangulations = MeshUtils::hasDeferredTriangulations(input.shape);
+        input.isTessellated =
+                input.hasDeferredTriangulations
+                || StdPrs_ToolTriangulatedShape::IsTessellated(input.shape, object->Attributes());
+        if (!input.isTessellated) {
+            input.deflection = StdPrs_ToolTriangulatedShape::GetDeflection(input.shape, object->Attributes());
+            input.angularDeflection = object->Attributes()->DeviationAngle();
+        }
+
+        taskData->vecShapeInput.push_back(input);
+        bndBox.Add(GraphicsUtils::AisObject_boundingBox(object));
+    }
+
+    // Projection plane crosses the middle of the objects, keeping drawing inside their bounding
+    // box helps automatic depth range of the view
+    const gp_Pnt bndCenter = bndBox.IsVoid() ?
+                gp::Origin() :
+                gp_Pnt((bndBox.CornerMin().XYZ() + bndBox.CornerMax().XYZ()) / 2.);
+    const gp_Dir viewAxis = viewPoint.viewDirection.Reversed();
+    const gp_Dir viewXDir = viewPoint.up.Crossed(viewAxis);
+    if (viewPoint.isPerspective) {
+        // Objects are in front of the eye(see drawableObjects()), so 'focus' is positive
+        const gp_Vec vecViewDir(viewPoint.viewDirection);
+        const double focus = gp_Vec(viewPoint.eye, bndCenter).Dot(vecViewDir);
+        taskData->viewAxes = gp_Ax2(viewPoint.eye.Translated(focus * vecViewDir), viewAxis, viewXDir);
+        taskData->focus = focus;
+    }
+    else {
+        taskData->viewAxes = gp_Ax2(bndCenter, viewAxis, viewXDir);
+    }
+
+    // Objects are displayed as usual until drawing is ready
+    m_scene->redraw();
+    const TaskId taskId = m_taskMgr.newTask([=](TaskProgress* progress) {
+        // Shapes not triangulated yet are copied so the triangulation of the document shapes
+        // isn't written concurrently by the shaded presentation
+        const int count = int(taskData->vecShapeInput.size());
+        OSD_Parallel::For(0, count, [=](int i) {
+            TaskData::ShapeInput& input = taskData->vecShapeInput.at(i);
+            if (progress->isAbortRequested())
+                return;
+
+            if (input.hasDeferredTriangulations) {
+                MeshUtils::loadDeferredTriangulations(input.shape);
+            }
+            else if (!input.isTessellated) {
+                input.shape = BRepBuilderAPI_Copy(input.shape, false).Shape();
+                BRepMesh_IncrementalMesh(input.shape, input.deflection, false, input.angularDeflection);
+            }
+        });
+
+        if (progress->isAbortRequested())
+            return;
+
+        TopoDS_Compound compShape;
+        BRep_Builder builder;
+        builder.MakeCompound(compShape);
+        for (const TaskData::ShapeInput& input : taskData->vecShapeInput)
+            builder.Add(compShape, input.shape);
+
+        taskData->hlr = ShapeHlr::compute(compShape, taskData->viewAxes, taskData->focus);
+        taskData->isComplete = !progress->isAbortRequested();
+    });
+    m_mapTask.insert({ taskId, taskData });
+    m_lastTaskId = taskId;
+    m_taskMgr.run(taskId);
+}
+
+void GraphicsHlrPresenter::suspend()
+{
+    if (!m_isEnabled)
+        return;
+
+    m_isSuspended = true;
+    if (m_isDrawingDisplayed) {
+        this->eraseDrawings();
+        m_scene->redraw();
+    }
+}
+
+void GraphicsHlrPresenter::setMaxCacheEntryCount(size_t count)
+{
+    m_maxCacheEntryCount = count;
+    while (m_listCacheEntry.size() > m_maxCacheEntryCount)
+        m_listCacheEntry.pop_back();
+}
+
+void GraphicsHlrPresenter::clearCache()
+{
+    m_listCacheEntry.clear();
+}
+
+bool GraphicsHlrPresenter::ViewPoint::isEqual(const ViewPoint& other) const
+{
+    constexpr double angularTolerance = 1e-6;
+    return this->viewDirection.IsEqual(other.viewDirection, angularTolerance)
+            && this->up.IsEqual(other.up, angularTolerance)
+            && this->isPerspective == other.isPerspective
+            && (!this->isPerspective || this->eye.IsEqual(other.eye, Precision::Confusion()));
+}
+
+GraphicsHlrPresenter::ViewPoint GraphicsHlrPresenter::currentViewPoint() const
+{
+    const Handle_Graphic3d_Camera& camera = m_view->Camera();
+    ViewPoint viewPoint;
+    viewPoint.viewDirection = camera->Direction();
+    viewPoint.up = camera->Up();
+    viewPoint.isPerspective = !camera->IsOrthographic();
+    viewPoint.eye = camera->Eye();
+    return viewPoint;
+}
+
+std::vector<GraphicsObjectPtr> GraphicsHlrPresenter::drawableObjects(const ViewPoint& viewPoint) const
+{
+    std::vector<GraphicsObjectPtr> vecObject;
+    for (const GraphicsObjectPtr& object : m_vecObject) {
+        if (!m_scene->isObjectVisible(object) || Handle_AIS_Shape::DownCast(object)->Shape().IsNull())
+            continue;
+
+        // Perspective projection is undefined for points behind the eye
+        if (viewPoint.isPerspective) {
+            const Bnd_Box bndBox = GraphicsUtils::AisObject_boundingBox(object);
+            if (bndBox.IsVoid())
+                continue;
+
+            const gp_XYZ cornerMin = bndBox.CornerMin().XYZ();
+            const gp_XYZ cornerMax = bndBox.CornerMax().XYZ();
+            bool isInFront = true;
+            for (int i = 0; i < 8 && isInFront; ++i) {
+                const gp_XYZ corner(
+                            (i & 1) ? cornerMax.X() : cornerMin.X(),
+                            (i & 2) ? cornerMax.Y() : cornerMin.Y(),
+                            (i & 4) ? cornerMax.Z() : cornerMin.Z());
+                const double depth = (corner - viewPoint.eye.XYZ()).Dot(viewPoint.viewDirection.XYZ());
+                isInFront = depth > Precision::Confusion();
+            }
+
+            if (!isInFront)
+                continue;
+        }
+
+        vecObject.push_back(object);
+    }
+
+    return vecObject;
+}
+
+const GraphicsHlrPresenter::CacheEntry* GraphicsHlrPresenter::findCacheEntry(
+        const ViewPoint& viewPoint, const std::vector<GraphicsObjectPtr>& vecObject)
+{
+    auto itFound = std::find_if(
+                m_listCacheEntry.begin(), m_listCacheEntry.end(), [&](const CacheEntry& entry) {
+        return entry.viewPoint.isEqual(viewPoint) && entry.vecObject == vecObject;
+    });
+    if (itFound == m_listCacheEntry.end())
+        return nullptr;
+
+    m_listCacheEntry.splice(m_listCacheEntry.begin(), m_listCacheEntry, itFound);
+    return &m_listCacheEntry.front();
+}
+
+void GraphicsHlrPresenter::addCacheEntry(
+        const ViewPoint& viewPoint, const std::vector<GraphicsObjectPtr>& vecObject, const ShapeHlr& hlr)
+{
+    if (m_maxCacheEntryCount == 0 || this->findCacheEntry(viewPoint, vecObject))
+        return;
+
+    m_listCacheEntry.push_front({ viewPoint, vecObject, hlr });
+    if (m_listCacheEntry.size() > m_maxCacheEntryCount)
+        m_listCacheEntry.pop_back();
+}
+
+void GraphicsHlrPresenter::abortTasks()
+{
+    for (const auto& mapPair : m_mapTask)
+        m_taskMgr.requestAbort(mapPair.first);
+}
+
+void GraphicsHlrPresenter::onTaskEnded(TaskId taskId)
+{
+    auto itFound = m_mapTask.find(taskId);
+    if (itFound == m_mapTask.end())
+        return;
+
+    const std::shared_ptr<TaskData> taskData = itFound->second;
+    m_mapTask.erase(itFound);
+    if (!taskData->isComplete)
+        return;
+
+    // Drawing is still valid even if camera was changed meanwhile, it's kept for later unless some
+    // object was removed
+    const bool hasRemovedObject = std::any_of(
+                taskData->vecObject.cbegin(), taskData->vecObject.cend(), [=](const GraphicsObjectPtr& object) {
+        return std::find(m_vecObject.cbegin(), m_vecObject.cend(), object) == m_vecObject.cend();
+    });
+    if (hasRemovedObject)
+        return;
+
+    this->addCacheEntry(taskData->viewPoint, taskData->vecObject, taskData->hlr);
+    if (m_isEnabled
+            && !m_isSuspended
+            && taskId == m_lastTaskId
+            && taskData->viewPoint.isEqual(this->currentViewPoint())
+            && taskData->vecObject == this->drawableObjects(taskData->viewPoint))
+    {
+        this->displayDrawing({ taskData->viewPoint, taskData->vecObject, taskData->hlr });
+    }
+}
+
+void GraphicsHlrPresenter::displayDrawing(const CacheEntry& entry)
+{
+    this->eraseDrawings();
+    auto fnAddDrawingObject = [=](const TopoDS_Shape& edges, const Handle_Prs3d_LineAspect& aspect) {
+        if (edges.IsNull())
+            return;
+
+        // Drawing edges aren't attached to any face, so they are displayed with the wire aspect
+        Handle_AIS_Shape gfxDrawing = new AIS_Shape(edges);
+        gfxDrawing->SetDisplayMode(AIS_WireFrame);
+        gfxDrawing->Attributes()->SetWireAspect(aspect);
+        m_scene->addObject(gfxDrawing);
+        m_scene->deactivateObjectSelection(gfxDrawing, 0);
+        m_vecDrawingObject.push_back(gfxDrawing);
+    };
+
+    fnAddDrawingObject(entry.hlr.visibleEdges, new Prs3d_LineAspect(Quantity_NOC_BLACK, Aspect_TOL_SOLID, 1.));
+    fnAddDrawingObject(entry.hlr.hiddenEdges, new Prs3d_LineAspect(Quantity_NOC_GRAY50, Aspect_TOL_DASH, 1.));
+    for (const GraphicsObjectPtr& object : entry.vecObject) {
+        m_scene->setObjectVisibleInView(object, m_view, false);
+        m_vecObjectHiddenInView.push_back(object);
+    }
+
+    m_isDrawingDisplayed = true;
+    m_displayedViewPoint = entry.viewPoint;
+    m_scene->redraw();
+}
+
+void GraphicsHlrPresenter::eraseDrawings()
+{
+    for (const GraphicsObjectPtr& object : m_vecDrawingObject)
+        m_scene->eraseObject(object);
+
+    for (const GraphicsObjectPtr& object : m_vecObjectHiddenInView)
+        m_scene->setObjectVisibleInView(object, m_view, true);
+
+    m_vecDrawingObject.clear();
+    m_vecObjectHiddenInView.clear();
+    m_isDrawingDisplayed = false;
+}
+
+} // namespace Mayo
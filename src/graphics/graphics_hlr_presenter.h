@@ -0,0 +1,114 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/shape_hlr.h"
+#include "../base/task_manager.h"
+#include "graphics_object_ptr.h"
+
+#include <gp_Dir.hxx>
+#include <gp_Pnt.hxx>
+#include <V3d_View.hxx>
+#include <QtCore/QObject>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Mayo {
+
+class GraphicsScene;
+
+// Displays registered graphics objects(AIS_Shape) as a hidden-line drawing in a 3D view
+//
+// A single drawing is computed for all the visible objects, so objects hide each other. It's
+// computed in background for the current camera, objects are displayed as usual(eg shaded) until
+// the drawing is ready. Triangulation required by the polygonal algorithm is also computed in
+// background, on a copy of the shapes not triangulated yet. Computations made stale by a camera
+// change are aborted, and drawings are cached so going back to a previous camera is immediate
+// With orthographic projection drawings depend only on camera orientation: panning and zooming
+// don't trigger any computation
+// With perspective projection drawings depend also on the eye position, and objects not entirely
+// in front of the eye are left out of the drawing and displayed as usual
+class GraphicsHlrPresenter : public QObject {
+    Q_OBJECT
+public:
+    GraphicsHlrPresenter(GraphicsScene* scene, const Handle_V3d_View& view, QObject* parent = nullptr);
+    ~GraphicsHlrPresenter();
+
+    void addObject(const GraphicsObjectPtr& object);
+    void removeObject(const GraphicsObjectPtr& object);
+
+    bool isEnabled() const { return m_isEnabled; }
+    void setEnabled(bool on);
+
+    // Displays the drawing matching current camera and visible objects, computation is started if
+    // it's not cached yet
+    // Cheap if camera and objects didn't change since previous call
+    void update();
+
+    // Camera is about to change(eg dynamic action), drawings are erased until next call to update()
+    // Running computations are kept as they are still relevant if camera doesn't change
+    void suspend();
+
+    size_t maxCacheEntryCount() const { return m_maxCacheEntryCount; }
+    void setMaxCacheEntryCount(size_t count);
+    size_t cacheEntryCount() const { return m_listCacheEntry.size(); }
+    void clearCache();
+
+private:
+    struct ViewPoint {
+        gp_Dir viewDirection;
+        gp_Dir up;
+        bool isPerspective = false;
+        gp_Pnt eye; // Relevant only for perspective projection
+        bool isEqual(const ViewPoint& other) const;
+    };
+
+    struct CacheEntry {
+        ViewPoint viewPoint;
+        std::vector<GraphicsObjectPtr> vecObject; // Objects in the drawing
+        ShapeHlr hlr;
+    };
+    using ListCacheEntry = std::list<CacheEntry>;
+
+    struct TaskData;
+
+    ViewPoint currentViewPoint() const;
+    std::vector<GraphicsObjectPtr> drawableObjects(const ViewPoint& viewPoint) const;
+    const CacheEntry* findCacheEntry(
+            const ViewPoint& viewPoint, const std::vector<GraphicsObjectPtr>& vecObject);
+    void addCacheEntry(
+            const ViewPoint& viewPoint, const std::vector<GraphicsObjectPtr>& vecObject, const ShapeHlr& hlr);
+
+    void abortTasks();
+    void onTaskEnded(TaskId taskId);
+
+    void displayDrawing(const CacheEntry& entry);
+    void eraseDrawings();
+
+    GraphicsScene* m_scene = nullptr;
+    Handle_V3d_View m_view;
+    std::vector<GraphicsObjectPtr> m_vecObject;
+    bool m_isEnabled = false;
+    bool m_isDirty = true;
+    bool m_isSuspended = false;
+
+    TaskManager m_taskMgr;
+    std::unordered_map<TaskId, std::shared_ptr<TaskData>> m_mapTask;
+    TaskId m_lastTaskId = 0;
+
+    size_t m_maxCacheEntryCount = 256;
+    ListCacheEntry m_listCacheEntry; // Front is the most recently used entry
+
+    bool m_isDrawingDisplayed = false;
+    ViewPoint m_displayedViewPoint;
+    std::vector<GraphicsObjectPtr> m_vecDrawingObject;
+    std::vector<GraphicsObjectPtr> m_vecObjectHiddenInView;
+};
+
+} // namespace Mayo
@@ -0,0 +1,229 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "graphics_lod_selector.h"
+
+#include "graphics_scene.h"
+#include "graphics_shape_object.h"
+#include "graphics_utils.h"
+
+#include <AIS_DisplayMode.hxx>
+#include <Graphic3d_ZLayerSettings.hxx>
+#include <Precision.hxx>
+#include <algorithm>
+
+namespace Mayo {
+
+namespace Internal {
+
+static GraphicsLodSelector::Parameters& lodDefaultParameters()
+{
+    static GraphicsLodSelector::Parameters params;
+    return params;
+}
+
+} // namespace Internal
+
+const GraphicsLodSelector::Parameters& GraphicsLodSelector::defaultParameters()
+{
+    return Internal::lodDefaultParameters();
+}
+
+void GraphicsLodSelector::setDefaultParameters(const Parameters& params)
+{
+    Internal::lodDefaultParameters() = params;
+}
+
+GraphicsLodSelector::GraphicsLodSelector(GraphicsScene* scene, QObject* parent)
+    : QObject(parent),
+      m_scene(scene)
+{
+    // Task manager signals are emitted from worker threads, so 'ended' is a queued connection
+    QObject::connect(&m_taskMgr, &TaskManager::ended, this, &GraphicsLodSelector::onTaskEnded);
+}
+
+GraphicsLodSelector::~GraphicsLodSelector()
+{
+    for (const auto& mapPair : m_mapTask)
+        m_taskMgr.waitForDone(mapPair.first);
+}
+
+void GraphicsLodSelector::addObject(const GraphicsObjectPtr& object)
+{
+    auto gfx = Handle_GraphicsShapeObject::DownCast(object);
+    if (gfx.IsNull() || !gfx->AcceptDisplayMode(GraphicsShapeObject::DisplayMode_CoarseShaded))
+        return;
+
+    m_vecObject.push_back(gfx);
+    m_isDirty = true;
+}
+
+void GraphicsLodSelector::removeObject(const GraphicsObjectPtr& object)
+{
+    auto itFound = std::find(m_vecObject.begin(), m_vecObject.end(), object);
+    if (itFound != m_vecObject.end())
+        m_vecObject.erase(itFound);
+}
+
+bool GraphicsLodSelector::update(const Handle_V3d_View& view)
+{
+    if (view.IsNull() || view->Window().IsNull())
+        return false;
+
+    const Parameters& params = GraphicsLodSelector::defaultParameters();
+    const Graphic3d_WorldViewProjState cameraState = view->Camera()->WorldViewProjState();
+    const int viewWidth = GraphicsUtils::AspectWindow_width(view->Window());
+    const int viewHeight = GraphicsUtils::AspectWindow_height(view->Window());
+    const bool paramsChanged =
+            params.isEnabled != m_lastParams.isEnabled
+            || params.coarsePixelSize != m_lastParams.coarsePixelSize
+            || params.cullingPixelSize != m_lastParams.cullingPixelSize;
+    if (!m_isDirty
+            && !paramsChanged
+            && view == m_lastView
+            && cameraState == m_lastCameraState
+            && viewWidth == m_lastViewWidth
+            && viewHeight == m_lastViewHeight)
+    {
+        return false;
+    }
+
+    const bool cullingChanged =
+            m_isDirty
+            || params.isEnabled != m_lastParams.isEnabled
+            || params.cullingPixelSize != m_lastParams.cullingPixelSize;
+    if (cullingChanged)
+        this->applyCullingPixelSize(view, params.isEnabled ? params.cullingPixelSize : 0);
+
+    m_isDirty = false;
+    m_lastParams = params;
+    m_lastView = view;
+    m_lastCameraState = cameraState;
+    m_lastViewWidth = viewWidth;
+    m_lastViewHeight = viewHeight;
+
+    // Part occurrences of all objects are projected at once
+    m_vecPartBndBox.clear();
+    if (params.isEnabled) {
+        for (const Handle_GraphicsShapeObject& object : m_vecObject) {
+            const std::vector<Bnd_Box>& vecBndBox = object->partOccurrenceBoundingBoxes();
+            m_vecPartBndBox.insert(m_vecPartBndBox.end(), vecBndBox.cbegin(), vecBndBox.cend());
+        }
+    }
+
+    const std::vector<double> vecSizePx = GraphicsUtils::V3dView_projectedBoxSizes(view, m_vecPartBndBox);
+    bool hasChanged = cullingChanged;
+    size_t partOffset = 0;
+    for (const Handle_GraphicsShapeObject& object : m_vecObject) {
+        const size_t partCount = params.isEnabled ? object->partOccurrenceBoundingBoxes().size() : 0;
+        const Span<const double> spanSizePx(vecSizePx.data() + partOffset, partCount);
+        partOffset += partCount;
+        const int currentMode = object->DisplayMode();
+        const bool isCoarseMode = currentMode == GraphicsShapeObject::DisplayMode_CoarseShaded;
+        if (currentMode != AIS_Shaded && !isCoarseMode)
+            continue;
+
+        // Levels currently displayed
+        std::vector<bool> vecIsCoarse(partCount, false);
+        if (isCoarseMode && object->coarsePartOccurrences().size() == partCount)
+            vecIsCoarse = object->coarsePartOccurrences();
+
+        GraphicsLodSelector::selectCoarseParts(spanSizePx, params, &vecIsCoarse);
+        const bool hasCoarseParts =
+                std::find(vecIsCoarse.cbegin(), vecIsCoarse.cend(), true) != vecIsCoarse.cend();
+        if (hasCoarseParts && !object->hasCoarseTessellation()) {
+            // Object is displayed as is until its coarse tessellation is ready
+            this->requestCoarseTessellation(object);
+            continue;
+        }
+
+        const bool partsChanged = hasCoarseParts && vecIsCoarse != object->coarsePartOccurrences();
+        if (hasCoarseParts)
+            object->setCoarsePartOccurrences(vecIsCoarse);
+
+        const int mode = hasCoarseParts ? GraphicsShapeObject::DisplayMode_CoarseShaded : AIS_Shaded;
+        if (mode != currentMode) {
+            m_scene->setObjectDisplayMode(object, mode);
+            hasChanged = true;
+        }
+        else if (partsChanged) {
+            m_scene->updateObjectPresentations(object);
+            hasChanged = true;
+        }
+    }
+
+    return hasChanged;
+}
+
+bool GraphicsLodSelector::selectCoarseParts(
+        Span<const double> spanSizePx, const Parameters& params, std::vector<bool>* ptrVecIsCoarse)
+{
+    std::vector<bool>& vecIsCoarse = *ptrVecIsCoarse;
+    bool hasChanged = vecIsCoarse.size() != spanSizePx.size();
+    vecIsCoarse.resize(spanSizePx.size(), false);
+    for (size_t i = 0; i < vecIsCoarse.size(); ++i) {
+        const bool isCoarse = vecIsCoarse.at(i);
+        bool wantCoarse = false;
+        if (params.isEnabled) {
+            const double threshold = params.coarsePixelSize * (isCoarse ? 1. : 0.8);
+            wantCoarse = spanSizePx[i] < threshold;
+        }
+
+        if (wantCoarse != isCoarse) {
+            vecIsCoarse.at(i) = wantCoarse;
+            hasChanged = true;
+        }
+    }
+
+    return hasChanged;
+}
+
+void GraphicsLodSelector::applyCullingPixelSize(const Handle_V3d_View& view, int sizePx)
+{
+    // Size culling is done by OpenCascade on each structure, with the frustum culling step
+    const Handle_V3d_Viewer& viewer = view->Viewer();
+    Graphic3d_ZLayerSettings settings = viewer->ZLayerSettings(Graphic3d_ZLayerId_Default);
+    settings.SetCullingSize(sizePx > 0 ? double(sizePx) : Precision::Infinite());
+    viewer->SetZLayerSettings(Graphic3d_ZLayerId_Default, settings);
+}
+
+void GraphicsLodSelector::requestCoarseTessellation(const Handle_GraphicsShapeObject& object)
+{
+    const bool isPending = std::any_of(m_mapTask.cbegin(), m_mapTask.cend(), [&](const auto& mapPair) {
+        return mapPair.second->object == object;
+    });
+    if (isPending)
+        return;
+
+    // Topological copy is made here, only meshing is done in the worker thread
+    auto taskData = std::make_shared<TaskData>();
+    taskData->object = object;
+    taskData->coarse = object->newCoarseTessellation();
+    const TaskId taskId = m_taskMgr.newTask([=](TaskProgress*) { taskData->coarse.compute(); });
+    m_mapTask.insert({ taskId, taskData });
+    m_taskMgr.run(taskId);
+}
+
+void GraphicsLodSelector::onTaskEnded(TaskId taskId)
+{
+    auto itFound = m_mapTask.find(taskId);
+    if (itFound == m_mapTask.end())
+        return;
+
+    const std::shared_ptr<TaskData> taskData = itFound->second;
+    m_mapTask.erase(itFound);
+    const Handle_GraphicsShapeObject& object = taskData->object;
+    if (std::find(m_vecObject.cbegin(), m_vecObject.cend(), object) == m_vecObject.cend())
+        return;
+
+    // Tessellation is ignored by the object if its shape changed meanwhile
+    object->setCoarseTessellation(taskData->coarse);
+    m_isDirty = true;
+    if (this->update(m_lastView))
+        m_scene->redraw();
+}
+
+} // namespace Mayo
@@ -0,0 +1,87 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/span.h"
+#include "../base/task_manager.h"
+#include "graphics_object_ptr.h"
+#include "graphics_shape_object.h"
+
+#include <Graphic3d_WorldViewProjState.hxx>
+#include <V3d_View.hxx>
+#include <QtCore/QObject>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Mayo {
+
+class GraphicsScene;
+
+// Picks for each part occurrence of the registered graphics objects the level of detail to display
+// in a view, from the size of its bounding box once projected in that view
+// Only objects displayed in shaded mode and accepting GraphicsShapeObject::DisplayMode_CoarseShaded
+// are concerned, other display modes are left untouched
+//
+// Coarse tessellations are computed in background on first need, objects are displayed as usual
+// until their coarse tessellation is ready
+class GraphicsLodSelector : public QObject {
+    Q_OBJECT
+public:
+    struct Parameters {
+        bool isEnabled = true;
+        // Part occurrences whose projected size(in pixels) is below this threshold are drawn coarse
+        int coarsePixelSize = 96;
+        // Objects whose projected size(in pixels) is below this threshold aren't drawn at all
+        int cullingPixelSize = 2;
+    };
+    static const Parameters& defaultParameters();
+    static void setDefaultParameters(const Parameters& params);
+
+    GraphicsLodSelector(GraphicsScene* scene, QObject* parent = nullptr);
+    ~GraphicsLodSelector();
+
+    // Bounding boxes of part occurrences are queried from the object on each update, so they
+    // follow changes of the shape(eg geometry loaded on demand)
+    void addObject(const GraphicsObjectPtr& object);
+    void removeObject(const GraphicsObjectPtr& object);
+
+    // Updates levels of detail in case camera or parameters changed since previous call
+    // Returns true if the display of some object was changed(a redraw is then needed)
+    bool update(const Handle_V3d_View& view);
+
+    // Levels of detail of part occurrences from their projected sizes(in pixels), with some
+    // hysteresis to avoid flickering of part occurrences whose size is close to the threshold
+    // 'ptrVecIsCoarse' holds the current levels and is updated in place, it's resized if needed
+    // Returns true if some level changed
+    static bool selectCoarseParts(
+            Span<const double> spanSizePx, const Parameters& params, std::vector<bool>* ptrVecIsCoarse);
+
+private:
+    void applyCullingPixelSize(const Handle_V3d_View& view, int sizePx);
+    void requestCoarseTessellation(const Handle_GraphicsShapeObject& object);
+    void onTaskEnded(TaskId taskId);
+
+    GraphicsScene* m_scene = nullptr;
+    std::vector<Handle_GraphicsShapeObject> m_vecObject;
+    std::vector<Bnd_Box> m_vecPartBndBox; // Part occurrences of all objects, reused between updates
+    Handle_V3d_View m_lastView;
+    Graphic3d_WorldViewProjState m_lastCameraState;
+    int m_lastViewWidth = 0;
+    int m_lastViewHeight = 0;
+    Parameters m_lastParams;
+    bool m_isDirty = true;
+
+    struct TaskData {
+        Handle_GraphicsShapeObject object;
+        GraphicsShapeObject::CoarseTessellation coarse;
+    };
+    TaskManager m_taskMgr;
+    std::unordered_map<TaskId, std::shared_ptr<TaskData>> m_mapTask;
+};
+
+} // namespace Mayo
@@ -0,0 +1,177 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "graphics_object_unloader.h"
+
+#include "graphics_scene.h"
+
+#include <AIS_Shape.hxx>
+#include <BRep_Tool.hxx>
+#include <Graphic3d_Vec3.hxx>
+#include <MeshVS_DataSource.hxx>
+#include <MeshVS_Mesh.hxx>
+#include <Poly_Polygon3D.hxx>
+#include <Poly_PolygonOnTriangulation.hxx>
+#include <Poly_Triangulation.hxx>
+#include <TopExp.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <TopTools_IndexedMapOfShape.hxx>
+
+namespace Mayo {
+
+namespace Internal {
+
+// Memory used by presentation arrays of a triangle mesh: vertex positions + normals and indices
+static size_t triangleMeshMemoryUsage(int nodeCount, int triangleCount)
+{
+    return size_t(nodeCount) * 2 * sizeof(Graphic3d_Vec3) + size_t(triangleCount) * 3 * sizeof(int);
+}
+
+// Memory used by presentation arrays of a polyline: vertex positions
+static size_t polylineMemoryUsage(int nodeCount)
+{
+    return size_t(nodeCount) * sizeof(Graphic3d_Vec3);
+}
+
+} // namespace Internal
+
+GraphicsObjectUnloader* GraphicsObjectUnloader::globalInstance()
+{
+    static GraphicsObjectUnloader global;
+    return &global;
+}
+
+void GraphicsObjectUnloader::setEnabled(bool on)
+{
+    m_isEnabled = on;
+    if (on) {
+        this->unloadIfNeeded();
+    }
+    else {
+        m_listEntry.clear();
+        m_mapObjectEntry.clear();
+        m_memoryUsage = 0;
+    }
+}
+
+void GraphicsObjectUnloader::setMemoryBudget(size_t sizeBytes)
+{
+    m_memoryBudget = sizeBytes;
+    this->unloadIfNeeded();
+}
+
+void GraphicsObjectUnloader::onObjectHidden(GraphicsScene* scene, const GraphicsObjectPtr& object)
+{
+    if (!m_isEnabled || !scene || object.IsNull())
+        return;
+
+    this->onObjectErased(object);
+    Entry entry;
+    entry.scene = scene;
+    entry.object = object;
+    entry.memoryUsage = GraphicsObjectUnloader::estimatedMemoryUsage(object);
+    m_memoryUsage += entry.memoryUsage;
+    auto itEntry = m_listEntry.insert(m_listEntry.end(), std::move(entry));
+    m_mapObjectEntry.insert({ object.get(), itEntry });
+    this->unloadIfNeeded();
+}
+
+void GraphicsObjectUnloader::onObjectShown(const GraphicsObjectPtr& object)
+{
+    // Presentation(if unloaded) is recomputed by AIS when displayed, just stop tracking object
+    this->onObjectErased(object);
+}
+
+void GraphicsObjectUnloader::onObjectErased(const GraphicsObjectPtr& object)
+{
+    auto itFound = m_mapObjectEntry.find(object.get());
+    if (itFound != m_mapObjectEntry.end())
+        this->removeEntry(itFound->second);
+}
+
+void GraphicsObjectUnloader::onSceneDestroyed(const GraphicsScene* scene)
+{
+    auto itEntry = m_listEntry.begin();
+    while (itEntry != m_listEntry.end()) {
+        auto itNext = std::next(itEntry);
+        if (itEntry->scene == scene)
+            this->removeEntry(itEntry);
+
+        itEntry = itNext;
+    }
+}
+
+size_t GraphicsObjectUnloader::estimatedMemoryUsage(const GraphicsObjectPtr& object)
+{
+    size_t memUsage = 0;
+    auto aisShape = Handle_AIS_Shape::DownCast(object);
+    if (!aisShape.IsNull()) {
+        for (TopExp_Explorer expl(aisShape->Shape(), TopAbs_FACE); expl.More(); expl.Next()) {
+            TopLoc_Location loc;
+            const TopoDS_Face& face = TopoDS::Face(expl.Current());
+            const Handle_Poly_Triangulation& polyTri = BRep_Tool::Triangulation(face, loc);
+            if (!polyTri.IsNull()) {
+                memUsage += Internal::triangleMeshMemoryUsage(
+                            polyTri->NbNodes(), polyTri->NbTriangles());
+            }
+        }
+
+        // Edges are discretized either on their own or from the triangulation of a face
+        TopTools_IndexedMapOfShape mapEdge;
+        TopExp::MapShapes(aisShape->Shape(), TopAbs_EDGE, mapEdge);
+        for (int i = 1; i <= mapEdge.Extent(); ++i) {
+            TopLoc_Location loc;
+            const TopoDS_Edge& edge = TopoDS::Edge(mapEdge.FindKey(i));
+            const Handle_Poly_Polygon3D& polygon = BRep_Tool::Polygon3D(edge, loc);
+            if (!polygon.IsNull()) {
+                memUsage += Internal::polylineMemoryUsage(polygon->NbNodes());
+            }
+            else {
+                Handle_Poly_PolygonOnTriangulation polygonOnTri;
+                Handle_Poly_Triangulation polyTri;
+                BRep_Tool::PolygonOnTriangulation(edge, polygonOnTri, polyTri, loc);
+                if (!polygonOnTri.IsNull())
+                    memUsage += Internal::polylineMemoryUsage(polygonOnTri->NbNodes());
+            }
+        }
+    }
+
+    auto meshVs = Handle_MeshVS_Mesh::DownCast(object);
+    if (!meshVs.IsNull() && !meshVs->GetDataSource().IsNull()) {
+        const Handle_MeshVS_DataSource& dataSource = meshVs->GetDataSource();
+        const int nodeCount = dataSource->GetAllNodes().Extent();
+        const int elementCount = dataSource->GetAllElements().Extent();
+        memUsage += Internal::triangleMeshMemoryUsage(nodeCount, elementCount);
+        // Mesh edges, each triangle edge is shared at most by two triangles
+        memUsage += Internal::polylineMemoryUsage(3 * elementCount);
+    }
+
+    return memUsage;
+}
+
+void GraphicsObjectUnloader::removeEntry(ListEntry::iterator itEntry)
+{
+    m_memoryUsage -= itEntry->memoryUsage;
+    m_mapObjectEntry.erase(itEntry->object.get());
+    m_listEntry.erase(itEntry);
+}
+
+void GraphicsObjectUnloader::unloadIfNeeded()
+{
+    if (!m_isEnabled)
+        return;
+
+    while (m_memoryUsage > m_memoryBudget && !m_listEntry.empty()) {
+        const Entry& entry = m_listEntry.front();
+        if (entry.scene)
+            entry.scene->unloadObjectPresentations(entry.object);
+
+        this->removeEntry(m_listEntry.begin());
+    }
+}
+
+} // namespace Mayo
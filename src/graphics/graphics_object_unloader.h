@@ -0,0 +1,66 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "graphics_object_ptr.h"
+
+#include <QtCore/QPointer>
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+
+namespace Mayo {
+
+class GraphicsScene;
+
+// Keeps track of hidden graphics objects and releases their presentations when the memory used by
+// them exceeds some budget. Objects hidden for the longest time are unloaded first(LRU policy)
+// Unloaded presentations are recomputed transparently when the object is displayed again
+class GraphicsObjectUnloader {
+public:
+    static GraphicsObjectUnloader* globalInstance();
+
+    bool isEnabled() const { return m_isEnabled; }
+    void setEnabled(bool on);
+
+    // Maximum memory(in bytes) the presentations of hidden objects can use before being unloaded
+    size_t memoryBudget() const { return m_memoryBudget; }
+    void setMemoryBudget(size_t sizeBytes);
+
+    // Estimated memory(in bytes) used by presentations of currently hidden and loaded objects
+    size_t memoryUsage() const { return m_memoryUsage; }
+
+    void onObjectHidden(GraphicsScene* scene, const GraphicsObjectPtr& object);
+    void onObjectShown(const GraphicsObjectPtr& object);
+    void onObjectErased(const GraphicsObjectPtr& object);
+    void onSceneDestroyed(const GraphicsScene* scene);
+
+    // Estimated memory(in bytes) used by the presentations of 'object': shaded triangles along
+    // with wireframe and face boundary polylines
+    static size_t estimatedMemoryUsage(const GraphicsObjectPtr& object);
+
+private:
+    GraphicsObjectUnloader() = default;
+
+    struct Entry {
+        QPointer<GraphicsScene> scene; // Null once the scene is destroyed
+        GraphicsObjectPtr object;
+        size_t memoryUsage = 0;
+    };
+    using ListEntry = std::list<Entry>;
+
+    void removeEntry(ListEntry::iterator itEntry);
+    void unloadIfNeeded();
+
+    bool m_isEnabled = false;
+    size_t m_memoryBudget = 0;
+    size_t m_memoryUsage = 0;
+    ListEntry m_listEntry; // Front is the least recently hidden object
+    std::unordered_map<const AIS_InteractiveObject*, ListEntry::iterator> m_mapObjectEntry;
+};
+
+} // namespace Mayo
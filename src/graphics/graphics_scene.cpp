@@ -7,11 +7,16 @@
 #include "graphics_scene.h"
 
 #include "../base/tkernel_utils.h"
+#include "graphics_object_unloader.h"
 #include "graphics_utils.h"
 
 #include <Graphic3d_GraphicDriver.hxx>
+#include <StdSelect_ViewerSelector3d.hxx>
 #include <V3d_TypeOfOrientation.hxx>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QPoint>
+#include <QtCore/QTimer>
+#include <vector>
 
 namespace Mayo {
 namespace Internal {
@@ -57,6 +62,17 @@ public:
     Handle_InteractiveContext m_aisContext;
     std::unordered_set<const AIS_InteractiveObject*> m_setClipPlaneSensitive;
     bool m_isRedrawBlocked = false;
+    bool m_isHiddenLineDrawingOn = false;
+
+    QTimer m_timerHighlight;
+    QPoint m_pendingHighlightPos;
+    Handle_V3d_View m_pendingHighlightView;
+    bool m_isHighlightSuspended = false;
+    double m_lastHighlightLatency = 0.;
+    double m_avgHighlightLatency = 0.;
+
+    QTimer m_timerSelectionWarmUp;
+    std::vector<GraphicsObjectPtr> m_vecObjectSelectionWarmUp;
 };
 
 GraphicsScene::GraphicsScene(QObject* parent)
@@ -65,10 +81,45 @@ GraphicsScene::GraphicsScene(QObject* parent)
 {
     d->m_v3dViewer = Internal::createOccViewer();
     d->m_aisContext = new InteractiveContext(d->m_v3dViewer);
+
+    d->m_timerHighlight.setSingleShot(true);
+    d->m_timerHighlight.setInterval(16); // ~60Hz
+    QObject::connect(&d->m_timerHighlight, &QTimer::timeout, this, [=]{
+        Handle_V3d_View view = std::move(d->m_pendingHighlightView);
+        if (view.IsNull() || d->m_isHighlightSuspended)
+            return;
+
+        QElapsedTimer chrono;
+        chrono.start();
+        this->highlightAt(d->m_pendingHighlightPos, view);
+        d->m_lastHighlightLatency = chrono.nsecsElapsed() / 1000000.;
+        d->m_avgHighlightLatency =
+                d->m_avgHighlightLatency > 0. ?
+                    0.9 * d->m_avgHighlightLatency + 0.1 * d->m_lastHighlightLatency :
+                    d->m_lastHighlightLatency;
+        emit highlightedAt(d->m_pendingHighlightPos);
+    });
+
+    // Build selection BVH trees ahead of the first pick, so it doesn't stall the cursor
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+    d->m_aisContext->MainSelector()->SetToPrebuildBVH(true);
+#else
+    d->m_timerSelectionWarmUp.setSingleShot(true);
+    d->m_timerSelectionWarmUp.setInterval(0);
+    QObject::connect(&d->m_timerSelectionWarmUp, &QTimer::timeout, this, [=]{
+        const Handle_StdSelect_ViewerSelector3d& selector = d->m_aisContext->MainSelector();
+        for (const GraphicsObjectPtr& object : d->m_vecObjectSelectionWarmUp)
+            selector->RebuildSensitivesTree(object);
+
+        selector->RebuildObjectsTree();
+        d->m_vecObjectSelectionWarmUp.clear();
+    });
+#endif
 }
 
 GraphicsScene::~GraphicsScene()
 {
+    GraphicsObjectUnloader::globalInstance()->onSceneDestroyed(this);
     delete d;
 }
 
@@ -94,7 +145,15 @@ const opencascade::handle<StdSelect_ViewerSelector3d>& GraphicsScene::mainSelect
 
 bool GraphicsScene::hiddenLineDrawingOn() const
 {
-    return d->m_aisContext->DrawHiddenLine();
+    return d->m_isHiddenLineDrawingOn;
+}
+
+void GraphicsScene::setHiddenLineDrawingOn(bool on)
+{
+    if (on != d->m_isHiddenLineDrawingOn) {
+        d->m_isHiddenLineDrawingOn = on;
+        emit hiddenLineDrawingChanged(on);
+    }
 }
 
 void GraphicsScene::addObject(const GraphicsObjectPtr& object)
@@ -106,6 +165,7 @@ void GraphicsScene::eraseObject(const GraphicsObjectPtr& object)
 {
     GraphicsUtils::AisContext_eraseObject(d->m_aisContext, object);
     d->m_setClipPlaneSensitive.erase(object.get());
+    GraphicsObjectUnloader::globalInstance()->onObjectErased(object);
 }
 
 void GraphicsScene::redraw()
@@ -127,11 +187,40 @@ void GraphicsScene::blockRedraw(bool on)
 void GraphicsScene::recomputeObjectPresentation(const GraphicsObjectPtr& object)
 {
     d->m_aisContext->Redisplay(object, false);
+    emit objectSelectionRecomputed(object);
+}
+
+void GraphicsScene::updateObjectPresentations(const GraphicsObjectPtr& object)
+{
+    d->m_aisContext->Update(object, false);
+}
+
+void GraphicsScene::unloadObjectPresentations(const GraphicsObjectPtr& object)
+{
+    if (object.IsNull())
+        return;
+
+    std::vector<int> vecMode;
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
+    for (const Handle_PrsMgr_Presentation& prs : object->Presentations())
+        vecMode.push_back(prs->Mode());
+#else
+    for (const PrsMgr_ModedPresentation& prs : object->Presentations())
+        vecMode.push_back(prs.Mode());
+#endif
+
+    for (int mode : vecMode)
+        d->m_aisContext->ClearPrs(object, mode, false);
 }
 
 void GraphicsScene::activateObjectSelection(const GraphicsObjectPtr& object, int mode)
 {
     d->m_aisContext->Activate(object, mode);
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 5, 0)
+    // BVH trees are built at the next event loop iteration(idle time) instead of first pick
+    d->m_vecObjectSelectionWarmUp.push_back(object);
+    d->m_timerSelectionWarmUp.start();
+#endif
 }
 
 void GraphicsScene::deactivateObjectSelection(const Mayo::GraphicsObjectPtr &object, int mode)
@@ -186,6 +275,16 @@ bool GraphicsScene::isObjectVisible(const GraphicsObjectPtr& object) const
 void GraphicsScene::setObjectVisible(const GraphicsObjectPtr& object, bool on)
 {
     GraphicsUtils::AisContext_setObjectVisible(d->m_aisContext, object, on);
+    if (on)
+        GraphicsObjectUnloader::globalInstance()->onObjectShown(object);
+    else
+        GraphicsObjectUnloader::globalInstance()->onObjectHidden(this, object);
+}
+
+void GraphicsScene::setObjectVisibleInView(
+        const GraphicsObjectPtr& object, const Handle_V3d_View& view, bool on)
+{
+    d->m_aisContext->SetViewAffinity(object, view, on);
 }
 
 GraphicsOwnerPtr GraphicsScene::firstSelectedOwner() const
@@ -215,9 +314,55 @@ void GraphicsScene::toggleOwnerSelection(const GraphicsOwnerPtr& gfxOwner)
 
 void GraphicsScene::highlightAt(const QPoint& pos, const Handle_V3d_View& view)
 {
+    emit aboutToPick(pos, view);
     d->m_aisContext->MoveTo(pos.x(), pos.y(), view, true);
 }
 
+void GraphicsScene::requestHighlightAt(const QPoint& pos, const Handle_V3d_View& view)
+{
+    if (d->m_isHighlightSuspended)
+        return;
+
+    d->m_pendingHighlightPos = pos;
+    d->m_pendingHighlightView = view;
+    if (!d->m_timerHighlight.isActive())
+        d->m_timerHighlight.start();
+}
+
+int GraphicsScene::highlightFrameInterval() const
+{
+    return d->m_timerHighlight.interval();
+}
+
+void GraphicsScene::setHighlightFrameInterval(int ms)
+{
+    d->m_timerHighlight.setInterval(ms);
+}
+
+bool GraphicsScene::isHighlightSuspended() const
+{
+    return d->m_isHighlightSuspended;
+}
+
+void GraphicsScene::setHighlightSuspended(bool on)
+{
+    d->m_isHighlightSuspended = on;
+    if (on) {
+        d->m_timerHighlight.stop();
+        d->m_pendingHighlightView.Nullify();
+    }
+}
+
+double GraphicsScene::lastHighlightLatency() const
+{
+    return d->m_lastHighlightLatency;
+}
+
+double GraphicsScene::averageHighlightLatency() const
+{
+    return d->m_avgHighlightLatency;
+}
+
 void GraphicsScene::selectCurrentHighlighted()
 {
     const AIS_StatusOfPick pick = d->m_aisContext->Select(true);
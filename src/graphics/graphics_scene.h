@@ -31,7 +31,9 @@ public:
     const opencascade::handle<V3d_Viewer>& v3dViewer() const;
     const opencascade::handle<Prs3d_Drawer>& defaultPrs3dDrawer() const;
     const opencascade::handle<StdSelect_ViewerSelector3d>& mainSelector() const;
+    // Whether graphics entities are displayed as hidden-line drawings(see GraphicsHlrPresenter)
     bool hiddenLineDrawingOn() const;
+    void setHiddenLineDrawingOn(bool on);
 
     void addObject(const GraphicsObjectPtr& object);
     void eraseObject(const GraphicsObjectPtr& object);
@@ -41,6 +43,11 @@ public:
     void blockRedraw(bool on);
 
     void recomputeObjectPresentation(const GraphicsObjectPtr& object);
+    // Recomputes the presentations of 'object' flagged with PrsMgr_PresentableObject::SetToUpdate()
+    // Unlike recomputeObjectPresentation(), selection of 'object' is left untouched
+    void updateObjectPresentations(const GraphicsObjectPtr& object);
+    // Releases all presentations of 'object', they will be recomputed when it's displayed again
+    void unloadObjectPresentations(const GraphicsObjectPtr& object);
 
     void activateObjectSelection(const GraphicsObjectPtr& object, int mode);
     void deactivateObjectSelection(const GraphicsObjectPtr& object, int mode);
@@ -56,10 +63,25 @@ public:
 
     bool isObjectVisible(const GraphicsObjectPtr& object) const;
     void setObjectVisible(const GraphicsObjectPtr& object, bool on);
+    // Visibility of a displayed 'object' restricted to 'view', other views aren't affected
+    void setObjectVisibleInView(const GraphicsObjectPtr& object, const Handle_V3d_View& view, bool on);
 
     void highlightAt(const QPoint& pos, const Handle_V3d_View& view);
     void selectCurrentHighlighted();
 
+    // Frame-paced highlighting: requests are coalesced and only the last one is processed at the
+    // next frame tick, so a burst of mouse moves costs a single pick(see signal highlightedAt())
+    void requestHighlightAt(const QPoint& pos, const Handle_V3d_View& view);
+    int highlightFrameInterval() const; // In milliseconds
+    void setHighlightFrameInterval(int ms);
+    // Pending and future highlight requests are dropped while suspended(eg view dynamic action)
+    bool isHighlightSuspended() const;
+    void setHighlightSuspended(bool on);
+
+    // Duration(in milliseconds) of the last highlight pick, and its exponential moving average
+    double lastHighlightLatency() const;
+    double averageHighlightLatency() const;
+
     const GraphicsOwnerPtr& currentHighlightedOwner() const;
 
     GraphicsOwnerPtr firstSelectedOwner() const;
@@ -81,6 +103,15 @@ public:
 signals:
     void selectionCleared();
     void singleItemSelected();
+    // Emitted before picking objects at 'pos' in 'view'(eg highlight), a chance to lazily activate
+    // selection of the objects under the cursor
+    void aboutToPick(const QPoint& pos, const Handle_V3d_View& view);
+    // Emitted after a frame-paced highlight, picking results are then available in mainSelector()
+    void highlightedAt(const QPoint& pos);
+    // Emitted after presentations and selection of 'object' were recomputed, graphics owners
+    // previously obtained for 'object' are then obsolete
+    void objectSelectionRecomputed(const GraphicsObjectPtr& object);
+    void hiddenLineDrawingChanged(bool on);
 
 private:
     AIS_InteractiveContext* aisContextPtr() const;
@@ -0,0 +1,859 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "graphics_shape_object.h"
+
+#include "../base/xcaf.h"
+
+#include <AIS_ColoredDrawer.hxx>
+#include <AIS_DisplayMode.hxx>
+#include <AIS_InteractiveContext.hxx>
+#include <BRep_Builder.hxx>
+#include <BRepBndLib.hxx>
+#include <BRepBuilderAPI_Copy.hxx>
+#include <BRepMesh_IncrementalMesh.hxx>
+#include <NCollection_DataMap.hxx>
+#include <OSD_Parallel.hxx>
+#include <Prs3d_ShadingAspect.hxx>
+#include <StdPrs_ShadedShape.hxx>
+#include <StdPrs_ToolTriangulatedShape.hxx>
+#include <TDF_AttributeSequence.hxx>
+#include <TDF_LabelMap.hxx>
+#include <TDF_LabelMapHasher.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS_Compound.hxx>
+#include <TopoDS_Iterator.hxx>
+#include <TopTools_MapOfShape.hxx>
+#include <XCAFDoc_DocumentTool.hxx>
+#include <algorithm>
+#include <vector>
+
+namespace Mayo {
+
+namespace {
+
+// Color given to a whole occurrence of a prototype by components and assemblies, it replaces the
+// own color of the prototype shape(see XCAFPrs::CollectStyleSettings())
+struct OccurrenceStyle {
+    bool hasColor = false;
+    Quantity_Color color;
+
+    bool isEqual(const OccurrenceStyle& other) const {
+        return this->hasColor == other.hasColor && (!this->hasColor || this->color == other.color);
+    }
+};
+
+struct PrototypeInstance {
+    TDF_Label prototype;
+    TopLoc_Location location;
+    OccurrenceStyle style;
+};
+
+// Surface color(or generic color if not set) directly attached to 'label'
+bool findOwnColor(const TDF_Label& label, Quantity_Color* ptrColor)
+{
+    const Handle_XCAFDoc_ColorTool colorTool = XCAFDoc_DocumentTool::ColorTool(label);
+    return colorTool->GetColor(label, XCAFDoc_ColorSurf, *ptrColor)
+            || colorTool->GetColor(label, XCAFDoc_ColorGen, *ptrColor);
+}
+
+// Whether XCAF styles attached to assembly or component 'label' can't be applied per instance
+// Only colors of surfaces and visibility are supported
+bool hasStyleNotInstanceable(const TDF_Label& label)
+{
+    const Handle_XCAFDoc_ColorTool colorTool = XCAFDoc_DocumentTool::ColorTool(label);
+    if (colorTool->IsSet(label, XCAFDoc_ColorCurv))
+        return true;
+
+#if OCC_VERSION_HEX >= 0x070500
+    if (!XCAFDoc_DocumentTool::VisMaterialTool(label)->GetShapeMaterial(label).IsNull())
+        return true;
+#endif
+
+    TDF_AttributeSequence seqShuo;
+    return XCaf::isShapeComponent(label)
+            && XCAFDoc_ShapeTool::GetAllComponentSHUO(label, seqShuo)
+            && !seqShuo.IsEmpty();
+}
+
+// Collects the prototypes(non-assembly shapes) of the assembly tree of 'label', each one with its
+// location and the color inherited from components and assemblies. Hidden occurrences are skipped
+// 'isOwnColorReplaced' is true when the component referring to 'label' has its own color
+// Returns false if some assembly or component has a style that can't be applied per instance
+bool collectInstances(
+        const TDF_Label& label,
+        const TopLoc_Location& loc,
+        const OccurrenceStyle& styleInherited,
+        bool isOwnColorReplaced,
+        std::vector<PrototypeInstance>* ptrVec)
+{
+    Quantity_Color color;
+    if (!XCaf::isShapeAssembly(label)) {
+        // Own color of the prototype takes precedence over colors of upper levels, but not over the
+        // color of the component referring to it
+        const bool keepOwnColor = !isOwnColorReplaced && findOwnColor(label, &color);
+        ptrVec->push_back({ label, loc, keepOwnColor ? OccurrenceStyle() : styleInherited });
+        return true;
+    }
+
+    const Handle_XCAFDoc_ColorTool colorTool = XCAFDoc_DocumentTool::ColorTool(label);
+    if (hasStyleNotInstanceable(label))
+        return false;
+
+    if (!colorTool->IsVisible(label))
+        return true;
+
+    OccurrenceStyle styleAssembly = styleInherited;
+    if (!isOwnColorReplaced && findOwnColor(label, &color))
+        styleAssembly = { true, color };
+
+    const TopLoc_Location locInner = loc * XCaf::shape(label).Location();
+    for (const TDF_Label& component : XCaf::shapeComponents(label)) {
+        if (hasStyleNotInstanceable(component))
+            return false;
+
+        if (!colorTool->IsVisible(component))
+            continue;
+
+        const bool hasComponentColor = findOwnColor(component, &color);
+        const OccurrenceStyle styleComponent =
+                hasComponentColor ? OccurrenceStyle{ true, color } : styleAssembly;
+        const TDF_Label referred = XCaf::shapeReferred(component);
+        const TopLoc_Location locComponent = locInner * XCaf::shapeReferenceLocation(component);
+        if (!collectInstances(referred, locComponent, styleComponent, hasComponentColor, ptrVec))
+            return false;
+    }
+
+    return true;
+}
+
+// Adds to 'ptrMap' the located sub-shapes of 'shape' reached through compounds, ie the
+// compounds(assemblies) and the part occurrences
+void addOccurrences(const TopoDS_Shape& shape, TopTools_MapOfShape* ptrMap)
+{
+    if (shape.IsNull() || !ptrMap->Add(shape) || shape.ShapeType() != TopAbs_COMPOUND)
+        return;
+
+    for (TopoDS_Iterator it(shape); it.More(); it.Next())
+        addOccurrences(it.Value(), ptrMap);
+}
+
+// Custom aspects of the sub-shapes of an AIS_ColoredShape
+struct CustomAspectKeys {
+    TopTools_MapOfShape mapOccurrence; // See addOccurrences()
+    // Sub-shape -> key of its custom aspect in AIS_ColoredShape::CustomAspectsMap()
+    // A key might be a compound grouping shapes with the same style, see
+    // XCAFPrs_AISObject::DispatchStyles()
+    NCollection_DataMap<TopoDS_Shape, TopoDS_Shape, TopTools_ShapeMapHasher> mapShapeKey;
+
+    bool isGroup(const TopoDS_Shape& key) const {
+        return key.ShapeType() == TopAbs_COMPOUND && !this->mapOccurrence.Contains(key);
+    }
+};
+
+CustomAspectKeys customAspectKeys(const AIS_ColoredShape* gfx)
+{
+    CustomAspectKeys keys;
+    addOccurrences(gfx->Shape(), &keys.mapOccurrence);
+    for (AIS_DataMapOfShapeDrawer::Iterator it(gfx->CustomAspectsMap()); it.More(); it.Next()) {
+        const TopoDS_Shape& key = it.Key();
+        if (keys.isGroup(key)) {
+            for (TopoDS_Iterator itChild(key); itChild.More(); itChild.Next())
+                keys.mapShapeKey.Bind(itChild.Value(), key);
+        }
+        else {
+            keys.mapShapeKey.Bind(key, key);
+        }
+    }
+
+    return keys;
+}
+
+// Custom aspect of a part occurrence having no style of its own, aspects are the ones of the
+// nearest enclosing shape having a style
+// Primitive groups are built per custom aspect, so the color of such part occurrence can later be
+// changed in place, which isn't possible for shapes sharing the groups of the default aspect
+class PartOccurrenceDrawer : public AIS_ColoredDrawer {
+public:
+    PartOccurrenceDrawer(const Handle_Prs3d_Drawer& link)
+        : AIS_ColoredDrawer(link)
+    {}
+
+    // Whether color is still the one of the enclosing shape, and then follows its changes
+    bool isColorInherited() const { return m_isColorInherited; }
+    void setColorInherited(bool on) { m_isColorInherited = on; }
+
+    DEFINE_STANDARD_RTTI_INLINE(PartOccurrenceDrawer, AIS_ColoredDrawer)
+
+private:
+    bool m_isColorInherited = true;
+};
+
+void addPartOccurrenceDrawers(
+        AIS_ColoredShape* gfx,
+        const TopoDS_Shape& shape,
+        const CustomAspectKeys& keys,
+        const Handle_AIS_ColoredDrawer& drawerEnclosing)
+{
+    const TopoDS_Shape* ptrKey = keys.mapShapeKey.Seek(shape);
+    const Handle_AIS_ColoredDrawer drawer =
+            ptrKey ? gfx->CustomAspectsMap().Find(*ptrKey) : drawerEnclosing;
+    // Custom aspects of sub-shapes would override the hidden state
+    if (!drawer.IsNull() && drawer->IsHidden())
+        return;
+
+    if (shape.ShapeType() == TopAbs_COMPOUND) {
+        for (TopoDS_Iterator it(shape); it.More(); it.Next())
+            addPartOccurrenceDrawers(gfx, it.Value(), keys, drawer);
+    }
+    else if (!ptrKey) {
+        // Aspects not owned are taken from the link, shading aspect is owned so it can be changed
+        // without affecting the enclosing shape
+        const Handle_Prs3d_Drawer link =
+                drawer.IsNull() ? gfx->Attributes() : Handle_Prs3d_Drawer(drawer);
+        opencascade::handle<PartOccurrenceDrawer> drawerPart = new PartOccurrenceDrawer(link);
+        drawerPart->SetShadingAspect(new Prs3d_ShadingAspect);
+        *drawerPart->ShadingAspect()->Aspect() = *link->ShadingAspect()->Aspect();
+        drawerPart->SetOwnColor(link->ShadingAspect()->Color());
+        if (!drawer.IsNull() && drawer->HasOwnMaterial())
+            drawerPart->SetOwnMaterial();
+
+        if (!drawer.IsNull() && drawer->HasOwnTransparency())
+            drawerPart->SetOwnTransparency(drawer->ShadingAspect()->Transparency());
+
+        gfx->ChangeCustomAspectsMap().Bind(shape, drawerPart);
+    }
+}
+
+// Gives a PartOccurrenceDrawer to each part occurrence of 'gfx' not having a custom aspect yet
+// To be called once styles are dispatched
+void addPartOccurrenceDrawers(AIS_ColoredShape* gfx)
+{
+    if (!gfx->Shape().IsNull())
+        addPartOccurrenceDrawers(gfx, gfx->Shape(), customAspectKeys(gfx), Handle_AIS_ColoredDrawer());
+}
+
+// Presentation shared by the instances of a prototype having the same occurrence style
+class GraphicsShapePrototype : public XCAFPrs_AISObject {
+public:
+    GraphicsShapePrototype(const TDF_Label& label, const OccurrenceStyle& style)
+        : XCAFPrs_AISObject(label),
+          m_style(style)
+    {}
+
+    const OccurrenceStyle& occurrenceStyle() const { return m_style; }
+
+    DEFINE_STANDARD_RTTI_INLINE(GraphicsShapePrototype, XCAFPrs_AISObject)
+
+protected:
+    using XCAFPrs_AISObject::Compute;
+    void Compute(
+            const opencascade::handle<PrsMgr_PresentationManager3d>& pm,
+            const opencascade::handle<Prs3d_Presentation>& prs,
+            const int mode) override
+    {
+        if (myToSyncStyles) {
+            myToSyncStyles = false;
+            this->DispatchStyles(false);
+            // Replaces the own color of the prototype shape, colors of sub-shapes still apply
+            if (m_style.hasColor)
+                this->SetCustomColor(this->Shape(), m_style.color);
+
+            addPartOccurrenceDrawers(this);
+        }
+
+        XCAFPrs_AISObject::Compute(pm, prs, mode);
+    }
+
+private:
+    OccurrenceStyle m_style;
+};
+
+// Occurrence of a prototype, child of the GraphicsShapeObject(see PrsMgr_PresentableObject::AddChild())
+// The presentation manager displays it along with its parent object and in the same display mode,
+// but only wireframe and shaded modes are instanced
+class GraphicsShapeInstance : public AIS_ConnectedInteractive {
+public:
+    DEFINE_STANDARD_RTTI_INLINE(GraphicsShapeInstance, AIS_ConnectedInteractive)
+
+protected:
+    using AIS_ConnectedInteractive::Compute;
+    void Compute(
+            const opencascade::handle<PrsMgr_PresentationManager3d>& pm,
+            const opencascade::handle<Prs3d_Presentation>& prs,
+            const int mode) override
+    {
+        if (mode == AIS_WireFrame || mode == AIS_Shaded)
+            AIS_ConnectedInteractive::Compute(pm, prs, mode);
+    }
+};
+
+struct ColorUpdate {
+    TopoDS_Shape key; // Key in AIS_ColoredShape::CustomAspectsMap()
+    Quantity_Color color;
+    bool isColorInherited; // See PartOccurrenceDrawer::isColorInherited()
+};
+
+// Finds the part occurrences below 'shape' whose color is inherited from 'shape', up to the
+// shapes having their own style
+void findInheritedColorUpdates(
+        const AIS_ColoredShape* gfx,
+        const TopoDS_Shape& shape,
+        const GraphicsShapeObject::MapShapeColor& mapShapeColor,
+        const CustomAspectKeys& keys,
+        TopTools_MapOfShape* ptrMapInheritedKey)
+{
+    if (shape.ShapeType() != TopAbs_COMPOUND)
+        return;
+
+    for (TopoDS_Iterator it(shape); it.More(); it.Next()) {
+        const TopoDS_Shape& child = it.Value();
+        if (mapShapeColor.IsBound(child))
+            continue; // Child gets its own new color
+
+        const TopoDS_Shape* ptrKey = keys.mapShapeKey.Seek(child);
+        if (!ptrKey) {
+            findInheritedColorUpdates(gfx, child, mapShapeColor, keys, ptrMapInheritedKey);
+            continue;
+        }
+
+        const auto drawerPart =
+                opencascade::handle<PartOccurrenceDrawer>::DownCast(gfx->CustomAspectsMap().Find(*ptrKey));
+        if (!drawerPart.IsNull() && drawerPart->isColorInherited())
+            ptrMapInheritedKey->Add(*ptrKey);
+    }
+}
+
+// Finds the custom aspects of 'gfx' to be updated for the new colors of 'mapShapeColor', whose
+// keys are located sub-shapes of gfx->Shape(). Part occurrences whose color is inherited follow
+// the new color of their nearest enclosing shape
+// Shapes found are added to 'ptrMapFound'. Returns false if some custom aspect is shared by
+// shapes not all getting the same new color
+bool findColorUpdates(
+        const AIS_ColoredShape* gfx,
+        const GraphicsShapeObject::MapShapeColor& mapShapeColor,
+        std::vector<ColorUpdate>* ptrVecUpdate,
+        TopTools_MapOfShape* ptrMapFound)
+{
+    const CustomAspectKeys keys = customAspectKeys(gfx);
+    GraphicsShapeObject::MapShapeColor mapKeyColor;
+    TopTools_MapOfShape mapOwnColorKey;
+    for (GraphicsShapeObject::MapShapeColor::Iterator it(mapShapeColor); it.More(); it.Next()) {
+        const TopoDS_Shape& shape = it.Key();
+        const TopoDS_Shape* ptrKey = keys.mapShapeKey.Seek(shape);
+        if (ptrKey) {
+            const Quantity_Color* ptrKeyColor = mapKeyColor.Seek(*ptrKey);
+            if (ptrKeyColor && *ptrKeyColor != it.Value())
+                return false;
+
+            mapKeyColor.Bind(*ptrKey, it.Value());
+            mapOwnColorKey.Add(*ptrKey);
+        }
+
+        if (!ptrKey && !keys.mapOccurrence.Contains(shape))
+            continue;
+
+        ptrMapFound->Add(shape);
+        TopTools_MapOfShape mapInheritedKey;
+        findInheritedColorUpdates(gfx, shape, mapShapeColor, keys, &mapInheritedKey);
+        for (TopTools_MapOfShape::Iterator itKey(mapInheritedKey); itKey.More(); itKey.Next())
+            mapKeyColor.Bind(itKey.Value(), it.Value());
+    }
+
+    for (GraphicsShapeObject::MapShapeColor::Iterator it(mapKeyColor); it.More(); it.Next()) {
+        // Custom aspect shared by a group of shapes, all of them must get the new color
+        if (keys.isGroup(it.Key())) {
+            for (TopoDS_Iterator itChild(it.Key()); itChild.More(); itChild.Next()) {
+                if (!mapShapeColor.IsBound(itChild.Value()))
+                    return false;
+            }
+        }
+
+        ptrVecUpdate->push_back({ it.Key(), it.Value(), !mapOwnColorKey.Contains(it.Key()) });
+    }
+
+    return true;
+}
+
+// Same as findColorUpdates() for a prototype displayed by instances at 'vecLocation', shapes of
+// 'mapShapeColor' being located in the shape of the instancing object
+// Returns false if new colors aren't the same for all the instances, as they share the aspects
+bool findPrototypeColorUpdates(
+        const AIS_ColoredShape* prototype,
+        const std::vector<TopLoc_Location>& vecLocation,
+        const GraphicsShapeObject::MapShapeColor& mapShapeColor,
+        std::vector<ColorUpdate>* ptrVecUpdate,
+        TopTools_MapOfShape* ptrMapFound)
+{
+    // Shapes that can get a color: occurrences and sub-shapes having a custom aspect(eg faces)
+    const CustomAspectKeys keys = customAspectKeys(prototype);
+    std::vector<TopoDS_Shape> vecShape;
+    for (TopTools_MapOfShape::Iterator it(keys.mapOccurrence); it.More(); it.Next())
+        vecShape.push_back(it.Value());
+
+    using MapShapeKey = NCollection_DataMap<TopoDS_Shape, TopoDS_Shape, TopTools_ShapeMapHasher>;
+    for (MapShapeKey::Iterator it(keys.mapShapeKey); it.More(); it.Next()) {
+        if (!keys.mapOccurrence.Contains(it.Key()))
+            vecShape.push_back(it.Key());
+    }
+
+    GraphicsShapeObject::MapShapeColor mapPrototypeColor;
+    for (size_t i = 0; i < vecLocation.size(); ++i) {
+        int instanceColorCount = 0;
+        for (const TopoDS_Shape& shape : vecShape) {
+            const TopoDS_Shape shapeInstance = shape.Moved(vecLocation.at(i));
+            const Quantity_Color* ptrColor = mapShapeColor.Seek(shapeInstance);
+            if (!ptrColor)
+                continue;
+
+            if (i == 0) {
+                mapPrototypeColor.Bind(shape, *ptrColor);
+            }
+            else {
+                const Quantity_Color* ptrPrototypeColor = mapPrototypeColor.Seek(shape);
+                if (!ptrPrototypeColor || *ptrPrototypeColor != *ptrColor)
+                    return false;
+            }
+
+            ptrMapFound->Add(shapeInstance);
+            ++instanceColorCount;
+        }
+
+        if (instanceColorCount != mapPrototypeColor.Extent())
+            return false;
+    }
+
+    TopTools_MapOfShape mapFoundPrototype;
+    return findColorUpdates(prototype, mapPrototypeColor, ptrVecUpdate, &mapFoundPrototype);
+}
+
+// Calls 'fn' for each part occurrence of 'shape', ie each non-compound sub-shape reached through
+// compounds. Locations are cumulated as with TopExp_Explorer
+template<typename FUNCTION>
+void foreachPartOccurrence(const TopoDS_Shape& shape, FUNCTION fn)
+{
+    if (shape.IsNull())
+        return;
+
+    if (shape.ShapeType() != TopAbs_COMPOUND) {
+        fn(shape);
+        return;
+    }
+
+    for (TopoDS_Iterator it(shape); it.More(); it.Next())
+        foreachPartOccurrence(it.Value(), fn);
+}
+
+std::vector<TopoDS_Shape> partOccurrences(const TopoDS_Shape& shape)
+{
+    std::vector<TopoDS_Shape> vecPart;
+    foreachPartOccurrence(shape, [&](const TopoDS_Shape& part) { vecPart.push_back(part); });
+    return vecPart;
+}
+
+} // namespace
+
+GraphicsShapeObject::GraphicsShapeObject(const TDF_Label& label)
+    : XCAFPrs_AISObject(label)
+{
+}
+
+void GraphicsShapeObject::setCoarseDeflectionCoefficient(double coeff)
+{
+    if (coeff != m_coarseDeflectionCoeff) {
+        m_coarseDeflectionCoeff = coeff;
+        this->clearCoarseTessellation();
+    }
+}
+
+void GraphicsShapeObject::CoarseTessellation::compute()
+{
+    if (this->coarseShape.IsNull())
+        return;
+
+    const double angularDeflection = 0.5; // radians
+    const bool isRelative = true;
+    const bool isInParallel = true;
+    BRepMesh_IncrementalMesh(
+                this->coarseShape,
+                this->deflectionCoefficient,
+                isRelative,
+                angularDeflection,
+                isInParallel);
+}
+
+GraphicsShapeObject::CoarseTessellation GraphicsShapeObject::newCoarseTessellation() const
+{
+    CoarseTessellation coarse;
+    coarse.sourceShape = this->levelOfDetailShape();
+    coarse.deflectionCoefficient = m_coarseDeflectionCoeff;
+    // Copy only topology: geometry is shared and no triangulation is copied
+    if (!coarse.sourceShape.IsNull())
+        coarse.coarseShape = BRepBuilderAPI_Copy(coarse.sourceShape, false).Shape();
+
+    return coarse;
+}
+
+void GraphicsShapeObject::setCoarseTessellation(const CoarseTessellation& coarse)
+{
+    if (!coarse.sourceShape.IsEqual(this->levelOfDetailShape())
+            || coarse.deflectionCoefficient != m_coarseDeflectionCoeff)
+    {
+        return;
+    }
+
+    m_coarseShape = coarse.coarseShape;
+    this->SetToUpdate(DisplayMode_CoarseShaded);
+}
+
+void GraphicsShapeObject::clearCoarseTessellation()
+{
+    m_coarseShape.Nullify();
+    this->SetToUpdate(DisplayMode_CoarseShaded);
+}
+
+const std::vector<Bnd_Box>& GraphicsShapeObject::partOccurrenceBoundingBoxes()
+{
+    const TopoDS_Shape shape = this->levelOfDetailShape();
+    if (shape.IsEqual(m_partOccurrencesShape))
+        return m_vecPartBndBox;
+
+    const std::vector<TopoDS_Shape> vecPart = partOccurrences(shape);
+    m_partOccurrencesShape = shape;
+    m_vecPartBndBox.clear();
+    m_vecPartBndBox.resize(vecPart.size());
+    OSD_Parallel::For(0, int(vecPart.size()), [&](int i) {
+        BRepBndLib::Add(vecPart.at(i), m_vecPartBndBox.at(i));
+    });
+
+    if (m_vecIsPartCoarse.size() != vecPart.size())
+        this->setCoarsePartOccurrences(std::vector<bool>(vecPart.size(), false));
+
+    return m_vecPartBndBox;
+}
+
+void GraphicsShapeObject::setCoarsePartOccurrences(const std::vector<bool>& vecIsCoarse)
+{
+    if (vecIsCoarse != m_vecIsPartCoarse) {
+        m_vecIsPartCoarse = vecIsCoarse;
+        this->SetToUpdate(DisplayMode_CoarseShaded);
+    }
+}
+
+bool GraphicsShapeObject::AcceptDisplayMode(const int mode) const
+{
+    return mode == DisplayMode_CoarseShaded || XCAFPrs_AISObject::AcceptDisplayMode(mode);
+}
+
+void GraphicsShapeObject::setInstancingEnabled(bool on)
+{
+    if (on != m_isInstancingEnabled) {
+        m_isInstancingEnabled = on;
+        this->clearInstancing();
+        this->SetToUpdate(AIS_WireFrame);
+        this->SetToUpdate(AIS_Shaded);
+    }
+}
+
+void GraphicsShapeObject::invalidateStyles()
+{
+    this->clearInstancing();
+    // Forces XCAFPrs_AISObject to collect styles again
+    this->SetLabel(this->GetLabel());
+}
+
+void GraphicsShapeObject::invalidateShape()
+{
+    m_coarseShape.Nullify();
+    this->invalidateStyles();
+}
+
+bool GraphicsShapeObject::updateColorsInPlace(const MapShapeColor& mapShapeColor)
+{
+    if (mapShapeColor.IsEmpty())
+        return true;
+
+    // Styles not dispatched yet will be dispatched from the up-to-date XCAF document
+    std::vector<std::pair<AIS_ColoredShape*, std::vector<ColorUpdate>>> vecObjectUpdate;
+    TopTools_MapOfShape mapFound;
+    if (!myToSyncStyles) {
+        vecObjectUpdate.push_back({ this, {} });
+        if (!findColorUpdates(this, mapShapeColor, &vecObjectUpdate.back().second, &mapFound))
+            return false;
+    }
+
+    // Colors inherited from components and assemblies are baked in the prototypes(a prototype per
+    // occurrence color), so shapes must be found in the prototypes themselves
+    if (!m_vecPrototype.empty()) {
+        mapFound.Clear();
+        for (size_t i = 0; i < m_vecPrototype.size(); ++i) {
+            std::vector<TopLoc_Location> vecLocation;
+            for (size_t j = 0; j < m_vecInstance.size(); ++j) {
+                if (m_vecInstancePrototypeIndex.at(j) == int(i))
+                    vecLocation.push_back(m_vecInstanceLocation.at(j));
+            }
+
+            AIS_ColoredShape* prototype = m_vecPrototype.at(i).get();
+            vecObjectUpdate.push_back({ prototype, {} });
+            auto ptrVecUpdate = &vecObjectUpdate.back().second;
+            if (!findPrototypeColorUpdates(prototype, vecLocation, mapShapeColor, ptrVecUpdate, &mapFound))
+                return false;
+        }
+    }
+
+    if ((!myToSyncStyles || !m_vecPrototype.empty()) && mapFound.Extent() != mapShapeColor.Extent())
+        return false;
+
+    // Primitive groups share the aspects of custom drawers, which must then already exist
+    for (const auto& objectUpdate : vecObjectUpdate) {
+        for (const ColorUpdate& update : objectUpdate.second) {
+            const AIS_DataMapOfShapeDrawer& mapDrawer = objectUpdate.first->CustomAspectsMap();
+            if (!mapDrawer.Find(update.key)->HasOwnShadingAspect())
+                return false;
+        }
+    }
+
+    for (const auto& objectUpdate : vecObjectUpdate) {
+        AIS_ColoredShape* gfx = objectUpdate.first;
+        for (const ColorUpdate& update : objectUpdate.second) {
+            gfx->SetCustomColor(update.key, update.color);
+            const auto drawerPart = opencascade::handle<PartOccurrenceDrawer>::DownCast(
+                        gfx->CustomAspectsMap().Find(update.key));
+            if (!drawerPart.IsNull())
+                drawerPart->setColorInherited(update.isColorInherited);
+        }
+
+        if (!objectUpdate.second.empty())
+            gfx->SynchronizeAspects();
+    }
+
+    return true;
+}
+
+void GraphicsShapeObject::Compute(
+        const opencascade::handle<PrsMgr_PresentationManager3d>& pm,
+        const opencascade::handle<Prs3d_Presentation>& prs,
+        const int mode)
+{
+    this->syncStyles();
+    if (mode == DisplayMode_CoarseShaded) {
+        this->computeCoarseShaded(prs);
+        return;
+    }
+
+    if (mode == AIS_WireFrame || mode == AIS_Shaded) {
+        this->prepareInstancing();
+        if (m_instancing == Instancing::Active) {
+            // Shape of the entity is still needed for selection, bounding box, ...
+            this->computeInstanced(pm, prs, mode);
+            return;
+        }
+    }
+
+    XCAFPrs_AISObject::Compute(pm, prs, mode);
+}
+
+void GraphicsShapeObject::syncStyles()
+{
+    // Same as XCAFPrs_AISObject::Compute(), this also assigns the shape of the XCAF label
+    if (myToSyncStyles) {
+        myToSyncStyles = false;
+        this->DispatchStyles(false);
+        addPartOccurrenceDrawers(this);
+    }
+}
+
+void GraphicsShapeObject::prepareInstancing()
+{
+    if (m_instancing != Instancing::Unknown)
+        return;
+
+    m_instancing = Instancing::Inactive;
+    if (!m_isInstancingEnabled || !XCaf::isShapeAssembly(myLabel))
+        return;
+
+    std::vector<PrototypeInstance> vecInstance;
+    if (!collectInstances(myLabel, TopLoc_Location(), OccurrenceStyle(), false, &vecInstance))
+        return;
+
+    // Instances of the same label but with different occurrence styles have their own prototype
+    // Instancing is worth it only if some prototype is referenced more than once
+    NCollection_DataMap<TDF_Label, std::vector<int>, TDF_LabelMapHasher> mapLabelPrototypeIndexes;
+    std::vector<OccurrenceStyle> vecPrototypeStyle;
+    std::vector<int> vecInstancePrototypeIndex;
+    vecInstancePrototypeIndex.reserve(vecInstance.size());
+    for (const PrototypeInstance& instance : vecInstance) {
+        std::vector<int>* ptrVecIndex = mapLabelPrototypeIndexes.ChangeSeek(instance.prototype);
+        if (!ptrVecIndex)
+            ptrVecIndex = mapLabelPrototypeIndexes.Bound(instance.prototype, {});
+
+        auto itIndex = std::find_if(ptrVecIndex->cbegin(), ptrVecIndex->cend(), [&](int index) {
+            return vecPrototypeStyle.at(index).isEqual(instance.style);
+        });
+        const int index = itIndex != ptrVecIndex->cend() ? *itIndex : int(vecPrototypeStyle.size());
+        if (itIndex == ptrVecIndex->cend()) {
+            ptrVecIndex->push_back(index);
+            vecPrototypeStyle.push_back(instance.style);
+        }
+
+        vecInstancePrototypeIndex.push_back(index);
+    }
+
+    if (vecPrototypeStyle.size() == vecInstance.size())
+        return;
+
+    // Prototypes inherit the attributes of this object(face boundaries, deflection, ...)
+    m_vecPrototype.resize(vecPrototypeStyle.size());
+    for (size_t i = 0; i < vecInstance.size(); ++i) {
+        auto& prototype = m_vecPrototype.at(vecInstancePrototypeIndex.at(i));
+        if (prototype.IsNull()) {
+            const PrototypeInstance& instance = vecInstance.at(i);
+            prototype = new GraphicsShapePrototype(instance.prototype, instance.style);
+            prototype->Attributes()->SetLink(myDrawer);
+        }
+    }
+
+    m_vecInstance.reserve(vecInstance.size());
+    for (size_t i = 0; i < vecInstance.size(); ++i) {
+        Handle_AIS_ConnectedInteractive gfxInstance = new GraphicsShapeInstance;
+        const auto& prototype = m_vecPrototype.at(vecInstancePrototypeIndex.at(i));
+        gfxInstance->Connect(prototype, vecInstance.at(i).location.Transformation());
+        this->AddChild(gfxInstance);
+        m_vecInstance.push_back(gfxInstance);
+        m_vecInstanceLocation.push_back(vecInstance.at(i).location);
+    }
+
+    m_vecInstancePrototypeIndex = std::move(vecInstancePrototypeIndex);
+
+    m_instancing = Instancing::Active;
+}
+
+void GraphicsShapeObject::computeInstanced(
+        const opencascade::handle<PrsMgr_PresentationManager3d>& pm,
+        const opencascade::handle<Prs3d_Presentation>& prs,
+        const int mode)
+{
+    // Attributes of this object might have changed(eg face boundaries toggled), prototypes have
+    // to follow. Each one is computed once, whatever the count of its instances
+    for (const auto& prototype : m_vecPrototype) {
+        prototype->SetToUpdate(mode);
+        pm->Update(prototype, mode);
+    }
+
+    // Own presentation is left empty, instances are child objects each having its own connected
+    // presentation(a presentation can reference only one other presentation)
+    // They are displayed by the presentation manager along with this object, but instances
+    // created while this object is already displayed(eg recomputation) have to be displayed here
+    if (prs->IsDisplayed()) {
+        for (const auto& gfxInstance : m_vecInstance)
+            pm->Display(gfxInstance, mode);
+    }
+}
+
+void GraphicsShapeObject::clearInstancing()
+{
+    const Handle_AIS_InteractiveContext context = this->GetContext();
+    for (const auto& gfxInstance : m_vecInstance) {
+        if (!context.IsNull()) {
+            context->MainPrsMgr()->Erase(gfxInstance, AIS_WireFrame);
+            context->MainPrsMgr()->Erase(gfxInstance, AIS_Shaded);
+        }
+
+        this->RemoveChild(gfxInstance);
+    }
+
+    m_vecInstance.clear();
+    m_vecInstanceLocation.clear();
+    m_vecInstancePrototypeIndex.clear();
+    m_vecPrototype.clear();
+    m_instancing = Instancing::Unknown;
+}
+
+TopoDS_Shape GraphicsShapeObject::levelOfDetailShape() const
+{
+    // Same shape as the one assigned by XCAFPrs_AISObject when styles are dispatched
+    return XCaf::shape(myLabel);
+}
+
+void GraphicsShapeObject::computeCoarseShaded(const opencascade::handle<Prs3d_Presentation>& prs)
+{
+    const TopoDS_Shape& shape = this->Shape();
+    if (shape.IsNull())
+        return;
+
+    // Find the drawer of each face, most nested sub-shapes override the aspects of their parents
+    using MapFaceDrawer = NCollection_DataMap<TopoDS_Shape, Handle_AIS_ColoredDrawer, TopTools_ShapeMapHasher>;
+    MapFaceDrawer mapFaceDrawer;
+    std::vector<std::pair<TopoDS_Shape, Handle_AIS_ColoredDrawer>> vecShapeDrawer;
+    for (AIS_DataMapOfShapeDrawer::Iterator it(this->CustomAspectsMap()); it.More(); it.Next())
+        vecShapeDrawer.emplace_back(it.Key(), it.Value());
+
+    std::stable_sort(vecShapeDrawer.begin(), vecShapeDrawer.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first.ShapeType() < rhs.first.ShapeType();
+    });
+    for (const auto& shapeDrawer : vecShapeDrawer) {
+        for (TopExp_Explorer expl(shapeDrawer.first, TopAbs_FACE); expl.More(); expl.Next()) {
+            if (!mapFaceDrawer.Bind(expl.Current(), shapeDrawer.second))
+                mapFaceDrawer.ChangeFind(expl.Current()) = shapeDrawer.second;
+        }
+    }
+
+    // The copy has the same structure as the source shape, so part occurrences and then faces are
+    // visited in the same order. Each part occurrence is drawn either from the source shape or from
+    // the coarse copy, faces drawn are gathered in one compound per drawer
+    // Presentation has to be computed again each time the coarse part occurrences change
+    const std::vector<TopoDS_Shape> vecPart = partOccurrences(shape);
+    const std::vector<TopoDS_Shape> vecCoarsePart = partOccurrences(m_coarseShape);
+    const bool hasCoarseParts = vecCoarsePart.size() == vecPart.size();
+    using MapDrawerCompound = NCollection_DataMap<Handle_AIS_ColoredDrawer, TopoDS_Compound>;
+    MapDrawerCompound mapDrawerCompound;
+    TopoDS_Compound compDefault;
+    BRep_Builder builder;
+    builder.MakeCompound(compDefault);
+    for (size_t i = 0; i < vecPart.size(); ++i) {
+        const TopoDS_Shape& part = vecPart.at(i);
+        const bool isCoarse =
+                hasCoarseParts && i < m_vecIsPartCoarse.size() && m_vecIsPartCoarse.at(i);
+        const TopoDS_Shape& partDrawn = isCoarse ? vecCoarsePart.at(i) : part;
+        if (!isCoarse && !StdPrs_ToolTriangulatedShape::IsTessellated(part, myDrawer))
+            StdPrs_ToolTriangulatedShape::Tessellate(part, myDrawer);
+
+        TopExp_Explorer explDrawn(partDrawn, TopAbs_FACE);
+        for (TopExp_Explorer expl(part, TopAbs_FACE); expl.More() && explDrawn.More(); expl.Next()) {
+            const TopoDS_Shape& faceDrawn = explDrawn.Current();
+            const Handle_AIS_ColoredDrawer* ptrDrawer = mapFaceDrawer.Seek(expl.Current());
+            if (!ptrDrawer) {
+                builder.Add(compDefault, faceDrawn);
+            }
+            else if (!(*ptrDrawer)->IsHidden()) {
+                TopoDS_Compound* ptrComp = mapDrawerCompound.ChangeSeek(*ptrDrawer);
+                if (!ptrComp) {
+                    ptrComp = mapDrawerCompound.Bound(*ptrDrawer, TopoDS_Compound());
+                    builder.MakeCompound(*ptrComp);
+                }
+
+                builder.Add(*ptrComp, faceDrawn);
+            }
+
+            explDrawn.Next();
+        }
+    }
+
+    // Faces are already meshed, and face boundaries aren't worth drawing at this level of detail
+    // Custom drawers are linked to 'myDrawer' so they inherit these temporary settings
+    const bool wasAutoTriangulation = myDrawer->IsAutoTriangulation();
+    const bool wasFaceBoundaryDraw = myDrawer->FaceBoundaryDraw();
+    myDrawer->SetAutoTriangulation(false);
+    myDrawer->SetFaceBoundaryDraw(false);
+    StdPrs_ShadedShape::Add(prs, compDefault, myDrawer);
+    for (MapDrawerCompound::Iterator it(mapDrawerCompound); it.More(); it.Next())
+        StdPrs_ShadedShape::Add(prs, it.Value(), it.Key());
+
+    myDrawer->SetFaceBoundaryDraw(wasFaceBoundaryDraw);
+    myDrawer->SetAutoTriangulation(wasAutoTriangulation);
+}
+
+} // namespace Mayo
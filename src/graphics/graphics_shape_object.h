@@ -0,0 +1,151 @@
+/****************************************************************************
+** Copyright (c) 2020, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/tkernel_utils.h"
+
+#include <AIS_ConnectedInteractive.hxx>
+#include <Bnd_Box.hxx>
+#include <NCollection_DataMap.hxx>
+#include <PrsMgr_PresentationManager3d.hxx>
+#include <Quantity_Color.hxx>
+#include <TopoDS_Shape.hxx>
+#include <TopTools_ShapeMapHasher.hxx>
+#include <XCAFPrs_AISObject.hxx>
+#include <vector>
+
+namespace Mayo {
+
+// XCAFPrs_AISObject used for the graphics entities of XCAF shapes
+//
+// Assemblies where some prototypes(parts) are referenced several times are displayed(wireframe
+// and shaded modes) through instancing: each prototype gets its own presentation computed once,
+// and each instance is a child AIS_ConnectedInteractive(as in AIS_MultipleConnectedInteractive)
+// with its own location. Colors and visibility of components and assemblies are applied per
+// instance: instances of a prototype sharing the same color share the same prototype presentation
+// Instancing isn't used for other styles of components and assemblies(curve colors, materials,
+// SHUO). Selection and HLR are still based on the whole shape of the entity, highlighting of the
+// whole entity is propagated to the instances
+//
+// Each part occurrence gets its own custom aspect even without a style of its own, so colors can
+// be changed in place(see updateColorsInPlace()) at the cost of one primitive group per part
+//
+// Provides also an additional shaded display mode where each part occurrence(non-compound
+// sub-shape, typically the solid of a part) is drawn either from the regular triangulation or from
+// a coarse tessellation, used as a cheap level of detail for the parts small on screen(see
+// GraphicsLodSelector). The coarse tessellation is made on a topological copy of the shape so the
+// triangulation owned by the document shape is kept untouched. It isn't computed by the object
+// but given to it, so costly meshing can run in a worker thread
+//
+// Triangulation data whose loading was deferred by the reader(eg glTF) must be loaded before the
+// object is computed, preferably in a worker thread(see GuiDocument)
+class GraphicsShapeObject : public XCAFPrs_AISObject {
+public:
+    enum { DisplayMode_CoarseShaded = 10 };
+
+    GraphicsShapeObject(const TDF_Label& label);
+
+    // Linear deflection of the coarse tessellation, relative to the size of each face
+    double coarseDeflectionCoefficient() const { return m_coarseDeflectionCoeff; }
+    void setCoarseDeflectionCoefficient(double coeff);
+
+    // Coarse tessellation of the shape, created by newCoarseTessellation() in the thread owning
+    // this object. Then compute() can be called in any thread, and result is given back with
+    // setCoarseTessellation()
+    struct CoarseTessellation {
+        TopoDS_Shape sourceShape; // Shape of the object at creation of the tessellation
+        TopoDS_Shape coarseShape; // Topological copy of 'sourceShape', meshed by compute()
+        double deflectionCoefficient = 0.1;
+        void compute();
+    };
+    CoarseTessellation newCoarseTessellation() const;
+    bool hasCoarseTessellation() const { return !m_coarseShape.IsNull(); }
+    // Ignored if the shape of the object changed since creation of 'coarse'
+    void setCoarseTessellation(const CoarseTessellation& coarse);
+    // Releases the coarse tessellation, it has to be computed again
+    void clearCoarseTessellation();
+
+    // Bounding boxes of the part occurrences, in the same order as setCoarsePartOccurrences()
+    // Boxes are computed again whenever the shape of the XCAF label changes(eg geometry loaded on
+    // demand), the box of an occurrence having no geometry yet is void
+    const std::vector<Bnd_Box>& partOccurrenceBoundingBoxes();
+    // Part occurrences drawn from the coarse tessellation in DisplayMode_CoarseShaded, the others
+    // are drawn from the regular triangulation
+    const std::vector<bool>& coarsePartOccurrences() const { return m_vecIsPartCoarse; }
+    void setCoarsePartOccurrences(const std::vector<bool>& vecIsCoarse);
+
+    bool isInstancingEnabled() const { return m_isInstancingEnabled; }
+    void setInstancingEnabled(bool on);
+
+    // Whether wireframe and shaded presentations are built from shared prototype presentations
+    // Valid only once presentations were computed
+    bool isInstanced() const { return m_instancing == Instancing::Active; }
+    int prototypeCount() const { return int(m_vecPrototype.size()); }
+    int instanceCount() const { return int(m_vecInstance.size()); }
+
+    // Styles(colors, visibility, ...) of the underlying XCAF document changed, prototypes are
+    // released and presentations have to be recomputed(eg with AIS_InteractiveContext::Redisplay())
+    void invalidateStyles();
+
+    // Shape of the XCAF label changed(eg geometry loaded on demand), cached data(prototypes, coarse
+    // tessellation, ...) is released and presentations have to be recomputed
+    void invalidateShape();
+
+    // Surface colors of XCAF shapes, keys are occurrences located in the shape of the XCAF label
+    // (see XCaf::shapeAbsoluteLocation())
+    using MapShapeColor = NCollection_DataMap<TopoDS_Shape, Quantity_Color, TopTools_ShapeMapHasher>;
+
+    // Applies new surface colors by updating in place the aspects of existing primitive groups,
+    // nothing is recomputed(triangulation, primitive arrays, selection)
+    // Part occurrences without a style of their own follow the new color of their nearest enclosing
+    // shape(component or assembly)
+    // Returns false if this isn't possible and nothing was changed, eg some shape shares its style
+    // with other shapes, or an occurrence color is baked in a prototype shared by other instances
+    // Then styles have to be dispatched again with invalidateStyles() and presentations recomputed
+    bool updateColorsInPlace(const MapShapeColor& mapShapeColor);
+
+    bool AcceptDisplayMode(const int mode) const override;
+
+    DEFINE_STANDARD_RTTI_INLINE(GraphicsShapeObject, XCAFPrs_AISObject)
+
+protected:
+    using XCAFPrs_AISObject::Compute;
+    void Compute(
+            const opencascade::handle<PrsMgr_PresentationManager3d>& pm,
+            const opencascade::handle<Prs3d_Presentation>& prs,
+            const int mode) override;
+
+private:
+    void syncStyles();
+    void computeCoarseShaded(const opencascade::handle<Prs3d_Presentation>& prs);
+    TopoDS_Shape levelOfDetailShape() const;
+
+    void prepareInstancing();
+    void computeInstanced(
+            const opencascade::handle<PrsMgr_PresentationManager3d>& pm,
+            const opencascade::handle<Prs3d_Presentation>& prs,
+            const int mode);
+    void clearInstancing();
+
+    double m_coarseDeflectionCoeff = 0.1;
+    TopoDS_Shape m_coarseShape;
+    TopoDS_Shape m_partOccurrencesShape; // Shape from which m_vecPartBndBox was computed
+    std::vector<Bnd_Box> m_vecPartBndBox;
+    std::vector<bool> m_vecIsPartCoarse;
+
+    enum class Instancing { Unknown, Active, Inactive };
+    bool m_isInstancingEnabled = true;
+    Instancing m_instancing = Instancing::Unknown;
+    std::vector<opencascade::handle<XCAFPrs_AISObject>> m_vecPrototype;
+    std::vector<opencascade::handle<AIS_ConnectedInteractive>> m_vecInstance;
+    std::vector<TopLoc_Location> m_vecInstanceLocation;
+    std::vector<int> m_vecInstancePrototypeIndex;
+};
+
+DEFINE_STANDARD_HANDLE(GraphicsShapeObject, XCAFPrs_AISObject)
+
+} // namespace Mayo
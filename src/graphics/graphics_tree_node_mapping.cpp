@@ -9,15 +9,37 @@
 #include "../base/brep_utils.h"
 #include "../base/document.h"
 #include "../base/document_tree_node.h"
+#include "graphics_utils.h"
 
 #include <AIS_Shape.hxx>
+#include <BRepBndLib.hxx>
+#include <OSD_Parallel.hxx>
 #include <StdSelect_BRepOwner.hxx>
 #include <TopoDS_Solid.hxx>
+#include <unordered_set>
 
 namespace Mayo {
 
-GraphicsShapeTreeNodeMapping::GraphicsShapeTreeNodeMapping(TopAbs_ShapeEnum shapeType)
-    : m_shapeType(shapeType)
+namespace {
+
+// Calls 'fn' for each sub-shape of type 'shapeType' in the (located) shape of 'treeNode'
+template<typename FUNCTION>
+void foreachMappedShape(const DocumentTreeNode& treeNode, TopAbs_ShapeEnum shapeType, FUNCTION fn)
+{
+    const TopLoc_Location shapeLoc = treeNode.document()->xcaf().shapeAbsoluteLocation(treeNode.id());
+    const TopoDS_Shape shape = XCaf::shape(treeNode.label()).Located(shapeLoc);
+    if (BRepUtils::moreComplex(shape.ShapeType(), shapeType))
+        BRepUtils::forEachSubShape(shape, shapeType, fn);
+    else if (shape.ShapeType() == shapeType)
+        fn(shape);
+}
+
+} // namespace
+
+GraphicsShapeTreeNodeMapping::GraphicsShapeTreeNodeMapping(
+        const DocumentTreeNode& entityTreeNode, TopAbs_ShapeEnum shapeType)
+    : m_entityTreeNode(entityTreeNode),
+      m_shapeType(shapeType)
 {
 }
 
@@ -29,24 +51,12 @@ int GraphicsShapeTreeNodeMapping::selectionMode() const
 std::vector<GraphicsOwnerPtr>
 GraphicsShapeTreeNodeMapping::findGraphicsOwners(const DocumentTreeNode& treeNode) const
 {
-    const TopLoc_Location shapeLoc = treeNode.document()->xcaf().shapeAbsoluteLocation(treeNode.id());
-    const TopoDS_Shape shape = XCaf::shape(treeNode.label()).Located(shapeLoc);
-    std::vector<TopoDS_Shape> vecShape;
-    if (BRepUtils::moreComplex(shape.ShapeType(), m_shapeType)) {
-        BRepUtils::forEachSubShape(shape, m_shapeType, [&](const TopoDS_Shape& subShape) {
-            vecShape.push_back(subShape);
-        });
-    }
-    else if (shape.ShapeType() == m_shapeType) {
-        vecShape.push_back(shape);
-    }
-
     std::vector<GraphicsOwnerPtr> vecGfxOwner;
-    for (const TopoDS_Shape& shape : vecShape) {
+    foreachMappedShape(treeNode, m_shapeType, [&](const TopoDS_Shape& shape) {
         auto it = m_mapGfxOwner.find(BRepUtils::hashCode(shape));
         if (it != m_mapGfxOwner.cend())
             vecGfxOwner.push_back(it->second);
-    }
+    });
 
     return vecGfxOwner;
 }
@@ -61,7 +71,75 @@ bool GraphicsShapeTreeNodeMapping::mapGraphicsOwner(const GraphicsOwnerPtr& gfxO
         return false;
 
     auto result = m_mapGfxOwner.emplace(BRepUtils::hashCode(brepOwner->Shape()), brepOwner);
+    if (result.second)
+        m_isOwnerCacheValid = false;
+
     return result.second;
 }
 
+void GraphicsShapeTreeNodeMapping::clearGraphicsOwners()
+{
+    m_mapGfxOwner.clear();
+    m_isOwnerCacheValid = false;
+}
+
+std::vector<TreeNodeId> GraphicsShapeTreeNodeMapping::findTreeNodesInsideArea(
+        const Handle_V3d_View& view, const QPolygon& area) const
+{
+    this->updateOwnerCache();
+    std::vector<TreeNodeId> vecTreeNodeId;
+    std::unordered_set<TreeNodeId> setTreeNodeId;
+    for (int index : GraphicsUtils::V3dView_findBoxesInsideArea(view, area, m_vecOwnerBndBox)) {
+        const TreeNodeId nodeId = m_vecOwnerTreeNodeId.at(index);
+        if (setTreeNodeId.insert(nodeId).second)
+            vecTreeNodeId.push_back(nodeId);
+    }
+
+    return vecTreeNodeId;
+}
+
+void GraphicsShapeTreeNodeMapping::updateOwnerCache() const
+{
+    if (m_isOwnerCacheValid)
+        return;
+
+    // Find tree node owning each mapped shape. Nodes are visited depth-first(parents before
+    // children) so the deepest tree node wins(eg the part rather than the enclosing assembly)
+    const DocumentPtr& doc = m_entityTreeNode.document();
+    std::unordered_map<int, TreeNodeId> mapShapeTreeNodeId;
+    deepForeachTreeNode(m_entityTreeNode.id(), doc->modelTree(), [&](TreeNodeId nodeId) {
+        const DocumentTreeNode treeNode(doc, nodeId);
+        if (!XCaf::isShape(treeNode.label()))
+            return;
+
+        foreachMappedShape(treeNode, m_shapeType, [&](const TopoDS_Shape& shape) {
+            mapShapeTreeNodeId[BRepUtils::hashCode(shape)] = nodeId;
+        });
+    });
+
+    std::vector<GraphicsOwnerPtr> vecOwner;
+    vecOwner.reserve(m_mapGfxOwner.size());
+    m_vecOwnerTreeNodeId.clear();
+    m_vecOwnerTreeNodeId.reserve(m_mapGfxOwner.size());
+    for (const auto& mapPair : m_mapGfxOwner) {
+        vecOwner.push_back(mapPair.second);
+        auto itNodeId = mapShapeTreeNodeId.find(mapPair.first);
+        const bool found = itNodeId != mapShapeTreeNodeId.cend();
+        m_vecOwnerTreeNodeId.push_back(found ? itNodeId->second : m_entityTreeNode.id());
+    }
+
+    m_vecOwnerBndBox.clear();
+    m_vecOwnerBndBox.resize(vecOwner.size());
+    OSD_Parallel::For(0, int(vecOwner.size()), [&](int i) {
+        auto brepOwner = Handle_StdSelect_BRepOwner::DownCast(vecOwner.at(i));
+        Bnd_Box bndBox;
+        BRepBndLib::Add(brepOwner->Shape(), bndBox);
+        if (brepOwner->Selectable() && !bndBox.IsVoid())
+            bndBox = bndBox.Transformed(brepOwner->Selectable()->Transformation());
+
+        m_vecOwnerBndBox.at(i) = bndBox;
+    });
+    m_isOwnerCacheValid = true;
+}
+
 } // namespace Mayo
@@ -6,33 +6,54 @@
 
 #pragma once
 
+#include "../base/document_tree_node.h"
 #include "graphics_owner_ptr.h"
+#include <Bnd_Box.hxx>
 #include <TopAbs_ShapeEnum.hxx>
+#include <V3d_View.hxx>
+#include <QtGui/QPolygon>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 namespace Mayo {
 
-class DocumentTreeNode;
-
 class GraphicsTreeNodeMapping {
 public:
     virtual int selectionMode() const = 0;
     virtual std::vector<GraphicsOwnerPtr> findGraphicsOwners(const DocumentTreeNode& treeNode) const = 0;
     virtual bool mapGraphicsOwner(const GraphicsOwnerPtr& gfxOwner) = 0;
+    // Forgets all mapped graphics owners, typically because they were recomputed along with the
+    // selection of the graphics object
+    virtual void clearGraphicsOwners() = 0;
+    // Tree nodes whose mapped graphics owners lie entirely inside 'area'(view coordinates)
+    virtual std::vector<TreeNodeId> findTreeNodesInsideArea(
+            const Handle_V3d_View& view, const QPolygon& area) const = 0;
 };
 
 class GraphicsShapeTreeNodeMapping : public GraphicsTreeNodeMapping {
 public:
-    GraphicsShapeTreeNodeMapping(TopAbs_ShapeEnum shapeType);
+    GraphicsShapeTreeNodeMapping(const DocumentTreeNode& entityTreeNode, TopAbs_ShapeEnum shapeType);
 
     int selectionMode() const override;
     std::vector<GraphicsOwnerPtr> findGraphicsOwners(const DocumentTreeNode& treeNode) const override;
     bool mapGraphicsOwner(const GraphicsOwnerPtr& gfxOwner) override;
+    void clearGraphicsOwners() override;
+    std::vector<TreeNodeId> findTreeNodesInsideArea(
+            const Handle_V3d_View& view, const QPolygon& area) const override;
 
 private:
+    void updateOwnerCache() const;
+
+    DocumentTreeNode m_entityTreeNode;
     std::unordered_map<int, GraphicsOwnerPtr> m_mapGfxOwner;
     TopAbs_ShapeEnum m_shapeType;
+
+    // Flat arrays built on demand from m_mapGfxOwner, for area selection
+    // Invalidated each time owners are mapped or cleared
+    mutable std::vector<Bnd_Box> m_vecOwnerBndBox;
+    mutable std::vector<TreeNodeId> m_vecOwnerTreeNodeId;
+    mutable bool m_isOwnerCacheValid = false;
 };
 
 } // namespace Mayo
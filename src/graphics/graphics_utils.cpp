@@ -9,8 +9,12 @@
 #include "../base/math_utils.h"
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
 #include <Bnd_Box.hxx>
 #include <ElSLib.hxx>
+#include <Graphic3d_Camera.hxx>
+#include <OSD_Parallel.hxx>
 #include <ProjLib.hxx>
 #include <SelectMgr_SelectionManager.hxx>
 #include <Standard_Version.hxx>
@@ -65,6 +69,151 @@ gp_Pnt GraphicsUtils::V3dView_to3dPosition(const Handle_V3d_View& view, double x
     return pntResult;
 }
 
+std::vector<int> GraphicsUtils::V3dView_findBoxesInsideArea(
+        const Handle_V3d_View& view, const QPolygon& area, Span<const Bnd_Box> spanBndBox)
+{
+    if (area.size() < 3 || spanBndBox.empty())
+        return {};
+
+    // Camera matrices are lazily computed by Graphic3d_Camera, so get them once before going
+    // multi-threaded
+    const Handle_Graphic3d_Camera& camera = view->Camera();
+    const Graphic3d_Mat4d matViewProj = camera->ProjectionMatrix() * camera->OrientationMatrix();
+    const int viewWidth = GraphicsUtils::AspectWindow_width(view->Window());
+    const int viewHeight = GraphicsUtils::AspectWindow_height(view->Window());
+    const QRect areaBndRect = area.boundingRect();
+    std::vector<char> vecInside(spanBndBox.size(), 0); // Not std::vector<bool>, written concurrently
+    OSD_Parallel::For(0, int(spanBndBox.size()), [&](int i) {
+        const Bnd_Box& bndBox = spanBndBox[i];
+        if (bndBox.IsVoid())
+            return;
+
+        const gp_Pnt pntMin = bndBox.CornerMin();
+        const gp_Pnt pntMax = bndBox.CornerMax();
+        for (int iCorner = 0; iCorner < 8; ++iCorner) {
+            const Graphic3d_Vec4d pnt(
+                        iCorner & 1 ? pntMax.X() : pntMin.X(),
+                        iCorner & 2 ? pntMax.Y() : pntMin.Y(),
+                        iCorner & 4 ? pntMax.Z() : pntMin.Z(),
+                        1.);
+            const Graphic3d_Vec4d pntClip = matViewProj * pnt;
+            if (pntClip.w() <= 0.)
+                return; // Behind the eye
+
+            const QPoint pntView(
+                        int((pntClip.x() / pntClip.w() + 1.) * 0.5 * viewWidth),
+                        int((1. - pntClip.y() / pntClip.w()) * 0.5 * viewHeight));
+            if (!areaBndRect.contains(pntView) || !area.containsPoint(pntView, Qt::OddEvenFill))
+                return;
+        }
+
+        vecInside.at(i) = 1;
+    });
+
+    std::vector<int> vecIndex;
+    for (size_t i = 0; i < vecInside.size(); ++i) {
+        if (vecInside.at(i))
+            vecIndex.push_back(int(i));
+    }
+
+    return vecIndex;
+}
+
+std::vector<int> GraphicsUtils::V3dView_findBoxesIntersectingRect(
+        const Handle_V3d_View& view, const QRect& rect, Span<const Bnd_Box> spanBndBox)
+{
+    std::vector<int> vecIndex;
+    if (rect.isEmpty() || spanBndBox.empty())
+        return vecIndex;
+
+    const Handle_Graphic3d_Camera& camera = view->Camera();
+    const Graphic3d_Mat4d matViewProj = camera->ProjectionMatrix() * camera->OrientationMatrix();
+    const double viewWidth = GraphicsUtils::AspectWindow_width(view->Window());
+    const double viewHeight = GraphicsUtils::AspectWindow_height(view->Window());
+    for (int i = 0; i < int(spanBndBox.size()); ++i) {
+        const Bnd_Box& bndBox = spanBndBox[i];
+        if (bndBox.IsVoid())
+            continue;
+
+        const gp_Pnt pntMin = bndBox.CornerMin();
+        const gp_Pnt pntMax = bndBox.CornerMax();
+        double xMin = std::numeric_limits<double>::max();
+        double yMin = std::numeric_limits<double>::max();
+        double xMax = std::numeric_limits<double>::lowest();
+        double yMax = std::numeric_limits<double>::lowest();
+        bool isBehindEye = false;
+        for (int iCorner = 0; iCorner < 8 && !isBehindEye; ++iCorner) {
+            const Graphic3d_Vec4d pnt(
+                        iCorner & 1 ? pntMax.X() : pntMin.X(),
+                        iCorner & 2 ? pntMax.Y() : pntMin.Y(),
+                        iCorner & 4 ? pntMax.Z() : pntMin.Z(),
+                        1.);
+            const Graphic3d_Vec4d pntClip = matViewProj * pnt;
+            isBehindEye = pntClip.w() <= 0.;
+            const double x = (pntClip.x() / pntClip.w() + 1.) * 0.5 * viewWidth;
+            const double y = (1. - pntClip.y() / pntClip.w()) * 0.5 * viewHeight;
+            xMin = std::min(xMin, x);
+            yMin = std::min(yMin, y);
+            xMax = std::max(xMax, x);
+            yMax = std::max(yMax, y);
+        }
+
+        if (isBehindEye
+                || (xMax >= rect.left() && xMin <= rect.right()
+                    && yMax >= rect.top() && yMin <= rect.bottom()))
+        {
+            vecIndex.push_back(i);
+        }
+    }
+
+    return vecIndex;
+}
+
+std::vector<double> GraphicsUtils::V3dView_projectedBoxSizes(
+        const Handle_V3d_View& view, Span<const Bnd_Box> spanBndBox)
+{
+    const Handle_Graphic3d_Camera& camera = view->Camera();
+    const Graphic3d_Mat4d matViewProj = camera->ProjectionMatrix() * camera->OrientationMatrix();
+    const double viewWidth = GraphicsUtils::AspectWindow_width(view->Window());
+    const double viewHeight = GraphicsUtils::AspectWindow_height(view->Window());
+    std::vector<double> vecSize(spanBndBox.size(), std::numeric_limits<double>::infinity());
+    OSD_Parallel::For(0, int(spanBndBox.size()), [&](int i) {
+        const Bnd_Box& bndBox = spanBndBox[i];
+        if (bndBox.IsVoid())
+            return;
+
+        const gp_Pnt pntMin = bndBox.CornerMin();
+        const gp_Pnt pntMax = bndBox.CornerMax();
+        double xMin = std::numeric_limits<double>::max();
+        double yMin = std::numeric_limits<double>::max();
+        double xMax = std::numeric_limits<double>::lowest();
+        double yMax = std::numeric_limits<double>::lowest();
+        for (int iCorner = 0; iCorner < 8; ++iCorner) {
+            const Graphic3d_Vec4d pnt(
+                        iCorner & 1 ? pntMax.X() : pntMin.X(),
+                        iCorner & 2 ? pntMax.Y() : pntMin.Y(),
+                        iCorner & 4 ? pntMax.Z() : pntMin.Z(),
+                        1.);
+            const Graphic3d_Vec4d pntClip = matViewProj * pnt;
+            if (pntClip.w() <= 0.) {
+                vecSize.at(i) = std::numeric_limits<double>::infinity();
+                return;
+            }
+
+            const double x = (pntClip.x() / pntClip.w() + 1.) * 0.5 * viewWidth;
+            const double y = (1. - pntClip.y() / pntClip.w()) * 0.5 * viewHeight;
+            xMin = std::min(xMin, x);
+            yMin = std::min(yMin, y);
+            xMax = std::max(xMax, x);
+            yMax = std::max(yMax, y);
+        }
+
+        vecSize.at(i) = std::hypot(xMax - xMin, yMax - yMin);
+    });
+
+    return vecSize;
+}
+
 void GraphicsUtils::AisContext_eraseObject(
         const Handle_AIS_InteractiveContext& context,
         const Handle_AIS_InteractiveObject& object)
@@ -10,6 +10,9 @@
 #include <AIS_InteractiveObject.hxx>
 #include <Aspect_Window.hxx>
 #include <V3d_View.hxx>
+#include <QtGui/QPolygon>
+#include "../base/span.h"
+#include <vector>
 
 namespace Mayo {
 
@@ -20,6 +23,18 @@ struct GraphicsUtils {
             const Handle_Graphic3d_ClipPlane& plane);
     static gp_Pnt V3dView_to3dPosition(
             const Handle_V3d_View& view, double x, double y);
+    // Indexes of the boxes lying entirely inside 'area'(closed polygon in view coordinates) once
+    // projected in 'view'. Boxes are tested in parallel
+    static std::vector<int> V3dView_findBoxesInsideArea(
+            const Handle_V3d_View& view, const QPolygon& area, Span<const Bnd_Box> spanBndBox);
+    // Indexes of the boxes whose projected bounding rectangle in 'view' intersects 'rect'(view
+    // coordinates). Boxes crossing the eye plane are always reported
+    static std::vector<int> V3dView_findBoxesIntersectingRect(
+            const Handle_V3d_View& view, const QRect& rect, Span<const Bnd_Box> spanBndBox);
+    // Sizes(in pixels) of the boxes once projected in 'view', ie the diagonal length of the
+    // projected bounding rectangle. Void boxes and boxes crossing the eye plane get an infinite size
+    static std::vector<double> V3dView_projectedBoxSizes(
+            const Handle_V3d_View& view, Span<const Bnd_Box> spanBndBox);
 
     static void AisContext_eraseObject(
             const Handle_AIS_InteractiveContext& context,
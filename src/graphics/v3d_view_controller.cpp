@@ -21,6 +21,7 @@ V3dViewController::V3dViewController(const Handle_V3d_View& view, QObject* paren
 V3dViewController::~V3dViewController()
 {
     delete m_rubberBand;
+    delete m_lasso;
 }
 
 void V3dViewController::zoomIn()
@@ -70,6 +71,16 @@ bool V3dViewController::isWindowZoomingStarted() const
     return m_dynamicAction == DynamicAction::WindowZoom;
 }
 
+bool V3dViewController::isBoxSelectionStarted() const
+{
+    return m_dynamicAction == DynamicAction::BoxSelection;
+}
+
+bool V3dViewController::isLassoSelectionStarted() const
+{
+    return m_dynamicAction == DynamicAction::LassoSelection;
+}
+
 void V3dViewController::drawRubberBand(const QPoint& posMin, const QPoint& posMax)
 {
     if (!m_rubberBand)
@@ -90,6 +101,21 @@ void V3dViewController::hideRubberBand()
         m_rubberBand->setVisible(false);
 }
 
+void V3dViewController::drawLasso(const QPolygon& polygon)
+{
+    if (!m_lasso)
+        m_lasso = this->createLasso();
+
+    m_lasso->updatePolygon(polygon);
+    m_lasso->setVisible(true);
+}
+
+void V3dViewController::hideLasso()
+{
+    if (m_lasso)
+        m_lasso->setVisible(false);
+}
+
 void V3dViewController::windowFitAll(const QPoint& posMin, const QPoint& posMax)
 {
     if (std::abs(posMin.x() - posMax.x()) > 1 || std::abs(posMin.y() - posMax.y()) > 1)
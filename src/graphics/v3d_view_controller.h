@@ -9,6 +9,7 @@
 #include <V3d_View.hxx>
 #include <QtCore/QObject>
 #include <QtCore/QPoint>
+#include <QtGui/QPolygon>
 
 namespace Mayo {
 
@@ -20,7 +21,9 @@ public:
         Panning,
         Rotation,
         WindowZoom,
-        InstantZoom
+        InstantZoom,
+        BoxSelection,
+        LassoSelection
     };
 
     struct AbstractRubberBand {
@@ -29,6 +32,12 @@ public:
         virtual void setVisible(bool on) = 0;
     };
 
+    struct AbstractLasso {
+        virtual ~AbstractLasso() {}
+        virtual void updatePolygon(const QPolygon& polygon) = 0;
+        virtual void setVisible(bool on) = 0;
+    };
+
     V3dViewController(const Handle_V3d_View& view, QObject* parent = nullptr);
     virtual ~V3dViewController();
 
@@ -46,6 +55,10 @@ signals:
     void mouseMoved(const QPoint& posMouseInView);
     void mouseClicked(Qt::MouseButton btn);
 
+    // Area selection gestures, coordinates are in the view space
+    void boxSelected(const QRect& rect);
+    void lassoSelected(const QPolygon& polygon);
+
 protected:
     void startDynamicAction(DynamicAction dynAction);
     void stopDynamicAction();
@@ -53,6 +66,8 @@ protected:
     bool isRotationStarted() const;
     bool isPanningStarted() const;
     bool isWindowZoomingStarted() const;
+    bool isBoxSelectionStarted() const;
+    bool isLassoSelectionStarted() const;
 
     void windowFitAll(const QPoint& posMin, const QPoint& posMax);
 
@@ -60,10 +75,15 @@ protected:
     void drawRubberBand(const QPoint& posMin, const QPoint& posMax);
     void hideRubberBand();
 
+    virtual AbstractLasso* createLasso() = 0;
+    void drawLasso(const QPolygon& polygon);
+    void hideLasso();
+
 private:
     Handle_V3d_View m_view;
     DynamicAction m_dynamicAction = DynamicAction::None;
     AbstractRubberBand* m_rubberBand = nullptr;
+    AbstractLasso* m_lasso = nullptr;
 };
 
 } // namespace Mayo
@@ -10,6 +10,7 @@
 #include "../base/application_item.h"
 #include "../base/bnd_utils.h"
 #include "../base/document.h"
+#include "../base/mesh_utils.h"
 #include "../base/tkernel_utils.h"
 #include "../gui/gui_application.h"
 #include "../graphics/graphics_entity_driver_table.h"
@@ -18,7 +19,10 @@
 
 #include <fougtools/occtools/qt_utils.h>
 
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QtDebug>
+#include <QtCore/QTimer>
+#include <algorithm>
 #if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
 #  include <AIS_ViewCube.hxx>
 #endif
@@ -31,6 +35,14 @@ namespace Mayo {
 
 namespace Internal {
 
+// Maximum time(milliseconds) spent activating pending selections per idle slice, so the GUI keeps
+// responsive and graphics scene can warm-up selection structures between slices
+const int SelectionActivationSliceDuration = 10;
+
+// Half-size(pixels) of the square around the cursor where entities get their selection activated
+// just before picking
+const int PickRectHalfSize = 4;
+
 // Defined in gui_create_gfx_driver.cpp
 Handle_Graphic3d_GraphicDriver createGfxDriver();
 
@@ -66,11 +78,20 @@ GuiDocument::GuiDocument(const DocumentPtr& doc, GuiApplication* guiApp)
       m_document(doc),
       m_gfxScene(this),
       m_v3dView(m_gfxScene.createV3dView()),
+      m_lodSelector(&m_gfxScene),
+      m_hlrPresenter(&m_gfxScene, m_v3dView),
       m_aisOriginTrihedron(Internal::createOriginTrihedron()),
-      m_cameraAnimation(new V3dViewCameraAnimation(m_v3dView, this))
+      m_cameraAnimation(new V3dViewCameraAnimation(m_v3dView, this)),
+      m_timerSelectionActivation(new QTimer(this))
 {
     Expects(!doc.IsNull());
 
+    m_timerSelectionActivation->setSingleShot(true);
+    m_timerSelectionActivation->setInterval(0);
+    QObject::connect(
+                m_timerSelectionActivation, &QTimer::timeout,
+                this, &GuiDocument::activatePendingSelectionSlice);
+
 #if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
     this->setViewTrihedronMode(ViewTrihedronMode::AisViewCube);
     this->setViewTrihedronCorner(Qt::TopLeftCorner);
@@ -93,14 +114,61 @@ GuiDocument::GuiDocument(const DocumentPtr& doc, GuiApplication* guiApp)
 
     m_cameraAnimation->setEasingCurve(QEasingCurve::OutExpo);
 
-    for (int i = 0; i < doc->entityCount(); ++i)
-        this->mapGraphics(doc->entityTreeNodeId(i));
+    // Task manager signals are emitted from worker threads, so 'ended' is a queued connection
+    QObject::connect(&m_taskMgr, &TaskManager::ended, this, &GuiDocument::onDeferredDataLoaded);
+    for (int i = 0; i < doc->entityCount(); ++i) {
+        const TreeNodeId entityTreeNodeId = doc->entityTreeNodeId(i);
+        if (!this->requestDeferredDataLoading(entityTreeNodeId))
+            this->mapGraphics(entityTreeNodeId);
+    }
+
+    GraphicsUtils::V3dView_fitAll(m_v3dView);
+    this->updateLevelsOfDetail();
+    this->updateHiddenLineDrawings();
 
     QObject::connect(doc.get(), &Document::colorChanged, this, &GuiDocument::onDocumentColorChanged);
+    QObject::connect(doc.get(), &Document::colorsChanged, this, &GuiDocument::onDocumentColorsChanged);
     QObject::connect(doc.get(), &Document::entityAdded, this, &GuiDocument::onDocumentEntityAdded);
     QObject::connect(
                 doc.get(), &Document::entityAboutToBeDestroyed,
                 this, &GuiDocument::onDocumentEntityAboutToBeDestroyed);
+    QObject::connect(
+                doc.get(), &Document::entityShapesChanged,
+                this, &GuiDocument::onDocumentEntityShapesChanged);
+    QObject::connect(
+                &m_gfxScene, &GraphicsScene::aboutToPick,
+                this, [=](const QPoint& pos, const Handle_V3d_View& view) {
+        if (view == m_v3dView) {
+            const QPoint ptHalfSize(Internal::PickRectHalfSize, Internal::PickRectHalfSize);
+            this->activateSelectionsIntersectingRect(QRect(pos - ptHalfSize, pos + ptHalfSize));
+        }
+    });
+    QObject::connect(
+                &m_gfxScene, &GraphicsScene::objectSelectionRecomputed,
+                this, [=](const GraphicsObjectPtr& object) {
+        for (GraphicsItem& item : m_vecGraphicsItem) {
+            if (item.graphicsEntity.aisObject() == object && item.isSelectionActivated) {
+                item.gpxTreeNodeMapping->clearGraphicsOwners();
+                this->mapSelectionOwners(&item);
+            }
+        }
+    });
+    QObject::connect(
+                m_cameraAnimation, &QAbstractAnimation::finished,
+                this, &GuiDocument::updateLevelsOfDetail);
+    QObject::connect(
+                m_cameraAnimation, &QAbstractAnimation::finished,
+                this, &GuiDocument::updateHiddenLineDrawings);
+    QObject::connect(
+                &m_gfxScene, &GraphicsScene::hiddenLineDrawingChanged,
+                &m_hlrPresenter, &GraphicsHlrPresenter::setEnabled);
+}
+
+GuiDocument::~GuiDocument()
+{
+    // Triangulations being loaded belong to the document shapes
+    for (const auto& mapPair : m_mapDeferredDataTask)
+        m_taskMgr.waitForDone(mapPair.first);
 }
 
 GraphicsEntity GuiDocument::findGraphicsEntity(TreeNodeId entityTreeNodeId) const
@@ -109,6 +177,14 @@ GraphicsEntity GuiDocument::findGraphicsEntity(TreeNodeId entityTreeNodeId) cons
     return gfxItem ? gfxItem->graphicsEntity : GraphicsEntity();
 }
 
+bool GuiDocument::isGraphicsEntityObject(const GraphicsObjectPtr& object) const
+{
+    return std::any_of(
+                m_vecGraphicsItem.cbegin(),
+                m_vecGraphicsItem.cend(),
+                [&](const GraphicsItem& item) { return item.graphicsEntity.aisObject() == object; });
+}
+
 void GuiDocument::toggleItemSelected(const ApplicationItem& appItem)
 {
     const DocumentPtr doc = appItem.document();
@@ -120,8 +196,9 @@ void GuiDocument::toggleItemSelected(const ApplicationItem& appItem)
         const TreeNodeId entityNodeId = doc->modelTree().nodeRoot(docTreeNode.id());
 
         // Add/remove graphics owner
-        const GraphicsItem* gfxItem = this->findGraphicsItem(entityNodeId);
+        GraphicsItem* gfxItem = this->findGraphicsItem(entityNodeId);
         if (gfxItem && gfxItem->gpxTreeNodeMapping) {
+            this->activateSelection(gfxItem);
             auto vecGfxOwner = gfxItem->gpxTreeNodeMapping->findGraphicsOwners(docTreeNode);
             for (const GraphicsOwnerPtr& gfxOwner : vecGfxOwner)
                 m_gfxScene.toggleOwnerSelection(gfxOwner);
@@ -129,6 +206,21 @@ void GuiDocument::toggleItemSelected(const ApplicationItem& appItem)
     }
 }
 
+std::vector<DocumentTreeNode> GuiDocument::findTreeNodesInsideArea(const QPolygon& area)
+{
+    this->activateSelectionsIntersectingRect(area.boundingRect());
+    std::vector<DocumentTreeNode> vecTreeNode;
+    for (const GraphicsItem& item : m_vecGraphicsItem) {
+        if (!item.gpxTreeNodeMapping || !m_gfxScene.isObjectVisible(item.graphicsEntity.aisObject()))
+            continue;
+
+        for (TreeNodeId nodeId : item.gpxTreeNodeMapping->findTreeNodesInsideArea(m_v3dView, area))
+            vecTreeNode.emplace_back(m_document, nodeId);
+    }
+
+    return vecTreeNode;
+}
+
 bool GuiDocument::isOriginTrihedronVisible() const
 {
     return m_gfxScene.isObjectVisible(m_aisOriginTrihedron);
@@ -162,6 +254,7 @@ void GuiDocument::setViewCameraOrientation(V3d_TypeOfOrientation projection)
 
 void GuiDocument::runViewCameraAnimation(const std::function<void (Handle_V3d_View)>& fnViewChange)
 {
+    this->suspendHiddenLineDrawings();
     m_cameraAnimation->configure(fnViewChange);
     m_cameraAnimation->start(QAbstractAnimation::KeepWhenStopped);
 }
@@ -284,38 +377,179 @@ int GuiDocument::aisViewCubeBoundingSize() const
 
 void GuiDocument::onDocumentColorChanged(TreeNodeId treeNodeId)
 {
-    const TreeNodeId entityTreeNodeId = m_document->modelTree().nodeRoot(treeNodeId);
-    const GraphicsItem* gfxItem = this->findGraphicsItem(entityTreeNodeId);
-    if (gfxItem) {
-        const GraphicsEntity& gfxEntity = gfxItem->graphicsEntity;
-        gfxEntity.driverPtr()->handleColorChanged(gfxEntity, { m_document, treeNodeId });
+    // Color changes are coalesced and applied at next event loop iteration, so a bulk change costs
+    // a single update of the graphics of each entity
+    if (m_vecPendingColorChangedNodeId.empty())
+        QTimer::singleShot(0, this, &GuiDocument::applyPendingColorChanges);
+
+    m_vecPendingColorChangedNodeId.push_back(treeNodeId);
+}
+
+void GuiDocument::onDocumentColorsChanged(const std::vector<TreeNodeId>& vecTreeNodeId)
+{
+    if (m_vecPendingColorChangedNodeId.empty())
+        QTimer::singleShot(0, this, &GuiDocument::applyPendingColorChanges);
+
+    m_vecPendingColorChangedNodeId.insert(
+                m_vecPendingColorChangedNodeId.end(), vecTreeNodeId.cbegin(), vecTreeNodeId.cend());
+}
+
+void GuiDocument::applyPendingColorChanges()
+{
+    // Same nodes may have been notified many times since last call
+    auto& vecPendingNodeId = m_vecPendingColorChangedNodeId;
+    std::sort(vecPendingNodeId.begin(), vecPendingNodeId.end());
+    vecPendingNodeId.erase(std::unique(vecPendingNodeId.begin(), vecPendingNodeId.end()), vecPendingNodeId.end());
+
+    std::unordered_map<TreeNodeId, std::vector<DocumentTreeNode>> mapEntityTreeNodes;
+    for (TreeNodeId treeNodeId : m_vecPendingColorChangedNodeId) {
+        const TreeNodeId entityTreeNodeId = m_document->modelTree().nodeRoot(treeNodeId);
+        mapEntityTreeNodes[entityTreeNodeId].emplace_back(m_document, treeNodeId);
     }
+
+    m_vecPendingColorChangedNodeId.clear();
+    {
+        GraphicsSceneRedrawBlocker redrawBlocker(&m_gfxScene); Q_UNUSED(redrawBlocker);
+        for (const auto& mapPair : mapEntityTreeNodes) {
+            const GraphicsItem* gfxItem = this->findGraphicsItem(mapPair.first);
+            if (gfxItem) {
+                const GraphicsEntity& gfxEntity = gfxItem->graphicsEntity;
+                gfxEntity.driverPtr()->handleColorsChanged(gfxEntity, mapPair.second);
+            }
+        }
+    }
+
+    m_gfxScene.redraw();
 }
 
 void GuiDocument::onDocumentEntityAdded(TreeNodeId entityTreeNodeId)
+{
+    // Otherwise entity is displayed by onDeferredDataLoaded()
+    if (!this->requestDeferredDataLoading(entityTreeNodeId))
+        this->displayNewEntity(entityTreeNodeId);
+}
+
+void GuiDocument::displayNewEntity(TreeNodeId entityTreeNodeId)
 {
     this->mapGraphics(entityTreeNodeId);
+    GraphicsUtils::V3dView_fitAll(m_v3dView);
+    this->updateLevelsOfDetail();
+    this->updateHiddenLineDrawings();
     emit graphicsBoundingBoxChanged(m_gpxBoundingBox);
 }
 
 void GuiDocument::onDocumentEntityAboutToBeDestroyed(TreeNodeId entityTreeNodeId)
 {
+    auto itPendingEnd = std::remove_if(
+                m_vecPendingColorChangedNodeId.begin(),
+                m_vecPendingColorChangedNodeId.end(),
+                [=](TreeNodeId nodeId) {
+        return m_document->modelTree().nodeRoot(nodeId) == entityTreeNodeId;
+    });
+    m_vecPendingColorChangedNodeId.erase(itPendingEnd, m_vecPendingColorChangedNodeId.end());
+
+    for (auto& mapPair : m_mapDeferredDataTask) {
+        if (mapPair.second == entityTreeNodeId)
+            mapPair.second = 0;
+    }
+
     const GraphicsItem* gfxItem = this->findGraphicsItem(entityTreeNodeId);
     if (gfxItem) {
         const GraphicsEntity& gfxEntity = gfxItem->graphicsEntity;
         m_gfxScene.eraseObject(gfxEntity.aisObject());
+        m_lodSelector.removeObject(gfxEntity.aisObject());
+        m_hlrPresenter.removeObject(gfxEntity.aisObject());
+        if (gfxItem->gpxTreeNodeMapping && !gfxItem->isSelectionActivated)
+            --m_pendingSelectionActivationCount;
+
         m_vecGraphicsItem.erase(m_vecGraphicsItem.begin() + (gfxItem - &m_vecGraphicsItem.front()));
         m_gfxScene.redraw();
+        this->updateHiddenLineDrawings();
+        this->recomputeGraphicsBoundingBox();
+        emit graphicsBoundingBoxChanged(m_gpxBoundingBox);
+    }
+}
 
-        // Recompute bounding box
-        m_gpxBoundingBox.SetVoid();
-        for (const GraphicsItem& item : m_vecGraphicsItem) {
-            const Bnd_Box entityBndBox = GraphicsUtils::AisObject_boundingBox(item.graphicsEntity.aisObject());
-            BndUtils::add(&m_gpxBoundingBox, entityBndBox);
-        }
+bool GuiDocument::requestDeferredDataLoading(TreeNodeId entityTreeNodeId)
+{
+    const TopoDS_Shape shape = XCaf::shape(m_document->modelTree().nodeData(entityTreeNodeId));
+    if (!MeshUtils::hasDeferredTriangulations(shape))
+        return false;
+
+    const TaskId taskId = m_taskMgr.newTask([=](TaskProgress*) {
+        MeshUtils::loadDeferredTriangulations(shape);
+    });
+    m_mapDeferredDataTask.insert({ taskId, entityTreeNodeId });
+    m_taskMgr.run(taskId);
+    return true;
+}
+
+bool GuiDocument::isDeferredDataLoading(TreeNodeId entityTreeNodeId) const
+{
+    return std::any_of(
+                m_mapDeferredDataTask.cbegin(), m_mapDeferredDataTask.cend(),
+                [=](const auto& mapPair) { return mapPair.second == entityTreeNodeId; });
+}
+
+void GuiDocument::onDeferredDataLoaded(TaskId taskId)
+{
+    auto itTask = m_mapDeferredDataTask.find(taskId);
+    if (itTask == m_mapDeferredDataTask.end())
+        return;
+
+    const TreeNodeId entityTreeNodeId = itTask->second;
+    m_mapDeferredDataTask.erase(itTask);
+    if (entityTreeNodeId != 0) // Entity not destroyed meanwhile
+        this->displayNewEntity(entityTreeNodeId);
+}
+
+void GuiDocument::onDocumentEntityShapesChanged(TreeNodeId entityTreeNodeId)
+{
+    // Entity will be mapped from its current shapes once its deferred data is loaded
+    if (this->isDeferredDataLoading(entityTreeNodeId))
+        return;
 
+    GraphicsItem* gfxItem = this->findGraphicsItem(entityTreeNodeId);
+    if (!gfxItem) {
+        this->mapGraphics(entityTreeNodeId);
+        this->updateLevelsOfDetail();
+        this->updateHiddenLineDrawings();
         emit graphicsBoundingBoxChanged(m_gpxBoundingBox);
+        return;
+    }
+
+    // Graphics object is kept along with its state in the scene(visibility, selection, display
+    // mode, ...) and the camera is left untouched, only presentations are recomputed
+    const GraphicsEntity& gfxEntity = gfxItem->graphicsEntity;
+    const GraphicsObjectPtr& gfxObject = gfxEntity.aisObject();
+    gfxEntity.driverPtr()->handleShapesChanged(gfxEntity);
+
+    gfxItem->bndBox = GraphicsUtils::AisObject_boundingBox(gfxObject);
+    m_lodSelector.removeObject(gfxObject);
+    m_lodSelector.addObject(gfxObject);
+    m_hlrPresenter.removeObject(gfxObject);
+    m_hlrPresenter.addObject(gfxObject);
+
+    // Graphics owners were recomputed along with the presentations, so mapping is built again
+    const bool wasSelectionActivated = gfxItem->isSelectionActivated;
+    if (gfxItem->gpxTreeNodeMapping && !wasSelectionActivated)
+        --m_pendingSelectionActivationCount;
+
+    const DocumentTreeNode entityTreeNode(m_document, entityTreeNodeId);
+    gfxItem->gpxTreeNodeMapping = m_guiApp->graphicsTreeNodeMappingDriverTable()->createMapping(entityTreeNode);
+    gfxItem->isSelectionActivated = false;
+    if (gfxItem->gpxTreeNodeMapping) {
+        ++m_pendingSelectionActivationCount;
+        if (wasSelectionActivated)
+            this->activateSelection(gfxItem);
+        else
+            this->requestPendingSelectionActivation();
     }
+
+    this->recomputeGraphicsBoundingBox();
+    this->updateLevelsOfDetail();
+    this->updateHiddenLineDrawings();
+    emit graphicsBoundingBoxChanged(m_gpxBoundingBox);
 }
 
 void GuiDocument::mapGraphics(TreeNodeId entityTreeNodeId)
@@ -332,26 +566,44 @@ void GuiDocument::mapGraphics(TreeNodeId entityTreeNodeId)
     item.entityTreeNodeId = entityTreeNodeId;
     m_gfxScene.redraw();
 
+    // Selection is activated later(see activateSelection()), computation of sensitive entities
+    // and owners can be costly and isn't needed as long as user doesn't pick anything
     item.gpxTreeNodeMapping = m_guiApp->graphicsTreeNodeMappingDriverTable()->createMapping(entityTreeNode);
     if (item.gpxTreeNodeMapping) {
-        const int selectMode = item.gpxTreeNodeMapping->selectionMode();
-        if (selectMode != -1) {
-            m_gfxScene.activateObjectSelection(gfxEntity.aisObject(), selectMode);
-            m_gfxScene.foreachOwner(gfxEntity.aisObject(), selectMode, [&](const GraphicsOwnerPtr& ptr) {
-                if (!item.gpxTreeNodeMapping->mapGraphicsOwner(ptr))
-                    qDebug() << "Insertion failed";
-            });
-
-            //m_aisContext->Deactivate(gfxEntity.aisObject(), selectMode);
-        }
+        ++m_pendingSelectionActivationCount;
+        this->requestPendingSelectionActivation();
     }
 
-    GraphicsUtils::V3dView_fitAll(m_v3dView);
-    const Bnd_Box itemBndBox = GraphicsUtils::AisObject_boundingBox(item.graphicsEntity.aisObject());
-    BndUtils::add(&m_gpxBoundingBox, itemBndBox);
+    item.bndBox = GraphicsUtils::AisObject_boundingBox(item.graphicsEntity.aisObject());
+    BndUtils::add(&m_gpxBoundingBox, item.bndBox);
+    m_lodSelector.addObject(item.graphicsEntity.aisObject());
+    m_hlrPresenter.addObject(item.graphicsEntity.aisObject());
     m_vecGraphicsItem.emplace_back(std::move(item));
 }
 
+void GuiDocument::recomputeGraphicsBoundingBox()
+{
+    m_gpxBoundingBox.SetVoid();
+    for (const GraphicsItem& item : m_vecGraphicsItem)
+        BndUtils::add(&m_gpxBoundingBox, item.bndBox);
+}
+
+void GuiDocument::updateLevelsOfDetail()
+{
+    if (m_lodSelector.update(m_v3dView))
+        m_gfxScene.redraw();
+}
+
+void GuiDocument::updateHiddenLineDrawings()
+{
+    m_hlrPresenter.update();
+}
+
+void GuiDocument::suspendHiddenLineDrawings()
+{
+    m_hlrPresenter.suspend();
+}
+
 const GuiDocument::GraphicsItem* GuiDocument::findGraphicsItem(TreeNodeId entityTreeNodeId) const
 {
     auto itFound = std::find_if(
@@ -361,6 +613,80 @@ const GuiDocument::GraphicsItem* GuiDocument::findGraphicsItem(TreeNodeId entity
     return itFound != m_vecGraphicsItem.end() ? &(*itFound) : nullptr;
 }
 
+GuiDocument::GraphicsItem* GuiDocument::findGraphicsItem(TreeNodeId entityTreeNodeId)
+{
+    const GuiDocument* constThis = this;
+    return const_cast<GraphicsItem*>(constThis->findGraphicsItem(entityTreeNodeId));
+}
+
+void GuiDocument::activateSelection(GraphicsItem* item)
+{
+    if (!item || !item->gpxTreeNodeMapping || item->isSelectionActivated)
+        return;
+
+    item->isSelectionActivated = true;
+    --m_pendingSelectionActivationCount;
+    const int selectMode = item->gpxTreeNodeMapping->selectionMode();
+    if (selectMode != -1) {
+        m_gfxScene.activateObjectSelection(item->graphicsEntity.aisObject(), selectMode);
+        this->mapSelectionOwners(item);
+    }
+}
+
+void GuiDocument::mapSelectionOwners(GraphicsItem* item)
+{
+    const int selectMode = item->gpxTreeNodeMapping->selectionMode();
+    if (selectMode == -1)
+        return;
+
+    const GraphicsObjectPtr& gfxObject = item->graphicsEntity.aisObject();
+    m_gfxScene.foreachOwner(gfxObject, selectMode, [=](const GraphicsOwnerPtr& ptr) {
+        if (!item->gpxTreeNodeMapping->mapGraphicsOwner(ptr))
+            qDebug() << "Insertion failed";
+    });
+}
+
+void GuiDocument::activateSelectionsIntersectingRect(const QRect& rect)
+{
+    if (!this->hasPendingSelectionActivation())
+        return;
+
+    std::vector<GraphicsItem*> vecPendingItem;
+    std::vector<Bnd_Box> vecPendingBndBox;
+    for (GraphicsItem& item : m_vecGraphicsItem) {
+        if (item.gpxTreeNodeMapping && !item.isSelectionActivated) {
+            vecPendingItem.push_back(&item);
+            vecPendingBndBox.push_back(item.bndBox);
+        }
+    }
+
+    for (int i : GraphicsUtils::V3dView_findBoxesIntersectingRect(m_v3dView, rect, vecPendingBndBox))
+        this->activateSelection(vecPendingItem.at(i));
+}
+
+void GuiDocument::activatePendingSelectionSlice()
+{
+    QElapsedTimer chrono;
+    chrono.start();
+    for (GraphicsItem& item : m_vecGraphicsItem) {
+        if (!this->hasPendingSelectionActivation())
+            return;
+
+        if (chrono.elapsed() >= Internal::SelectionActivationSliceDuration) {
+            this->requestPendingSelectionActivation();
+            return;
+        }
+
+        this->activateSelection(&item);
+    }
+}
+
+void GuiDocument::requestPendingSelectionActivation()
+{
+    if (!m_timerSelectionActivation->isActive())
+        m_timerSelectionActivation->start();
+}
+
 void GuiDocument::v3dViewTrihedronDisplay(Qt::Corner corner)
 {
     constexpr double scale = 0.075;
@@ -7,7 +7,10 @@
 #pragma once
 
 #include "../base/document.h"
+#include "../base/task_manager.h"
 #include "../graphics/graphics_entity.h"
+#include "../graphics/graphics_hlr_presenter.h"
+#include "../graphics/graphics_lod_selector.h"
 #include "../graphics/graphics_scene.h"
 #include "../graphics/graphics_tree_node_mapping.h"
 
@@ -21,6 +24,8 @@
 #include <unordered_map>
 #include <vector>
 
+class QTimer;
+
 namespace Mayo {
 
 class ApplicationItem;
@@ -31,6 +36,7 @@ class GuiDocument : public QObject {
     Q_OBJECT
 public:
     GuiDocument(const DocumentPtr& doc, GuiApplication* guiApp);
+    ~GuiDocument();
 
     GuiApplication* guiApplication() const { return m_guiApp; }
 
@@ -39,9 +45,29 @@ public:
     GraphicsScene* graphicsScene() { return &m_gfxScene; }
     const Bnd_Box& graphicsBoundingBox() const { return m_gpxBoundingBox; }
     GraphicsEntity findGraphicsEntity(TreeNodeId entityTreeNodeId) const;
+    // Whether 'object' is the graphics object of some document entity(ie not a helper object like
+    // origin trihedron, view cube, ...)
+    bool isGraphicsEntityObject(const GraphicsObjectPtr& object) const;
 
     void toggleItemSelected(const ApplicationItem& appItem);
 
+    // Selection of graphics entities is not activated when they are mapped but lazily: entities
+    // under the cursor are activated just before picking, remaining ones in short idle slices
+    bool hasPendingSelectionActivation() const { return m_pendingSelectionActivationCount > 0; }
+
+    // Tree nodes of the visible entities lying entirely inside 'area'(closed polygon in view
+    // coordinates), typically result of box or lasso selection
+    std::vector<DocumentTreeNode> findTreeNodesInsideArea(const QPolygon& area);
+
+    // Switches level of detail of graphics entities from their size once projected in the 3D view
+    // Cheap if camera didn't change since previous call, so it can be called on each view change
+    void updateLevelsOfDetail();
+
+    // Hidden-line drawings of graphics entities(see GraphicsHlrPresenter), when enabled in the
+    // graphics scene. Drawings are erased when suspended, until next update
+    void updateHiddenLineDrawings();
+    void suspendHiddenLineDrawings();
+
     bool isOriginTrihedronVisible() const;
     void toggleOriginTrihedronVisibility();
 
@@ -72,18 +98,38 @@ signals:
 
 private:
     void onDocumentColorChanged(TreeNodeId treeNodeId);
+    void onDocumentColorsChanged(const std::vector<TreeNodeId>& vecTreeNodeId);
+    void applyPendingColorChanges();
     void onDocumentEntityAdded(TreeNodeId entityTreeNodeId);
     void onDocumentEntityAboutToBeDestroyed(TreeNodeId entityTreeNodeId);
+    void onDocumentEntityShapesChanged(TreeNodeId entityTreeNodeId);
+
+    // Entities having triangulations whose loading was deferred by the reader(eg glTF) are mapped
+    // once these triangulations are loaded in a worker thread
+    // Returns false if entity has no deferred triangulation, then it can be mapped right now
+    bool requestDeferredDataLoading(TreeNodeId entityTreeNodeId);
+    bool isDeferredDataLoading(TreeNodeId entityTreeNodeId) const;
+    void onDeferredDataLoaded(TaskId taskId);
+    void displayNewEntity(TreeNodeId entityTreeNodeId);
 
     void mapGraphics(TreeNodeId entityTreeNodeId);
+    void recomputeGraphicsBoundingBox();
 
     struct GraphicsItem {
         GraphicsEntity graphicsEntity;
         TreeNodeId entityTreeNodeId;
         std::unique_ptr<GraphicsTreeNodeMapping> gpxTreeNodeMapping;
+        bool isSelectionActivated = false;
+        Bnd_Box bndBox;
     };
 
     const GraphicsItem* findGraphicsItem(TreeNodeId entityTreeNodeId) const;
+    GraphicsItem* findGraphicsItem(TreeNodeId entityTreeNodeId);
+    void activateSelection(GraphicsItem* item);
+    void mapSelectionOwners(GraphicsItem* item);
+    void activateSelectionsIntersectingRect(const QRect& rect);
+    void activatePendingSelectionSlice();
+    void requestPendingSelectionActivation();
 
     void v3dViewTrihedronDisplay(Qt::Corner corner);
 
@@ -91,6 +137,8 @@ private:
     DocumentPtr m_document;
     GraphicsScene m_gfxScene;
     Handle_V3d_View m_v3dView;
+    GraphicsLodSelector m_lodSelector;
+    GraphicsHlrPresenter m_hlrPresenter;
     Handle_AIS_InteractiveObject m_aisOriginTrihedron;
 
     V3dViewCameraAnimation* m_cameraAnimation;
@@ -99,7 +147,12 @@ private:
     Handle_AIS_InteractiveObject m_aisViewCube;
 
     std::vector<GraphicsItem> m_vecGraphicsItem;
+    std::vector<TreeNodeId> m_vecPendingColorChangedNodeId;
+    int m_pendingSelectionActivationCount = 0;
+    QTimer* m_timerSelectionActivation = nullptr;
     Bnd_Box m_gpxBoundingBox;
+    TaskManager m_taskMgr;
+    std::unordered_map<TaskId, TreeNodeId> m_mapDeferredDataTask; // Null tree node if entity destroyed
 };
 
 } // namespace Mayo
@@ -14,6 +14,7 @@ INCLUDEPATH += \
 HEADERS += \
     test.h \
     $$files(../src/base/*.h) \
+    $$files(../src/graphics/*.h) \
 
 SOURCES += \
     test.cpp \
@@ -21,6 +22,8 @@ SOURCES += \
     \
     ../src/3rdparty/fougtools/occtools/qt_utils.cpp \
     $$files(../src/base/*.cpp) \
+    $$files(../src/graphics/*.cpp) \
+    ../src/gui/gui_create_gfx_driver.cpp \
 
 CONFIG += file_copies
 COPIES += MayoInputs
@@ -30,8 +33,10 @@ MayoInputs.path = $$OUT_PWD/inputs
 # OpenCascade
 include(../opencascade.pri)
 LIBS += -lTKernel -lTKMath -lTKBRep -lTKGeomBase -lTKTopAlgo -lTKPrim -lTKMesh -lTKG3d
+LIBS += -lTKBO -lTKHLR
 LIBS += -lTKXSBase
 LIBS += -lTKLCAF -lTKXCAF -lTKCAF
+LIBS += -lTKG2d -lTKGeomAlgo -lTKMeshVS -lTKOpenGl -lTKService -lTKV3d -lTKVCAF
 LIBS += -lTKCDF -lTKBin -lTKBinL -lTKBinXCAF -lTKXml -lTKXmlL -lTKXmlXCAF
 # -- IGES support
 LIBS += -lTKIGES -lTKXDEIGES
@@ -50,7 +55,10 @@ minOpenCascadeVersion(7, 4, 0) {
 }
 
 !minOpenCascadeVersion(7, 5, 0) {
-    SOURCES -= ../src/base/io_occ_gltf_writer.cpp
+    SOURCES -= \
+        ../src/base/io_gltf_parallel_writer.cpp \
+        ../src/base/io_obj_parallel_reader.cpp \
+        ../src/base/io_occ_gltf_writer.cpp
 }
 # -- VRML support
 LIBS += -lTKVRML
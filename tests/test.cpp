@@ -9,37 +9,89 @@
 
 #include "test.h"
 #include "../src/base/application.h"
+#include "../src/base/application_item_selection_model.h"
 #include "../src/base/brep_utils.h"
 #include "../src/base/caf_utils.h"
+#include "../src/base/document_coloring.h"
+#include "../src/base/document_formula_table.h"
+#include "../src/base/formula.h"
 #include "../src/base/geom_utils.h"
+#include "../src/base/io_file_scan.h"
+#include "../src/base/io_import_cache.h"
+#include "../src/base/io_mayo_doc.h"
 #include "../src/base/io_occ.h"
+#include "../src/base/io_occ_step.h"
+#include "../src/base/io_occ_stl.h"
+#include "../src/base/io_step_parallel_reader.h"
 #include "../src/base/io_system.h"
+#include "../src/base/occ_mapped_file_system.h"
 #include "../src/base/occ_static_variables_rollback.h"
 #include "../src/base/libtree.h"
 #include "../src/base/mesh_utils.h"
 #include "../src/base/meta_enum.h"
+#include "../src/base/property_builtins.h"
 #include "../src/base/result.h"
+#include "../src/base/settings.h"
+#include "../src/base/shape_hlr.h"
+#include "../src/base/shape_section.h"
 #include "../src/base/string_utils.h"
 #include "../src/base/task_manager.h"
+#include "../src/base/tkernel_utils.h"
 #include "../src/base/unit.h"
 #include "../src/base/unit_system.h"
+#include "../src/graphics/graphics_entity_driver.h"
+#include "../src/graphics/graphics_hlr_presenter.h"
+#include "../src/graphics/graphics_lod_selector.h"
+#include "../src/graphics/graphics_object_unloader.h"
+#include "../src/graphics/graphics_scene.h"
+#include "../src/graphics/graphics_shape_object.h"
+#include "../src/graphics/graphics_tree_node_mapping.h"
+
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+#  include "../src/base/io_gltf_parallel_writer.h"
+#  include "../src/base/io_occ_gltf_reader.h"
+#  include "../src/base/io_occ_obj.h"
+#endif
 
 #include <fougtools/occtools/qt_utils.h>
 
+#include <AIS_Shape.hxx>
 #include <BRep_Tool.hxx>
 #include <BRepAdaptor_Curve.hxx>
+#include <BRepBndLib.hxx>
+#include <Bnd_Box.hxx>
 #include <BRepMesh_IncrementalMesh.hxx>
 #include <GCPnts_TangentialDeflection.hxx>
+#include <gp.hxx>
 #include <Interface_ParamType.hxx>
 #include <Interface_Static.hxx>
+#include <RWStl.hxx>
+#include <STEPControl_Reader.hxx>
+#include <StdSelect_BRepOwner.hxx>
+#include <StepData_StepModel.hxx>
 #include <TopAbs_ShapeEnum.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <XCAFDoc_ColorTool.hxx>
+#include <XCAFDoc_ShapeTool.hxx>
 #include <QtCore/QtDebug>
+#include <QtCore/QDir>
 #include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QThread>
+#include <QtCore/QtEndian>
 #include <QtCore/QVariant>
 #include <QtTest/QSignalSpy>
 #include <gsl/gsl_util>
+#include <algorithm>
 #include <cmath>
 #include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
 #include <utility>
 #include <iostream>
 #include <sstream>
@@ -63,6 +115,16 @@ static bool operator==(
             && std::abs(lhs.factor - rhs.factor) < 1e-6;
 }
 
+// GraphicsScene needs a connection to the display server on X11
+static bool isGraphicsSceneAvailable()
+{
+#if defined(Q_OS_WIN) || defined(Q_OS_MAC)
+    return true;
+#else
+    return !qEnvironmentVariableIsEmpty("DISPLAY");
+#endif
+}
+
 void Test::Application_test()
 {
     auto app = Application::instance();
@@ -131,9 +193,97 @@ void Test::Application_test()
         QCOMPARE(doc->entityCount(), 0);
     }
 
+    {   // Close document in background
+        DocumentPtr doc = app->newDocument();
+        QVERIFY(fnImportInDocument(doc, "inputs/cube.step"));
+        QCOMPARE(doc->entityCount(), 1);
+
+        TaskManager taskMgr;
+        QSignalSpy sigSpy_documentAboutToClose(app.get(), &Application::documentAboutToClose);
+        const TaskId taskId = app->closeDocumentInBackground(doc, &taskMgr);
+        QCOMPARE(sigSpy_documentAboutToClose.count(), 1);
+        QCOMPARE(app->documentCount(), 0);
+        QVERIFY(taskMgr.waitForDone(taskId));
+        QVERIFY(!XCaf::isShape(doc->entityLabel(0)));
+        QCOMPARE(doc->rootLabel().NbAttributes(), 0);
+    }
+
     QCOMPARE(app->documentCount(), 0);
 }
 
+void Test::ApplicationItemSelectionModel_test()
+{
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+    std::vector<ApplicationItem> vecItem;
+    for (TreeNodeId id = 1; id <= 10; ++id)
+        vecItem.push_back(DocumentTreeNode(doc, id));
+
+    ApplicationItemSelectionModel selModel;
+    std::vector<ApplicationItem> vecLastSelected;
+    std::vector<ApplicationItem> vecLastDeselected;
+    QObject::connect(
+                &selModel, &ApplicationItemSelectionModel::changed,
+                [&](Span<ApplicationItem> selected, Span<ApplicationItem> deselected) {
+        vecLastSelected.assign(selected.begin(), selected.end());
+        vecLastDeselected.assign(deselected.begin(), deselected.end());
+    });
+
+    // Items already selected are skipped, only new ones are reported as selected
+    selModel.add(Span<ApplicationItem>(vecItem).first(5));
+    selModel.add(Span<ApplicationItem>(vecItem).first(7));
+    QCOMPARE(selModel.selectedItemCount(), size_t(7));
+    QCOMPARE(vecLastSelected.size(), size_t(2));
+    QVERIFY(vecLastSelected.at(0) == vecItem.at(5));
+    QVERIFY(vecLastSelected.at(1) == vecItem.at(6));
+    QVERIFY(vecLastDeselected.empty());
+    QVERIFY(selModel.isSelected(vecItem.at(6)));
+    QVERIFY(!selModel.isSelected(vecItem.at(7)));
+
+    // Remove keeps selection order
+    std::vector<ApplicationItem> vecToRemove = { vecItem.at(0), vecItem.at(3), vecItem.at(8) };
+    selModel.remove(vecToRemove);
+    QCOMPARE(vecLastDeselected.size(), size_t(2));
+    QVERIFY(vecLastSelected.empty());
+    const std::vector<ApplicationItem> vecExpected = {
+        vecItem.at(1), vecItem.at(2), vecItem.at(4), vecItem.at(5), vecItem.at(6)
+    };
+    QVERIFY(std::equal(
+                vecExpected.cbegin(), vecExpected.cend(),
+                selModel.selectedItems().begin(), selModel.selectedItems().end()));
+    QVERIFY(!selModel.isSelected(vecItem.at(3)));
+    QVERIFY(selModel.isSelected(vecItem.at(4)));
+
+    // Toggle
+    std::vector<ApplicationItem> vecToToggle = { vecItem.at(1), vecItem.at(9) };
+    selModel.toggle(vecToToggle);
+    QCOMPARE(selModel.selectedItemCount(), size_t(5));
+    QCOMPARE(vecLastSelected.size(), size_t(1));
+    QVERIFY(vecLastSelected.front() == vecItem.at(9));
+    QCOMPARE(vecLastDeselected.size(), size_t(1));
+    QVERIFY(vecLastDeselected.front() == vecItem.at(1));
+    for (const ApplicationItem& item : selModel.selectedItems())
+        QVERIFY(selModel.isSelected(item));
+
+    // Replace whole selection, as box selection does
+    std::vector<ApplicationItem> vecNewSelection = { vecItem.at(4), vecItem.at(8) };
+    selModel.setSelectedItems(vecNewSelection);
+    QCOMPARE(selModel.selectedItemCount(), size_t(2));
+    QCOMPARE(vecLastSelected.size(), size_t(1));
+    QVERIFY(vecLastSelected.front() == vecItem.at(8));
+    QCOMPARE(vecLastDeselected.size(), size_t(4));
+    QVERIFY(selModel.isSelected(vecItem.at(4)));
+    QVERIFY(!selModel.isSelected(vecItem.at(9)));
+
+    // Clear
+    QSignalSpy sigSpy_cleared(&selModel, &ApplicationItemSelectionModel::cleared);
+    selModel.clear();
+    QCOMPARE(sigSpy_cleared.count(), 1);
+    QCOMPARE(selModel.selectedItemCount(), size_t(0));
+    QVERIFY(!selModel.isSelected(vecItem.at(9)));
+}
+
 void Test::TextId_test()
 {
     QVERIFY(TextId(MAYO_TEXT_ID("Mayo::Test", "foobar")).key == "foobar");
@@ -223,6 +373,720 @@ void Test::IO_OccStaticVariablesRollback_test_data()
     QTest::newRow("var_str2") << "mayo.test.variable_str2" << QVariant("foo") << QVariant("blah");
 }
 
+void Test::IO_OccStlWriter_test()
+{
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+    const bool okImport = app->ioSystem()->importInDocument()
+            .targetDocument(doc)
+            .withFilepaths({ "inputs/cube.step" })
+            .execute();
+    QVERIFY(okImport);
+    BRepMesh_IncrementalMesh mesher(XCaf::shape(doc->entityLabel(0)), 0.1);
+    QVERIFY(mesher.IsDone());
+
+    for (const IO::OccStlWriter::Format format : { IO::OccStlWriter::Format::Ascii, IO::OccStlWriter::Format::Binary }) {
+        const QString filepath = QDir::temp().absoluteFilePath("mayo_test_writer.stl");
+        auto _ = gsl::finally([=]{ QFile::remove(filepath); });
+        IO::OccStlWriter writer;
+        writer.parameters().format = format;
+        const ApplicationItem appItem(doc);
+        QVERIFY(writer.transfer(Span<const ApplicationItem>(&appItem, 1), nullptr));
+        QVERIFY(writer.writeFile(filepath, nullptr));
+        QCOMPARE(app->ioSystem()->probeFormat(filepath), IO::Format_STL);
+
+        // Faces of the cube are two triangles each
+        const Handle_Poly_Triangulation mesh = RWStl::ReadFile(filepath.toUtf8().constData());
+        QVERIFY(!mesh.IsNull());
+        QCOMPARE(mesh->NbTriangles(), 12);
+    }
+}
+
+void Test::IO_OccBinaryBRep_test()
+{
+    auto fnFaceCount = [](const TopoDS_Shape& shape) {
+        int count = 0;
+        BRepUtils::forEachSubFace(shape, [&](const TopoDS_Face&) { ++count; });
+        return count;
+    };
+
+    // In-memory round-trip keeps triangulation
+    {
+        const TopoDS_Shape shapeBox = BRepPrimAPI_MakeBox(10, 20, 30);
+        BRepMesh_IncrementalMesh mesher(shapeBox, 0.1);
+        QVERIFY(mesher.IsDone());
+        const TopoDS_Shape shape = BRepUtils::shapeFromBinaryString(BRepUtils::shapeToBinaryString(shapeBox));
+        QVERIFY(!shape.IsNull());
+        QCOMPARE(fnFaceCount(shape), 6);
+        BRepUtils::forEachSubFace(shape, [](const TopoDS_Face& face) {
+            TopLoc_Location loc;
+            QVERIFY(!BRep_Tool::Triangulation(face, loc).IsNull());
+        });
+    }
+
+    // Export then import back through IO::System
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+    const bool okImport = app->ioSystem()->importInDocument()
+            .targetDocument(doc)
+            .withFilepaths({ "inputs/cube.brep" })
+            .execute();
+    QVERIFY(okImport);
+
+    const QString filepath = QDir::temp().absoluteFilePath("mayo_test_writer.bbrep");
+    auto _2 = gsl::finally([=]{ QFile::remove(filepath); });
+    const ApplicationItem appItem(doc);
+    const bool okExport = app->ioSystem()->exportApplicationItems()
+            .targetFile(filepath)
+            .targetFormat(IO::Format_OCCBREP_BIN)
+            .withItems(Span<const ApplicationItem>(&appItem, 1))
+            .execute();
+    QVERIFY(okExport);
+    QCOMPARE(app->ioSystem()->probeFormat(filepath), IO::Format_OCCBREP_BIN);
+
+    DocumentPtr docRead = app->newDocument();
+    auto _3 = gsl::finally([=]{ app->closeDocument(docRead); });
+    const bool okImportBin = app->ioSystem()->importInDocument()
+            .targetDocument(docRead)
+            .withFilepaths({ filepath })
+            .execute();
+    QVERIFY(okImportBin);
+    QCOMPARE(docRead->entityCount(), 1);
+    QCOMPARE(fnFaceCount(XCaf::shape(docRead->entityLabel(0))), fnFaceCount(XCaf::shape(doc->entityLabel(0))));
+}
+
+void Test::IO_MayoDoc_test()
+{
+    auto fnFaceCount = [](const TopoDS_Shape& shape) {
+        int count = 0;
+        for (TopExp_Explorer expFace(shape, TopAbs_FACE); expFace.More(); expFace.Next())
+            ++count;
+
+        return count;
+    };
+
+    // Assembly with two instances of a colored part
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+    const Handle_XCAFDoc_ShapeTool shapeTool = doc->xcaf().shapeTool();
+    const Handle_XCAFDoc_ColorTool colorTool = doc->xcaf().colorTool();
+    const TopoDS_Shape shapeBox = BRepPrimAPI_MakeBox(10, 20, 30);
+    BRepMesh_IncrementalMesh(shapeBox, 1.);
+    const TDF_Label partLabel = shapeTool->AddShape(shapeBox, false);
+    CafUtils::setLabelAttrStdName(partLabel, "Box");
+    colorTool->SetColor(partLabel, Quantity_Color(Quantity_NOC_RED), XCAFDoc_ColorSurf);
+    const TopoDS_Shape shapeFace = TopExp_Explorer(shapeBox, TopAbs_FACE).Current();
+    const TDF_Label faceLabel = shapeTool->AddSubShape(partLabel, shapeFace);
+    colorTool->SetColor(faceLabel, Quantity_Color(Quantity_NOC_BLUE1), XCAFDoc_ColorSurf);
+    const TDF_Label asmLabel = shapeTool->NewShape();
+    CafUtils::setLabelAttrStdName(asmLabel, "Assembly");
+    gp_Trsf trsf;
+    trsf.SetTranslation(gp_Vec(100, 0, 0));
+    shapeTool->AddComponent(asmLabel, partLabel, TopLoc_Location());
+    const TDF_Label compLabel = shapeTool->AddComponent(asmLabel, partLabel, TopLoc_Location(trsf));
+    CafUtils::setLabelAttrStdName(compLabel, "Box_moved");
+
+    const QString filepath = QDir::temp().absoluteFilePath("mayo_test_doc.mayo");
+    auto _2 = gsl::finally([=]{ QFile::remove(filepath); });
+    {
+        IO::MayoDocWriter writer;
+        TaskProgress progress;
+        const ApplicationItem appItem(doc);
+        QVERIFY(writer.transfer(Span<const ApplicationItem>(&appItem, 1), &progress));
+        QVERIFY(writer.writeFile(filepath, &progress));
+        QCOMPARE(app->ioSystem()->probeFormat(filepath), IO::Format_MAYODOC);
+    }
+
+    auto fnCheckDocument = [&](const DocumentPtr& docRead) {
+        QCOMPARE(docRead->entityCount(), 1);
+        const TDF_Label entityLabel = docRead->entityLabel(0);
+        QVERIFY(XCaf::isShapeAssembly(entityLabel));
+        QCOMPARE(CafUtils::labelAttrStdName(entityLabel), QString("Assembly"));
+        const TDF_LabelSequence seqComponent = XCaf::shapeComponents(entityLabel);
+        QCOMPARE(seqComponent.Length(), 2);
+        QCOMPARE(CafUtils::labelAttrStdName(seqComponent.Value(2)), QString("Box_moved"));
+        const gp_XYZ pnt = XCaf::shapeReferenceLocation(seqComponent.Value(2)).Transformation().TranslationPart();
+        QVERIFY(pnt.IsEqual(gp_XYZ(100, 0, 0), Precision::Confusion()));
+        const TDF_Label readPartLabel = XCaf::shapeReferred(seqComponent.Value(1));
+        QCOMPARE(XCaf::shapeReferred(seqComponent.Value(2)), readPartLabel);
+        QCOMPARE(CafUtils::labelAttrStdName(readPartLabel), QString("Box"));
+        Quantity_Color color;
+        QVERIFY(docRead->xcaf().colorTool()->GetColor(readPartLabel, XCAFDoc_ColorSurf, color));
+        QVERIFY(color.IsEqual(Quantity_Color(Quantity_NOC_RED)));
+    };
+    auto fnPartLabel = [](const DocumentPtr& docRead) {
+        return XCaf::shapeReferred(XCaf::shapeComponents(docRead->entityLabel(0)).Value(1));
+    };
+
+    auto fnTriangleCount = [](const TopoDS_Shape& shape) {
+        int count = 0;
+        for (TopExp_Explorer expFace(shape, TopAbs_FACE); expFace.More(); expFace.Next()) {
+            TopLoc_Location loc;
+            const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(TopoDS::Face(expFace.Current()), loc);
+            count += !triangulation.IsNull() ? triangulation->NbTriangles() : 0;
+        }
+
+        return count;
+    };
+    QVERIFY(fnTriangleCount(shapeBox) > 0);
+
+    auto fnCheckPartGeometry = [&](const DocumentPtr& docRead, const TDF_Label& readPartLabel) {
+        QCOMPARE(fnFaceCount(XCaf::shape(readPartLabel)), 6);
+        QCOMPARE(fnTriangleCount(XCaf::shape(readPartLabel)), fnTriangleCount(shapeBox));
+        const TDF_LabelSequence seqSubShape = XCaf::shapeSubs(readPartLabel);
+        QCOMPARE(seqSubShape.Length(), 1);
+        Quantity_Color color;
+        QVERIFY(docRead->xcaf().colorTool()->GetColor(seqSubShape.Value(1), XCAFDoc_ColorSurf, color));
+        QVERIFY(color.IsEqual(Quantity_Color(Quantity_NOC_BLUE1)));
+    };
+
+    // Geometry decoded at import
+    {
+        DocumentPtr docRead = app->newDocument();
+        auto _3 = gsl::finally([=]{ app->closeDocument(docRead); });
+        IO::MayoDocReader reader;
+        TaskProgress progress;
+        QVERIFY(reader.readFile(filepath, &progress));
+        QVERIFY(reader.transfer(docRead, &progress));
+        QVERIFY(docRead->lazyShapeLoaders().empty());
+        fnCheckDocument(docRead);
+        fnCheckPartGeometry(docRead, fnPartLabel(docRead));
+    }
+
+    // Geometry decoded on demand
+    {
+        DocumentPtr docRead = app->newDocument();
+        auto _3 = gsl::finally([=]{ app->closeDocument(docRead); });
+        IO::MayoDocReader reader;
+        reader.parameters().loadPartsOnDemand = true;
+        TaskProgress progress;
+        QVERIFY(reader.readFile(filepath, &progress));
+        QVERIFY(reader.transfer(docRead, &progress));
+        QVERIFY(!docRead->lazyShapeLoaders().empty());
+        fnCheckDocument(docRead);
+        const TDF_Label readPartLabel = fnPartLabel(docRead);
+        QCOMPARE(fnFaceCount(XCaf::shape(readPartLabel)), 0);
+        const TreeNodeId entityId = docRead->entityTreeNodeId(0);
+        QVERIFY(docRead->hasPendingLazyShapes(entityId));
+        QVERIFY(docRead->loadLazyShapes(entityId));
+        QVERIFY(!docRead->hasPendingLazyShapes(entityId));
+        fnCheckPartGeometry(docRead, readPartLabel);
+    }
+
+    // Corrupted file is rejected
+    {
+        QFile file(filepath);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        file.resize(file.size() / 2);
+        file.close();
+        IO::MayoDocReader reader;
+        TaskProgress progress;
+        QVERIFY(!reader.readFile(filepath, &progress));
+    }
+}
+
+void Test::IO_ImportCache_test()
+{
+    auto fnFaceCount = [](const TopoDS_Shape& shape) {
+        int count = 0;
+        for (TopExp_Explorer expFace(shape, TopAbs_FACE); expFace.More(); expFace.Next())
+            ++count;
+
+        return count;
+    };
+
+    // Key depends on reader parameters
+    const QString stepFilepath = "inputs/cube.step";
+    const QString key = IO::ImportCache::computeKey(stepFilepath, nullptr);
+    QVERIFY(!key.isEmpty());
+    QCOMPARE(IO::ImportCache::computeKey(stepFilepath, nullptr), key);
+    const std::unique_ptr<PropertyGroup> ptrStepParams = IO::OccStepReader::createProperties(nullptr);
+    QVERIFY(IO::ImportCache::computeKey(stepFilepath, ptrStepParams.get()) != key);
+    QVERIFY(IO::ImportCache::computeKey("inputs/file_not_existing.step", nullptr).isEmpty());
+
+    auto app = Application::instance();
+    const QString cacheDirPath = QDir::temp().absoluteFilePath("mayo_test_import_cache");
+    auto importCache = new IO::ImportCache(cacheDirPath);
+    importCache->setEnabled(true);
+    importCache->clear();
+    app->ioSystem()->setImportCache(std::unique_ptr<IO::ImportCache>(importCache));
+    auto _ = gsl::finally([=]{
+        app->ioSystem()->setImportCache({});
+        QDir(cacheDirPath).removeRecursively();
+    });
+
+    auto fnImport = [=](const DocumentPtr& doc) {
+        return app->ioSystem()->importInDocument()
+                .targetDocument(doc)
+                .withFilepath(stepFilepath)
+                .execute();
+    };
+
+    // First import translates the file and fills the cache
+    DocumentPtr doc = app->newDocument();
+    auto _2 = gsl::finally([=]{ app->closeDocument(doc); });
+    QVERIFY(fnImport(doc));
+    importCache->waitForBackgroundStores();
+    QCOMPARE(importCache->entries().size(), size_t(1));
+    QVERIFY(QDir(cacheDirPath).entryList({ "*.tmp" }, QDir::Files).isEmpty());
+    const IO::ImportCache::Entry entry = importCache->entries().front();
+    QCOMPARE(entry.key, key);
+    QCOMPARE(entry.sourceFilepath, QFileInfo(stepFilepath).absoluteFilePath());
+    QCOMPARE(entry.formatIdentifier, IO::Format_STEP.identifier);
+    QVERIFY(entry.size > 0);
+
+    // Second import is restored from the cache
+    QThread::msleep(20);
+    DocumentPtr docCached = app->newDocument();
+    auto _3 = gsl::finally([=]{ app->closeDocument(docCached); });
+    QVERIFY(fnImport(docCached));
+    QCOMPARE(importCache->entries().size(), size_t(1));
+    QVERIFY(importCache->entries().front().lastUsed > entry.lastUsed);
+    QCOMPARE(docCached->entityCount(), doc->entityCount());
+    QCOMPARE(CafUtils::labelAttrStdName(docCached->entityLabel(0)), CafUtils::labelAttrStdName(doc->entityLabel(0)));
+    QCOMPARE(fnFaceCount(XCaf::shape(docCached->entityLabel(0))), fnFaceCount(XCaf::shape(doc->entityLabel(0))));
+
+    // Size limit is enforced
+    importCache->setMaxSize(0);
+    QVERIFY(importCache->entries().empty());
+    QCOMPARE(importCache->totalSize(), int64_t(0));
+}
+
+void Test::IO_ObjParallelReader_test()
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+    auto fnReadObj = [](
+            const QString& filepath,
+            IO::OccObjReader::Engine engine,
+            std::vector<int>* ptrVecNodeCount = nullptr)
+    {
+        auto app = Application::instance();
+        DocumentPtr doc = app->newDocument();
+        auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+        IO::OccObjReader reader;
+        reader.parameters().engine = engine;
+        TaskProgress progress;
+        std::vector<int> vecTriangleCount;
+        if (!reader.readFile(filepath, &progress) || !reader.transfer(doc, &progress))
+            return vecTriangleCount;
+
+        for (int i = 0; i < doc->entityCount(); ++i) {
+            const TopoDS_Shape shape = XCaf::shape(doc->entityLabel(i));
+            for (TopExp_Explorer expFace(shape, TopAbs_FACE); expFace.More(); expFace.Next()) {
+                TopLoc_Location loc;
+                const Handle_Poly_Triangulation triangulation =
+                        BRep_Tool::Triangulation(TopoDS::Face(expFace.Current()), loc);
+                vecTriangleCount.push_back(!triangulation.IsNull() ? triangulation->NbTriangles() : 0);
+                if (ptrVecNodeCount)
+                    ptrVecNodeCount->push_back(!triangulation.IsNull() ? triangulation->NbNodes() : 0);
+            }
+        }
+
+        return vecTriangleCount;
+    };
+
+    // Same triangles as OpenCascade reader
+    const std::vector<int> vecOccCount = fnReadObj("inputs/cube.obj", IO::OccObjReader::Engine::OpenCascade);
+    const std::vector<int> vecParallelCount = fnReadObj("inputs/cube.obj", IO::OccObjReader::Engine::Parallel);
+    QCOMPARE(vecParallelCount, vecOccCount);
+    QCOMPARE(vecParallelCount, std::vector<int>{ 12 });
+
+    // Groups, polygons and relative indices
+    const QString filepath = QDir::temp().absoluteFilePath("mayo_test_reader.obj");
+    auto _ = gsl::finally([=]{ QFile::remove(filepath); });
+    {
+        QFile file(filepath);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nvn 0 0 1\n"
+                   "g quad\nf 1//1 2//1 3//1 4//1\n"
+                   "g\tpentagon\nv 2 2 0\nf -1 -2 -3 -4 -5\n");
+    }
+
+    QCOMPARE(fnReadObj(filepath, IO::OccObjReader::Engine::Parallel), std::vector<int>({ 2, 3 }));
+
+    // Positions shared by faces with different normals(hard edge) give distinct nodes
+    {
+        QFile file(filepath);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("v 0 0 0\nv 1 0 0\nv 1 1 0\nv 1 0 1\nvn 0 0 1\nvn 0 -1 0\n"
+                   "f 1//1 2//1 3//1\nf 2//1 1//1 3//1\nf 1//2 2//2 4//2\n");
+    }
+
+    std::vector<int> vecNodeCount;
+    QCOMPARE(fnReadObj(filepath, IO::OccObjReader::Engine::Parallel, &vecNodeCount), std::vector<int>{ 3 });
+    QCOMPARE(vecNodeCount, std::vector<int>{ 6 });
+#else
+    QSKIP("OpenCascade >= v7.5.0 required");
+#endif
+}
+
+void Test::IO_OccMappedFileSystem_test()
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    const QString filepath = QDir::temp().absoluteFilePath("mayo_test_mapped_file.bin");
+    auto _ = gsl::finally([=]{ QFile::remove(filepath); });
+    {
+        QFile file(filepath);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("0123456789");
+    }
+
+    const TCollection_AsciiString url = occ::QtUtils::toOccUtf8String(filepath);
+    Handle_OccMappedFileSystem fileSystem = new OccMappedFileSystem({ filepath });
+    QVERIFY(fileSystem->IsSupportedPath(url));
+    QVERIFY(!fileSystem->IsSupportedPath(occ::QtUtils::toOccUtf8String(filepath + ".other")));
+    QVERIFY(!fileSystem->OpenOStream(url, std::ios::out));
+
+    // Streams opened at some offset
+    std::shared_ptr<std::istream> stream = fileSystem->OpenIStream(url, std::ios::in | std::ios::binary, 3);
+    QVERIFY(fileSystem->IsOpenIStream(stream));
+    char buffer[4] = {};
+    stream->read(buffer, 3);
+    QCOMPARE(QByteArray(buffer), QByteArray("345"));
+    stream->seekg(1);
+    stream->read(buffer, 3);
+    QCOMPARE(QByteArray(buffer), QByteArray("123"));
+    stream->seekg(-2, std::ios::end);
+    stream->read(buffer, 3);
+    QCOMPARE(stream->gcount(), std::streamsize(2));
+    QVERIFY(stream->eof());
+    QVERIFY(!fileSystem->OpenIStream(url, std::ios::in, 11));
+#else
+    QSKIP("OpenCascade >= v7.6.0 required");
+#endif
+}
+
+void Test::IO_GltfParallelWriter_test()
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+    const bool okImport = app->ioSystem()->importInDocument()
+            .targetDocument(doc)
+            .withFilepaths({ "inputs/cube.step" })
+            .execute();
+    QVERIFY(okImport);
+    const TDF_Label partLabel = doc->entityLabel(0);
+    QVERIFY(XCaf::isShapeSimple(partLabel));
+    BRepMesh_IncrementalMesh mesher(XCaf::shape(partLabel), 0.1);
+    QVERIFY(mesher.IsDone());
+
+    // Assembly with two instances of the part
+    const Handle_XCAFDoc_ShapeTool shapeTool = doc->xcaf().shapeTool();
+    const TDF_Label asmLabel = shapeTool->NewShape();
+    gp_Trsf trsf;
+    trsf.SetTranslation(gp_Vec(100, 0, 0));
+    shapeTool->AddComponent(asmLabel, partLabel, TopLoc_Location());
+    shapeTool->AddComponent(asmLabel, partLabel, TopLoc_Location(trsf));
+    TDF_LabelSequence seqRootLabel;
+    seqRootLabel.Append(asmLabel);
+
+    auto fnGlbJson = [](const QString& filepath) {
+        QFile file(filepath);
+        if (!file.open(QIODevice::ReadOnly))
+            return QJsonObject();
+
+        const QByteArray glb = file.readAll();
+        if (glb.size() < 20 || qFromLittleEndian<quint32>(glb.constData()) != 0x46546C67)
+            return QJsonObject();
+
+        const quint32 jsonSize = qFromLittleEndian<quint32>(glb.constData() + 12);
+        return QJsonDocument::fromJson(glb.mid(20, int(jsonSize))).object();
+    };
+
+    const QString filepath = QDir::temp().absoluteFilePath("mayo_test_writer.glb");
+    auto _1 = gsl::finally([=]{ QFile::remove(filepath); });
+    qint64 fileSize[2] = {};
+    for (const bool quantize : { false, true }) {
+        IO::GltfParallelWriter::Options options;
+        options.quantize = quantize;
+        QVERIFY(IO::GltfParallelWriter(options).perform(filepath, doc, seqRootLabel, nullptr));
+        fileSize[quantize ? 1 : 0] = QFileInfo(filepath).size();
+
+        // Mesh of the part is shared by both instances
+        const QJsonObject json = fnGlbJson(filepath);
+        QCOMPARE(json.value("meshes").toArray().size(), 1);
+        // Quantized meshes are referenced by additional dequantization nodes
+        QCOMPARE(json.value("nodes").toArray().size(), quantize ? 5 : 3);
+        QCOMPARE(json.value("extensionsRequired").toArray().contains("KHR_mesh_quantization"), quantize);
+    }
+
+    QVERIFY(fileSize[1] < fileSize[0]);
+
+    // Read back the file written without quantization
+    IO::GltfParallelWriter::Options options;
+    options.quantize = false;
+    QVERIFY(IO::GltfParallelWriter(options).perform(filepath, doc, seqRootLabel, nullptr));
+    DocumentPtr docRead = app->newDocument();
+    auto _2 = gsl::finally([=]{ app->closeDocument(docRead); });
+    IO::OccGltfReader reader;
+    TaskProgress progress;
+    QVERIFY(reader.readFile(filepath, &progress));
+    QVERIFY(reader.transfer(docRead, &progress));
+    int triangleCount = 0;
+    for (int i = 0; i < docRead->entityCount(); ++i) {
+        const TopoDS_Shape shape = XCaf::shape(docRead->entityLabel(i));
+        for (TopExp_Explorer expFace(shape, TopAbs_FACE); expFace.More(); expFace.Next()) {
+            TopLoc_Location loc;
+            const Handle_Poly_Triangulation triangulation =
+                    BRep_Tool::Triangulation(TopoDS::Face(expFace.Current()), loc);
+            triangleCount += !triangulation.IsNull() ? triangulation->NbTriangles() : 0;
+        }
+    }
+
+    QCOMPARE(triangleCount, 24);
+#else
+    QSKIP("OpenCascade >= v7.5.0 required");
+#endif
+}
+
+void Test::IO_FileScan_test()
+{
+    {
+        const IO::FileScan scan = IO::scanFile_STEP("inputs/cube.step");
+        QCOMPARE(scan.format, IO::Format_STEP);
+        QVERIFY(scan.isComplete());
+        QCOMPARE(scan.schema, QString("AUTOMOTIVE_DESIGN { 1 0 10303 214 1 1 1 1 }"));
+        QCOMPARE(scan.originatingSystem, QString("FreeCAD"));
+        QCOMPARE(scan.lengthUnits, QStringList("mm"));
+        QCOMPARE(int(scan.vecProduct.size()), 1);
+        QCOMPARE(scan.vecProduct.front().name, QString("Cube"));
+        QCOMPARE(scan.entityCount, int64_t(361));
+        QVERIFY(!scan.vecEntityTypeCount.empty());
+    }
+
+    {
+        const IO::FileScan scan = IO::scanFile_IGES("inputs/cube.iges");
+        QCOMPARE(scan.format, IO::Format_IGES);
+        QVERIFY(scan.isComplete());
+        QCOMPARE(scan.schema, QString("IGES 5.3"));
+        QCOMPARE(scan.originatingSystem, QString("Open CASCADE 7.3"));
+        QCOMPARE(scan.lengthUnits, QStringList("mm"));
+        QCOMPARE(scan.entityCount, int64_t(49));
+    }
+
+    // Assembly structure: product 'Asm' with two instances of product 'Part'
+    const QString filepath = QDir::temp().absoluteFilePath("mayo_test_scan.step");
+    auto _ = gsl::finally([=]{ QFile::remove(filepath); });
+    {
+        QFile file(filepath);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("ISO-10303-21;\nHEADER;\n"
+                   "FILE_NAME('asm.step','',(''),(''),'Preprocessor','Mayo;\\X2\\00E9\\X0\\','');\n"
+                   "FILE_SCHEMA(('AP242_MANAGED_MODEL_BASED_3D_ENGINEERING_MIM_LF'));\n"
+                   "ENDSEC;\nDATA;\n"
+                   "#1=PRODUCT('asm','Asm','',(#20));\n"
+                   "#2=PRODUCT_DEFINITION_FORMATION('','',#1);\n"
+                   "#3=PRODUCT_DEFINITION('design','',#2,#21);\n"
+                   "/* comment; #4=PRODUCT('x','X','',()); */\n"
+                   "#4=PRODUCT('part','Part','',(#20));\n"
+                   "#5=PRODUCT_DEFINITION_FORMATION_WITH_SPECIFIED_SOURCE('','',#4,.NOT_KNOWN.);\n"
+                   "#6=PRODUCT_DEFINITION('design','',#5,#21);\n"
+                   "#7=NEXT_ASSEMBLY_USAGE_OCCURRENCE('1','','',#3,#6,$);\n"
+                   "#8=NEXT_ASSEMBLY_USAGE_OCCURRENCE('2','','',#3,#6,$);\n"
+                   "#9=(CONVERSION_BASED_UNIT('INCH',#10)LENGTH_UNIT()NAMED_UNIT(#11));\n"
+                   "ENDSEC;\nEND-ISO-10303-21;\n");
+    }
+
+    const IO::FileScan scan = IO::scanFile(filepath, IO::Format_STEP);
+    QCOMPARE(scan.schema, QString("AP242_MANAGED_MODEL_BASED_3D_ENGINEERING_MIM_LF"));
+    QCOMPARE(scan.originatingSystem, QString::fromUtf8("Mayo;é"));
+    QCOMPARE(scan.lengthUnits, QStringList("inch"));
+    QCOMPARE(scan.entityCount, int64_t(9));
+    QCOMPARE(scan.assemblyComponentCount, 2);
+    QCOMPARE(int(scan.vecProduct.size()), 2);
+    QCOMPARE(scan.rootProducts(), std::vector<int>{ 0 });
+    QCOMPARE(scan.vecProduct.at(0).vecComponent, std::vector<int>({ 1, 1 }));
+    QVERIFY(scan.summaryText().contains("Part (x2)"));
+    QVERIFY(scan.summaryText().contains("Products: 2"));
+
+    // Counts of a partial scan are lower bounds
+    IO::FileScan scanPartial = scan;
+    scanPartial.scannedSize = scan.fileSize / 2;
+    QVERIFY(!scanPartial.isComplete());
+    QVERIFY(scanPartial.summaryText().contains("Products: at least 2"));
+    QVERIFY(!IO::scanFile(filepath, IO::Format_OBJ).isValid());
+}
+
+void Test::IO_OccStepLazyShapes_test()
+{
+    auto fnFaceCount = [](const TopoDS_Shape& shape) {
+        int count = 0;
+        for (TopExp_Explorer expFace(shape, TopAbs_FACE); expFace.More(); expFace.Next())
+            ++count;
+
+        return count;
+    };
+
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+    IO::OccStepReader reader;
+    reader.parameters().loadPartsOnDemand = true;
+    TaskProgress progress;
+    QVERIFY(reader.readFile("inputs/cube.step", &progress));
+    QVERIFY(reader.transfer(doc, &progress));
+    QCOMPARE(doc->entityCount(), 1);
+    QVERIFY(!doc->lazyShapeLoaders().empty());
+
+    // Structure and names are there, geometry is pending
+    const TreeNodeId entityId = doc->entityTreeNodeId(0);
+    const TDF_Label entityLabel = doc->entityLabel(0);
+    QCOMPARE(CafUtils::labelAttrStdName(entityLabel), QString("Cube"));
+    QCOMPARE(fnFaceCount(XCaf::shape(entityLabel)), 0);
+    QVERIFY(doc->hasPendingLazyShapes(entityId));
+    QCOMPARE(doc->pendingLazyShapes(entityId).size(), size_t(1));
+
+    QSignalSpy sigSpy_entityShapesChanged(doc.get(), &Document::entityShapesChanged);
+    QVERIFY(doc->loadLazyShapes(entityId));
+    QCOMPARE(sigSpy_entityShapesChanged.count(), 1);
+    QCOMPARE(sigSpy_entityShapesChanged.at(0).at(0).value<TreeNodeId>(), entityId);
+    QCOMPARE(fnFaceCount(XCaf::shape(entityLabel)), 6);
+    QVERIFY(!doc->hasPendingLazyShapes(entityId));
+
+    // Nothing left to load
+    QVERIFY(doc->loadLazyShapes(entityId));
+    QCOMPARE(sigSpy_entityShapesChanged.count(), 1);
+
+    // Another lazy import must not discard pending parts of the previous one
+    IO::OccStepReader reader2;
+    reader2.parameters().loadPartsOnDemand = true;
+    IO::OccStepReader reader3;
+    reader3.parameters().loadPartsOnDemand = true;
+    QVERIFY(reader2.readFile("inputs/cube.step", &progress));
+    QVERIFY(reader2.transfer(doc, &progress));
+    QVERIFY(reader3.readFile("inputs/cube.step", &progress));
+    QVERIFY(reader3.transfer(doc, &progress));
+    QCOMPARE(doc->entityCount(), 3);
+    QCOMPARE(doc->lazyShapeLoaders().size(), size_t(3));
+    QVERIFY(doc->hasPendingLazyShapes(doc->entityTreeNodeId(1)));
+    QVERIFY(doc->hasPendingLazyShapes(doc->entityTreeNodeId(2)));
+    QVERIFY(doc->loadLazyShapes(doc->entityTreeNodeId(1)));
+    QCOMPARE(fnFaceCount(XCaf::shape(doc->entityLabel(1))), 6);
+    QVERIFY(doc->hasPendingLazyShapes(doc->entityTreeNodeId(2)));
+
+    // Translation leaves the document untouched until shapes are assigned
+    const auto vecTranslated = doc->translateLazyShapes(doc->entityTreeNodeId(2));
+    QCOMPARE(vecTranslated.size(), size_t(1));
+    QVERIFY(!doc->hasPendingLazyShapes(doc->entityTreeNodeId(2)));
+    QCOMPARE(fnFaceCount(XCaf::shape(doc->entityLabel(2))), 0);
+    QVERIFY(doc->assignLazyShapes(vecTranslated));
+    QCOMPARE(fnFaceCount(XCaf::shape(doc->entityLabel(2))), 6);
+}
+
+void Test::IO_StepParallelReader_test()
+{
+    // Models loaded from records of OpenCascade parser and parallel parser must be the same
+    auto fnCompareModels = [](const QString& filepath) {
+        STEPControl_Reader occReader;
+        QCOMPARE(occReader.ReadFile(filepath.toUtf8().constData()), IFSelect_RetDone);
+        STEPControl_Reader parallelReader;
+        QVERIFY(IO::StepParallelReader::readFile(filepath, parallelReader.WS(), nullptr));
+        const Handle_StepData_StepModel occModel = occReader.StepModel();
+        const Handle_StepData_StepModel parallelModel = parallelReader.StepModel();
+        QVERIFY(!parallelModel.IsNull());
+        QCOMPARE(parallelModel->NbEntities(), occModel->NbEntities());
+        for (int i = 1; i <= occModel->NbEntities(); ++i) {
+            const Handle_Standard_Type occType = occModel->Value(i)->DynamicType();
+            QCOMPARE(parallelModel->Value(i)->DynamicType()->Name(), occType->Name());
+            QCOMPARE(parallelModel->IsRedefinedContent(i), occModel->IsRedefinedContent(i));
+        }
+
+        QCOMPARE(parallelReader.NbRootsForTransfer(), occReader.NbRootsForTransfer());
+    };
+
+    fnCompareModels("inputs/cube.step");
+
+    // Strings with terminators and quotes, comments, complex entities, typed parameters, lists
+    const QString filepath = QDir::temp().absoluteFilePath("mayo_test_reader.step");
+    auto _ = gsl::finally([=]{ QFile::remove(filepath); });
+    {
+        QFile file(filepath);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("ISO-10303-21;\nHEADER;\n"
+                   "FILE_DESCRIPTION(('test;(list)'),'2;1');\n"
+                   "FILE_NAME('mayo','2021-01-01T00:00:00',(''),(''),'','','');\n"
+                   "FILE_SCHEMA(('AUTOMOTIVE_DESIGN { 1 0 10303 214 1 1 1 1 }'));\n"
+                   "ENDSEC;\nDATA;\n"
+                   "#1=CARTESIAN_POINT('it''s;/* not a comment',(0.,1.E-3,-2.));\n"
+                   "/* comment; with 'quote */\n"
+                   "#2=DIRECTION('',(0.,0.,1.));\n"
+                   "#3=(LENGTH_UNIT()NAMED_UNIT(*)SI_UNIT(.MILLI.,.METRE.));\n"
+                   "#4=MEASURE_WITH_UNIT(LENGTH_MEASURE(2.5),#3);\n"
+                   "#5=AXIS2_PLACEMENT_3D('',#1,#2,$);\n"
+                   "ENDSEC;\nEND-ISO-10303-21;\n");
+    }
+
+    fnCompareModels(filepath);
+    Handle_XSControl_WorkSession ws = STEPControl_Reader().WS();
+    QVERIFY(IO::StepParallelReader::readFile(filepath, ws, nullptr));
+    QCOMPARE(ws->Model()->NbEntities(), 5);
+
+    // Syntax error: not handled, so OpenCascade parser can report it
+    {
+        QFile file(filepath);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("ISO-10303-21;\nHEADER;\nENDSEC;\nDATA;\n#1=CARTESIAN_POINT('',(0.,0.,0.);\n"
+                   "ENDSEC;\nEND-ISO-10303-21;\n");
+    }
+
+    QVERIFY(!IO::StepParallelReader::readFile(filepath, STEPControl_Reader().WS(), nullptr));
+}
+
+void Test::IO_StepParallelReader_benchmark()
+{
+    QFETCH(bool, isParallel);
+    // Synthetic file with many entities so the DATA section is split in several chunks
+    const QString filepath = QDir::temp().absoluteFilePath("mayo_bench_reader.step");
+    auto _ = gsl::finally([=]{ QFile::remove(filepath); });
+    {
+        QFile file(filepath);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("ISO-10303-21;\nHEADER;\n"
+                   "FILE_DESCRIPTION((''),'2;1');\n"
+                   "FILE_NAME('mayo','',(''),(''),'','','');\n"
+                   "FILE_SCHEMA(('AUTOMOTIVE_DESIGN { 1 0 10303 214 1 1 1 1 }'));\n"
+                   "ENDSEC;\nDATA;\n");
+        const int pointCount = 200000;
+        QByteArray line;
+        for (int i = 1; i <= pointCount; ++i) {
+            line = "#" + QByteArray::number(i) + "=CARTESIAN_POINT('',("
+                    + QByteArray::number(i * 0.5, 'f', 3) + ","
+                    + QByteArray::number(i * -0.25, 'f', 3) + ",1.E-2));\n";
+            file.write(line);
+        }
+
+        for (int i = 1; i <= pointCount; i += 8) {
+            line = "#" + QByteArray::number(pointCount + i) + "=POLYLINE('/* polyline; */',(";
+            for (int j = i; j < i + 8 && j <= pointCount; ++j)
+                line += (j != i ? ",#" : "#") + QByteArray::number(j);
+
+            file.write(line + "));\n");
+        }
+
+        file.write("ENDSEC;\nEND-ISO-10303-21;\n");
+    }
+
+    QBENCHMARK {
+        STEPControl_Reader reader;
+        if (isParallel)
+            QVERIFY(IO::StepParallelReader::readFile(filepath, reader.WS(), nullptr));
+        else
+            QCOMPARE(reader.ReadFile(filepath.toUtf8().constData()), IFSelect_RetDone);
+    }
+}
+
+void Test::IO_StepParallelReader_benchmark_data()
+{
+    QTest::addColumn<bool>("isParallel");
+    QTest::newRow("OpenCascade") << false;
+    QTest::newRow("Parallel") << true;
+}
+
 void Test::BRepUtils_test()
 {
     QVERIFY(BRepUtils::moreComplex(TopAbs_COMPOUND, TopAbs_SOLID));
@@ -241,6 +1105,30 @@ void Test::BRepUtils_test()
     }
 }
 
+void Test::ShapeSection_test()
+{
+    const TopoDS_Shape shapeBox = BRepPrimAPI_MakeBox(10, 20, 30);
+    const gp_Pln planeCrossing(gp_Pnt(0, 0, 15), gp::DZ());
+    const ShapeSection section = ShapeSection::compute(shapeBox, planeCrossing);
+    QVERIFY(!section.faces.IsNull());
+    QVERIFY(std::abs(section.area - 200.) < 1e-6);
+
+    const gp_Pln planeOutside(gp_Pnt(0, 0, 50), gp::DZ());
+    const ShapeSection sectionEmpty = ShapeSection::compute(shapeBox, planeOutside);
+    QVERIFY(sectionEmpty.faces.IsNull());
+    QCOMPARE(sectionEmpty.area, 0.);
+
+    ShapeSectionCache cache(2);
+    QVERIFY(std::abs(cache.get(shapeBox, planeCrossing).area - 200.) < 1e-6);
+    QVERIFY(std::abs(cache.get(shapeBox, planeCrossing).area - 200.) < 1e-6);
+    QCOMPARE(cache.entryCount(), size_t(1));
+    cache.get(shapeBox, planeOutside);
+    cache.get(shapeBox, gp_Pln(gp_Pnt(5, 0, 0), gp::DX()));
+    QCOMPARE(cache.entryCount(), size_t(2));
+    cache.clear();
+    QCOMPARE(cache.entryCount(), size_t(0));
+}
+
 void Test::CafUtils_test()
 {
     // TODO Add CafUtils::labelTag() test for multi-threaded safety
@@ -470,6 +1358,297 @@ void Test::Result_test()
     }
 }
 
+void Test::Settings_deferredGroup_test()
+{
+    Settings settings;
+    std::unique_ptr<PropertyInt> ptrProp;
+    int initCount = 0;
+    Settings::SectionIndex sectionId;
+    const Settings::GroupIndex groupId = settings.addGroup(QByteArrayLiteral("deferred"));
+    settings.setGroupInitFunction(groupId, [&]{
+        ++initCount;
+        ptrProp = std::make_unique<PropertyInt>(&settings, MAYO_TEXT_ID("Mayo::Test", "value"));
+        sectionId = settings.addSection(groupId, QByteArrayLiteral("values"));
+        settings.addSetting(ptrProp.get(), sectionId);
+        settings.addGroupResetFunction(groupId, [&]{ ptrProp->setValue(42); });
+    });
+
+    QVERIFY(!settings.isGroupInitialized(groupId));
+    settings.resetAll();
+    QCOMPARE(initCount, 0);
+    QVERIFY(!ptrProp);
+
+    // First access initializes then resets the group, default section comes first
+    QCOMPARE(settings.sectionCount(groupId), 2);
+    QCOMPARE(initCount, 1);
+    QVERIFY(settings.isGroupInitialized(groupId));
+    QVERIFY(ptrProp);
+    QCOMPARE(ptrProp->value(), 42);
+    QCOMPARE(sectionId.get(), 1);
+    QCOMPARE(settings.settingCount(sectionId), 1);
+    QCOMPARE(settings.findProperty(ptrProp.get()).section().get(), sectionId.get());
+
+    settings.initGroup(groupId);
+    QCOMPARE(initCount, 1);
+}
+
+void Test::ShapeHlr_test()
+{
+    const TopoDS_Shape shapeBox = BRepPrimAPI_MakeBox(10, 20, 30);
+    BRepMesh_IncrementalMesh(shapeBox, 0.1);
+    auto fnBndBox = [](const TopoDS_Shape& shape) {
+        Bnd_Box bndBox;
+        BRepBndLib::Add(shape, bndBox);
+        bndBox.SetGap(0.);
+        return bndBox;
+    };
+    auto fnIsNear = [](double lhs, double rhs) { return std::abs(lhs - rhs) < 1e-4; };
+
+    // Box seen from top, drawing lies in plane Z=0
+    const ShapeHlr hlrTop = ShapeHlr::compute(shapeBox, gp_Ax2(gp::Origin(), gp::DZ()));
+    QVERIFY(!hlrTop.visibleEdges.IsNull());
+    const Bnd_Box bndTop = fnBndBox(hlrTop.visibleEdges);
+    QVERIFY(fnIsNear(bndTop.CornerMin().X(), 0.) && fnIsNear(bndTop.CornerMax().X(), 10.));
+    QVERIFY(fnIsNear(bndTop.CornerMin().Y(), 0.) && fnIsNear(bndTop.CornerMax().Y(), 20.));
+    QVERIFY(fnIsNear(bndTop.CornerMin().Z(), 0.) && fnIsNear(bndTop.CornerMax().Z(), 0.));
+
+    // Box seen from front, drawing lies in plane Y=-5
+    const ShapeHlr hlrFront = ShapeHlr::compute(shapeBox, gp_Ax2(gp_Pnt(0, -5, 0), -gp::DY()));
+    QVERIFY(!hlrFront.visibleEdges.IsNull());
+    const Bnd_Box bndFront = fnBndBox(hlrFront.visibleEdges);
+    QVERIFY(fnIsNear(bndFront.CornerMin().X(), 0.) && fnIsNear(bndFront.CornerMax().X(), 10.));
+    QVERIFY(fnIsNear(bndFront.CornerMin().Y(), -5.) && fnIsNear(bndFront.CornerMax().Y(), -5.));
+    QVERIFY(fnIsNear(bndFront.CornerMin().Z(), 0.) && fnIsNear(bndFront.CornerMax().Z(), 30.));
+
+    // Box seen from top in perspective, eye at Z=100: top face is magnified by 100/(100-30)
+    const ShapeHlr hlrPersp = ShapeHlr::compute(shapeBox, gp_Ax2(gp::Origin(), gp::DZ()), 100.);
+    QVERIFY(!hlrPersp.visibleEdges.IsNull());
+    const Bnd_Box bndPersp = fnBndBox(hlrPersp.visibleEdges);
+    QVERIFY(fnIsNear(bndPersp.CornerMin().X(), 0.) && fnIsNear(bndPersp.CornerMax().X(), 10. / 0.7));
+    QVERIFY(fnIsNear(bndPersp.CornerMin().Y(), 0.) && fnIsNear(bndPersp.CornerMax().Y(), 20. / 0.7));
+    QVERIFY(fnIsNear(bndPersp.CornerMin().Z(), 0.) && fnIsNear(bndPersp.CornerMax().Z(), 0.));
+
+    QVERIFY(ShapeHlr::compute(TopoDS_Shape(), gp::XOY()).visibleEdges.IsNull());
+}
+
+void Test::DocumentColoring_test()
+{
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+    const bool okImport = app->ioSystem()->importInDocument()
+            .targetDocument(doc)
+            .withFilepaths({ "inputs/cube.step" })
+            .execute();
+    QVERIFY(okImport);
+    QCOMPARE(doc->entityCount(), 1);
+
+    ColorRule ruleAssembly;
+    ruleAssembly.xdeKind = ColorRule::XdeKind::Assembly;
+    ColorRule ruleTinyVolume;
+    ruleTinyVolume.maxVolume = 1e-6;
+    ColorRule ruleName;
+    ruleName.namePattern = "cU?e";
+    ruleName.color = Quantity_NOC_RED;
+    ColorRule ruleAny;
+    ruleAny.color = Quantity_NOC_BLUE;
+
+    // First matching rule applies
+    const std::vector<ColorRule> vecRule = { ruleAssembly, ruleTinyVolume, ruleName, ruleAny };
+    const auto vecAssignment = DocumentColoring::evaluate(doc, vecRule);
+    QCOMPARE(vecAssignment.size(), size_t(1));
+    QCOMPARE(vecAssignment.front().treeNodeId, doc->entityTreeNodeId(0));
+    QCOMPARE(vecAssignment.front().ruleIndex, 2);
+
+    // Colors are written at once, with a single notification
+    QSignalSpy sigSpy_colorsChanged(doc.get(), &Document::colorsChanged);
+    QCOMPARE(DocumentColoring::apply(doc, vecRule), 1);
+    QCOMPARE(sigSpy_colorsChanged.count(), 1);
+    QVERIFY(doc->xcaf().hasShapeColor(doc->entityLabel(0)));
+    QVERIFY(doc->xcaf().shapeColor(doc->entityLabel(0)) == Quantity_Color(Quantity_NOC_RED));
+
+    const std::vector<ColorRule> vecRuleNoMatch = { ruleAssembly, ruleTinyVolume };
+    QCOMPARE(DocumentColoring::apply(doc, vecRuleNoMatch), 0);
+    QCOMPARE(sigSpy_colorsChanged.count(), 1);
+
+    // Unchanged colors aren't notified
+    DocumentColoring::apply(doc, vecRule);
+    QCOMPARE(sigSpy_colorsChanged.count(), 1);
+
+    // Color is set once per label, the last one given wins
+    const TreeNodeId entityTreeNodeId = doc->entityTreeNodeId(0);
+    std::vector<TreeNodeId> vecChangedTreeNodeId;
+    QObject::connect(doc.get(), &Document::colorsChanged, [&](const std::vector<TreeNodeId>& vecId) {
+        vecChangedTreeNodeId = vecId;
+    });
+    const std::vector<Document::TreeNodeColor> vecNodeColor = {
+        { entityTreeNodeId, Quantity_NOC_GREEN }, { entityTreeNodeId, Quantity_NOC_YELLOW }
+    };
+    doc->changeColors(vecNodeColor);
+    QCOMPARE(sigSpy_colorsChanged.count(), 2);
+    QCOMPARE(vecChangedTreeNodeId.size(), size_t(1));
+    QCOMPARE(vecChangedTreeNodeId.front(), entityTreeNodeId);
+    QVERIFY(doc->xcaf().shapeColor(doc->entityLabel(0)) == Quantity_Color(Quantity_NOC_YELLOW));
+}
+
+void Test::Formula_test()
+{
+    // Row count isn't a multiple of the block size, so last block is partial
+    const int rowCount = 3 * Formula::BlockSize + 17;
+    std::vector<double> vecA(rowCount);
+    std::vector<double> vecB(rowCount);
+    for (int i = 0; i < rowCount; ++i) {
+        vecA.at(i) = i;
+        vecB.at(i) = 2. * i + 1.;
+    }
+
+    FormulaTable table;
+    table.addColumn("a", std::move(vecA));
+    table.addColumn("b", std::move(vecB));
+    QCOMPARE(table.rowCount(), rowCount);
+    QCOMPARE(table.findColumn("b"), 1);
+    QCOMPARE(table.findColumn("c"), -1);
+
+    struct TestData {
+        const char* expression;
+        std::function<double(double, double)> fnExpected;
+    };
+    const TestData tests[] = {
+        { "a + b * 2", [](double a, double b) { return a + b * 2; } },
+        { "(a + b) * 2", [](double a, double b) { return (a + b) * 2; } },
+        { "-a^2 + 2^3^2", [](double a, double) { return -std::pow(a, 2) + std::pow(2, 9); } },
+        { "a - b - 1", [](double a, double b) { return a - b - 1; } },
+        { "a > 100 && b < 500 ? 1 : 0", [](double a, double b) { return a > 100 && b < 500 ? 1 : 0; } },
+        { "if(a == 0, -1, min(a, 10) + max(b, 20))", [](double a, double b) {
+              return a == 0 ? -1 : std::min(a, 10.) + std::max(b, 20.); } },
+        { "floor(sqrt(b)) + abs(-a) + round(2.5) + pow(a, 0)", [](double a, double b) {
+              return std::floor(std::sqrt(b)) + std::abs(-a) + std::round(2.5) + 1; } },
+        { "!(a < 10) || b == 1", [](double a, double b) { return !(a < 10) || b == 1 ? 1 : 0; } },
+        { "2 * pi * 1.5e1", [](double, double) { return 2 * 3.14159265358979323846 * 15; } }
+    };
+    for (const TestData& test : tests) {
+        const Result<Formula> formula = Formula::compile(test.expression, table);
+        QVERIFY2(formula.valid(), qUtf8Printable(formula.errorText()));
+        const std::vector<double> vecResult = formula.get().evaluate(table);
+        QCOMPARE(int(vecResult.size()), rowCount);
+        for (int i = 0; i < rowCount; ++i) {
+            const double a = table.columnValues(0)[i];
+            const double b = table.columnValues(1)[i];
+            QCOMPARE(vecResult.at(i), test.fnExpected(a, b));
+        }
+    }
+}
+
+void Test::Formula_errors_test()
+{
+    FormulaTable table;
+    table.addColumn("area", { 1., 2. });
+    const char* const invalidExpressions[] = {
+        "", "area +", "(area", "area area", "volume", "sin(area)", "min(area)", "area $ 2", "1.2.3"
+    };
+    for (const char* expression : invalidExpressions) {
+        const Result<Formula> formula = Formula::compile(expression, table);
+        QVERIFY2(!formula.valid(), expression);
+        QVERIFY(!formula.errorText().isEmpty());
+    }
+}
+
+void Test::DocumentFormulaTable_test()
+{
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+    const bool okImport = app->ioSystem()->importInDocument()
+            .targetDocument(doc)
+            .withFilepaths({ "inputs/cube.step" })
+            .execute();
+    QVERIFY(okImport);
+    const DocumentFormulaTable docTable = DocumentFormulaTable::build(doc);
+    QCOMPARE(docTable.table.rowCount(), 1);
+    QCOMPARE(docTable.vecTreeNodeId.front(), doc->entityTreeNodeId(0));
+    const Result<Formula> formula = Formula::compile("volume > 0 && dx > 0 && part", docTable.table);
+    QVERIFY(formula.valid());
+    QCOMPARE(formula.get().evaluate(docTable.table).front(), 1.);
+
+    // Assembly of two instances of the same part, properties of the assembly are aggregated
+    DocumentPtr docAsm = app->newDocument();
+    auto _2 = gsl::finally([=]{ app->closeDocument(docAsm); });
+    const Handle_XCAFDoc_ShapeTool shapeTool = docAsm->xcaf().shapeTool();
+    const TDF_Label partLabel = shapeTool->AddShape(BRepPrimAPI_MakeBox(10, 20, 30), false);
+    const TDF_Label asmLabel = shapeTool->NewShape();
+    gp_Trsf trsf;
+    trsf.SetTranslation(gp_Vec(100, 0, 0));
+    shapeTool->AddComponent(asmLabel, partLabel, TopLoc_Location());
+    shapeTool->AddComponent(asmLabel, partLabel, TopLoc_Location(trsf));
+    shapeTool->UpdateAssemblies();
+    docAsm->rebuildModelTree();
+
+    const DocumentFormulaTable asmTable = DocumentFormulaTable::build(docAsm);
+    QCOMPARE(asmTable.table.rowCount(), 5); // Assembly, 2 instances and their parts
+    QCOMPARE(asmTable.vecTreeNodeId.front(), docAsm->entityTreeNodeId(0));
+    auto fnColumn = [&](const char* name) {
+        return asmTable.table.columnValues(asmTable.table.findColumn(name));
+    };
+    QVERIFY(std::abs(fnColumn("volume")[0] - 2 * 6000.) < 1e-6);
+    QVERIFY(std::abs(fnColumn("xmax")[0] - 110.) < 1e-3);
+
+    // Instances and assembly stand for the same geometry as the parts, only parts are summed
+    QVERIFY(std::abs(asmTable.sumOfParts(fnColumn("volume")) - 2 * 6000.) < 1e-6);
+
+    // Parts are colored from their value, lowest to blue and highest to red
+    const auto vecNodeColor = asmTable.bucketColors(fnColumn("xmin"), 3);
+    QCOMPARE(vecNodeColor.size(), size_t(2));
+    QVERIFY(vecNodeColor.at(0).color == Quantity_Color(Quantity_NOC_BLUE1));
+    QVERIFY(vecNodeColor.at(1).color == Quantity_Color(Quantity_NOC_RED));
+}
+
+void Test::Settings_startup_benchmark()
+{
+    // Measures the settings part of application startup: registration of the import/export groups
+    // then loading of the stored values. Parameters of readers/writers are created at startup only
+    // when initialization isn't deferred
+    QFETCH(bool, isDeferred);
+    const IO::System* ioSystem = Application::instance()->ioSystem();
+    QBENCHMARK {
+        Settings settings;
+        std::vector<std::unique_ptr<PropertyGroup>> vecPtrGroup;
+        const Settings::GroupIndex groupId_import = settings.addGroup(QByteArrayLiteral("import"));
+        const Settings::GroupIndex groupId_export = settings.addGroup(QByteArrayLiteral("export"));
+        settings.setGroupInitFunction(groupId_import, [&]{
+            for (const IO::Format& format : ioSystem->readerFormats()) {
+                const IO::FactoryReader* factory = ioSystem->findFactoryReader(format);
+                vecPtrGroup.push_back(factory->createProperties(format, &settings));
+                PropertyGroup* ptrGroup = vecPtrGroup.back().get();
+                if (ptrGroup)
+                    settings.addGroupResetFunction(groupId_import, [=]{ ptrGroup->restoreDefaults(); });
+            }
+        });
+        settings.setGroupInitFunction(groupId_export, [&]{
+            for (const IO::Format& format : ioSystem->writerFormats()) {
+                const IO::FactoryWriter* factory = ioSystem->findFactoryWriter(format);
+                vecPtrGroup.push_back(factory->createProperties(format, &settings));
+                PropertyGroup* ptrGroup = vecPtrGroup.back().get();
+                if (ptrGroup)
+                    settings.addGroupResetFunction(groupId_export, [=]{ ptrGroup->restoreDefaults(); });
+            }
+        });
+
+        if (!isDeferred) {
+            settings.initGroup(groupId_import);
+            settings.initGroup(groupId_export);
+        }
+
+        settings.load();
+    }
+}
+
+void Test::Settings_startup_benchmark_data()
+{
+    QTest::addColumn<bool>("isDeferred");
+    QTest::newRow("deferred") << true;
+    QTest::newRow("eager") << false;
+}
+
 void Test::StringUtils_append_test()
 {
     QFETCH(QString, strExpected);
@@ -648,11 +1827,399 @@ void Test::OccQtUtils_test()
     QCOMPARE(qtColor, backQtColor);
 }
 
+void Test::GraphicsObjectUnloader_test()
+{
+    if (!isGraphicsSceneAvailable())
+        QSKIP("Display connection required");
+
+    GraphicsObjectUnloader* unloader = GraphicsObjectUnloader::globalInstance();
+    const bool wasEnabled = unloader->isEnabled();
+    const size_t prevBudget = unloader->memoryBudget();
+    auto _ = gsl::finally([=]{
+        unloader->setEnabled(wasEnabled);
+        unloader->setMemoryBudget(prevBudget);
+    });
+    unloader->setEnabled(true);
+    unloader->setMemoryBudget(std::numeric_limits<size_t>::max());
+
+    // Boxes meshed with different deflections, so their memory usages differ
+    const TopoDS_Shape shapeBox1 = BRepPrimAPI_MakeBox(10, 20, 30);
+    const TopoDS_Shape shapeBox2 = BRepPrimAPI_MakeBox(10, 20, 30);
+    BRepMesh_IncrementalMesh(shapeBox1, 1.);
+    BRepMesh_IncrementalMesh(shapeBox2, 0.01, false, 0.05);
+    const Handle_AIS_Shape gfxBox1 = new AIS_Shape(shapeBox1);
+    const Handle_AIS_Shape gfxBox2 = new AIS_Shape(shapeBox2);
+    gfxBox1->Attributes()->SetAutoTriangulation(false);
+    gfxBox2->Attributes()->SetAutoTriangulation(false);
+    const size_t memBox1 = GraphicsObjectUnloader::estimatedMemoryUsage(gfxBox1);
+    const size_t memBox2 = GraphicsObjectUnloader::estimatedMemoryUsage(gfxBox2);
+    QVERIFY(memBox1 > 0);
+    QVERIFY(memBox2 > memBox1);
+
+    auto scene = std::make_unique<GraphicsScene>();
+    scene->addObject(gfxBox1);
+    scene->addObject(gfxBox2);
+    scene->setObjectVisible(gfxBox1, false);
+    scene->setObjectVisible(gfxBox2, false);
+    QCOMPARE(unloader->memoryUsage(), memBox1 + memBox2);
+
+    // Budget exceeded, the least recently hidden object is unloaded first
+    unloader->setMemoryBudget(memBox2);
+    QCOMPARE(unloader->memoryUsage(), memBox2);
+
+    // Shown objects aren't tracked anymore
+    scene->setObjectVisible(gfxBox2, true);
+    QCOMPARE(unloader->memoryUsage(), size_t(0));
+
+    // Objects of a destroyed scene aren't tracked anymore
+    scene->setObjectVisible(gfxBox1, true);
+    scene->setObjectVisible(gfxBox1, false);
+    QCOMPARE(unloader->memoryUsage(), memBox1);
+    scene.reset();
+    QCOMPARE(unloader->memoryUsage(), size_t(0));
+}
+
+void Test::GraphicsShapeEntityDriver_colorsChanged_test()
+{
+    if (!isGraphicsSceneAvailable())
+        QSKIP("Display connection required");
+
+    // Assembly of two different parts, no color so far
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+    const Handle_XCAFDoc_ShapeTool shapeTool = doc->xcaf().shapeTool();
+    const Handle_XCAFDoc_ColorTool colorTool = doc->xcaf().colorTool();
+    const TDF_Label partLabel1 = shapeTool->AddShape(BRepPrimAPI_MakeBox(10, 20, 30), false);
+    const TDF_Label partLabel2 = shapeTool->AddShape(BRepPrimAPI_MakeBox(30, 20, 10), false);
+    const TDF_Label asmLabel = shapeTool->NewShape();
+    gp_Trsf trsf;
+    trsf.SetTranslation(gp_Vec(100, 0, 0));
+    const TDF_Label componentLabel1 = shapeTool->AddComponent(asmLabel, partLabel1, TopLoc_Location());
+    const TDF_Label componentLabel2 = shapeTool->AddComponent(asmLabel, partLabel2, TopLoc_Location(trsf));
+    shapeTool->UpdateAssemblies();
+    doc->rebuildModelTree();
+    QCOMPARE(doc->entityCount(), 1);
+
+    const TreeNodeId entityTreeNodeId = doc->entityTreeNodeId(0);
+    auto fnTreeNode = [&](const TDF_Label& label) {
+        TreeNodeId nodeIdFound = 0;
+        deepForeachTreeNode(entityTreeNodeId, doc->modelTree(), [&](TreeNodeId nodeId) {
+            if (doc->modelTree().nodeData(nodeId) == label)
+                nodeIdFound = nodeId;
+        });
+        return DocumentTreeNode(doc, nodeIdFound);
+    };
+
+    GraphicsScene scene;
+    const GraphicsShapeEntityDriver driver;
+    GraphicsEntity entity = driver.createEntity(asmLabel);
+    entity.setScene(&scene);
+    entity.setVisible(true);
+    auto gfx = Handle_GraphicsShapeObject::DownCast(entity.aisObject());
+    QVERIFY(!gfx.IsNull());
+    QVERIFY(!gfx->isInstanced());
+    auto fnOccurrenceColor = [&](const TDF_Label& componentLabel) {
+        const Handle_AIS_ColoredDrawer* ptrDrawer = gfx->CustomAspectsMap().Seek(XCaf::shape(componentLabel));
+        return ptrDrawer ? (*ptrDrawer)->ShadingAspect()->Color() : Quantity_Color(Quantity_NOC_BLACK);
+    };
+
+    QSignalSpy sigSpy_recomputed(&scene, &GraphicsScene::objectSelectionRecomputed);
+    auto fnChangeColor = [&](const TDF_Label& label, Quantity_NameOfColor color) {
+        colorTool->SetColor(label, color, XCAFDoc_ColorSurf);
+        const std::vector<DocumentTreeNode> vecTreeNode = { fnTreeNode(label) };
+        driver.handleColorsChanged(entity, vecTreeNode);
+    };
+
+    // First coloring of a component and then recoloring, updated in place
+    fnChangeColor(componentLabel1, Quantity_NOC_RED);
+    QCOMPARE(sigSpy_recomputed.count(), 0);
+    QVERIFY(fnOccurrenceColor(componentLabel1) == Quantity_Color(Quantity_NOC_RED));
+    fnChangeColor(componentLabel1, Quantity_NOC_GREEN);
+    QCOMPARE(sigSpy_recomputed.count(), 0);
+    QVERIFY(fnOccurrenceColor(componentLabel1) == Quantity_Color(Quantity_NOC_GREEN));
+
+    // Color of the assembly applies to the occurrences without color of their own
+    fnChangeColor(asmLabel, Quantity_NOC_BLUE1);
+    QCOMPARE(sigSpy_recomputed.count(), 0);
+    QVERIFY(fnOccurrenceColor(componentLabel1) == Quantity_Color(Quantity_NOC_GREEN));
+    QVERIFY(fnOccurrenceColor(componentLabel2) == Quantity_Color(Quantity_NOC_BLUE1));
+
+    // Color of the part is replaced by the one of its component
+    fnChangeColor(partLabel1, Quantity_NOC_YELLOW);
+    QCOMPARE(sigSpy_recomputed.count(), 0);
+    QVERIFY(fnOccurrenceColor(componentLabel1) == Quantity_Color(Quantity_NOC_GREEN));
+
+    // Color removed, styles are dispatched again
+    colorTool->UnSetColor(componentLabel1, XCAFDoc_ColorSurf);
+    const std::vector<DocumentTreeNode> vecTreeNode = { fnTreeNode(componentLabel1) };
+    driver.handleColorsChanged(entity, vecTreeNode);
+    QCOMPARE(sigSpy_recomputed.count(), 1);
+    QVERIFY(fnOccurrenceColor(componentLabel1) == Quantity_Color(Quantity_NOC_YELLOW));
+}
+
+void Test::GraphicsHlrPresenter_test()
+{
+    if (!isGraphicsSceneAvailable())
+        QSKIP("Display connection required");
+
+    auto fnHasTriangulation = [](const TopoDS_Shape& shape) {
+        TopLoc_Location loc;
+        TopExp_Explorer expl(shape, TopAbs_FACE);
+        return expl.More() && !BRep_Tool::Triangulation(TopoDS::Face(expl.Current()), loc).IsNull();
+    };
+
+    // Two boxes in front of the camera(looking towards +Z), displayed in wireframe so they aren't
+    // triangulated
+    const TopoDS_Shape shapeBox1 = BRepPrimAPI_MakeBox(gp_Pnt(0, 0, 10), 10, 10, 10);
+    const TopoDS_Shape shapeBox2 = BRepPrimAPI_MakeBox(gp_Pnt(0, 0, 50), 20, 20, 20);
+    const Handle_AIS_Shape gfxBox1 = new AIS_Shape(shapeBox1);
+    const Handle_AIS_Shape gfxBox2 = new AIS_Shape(shapeBox2);
+    GraphicsScene scene;
+    const Handle_V3d_View view = scene.createV3dView();
+    view->Camera()->SetEye(gp_Pnt(5, 5, -100));
+    view->Camera()->SetCenter(gp_Pnt(5, 5, 0));
+    view->Camera()->SetUp(gp::DY());
+    scene.addObject(gfxBox1);
+    scene.addObject(gfxBox2);
+
+    // Single drawing for all objects, triangulation is computed in background on copies
+    GraphicsHlrPresenter presenter(&scene, view);
+    presenter.addObject(gfxBox1);
+    presenter.addObject(gfxBox2);
+    presenter.setEnabled(true);
+    QTRY_COMPARE(presenter.cacheEntryCount(), size_t(1));
+    QVERIFY(!fnHasTriangulation(shapeBox1));
+    QVERIFY(!fnHasTriangulation(shapeBox2));
+
+    // Camera unchanged, drawing is taken from the cache
+    presenter.update();
+    QCOMPARE(presenter.cacheEntryCount(), size_t(1));
+
+    // Perspective drawing depends on the eye position
+    view->Camera()->SetProjectionType(Graphic3d_Camera::Projection_Perspective);
+    presenter.update();
+    QTRY_COMPARE(presenter.cacheEntryCount(), size_t(2));
+
+    // Drawings involving a removed object are discarded
+    presenter.removeObject(gfxBox2);
+    QCOMPARE(presenter.cacheEntryCount(), size_t(0));
+}
+
+void Test::GraphicsLodSelector_selectCoarseParts_test()
+{
+    const double inf = std::numeric_limits<double>::infinity();
+    GraphicsLodSelector::Parameters params;
+    params.coarsePixelSize = 100;
+
+    // Coarse below 80% of the threshold, void bounding box(infinite size) stays fine
+    std::vector<bool> vecIsCoarse;
+    const std::vector<double> vecSize1 = { inf, 10., 200., 90. };
+    QVERIFY(GraphicsLodSelector::selectCoarseParts(vecSize1, params, &vecIsCoarse));
+    QCOMPARE(vecIsCoarse, std::vector<bool>({ false, true, false, false }));
+
+    // Hysteresis, coarse parts are drawn fine again only above the threshold
+    const std::vector<double> vecSize2 = { inf, 90., 200., 90. };
+    QVERIFY(!GraphicsLodSelector::selectCoarseParts(vecSize2, params, &vecIsCoarse));
+    QCOMPARE(vecIsCoarse, std::vector<bool>({ false, true, false, false }));
+    const std::vector<double> vecSize3 = { 10., 110., 200., 90. };
+    QVERIFY(GraphicsLodSelector::selectCoarseParts(vecSize3, params, &vecIsCoarse));
+    QCOMPARE(vecIsCoarse, std::vector<bool>({ true, false, false, false }));
+
+    // Disabled
+    params.isEnabled = false;
+    QVERIFY(GraphicsLodSelector::selectCoarseParts(vecSize3, params, &vecIsCoarse));
+    QCOMPARE(vecIsCoarse, std::vector<bool>(4, false));
+}
+
+void Test::GraphicsShapeObject_partOccurrences_test()
+{
+    auto fnHasTriangulation = [](const TopoDS_Shape& shape) {
+        TopLoc_Location loc;
+        for (TopExp_Explorer expl(shape, TopAbs_FACE); expl.More(); expl.Next()) {
+            if (BRep_Tool::Triangulation(TopoDS::Face(expl.Current()), loc).IsNull())
+                return false;
+        }
+
+        return true;
+    };
+
+    // Assembly with two instances of a box
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+    const Handle_XCAFDoc_ShapeTool shapeTool = doc->xcaf().shapeTool();
+    const TDF_Label partLabel = shapeTool->AddShape(BRepPrimAPI_MakeBox(10, 20, 30), false);
+    const TDF_Label asmLabel = shapeTool->NewShape();
+    gp_Trsf trsf;
+    trsf.SetTranslation(gp_Vec(100, 0, 0));
+    shapeTool->AddComponent(asmLabel, partLabel, TopLoc_Location());
+    shapeTool->AddComponent(asmLabel, partLabel, TopLoc_Location(trsf));
+    shapeTool->UpdateAssemblies();
+
+    // Level of detail is chosen for each occurrence
+    Handle_GraphicsShapeObject gfx = new GraphicsShapeObject(asmLabel);
+    {
+        const std::vector<Bnd_Box> vecBndBox = gfx->partOccurrenceBoundingBoxes();
+        QCOMPARE(vecBndBox.size(), size_t(2));
+        QVERIFY(!vecBndBox.at(0).IsVoid());
+        QVERIFY(!vecBndBox.at(1).IsVoid());
+        QVERIFY(vecBndBox.at(0).IsOut(vecBndBox.at(1)));
+        QCOMPARE(gfx->coarsePartOccurrences(), std::vector<bool>(2, false));
+    }
+
+    // Coarse tessellation is computed in a worker thread, on a copy of the shape
+    QVERIFY(!gfx->hasCoarseTessellation());
+    GraphicsShapeObject::CoarseTessellation coarse = gfx->newCoarseTessellation();
+    TaskManager taskMgr;
+    const TaskId taskId = taskMgr.newTask([&](TaskProgress*) { coarse.compute(); });
+    taskMgr.run(taskId);
+    taskMgr.waitForDone(taskId);
+    QVERIFY(fnHasTriangulation(coarse.coarseShape));
+    QVERIFY(!fnHasTriangulation(XCaf::shape(asmLabel)));
+    gfx->setCoarseTessellation(coarse);
+    QVERIFY(gfx->hasCoarseTessellation());
+    gfx->setCoarsePartOccurrences({ false, true });
+    QCOMPARE(gfx->coarsePartOccurrences(), std::vector<bool>({ false, true }));
+
+    // Bounding boxes follow the shape
+    const GraphicsShapeObject::CoarseTessellation coarseStale = gfx->newCoarseTessellation();
+    shapeTool->SetShape(partLabel, BRepPrimAPI_MakeBox(50, 20, 30));
+    shapeTool->UpdateAssemblies();
+    gfx->invalidateShape();
+    {
+        const std::vector<Bnd_Box> vecBndBox = gfx->partOccurrenceBoundingBoxes();
+        QCOMPARE(vecBndBox.size(), size_t(2));
+        double xMin, yMin, zMin, xMax, yMax, zMax;
+        vecBndBox.at(0).Get(xMin, yMin, zMin, xMax, yMax, zMax);
+        QVERIFY(xMax - xMin >= 50.);
+    }
+
+    // Coarse tessellation of the previous shape is rejected
+    QVERIFY(!gfx->hasCoarseTessellation());
+    gfx->setCoarseTessellation(coarseStale);
+    QVERIFY(!gfx->hasCoarseTessellation());
+}
+
+void Test::GraphicsShapeObject_instancing_test()
+{
+    if (!isGraphicsSceneAvailable())
+        QSKIP("Display connection required");
+
+    // Assembly with three instances of a box, one of them colored through its component
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+    const Handle_XCAFDoc_ShapeTool shapeTool = doc->xcaf().shapeTool();
+    const TDF_Label partLabel = shapeTool->AddShape(BRepPrimAPI_MakeBox(10, 20, 30), false);
+    const TDF_Label asmLabel = shapeTool->NewShape();
+    std::vector<TDF_Label> vecComponent;
+    for (int i = 0; i < 3; ++i) {
+        gp_Trsf trsf;
+        trsf.SetTranslation(gp_Vec(i * 100, 0, 0));
+        vecComponent.push_back(shapeTool->AddComponent(asmLabel, partLabel, TopLoc_Location(trsf)));
+    }
+
+    shapeTool->UpdateAssemblies();
+    doc->xcaf().colorTool()->SetColor(vecComponent.at(1), Quantity_NOC_RED, XCAFDoc_ColorSurf);
+
+    // Colored instance gets its own prototype, instancing is kept
+    GraphicsScene scene;
+    Handle_GraphicsShapeObject gfx = new GraphicsShapeObject(asmLabel);
+    scene.addObject(gfx);
+    scene.setObjectDisplayMode(gfx, AIS_Shaded);
+    QVERIFY(gfx->isInstanced());
+    QCOMPARE(gfx->instanceCount(), 3);
+    QCOMPARE(gfx->prototypeCount(), 2);
+
+    // Selection is computed on the whole shape
+    int faceOwnerCount = 0;
+    scene.activateObjectSelection(gfx, AIS_Shape::SelectionMode(TopAbs_FACE));
+    scene.foreachOwner(gfx, AIS_Shape::SelectionMode(TopAbs_FACE), [&](const GraphicsOwnerPtr&) {
+        ++faceOwnerCount;
+    });
+    QCOMPARE(faceOwnerCount, 3 * 6);
+
+    // Highlighting of the entity is propagated to the instances
+    const Handle_AIS_InteractiveContext context = gfx->GetContext();
+    context->HilightWithColor(gfx, context->HighlightStyle(), false);
+    QCOMPARE(gfx->Children().Size(), 3);
+    for (const Handle_PrsMgr_PresentableObject& child : gfx->Children())
+        QVERIFY(context->MainPrsMgr()->IsHighlighted(child, AIS_Shaded));
+}
+
+void Test::GraphicsShapeTreeNodeMapping_areaSelection_test()
+{
+    if (!isGraphicsSceneAvailable())
+        QSKIP("Display connection required");
+
+    // Assembly of three boxes
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+    const Handle_XCAFDoc_ShapeTool shapeTool = doc->xcaf().shapeTool();
+    const TDF_Label asmLabel = shapeTool->NewShape();
+    for (int i = 0; i < 3; ++i) {
+        const TDF_Label partLabel = shapeTool->AddShape(BRepPrimAPI_MakeBox(10, 20, 30), false);
+        gp_Trsf trsf;
+        trsf.SetTranslation(gp_Vec(i * 100, 0, 0));
+        shapeTool->AddComponent(asmLabel, partLabel, TopLoc_Location(trsf));
+    }
+
+    shapeTool->UpdateAssemblies();
+    doc->rebuildModelTree();
+    QCOMPARE(doc->entityCount(), 1);
+
+    // Graphics owner of each located box
+    const DocumentTreeNode entityTreeNode = doc->entityTreeNode(0);
+    std::vector<TreeNodeId> vecBoxNodeId;
+    std::vector<GraphicsOwnerPtr> vecBoxOwner;
+    deepForeachTreeNode(entityTreeNode.id(), doc->modelTree(), [&](TreeNodeId nodeId) {
+        const TDF_Label label = doc->modelTree().nodeData(nodeId);
+        if (XCaf::isShapeReference(label)) {
+            const TopLoc_Location loc = doc->xcaf().shapeAbsoluteLocation(nodeId);
+            vecBoxNodeId.push_back(nodeId);
+            vecBoxOwner.push_back(new StdSelect_BRepOwner(XCaf::shape(label).Located(loc)));
+        }
+    });
+    QCOMPARE(vecBoxNodeId.size(), size_t(3));
+
+    // View has no window, so boxes in front of the camera are all projected at the origin of view
+    // coordinates
+    GraphicsScene scene;
+    const Handle_V3d_View view = scene.createV3dView();
+    const QPolygon area(QRect(-10, -10, 20, 20));
+    auto fnSorted = [](std::vector<TreeNodeId> vecNodeId) {
+        std::sort(vecNodeId.begin(), vecNodeId.end());
+        return vecNodeId;
+    };
+    auto fnSortedTreeNodesInsideArea = [&](const GraphicsTreeNodeMapping& mapping) {
+        return fnSorted(mapping.findTreeNodesInsideArea(view, area));
+    };
+
+    GraphicsShapeTreeNodeMapping mapping(entityTreeNode, TopAbs_SOLID);
+    QVERIFY(mapping.mapGraphicsOwner(vecBoxOwner.at(0)));
+    QVERIFY(mapping.mapGraphicsOwner(vecBoxOwner.at(1)));
+    QCOMPARE(fnSortedTreeNodesInsideArea(mapping), fnSorted({ vecBoxNodeId.at(0), vecBoxNodeId.at(1) }));
+
+    // Owners remapped with same count, area selection must not use previous owners
+    mapping.clearGraphicsOwners();
+    QVERIFY(mapping.mapGraphicsOwner(vecBoxOwner.at(0)));
+    QVERIFY(mapping.mapGraphicsOwner(vecBoxOwner.at(2)));
+    QCOMPARE(fnSortedTreeNodesInsideArea(mapping), fnSorted({ vecBoxNodeId.at(0), vecBoxNodeId.at(2) }));
+
+    // Owners cleared
+    mapping.clearGraphicsOwners();
+    QVERIFY(fnSortedTreeNodesInsideArea(mapping).empty());
+}
+
 void Test::initTestCase()
 {
     IO::System* ioSystem = Application::instance()->ioSystem();
     ioSystem->addFactoryReader(std::make_unique<IO::OccFactoryReader>());
     ioSystem->addFactoryWriter(std::make_unique<IO::OccFactoryWriter>());
+    ioSystem->addFactoryReader(std::make_unique<IO::MayoDocFactoryReader>());
+    ioSystem->addFactoryWriter(std::make_unique<IO::MayoDocFactoryWriter>());
     IO::addPredefinedFormatProbes(ioSystem);
 }
 
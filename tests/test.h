@@ -15,12 +15,26 @@ class Test : public QObject {
     Q_OBJECT
 private slots:
     void Application_test();
+    void ApplicationItemSelectionModel_test();
     void TextId_test();
     void IO_test();
     void IO_test_data();
     void IO_OccStaticVariablesRollback_test();
     void IO_OccStaticVariablesRollback_test_data();
+    void IO_OccStlWriter_test();
+    void IO_OccBinaryBRep_test();
+    void IO_MayoDoc_test();
+    void IO_ImportCache_test();
+    void IO_ObjParallelReader_test();
+    void IO_OccMappedFileSystem_test();
+    void IO_GltfParallelWriter_test();
+    void IO_FileScan_test();
+    void IO_OccStepLazyShapes_test();
+    void IO_StepParallelReader_test();
+    void IO_StepParallelReader_benchmark();
+    void IO_StepParallelReader_benchmark_data();
     void BRepUtils_test();
+    void ShapeSection_test();
     void CafUtils_test();
     void MeshUtils_test();
     void MeshUtils_test_data();
@@ -29,6 +43,14 @@ private slots:
     void MetaEnum_test();
     void Quantity_test();
     void Result_test();
+    void Settings_deferredGroup_test();
+    void ShapeHlr_test();
+    void DocumentColoring_test();
+    void Formula_test();
+    void Formula_errors_test();
+    void DocumentFormulaTable_test();
+    void Settings_startup_benchmark();
+    void Settings_startup_benchmark_data();
     void StringUtils_append_test();
     void StringUtils_append_test_data();
     void StringUtils_text_test();
@@ -41,6 +63,14 @@ private slots:
 
     void OccQtUtils_test();
 
+    void GraphicsObjectUnloader_test();
+    void GraphicsShapeEntityDriver_colorsChanged_test();
+    void GraphicsHlrPresenter_test();
+    void GraphicsLodSelector_selectCoarseParts_test();
+    void GraphicsShapeObject_partOccurrences_test();
+    void GraphicsShapeObject_instancing_test();
+    void GraphicsShapeTreeNodeMapping_areaSelection_test();
+
     void initTestCase();
 };
 